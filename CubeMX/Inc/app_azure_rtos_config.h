@@ -43,7 +43,7 @@ extern "C" {
 
 #define USE_STATIC_ALLOCATION                    1
 
-#define TX_APP_MEM_POOL_SIZE                     1024 * 4
+#define TX_APP_MEM_POOL_SIZE                     1024 * 6
 
 /* USER CODE BEGIN EC */
 
@@ -53,6 +53,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void error_handler_hook(uint32_t caller);
 
 /* USER CODE END EFP */
 
@@ -37,7 +37,8 @@
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
-
+/* Flash ECC double errors taken in NMI_Handler */
+extern volatile uint32_t flash_ecc_errors;
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
@@ -47,7 +48,7 @@
 
 /* Exported functions prototypes ---------------------------------------------*/
 void NMI_Handler(void);
-void HardFault_Handler(void);
+void DMA1_Channel1_IRQHandler(void);
 void TIM6_DAC_LPTIM1_IRQHandler(void);
 void USART2_LPUART2_IRQHandler(void);
 /* USER CODE BEGIN EFP */
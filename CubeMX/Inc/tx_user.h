@@ -164,6 +164,11 @@
 
 /*#define TX_DISABLE_REDUNDANT_CLEARING*/
 
+/* Fast boot (lib/boot): startup zeroes .bss, ThreadX's globals included */
+#ifdef PICOAPRS_FAST_BOOT
+#define TX_DISABLE_REDUNDANT_CLEARING
+#endif
+
 /* Determine if no timer processing is required. This option will help eliminate the timer
    processing when not needed. The user will also have to comment out the call to
    tx_timer_interrupt, which is typically made from assembly language in
@@ -267,6 +272,12 @@
 
 /* USER CODE BEGIN 2 */
 
+/* Idle through lib/power: WFI in the scheduler loop, with hooks around it
+   that turn it into STOP2 when the next timeout is far enough away.  */
+
+#define TX_LOW_POWER
+#define TX_ENABLE_WFI
+
 /* USER CODE END 2 */
 
 #endif
@@ -19,6 +19,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "app_threadx.h"
 #include "main.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 
@@ -56,7 +57,16 @@ void SystemClock_Config(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-
+/**
+  * @brief  Called by Error_Handler() with interrupts disabled, before it spins.
+  *         Overridden by lib/crash to snapshot the context and reset.
+  * @param  caller: return address of the Error_Handler() call
+  * @retval None
+  */
+__attribute__((weak)) void error_handler_hook(uint32_t caller)
+{
+  (void)caller;
+}
 /* USER CODE END 0 */
 
 /**
@@ -137,6 +147,7 @@ void Error_Handler(void)
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
+  error_handler_hook((uint32_t)__builtin_return_address(0));
   while (1)
   {
   }
@@ -3,30 +3,78 @@
 #include "tx_api.h"
 #include "app_azure_rtos.h"
 #include "app_threadx.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 #include "weak_functions.h"
+#include "ring_buffer.h"
+#include "uart_tx.h"
+#include "dlog.h"
+#include "uart_stdio.h"
+#include "crash.h"
+#include "boot.h"
+#include "watchdog.h"
+#include "flash_stm32.h"
+#include "flightlog.h"
+#include "config.h"
+#include "console.h"
+#include "adc_service.h"
+#include "sunrise_service.h"
+#include "nav_service.h"
+#include "i2c_bus.h"
+#include "bme280.h"
+#include "clock.h"
+#include "power.h"
+#include "powerfail.h"
+#include "qmath.h"
+#include "warmboot.h"
 //#include "app_hooks.h"
 #include <stdio.h>
 
 /* Private define ------------------------------------------------------------*/
 #define TX_APP_STACK_SIZE                 1024
-#define UART_ECHO_THREAD_STACK_SIZE       512
-#define UART_ECHO_THREAD_PRIORITY         5
+#define CONSOLE_THREAD_STACK_SIZE         1024
+#define CONSOLE_THREAD_PRIORITY           20   // Below everything but the log drain
+#define UART_RX_RING_SIZE                 64   // Must be a power of two
 #define TX_APP_THREAD_PRIO                5
 
 
-#define LED_TOGGLE_INTERVAL               100  // 1 second in ticks (assuming 100 ticks/sec)
+#define CONSOLE_IDLE_TIMEOUT              50   // Wake up to check in even without input
+#define CONSOLE_THREAD_DEADLINE           250  // Watchdog deadline, in ticks
+#define CONSOLE_CLOCK_HOLD                3000 // Clock floor kept this long after input, in ticks
+#define LED_BLINK_TICKS                   2    // LED on time, out of led_interval
 
 TX_THREAD tx_app_thread;
 /* USER CODE BEGIN PV */
-TX_THREAD uart_echo_thread;
-TX_MUTEX uart_mutex;
+TX_THREAD console_thread;
+TX_SEMAPHORE uart_rx_sem;
 
 extern UART_HandleTypeDef huart2; 
-uint8_t rx_data;  // Buffer for received character 
-void uart_echo_thread_entry(ULONG thread_input);
+static uint8_t rx_data;  // Single-byte landing slot for HAL_UART_Receive_IT
+RING_BUFFER_DEFINE(uart_rx_ring, UART_RX_RING_SIZE);  // ISR -> console thread
+static flash_dev_t config_flash;
+static flash_dev_t flightlog_flash;
+static flightlog_t flightlog;
+static watchdog_handle_t main_thread_wdg;
+static watchdog_handle_t console_thread_wdg;
+static console_t console;
+static i2c_bus_client_t baro_client;
+static i2c_dev_t baro_dev;
+static bme280_t baro;
+static uint8_t baro_present;
+void console_thread_entry(ULONG thread_input);
 void MainThread_Entry(ULONG thread_input);
+static uint32_t reset_flags;        // RCC->CSR at boot; main() clears the flags after reading
+static void config_boot(void);
+static void boot_banner(void);
+static void flightlog_boot(void);
+static void baro_probe(void);
+static void console_clock_hold(int wanted);
+
+extern uint32_t _config_start;      // Flash regions, from the linker script
+extern uint32_t _config_end;
+extern uint32_t _flightlog_start;
+extern uint32_t _flightlog_end;
 
 // Forward declaration of the init function
 UINT UartEchoApp_Init(VOID *memory_ptr);
@@ -38,10 +86,35 @@ UINT app_init_hook(VOID *memory_ptr) {
 int main(void)
 {
   //register_app_init();
+  boot_start();
+  reset_flags = RCC->CSR;
+  /* Cleared here, once, so the next reset's flags are not mixed with these */
+  __HAL_RCC_CLEAR_RESET_FLAGS();
   HAL_Init();
+  boot_mark(BOOT_PHASE_HAL);
   SystemClock_Config();
+  boot_mark(BOOT_PHASE_CLOCK);
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
+  boot_mark(BOOT_PHASE_PERIPH);
+  config_boot();
+  uart_stdio_init(&huart2);
+  boot_mark(BOOT_PHASE_CONFIG);
+
+  /* A crash record must be taken before anything can overwrite it */
+  crash_boot_report();
+  powerfail_boot_report();
+  powerfail_init();
+#ifndef PICOAPRS_FAST_BOOT
+  boot_banner();
+  flightlog_boot();
+  boot_mark(BOOT_PHASE_REPORTS);
+  power_init(&huart2);
+  warmboot_boot(reset_flags);
+  boot_mark(BOOT_PHASE_POWER);
+#endif
+
   MX_ThreadX_Init();
 
   /* We should never get here as control is now taken by the scheduler */
@@ -60,6 +133,8 @@ UINT UartEchoApp_Init(VOID *memory_ptr)
   UINT ret = TX_SUCCESS;
   TX_BYTE_POOL *byte_pool = (TX_BYTE_POOL*)memory_ptr;
 
+  boot_mark(BOOT_PHASE_KERNEL);
+
   /* USER CODE BEGIN App_ThreadX_MEM_POOL */
   /* USER CODE END App_ThreadX_MEM_POOL */
   CHAR *pointer;
@@ -79,25 +154,78 @@ UINT UartEchoApp_Init(VOID *memory_ptr)
   }
 
   /* USER CODE BEGIN App_ThreadX_Init */
-  // Allocate memory for the UART echo thread stack
+  // Allocate memory for the console thread stack
   if(tx_byte_allocate(byte_pool, (VOID**) &pointer, 
-      UART_ECHO_THREAD_STACK_SIZE, TX_NO_WAIT) != TX_SUCCESS) {
+      CONSOLE_THREAD_STACK_SIZE, TX_NO_WAIT) != TX_SUCCESS) {
     Error_Handler();
   }
 
-  if(tx_thread_create(&uart_echo_thread, "UART Echo Thread", uart_echo_thread_entry, 0, 
-                      pointer, UART_ECHO_THREAD_STACK_SIZE, UART_ECHO_THREAD_PRIORITY, UART_ECHO_THREAD_PRIORITY, 
+  if(tx_thread_create(&console_thread, "Console Thread", console_thread_entry, 0, 
+                      pointer, CONSOLE_THREAD_STACK_SIZE, CONSOLE_THREAD_PRIORITY, CONSOLE_THREAD_PRIORITY, 
                       TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS)
   {
     Error_Handler();
   }
 
-  if(tx_mutex_create(&uart_mutex, "UART Mutex", TX_NO_INHERIT) != TX_SUCCESS)
+  if(uart_tx_init(&huart2) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(clock_init(&huart2) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(dlog_init(byte_pool) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(watchdog_init(byte_pool, reset_flags) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(adc_service_init(byte_pool) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(sunrise_service_init(byte_pool) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(nav_service_init(byte_pool) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  if(i2c_bus_init(byte_pool) != TX_SUCCESS ||
+     i2c_bus_client_init(&baro_client, "BME280", BME280_ADDR) != TX_SUCCESS)
+  {
+    Error_Handler();
+  }
+
+  /* Two LED periods plus one poll; led_interval only changes across a reboot */
+  main_thread_wdg = watchdog_register(&tx_app_thread,
+                                      2U * config_get()->led_interval + WATCHDOG_PERIOD);
+  console_thread_wdg = watchdog_register(&console_thread, CONSOLE_THREAD_DEADLINE);
+  if(main_thread_wdg == NULL || console_thread_wdg == NULL)
+  {
+    Error_Handler();
+  }
+
+  if(tx_semaphore_create(&uart_rx_sem, "UART RX Semaphore", 0) != TX_SUCCESS)
   {
     Error_Handler();
   }
 
   HAL_UART_Receive_IT(&huart2, &rx_data, 1);
+
+  DLOG_INFO("uart_echo_app started, HCLK %u Hz", HAL_RCC_GetHCLKFreq());
+  boot_mark(BOOT_PHASE_APP);
   /* USER CODE END App_ThreadX_Init */
 
   return ret;
@@ -110,14 +238,21 @@ UINT UartEchoApp_Init(VOID *memory_ptr)
 void MainThread_Entry(ULONG thread_input)
 {
   /* USER CODE BEGIN MainThread_Entry */
+  const ULONG led_interval = config_get()->led_interval;
   (void) thread_input;
 
+  boot_mark(BOOT_PHASE_THREAD);
+
   for(;;) {
-    /* Toggle the User LED */
-    HAL_GPIO_TogglePin(User_LED_GPIO_Port, User_LED_Pin);
-     
-    /* Sleep for the defined interval */
-    tx_thread_sleep(LED_TOGGLE_INTERVAL);
+    watchdog_checkin(main_thread_wdg);
+
+    /* Blink the User LED: a short flash keeps the long gap free for STOP2 */
+    HAL_GPIO_WritePin(User_LED_GPIO_Port, User_LED_Pin, GPIO_PIN_SET);
+    tx_thread_sleep(LED_BLINK_TICKS);
+    HAL_GPIO_WritePin(User_LED_GPIO_Port, User_LED_Pin, GPIO_PIN_RESET);
+
+    /* Sleep for the rest of the interval */
+    tx_thread_sleep(led_interval - LED_BLINK_TICKS);
   }
   /* USER CODE END MainThread_Entry */
 }
@@ -125,37 +260,234 @@ void MainThread_Entry(ULONG thread_input)
 
 /* USER CODE BEGIN 1 */
 /**
-  * @brief  UART Echo Thread function
+  * @brief  Load the persistent configuration and apply the boot-time
+  *         settings: USART2 comes up at the default rate and is re-timed
+  *         here if the stored one differs.
+  * @retval None
+  */
+static void config_boot(void)
+{
+  flash_stm32_init(&config_flash, (uint32_t)&_config_start, (uint32_t)&_config_end);
+  if (config_init(&config_flash) < CONFIG_OK) {
+    Error_Handler();
+  }
+
+  if (huart2.Init.BaudRate != config_get()->uart_baud) {
+    huart2.Init.BaudRate = config_get()->uart_baud;
+    if (HAL_UART_Init(&huart2) != HAL_OK) {
+      Error_Handler();
+    }
+  }
+}
+
+/**
+  * @brief  Print the version line and the configuration in use.
+  * @retval None
+  */
+static void boot_banner(void)
+{
+  printf("\nPicoAPRS uart_echo_app, HCLK %lu Hz\n", (unsigned long)HAL_RCC_GetHCLKFreq());
+  printf("config: %s-%u, generation %lu\n", config_get()->callsign, config_get()->ssid,
+         (unsigned long)config_generation());
+}
+
+/**
+  * @brief  Rebuild the flight log index and record this boot, with the reset
+  *         flags and the previous run's crash reason.
+  * @retval None
+  */
+static void flightlog_boot(void)
+{
+  const crash_record_t *crash = crash_last();
+  uint32_t boot[2];
+
+  flash_stm32_init(&flightlog_flash, (uint32_t)&_flightlog_start, (uint32_t)&_flightlog_end);
+  if (flightlog_init(&flightlog, &flightlog_flash) != FLIGHTLOG_OK) {
+    Error_Handler();
+  }
+  printf("flightlog: %lu pages, head %lu @%lu, seq %lu\n",
+         (unsigned long)flightlog_flash.page_count, (unsigned long)flightlog.head_page,
+         (unsigned long)flightlog.head_offset, (unsigned long)flightlog.head_seq);
+
+  boot[0] = reset_flags;
+  boot[1] = (crash != NULL) ? crash->reason : CRASH_REASON_NONE;
+  (void)flightlog_append(&flightlog, FLIGHTLOG_TYPE_BOOT, boot, sizeof(boot));
+  powerfail_attach(&flightlog);
+}
+
+/**
+  * @brief  Console sink for echo and line editing: straight to the UART,
+  *         ahead of anything buffered in stdio.
+  */
+static void console_write(const char *buf, uint32_t len)
+{
+  (void)uart_tx_write((const uint8_t *)buf, (uint16_t)len, TX_WAIT_FOREVER);
+}
+
+/**
+  * @brief  Console Thread function: feeds received bytes to the line editor,
+  *         which runs the commands.
   * @param  thread_input: ULONG user argument
   * @retval None
   */
-void uart_echo_thread_entry(ULONG thread_input) {
+void console_thread_entry(ULONG thread_input) {
   (void) thread_input;
-  uint8_t echo_data;
-   
+  uint8_t rx[UART_RX_RING_SIZE];
+  uint32_t len;
+  uint32_t i;
+  ULONG last_rx;
+
+  boot_mark(BOOT_PHASE_THREAD);
+#ifdef PICOAPRS_FAST_BOOT
+  /* Work the first beacon does not wait for, at the lowest priority but one.
+   * LSE can take seconds to start; until the RTC runs, idle is plain Sleep */
+  power_init(&huart2);
+  warmboot_boot(reset_flags);
+  boot_banner();
+  flightlog_boot();
+  boot_mark(BOOT_PHASE_DEFERRED);
+#endif
+  boot_report();
+
+  last_rx = tx_time_get();
+  baro_probe();
+  console_init(&console, console_write);
+
   for(;;) {
-    /* Wait for UART reception to complete (triggered by interrupt) */
-    if (HAL_UART_GetState(&huart2) == HAL_UART_STATE_READY) {
-      /* Get mutex to safely access UART */
-      if (tx_mutex_get(&uart_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-        echo_data = rx_data;  // Save received data
-         
-        /* Echo the received character back */
-        HAL_UART_Transmit(&huart2, &echo_data, 1, HAL_MAX_DELAY);
-         
-        /* Start another reception */
-        HAL_UART_Receive_IT(&huart2, &rx_data, 1);
-         
-        /* Release the mutex */
-        tx_mutex_put(&uart_mutex);
-      }
+    watchdog_checkin(console_thread_wdg);
+    /* Other threads' partial stdio lines, held too long */
+    uart_stdio_poll();
+    console_clock_hold(tx_time_get() - last_rx < CONSOLE_CLOCK_HOLD);
+
+    /* Block until the RX interrupt has queued at least one byte */
+    if (tx_semaphore_get(&uart_rx_sem, CONSOLE_IDLE_TIMEOUT) != TX_SUCCESS) {
+      continue;
+    }
+    last_rx = tx_time_get();
+    console_clock_hold(1);
+
+    /* Drain everything that arrived so far in one go */
+    len = ring_buffer_read(&uart_rx_ring, rx, sizeof(rx));
+    for (i = 0; i < len; i++) {
+      console_feed(&console, (char)rx[i]);
     }
-     
-    /* Yield to allow LED thread to run */
-    tx_thread_sleep(1);
   }
 }
- 
+
+/**
+  * @brief  Take or drop the console's clock floor. While someone is typing,
+  *         the clock stays where the baud rate needs it, so a pasted line
+  *         does not overrun the RX interrupt; idle, the USART runs from
+  *         HSI16 at the lower levels. Sunrise's first stage comes first:
+  *         on a marginal supply the console is served at the minimum clock.
+  * @param  wanted: non-zero while the console is in use
+  */
+static void console_clock_hold(int wanted)
+{
+  static uint8_t holding;
+  clock_level_t floor = clock_level_for_baud(huart2.Init.BaudRate);
+
+  wanted = wanted && (sunrise_service_stage() != SUNRISE_ADC_ONLY);
+  if (wanted && !holding) {
+    clock_request(floor);
+    holding = 1U;
+  } else if (!wanted && holding) {
+    clock_release(floor);
+    holding = 0U;
+  }
+}
+
+/**
+  * @brief  Look for the BME280 on the I2C bus. The payload flies without
+  *         one if it is missing.
+  * @retval None
+  */
+static void baro_probe(void)
+{
+  bme280_status_t status;
+
+  i2c_bus_client_dev(&baro_client, &baro_dev);
+  /* One clock switch for all of its transfers, not one each */
+  clock_request(CLOCK_LEVEL_HIGH);
+  status = bme280_init(&baro, &baro_dev);
+  clock_release(CLOCK_LEVEL_HIGH);
+  baro_present = (status == BME280_OK);
+  if (!baro_present) {
+    DLOG_WARN("bme280: not found (%d)", (int32_t)status);
+  }
+}
+
+/**
+  * @brief  'baro' console command: take one forced-mode measurement.
+  */
+static int console_cmd_baro(int argc, char *argv[])
+{
+  bme280_sample_t sample;
+  bme280_status_t status;
+  int32_t t;
+  (void)argc;
+  (void)argv;
+
+  if (!baro_present) {
+    printf("  no BME280\n");
+    return 0;
+  }
+  /* The bus thread asks for HIGH per transfer; held here, the clock stays
+   * put from the start through the read instead of dropping in between */
+  clock_request(CLOCK_LEVEL_HIGH);
+  status = bme280_start(&baro);
+  if (status == BME280_OK) {
+    /* One tick more, as the first one may be partial */
+    tx_thread_sleep((BME280_MEASURE_TIME_MS * TX_TIMER_TICKS_PER_SECOND + 999U) / 1000U + 1U);
+    status = bme280_read(&baro, &sample);
+  }
+  clock_release(CLOCK_LEVEL_HIGH);
+  if (status != BME280_OK) {
+    return (int)status;
+  }
+  t = sample.temp_cdeg;
+  printf("  %lu Pa, %s%ld.%02ld C, %lu.%02lu %%RH\n", (unsigned long)sample.pressure_pa,
+         (t < 0) ? "-" : "", (long)((t < 0) ? -t : t) / 100L, (long)((t < 0) ? -t : t) % 100L,
+         (unsigned long)(sample.humidity_q10 >> 10),
+         (unsigned long)(((sample.humidity_q10 & 1023U) * 100U) >> 10));
+  t = qmath_baro_altitude_cm(sample.pressure_pa, QMATH_BARO_P0_PA);
+  nav_service_baro(t);
+  printf("  %s%ld.%02ld m pressure altitude (ISA)\n", (t < 0) ? "-" : "",
+         (long)((t < 0) ? -t : t) / 100L, (long)((t < 0) ? -t : t) % 100L);
+  return 0;
+}
+
+CONSOLE_COMMAND(baro, "read pressure, temperature, humidity and pressure altitude", console_cmd_baro, NULL);
+
+/**
+  * @brief  'log' console command: dump the flight log, oldest first.
+  */
+static int console_cmd_log(int argc, char *argv[])
+{
+  flightlog_iter_t it;
+  flightlog_record_t rec;
+  uint32_t count = 0;
+  uint32_t i;
+  (void)argc;
+  (void)argv;
+
+  flightlog_iter_begin(&flightlog, &it);
+  while (flightlog_iter_next(&flightlog, &it, &rec) == FLIGHTLOG_OK) {
+    /* A full log takes a while over the UART */
+    watchdog_checkin(console_thread_wdg);
+    printf("  %6lu %3u %2u ", (unsigned long)rec.seq, rec.type, rec.len);
+    for (i = 0; i < rec.len; i++) {
+      printf("%02x", rec.payload[i]);
+    }
+    printf("\n");
+    count++;
+  }
+  printf("  %lu records\n", (unsigned long)count);
+  return 0;
+}
+
+CONSOLE_COMMAND(log, "dump the flight log", console_cmd_log, NULL);
+
  /**
    * @brief  UART Rx Transfer completed callback
    * @param  huart: UART handle
@@ -164,8 +496,13 @@ void uart_echo_thread_entry(ULONG thread_input) {
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
   /* This function is called when UART reception is complete */
   if (huart->Instance == USART2) {
+    /* Queue the byte (dropped if the thread has fallen behind) and re-arm */
+    (void)ring_buffer_put(&uart_rx_ring, rx_data);
+    HAL_UART_Receive_IT(&huart2, &rx_data, 1);
+    power_activity();
+
     /* Wake up the UART thread to process the received data */
-    tx_thread_resume(&uart_echo_thread);
+    tx_semaphore_put(&uart_rx_sem);
   }
 }
 
@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file    sim.h
+  * @brief   Host build: the simulated part behind the HAL API.
+  *
+  *          The firmware runs as a Linux process on ThreadX's Linux port.
+  *          Each HAL function it calls is reimplemented in sim_*.c on top
+  *          of POSIX, and the ones that complete asynchronously finish in a
+  *          simulated interrupt: sim_irq_raise() from any host thread, and
+  *          the handler runs on the interrupt thread inside
+  *          _tx_thread_context_save()/_tx_thread_context_restore(), the way
+  *          the port runs its timer. __get_IPSR() is non-zero there, so
+  *          firmware checks for ISR context work unchanged.
+  *
+  *          Interrupts are held back until the scheduler runs; on target
+  *          they are only enabled by then too.
+  *
+  *          The environment configures the part:
+  *            - PICOAPRS_UART=pty: USART2 on a new pseudo-terminal, its path
+  *              printed on stderr. Otherwise stdin/stdout.
+  *            - PICOAPRS_FLASH: backing file for the config and flight log
+  *              pages, default picoaprs_flash.bin. Survives restarts.
+  *            - PICOAPRS_GPIO_LOG: file to log pin changes to, with a
+  *              millisecond time stamp.
+  *
+  *          NVIC_SystemReset() and watchdog expiry re-exec the process with
+  *          the reset cause in RCC->CSR; .noinit does not survive it.
+  ******************************************************************************
+  */
+#ifndef SIM_H
+#define SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sim_regs.h"
+
+typedef enum {
+  SIM_IRQ_USART2_TX = 0,
+  SIM_IRQ_USART2_RX,
+  SIM_IRQ_ADC1,
+  SIM_IRQ_I2C1,
+  SIM_IRQ_PVD,
+  SIM_IRQS
+} sim_irq_t;
+
+/* Factory calibration: VREFINT reads 1.212 V and the sensor 0.76 V at 30 C
+ * and 1.01 V at 130 C, all at 3.0 V */
+#define SIM_VREFINT_CAL         1655U
+#define SIM_TS_CAL1             1038U
+#define SIM_TS_CAL2             1379U
+
+extern const uint16_t sim_vrefint_cal;
+extern const uint16_t sim_ts_cal1;
+extern const uint16_t sim_ts_cal2;
+
+#undef VREFINT_CAL_ADDR
+#undef TEMPSENSOR_CAL1_ADDR
+#undef TEMPSENSOR_CAL2_ADDR
+#define VREFINT_CAL_ADDR        (&sim_vrefint_cal)
+#define TEMPSENSOR_CAL1_ADDR    (&sim_ts_cal1)
+#define TEMPSENSOR_CAL2_ADDR    (&sim_ts_cal2)
+
+/* Core intrinsics the firmware uses, past their CMSIS definitions */
+#define __get_IPSR()            sim_ipsr()
+#define __get_MSP()             sim_sp()
+#define __get_PSP()             sim_sp()
+#define __get_CONTROL()         0U
+#define __disable_irq()         sim_disable_irq()
+#define __enable_irq()          sim_enable_irq()
+#undef NVIC_SystemReset
+#define NVIC_SystemReset()      sim_reset(RCC_CSR_SFTRSTF)
+#undef NVIC_SetPendingIRQ
+#define NVIC_SetPendingIRQ(irqn) sim_nvic_pend(irqn)
+
+/**
+  * @brief  Exception number: non-zero while a simulated handler runs.
+  */
+uint32_t sim_ipsr(void);
+
+/**
+  * @brief  Current stack pointer of the calling host thread.
+  */
+uint32_t sim_sp(void);
+
+void sim_disable_irq(void);
+void sim_enable_irq(void);
+
+/**
+  * @brief  Restart the firmware: re-exec the process.
+  * @param  cause: RCC_CSR_*RSTF flag the new run finds set
+  */
+void sim_reset(uint32_t cause) __attribute__((noreturn));
+
+/**
+  * @brief  Pend a simulated interrupt. Any thread, including a signal
+  *         handler; raising a pending one again is a no-op.
+  */
+void sim_irq_raise(sim_irq_t irq);
+
+/**
+  * @brief  Pend a device interrupt by its IRQn, for those the simulation
+  *         has (only PVD_PVM_IRQn so far); others are ignored.
+  */
+void sim_nvic_pend(IRQn_Type irqn);
+
+/**
+  * @brief  Milliseconds since the process started.
+  */
+uint32_t sim_millis(void);
+
+/* Handlers, one per sim_irq_t, and the per-peripheral start-up run from
+ * HAL_Init() */
+void sim_uart_tx_isr(void);
+void sim_uart_rx_isr(void);
+void sim_adc_isr(void);
+void sim_i2c_isr(void);
+void sim_pvd_isr(void);
+void sim_irq_init(void);
+void sim_uart_init(void);
+void sim_gpio_init(void);
+void sim_flash_init(void);
+
+/**
+  * @brief  Called on the interrupt thread every few milliseconds, outside
+  *         interrupt context: the watchdog counts down here.
+  */
+void sim_iwdg_poll(void);
+
+/**
+  * @brief  Put the console terminal back the way it was found.
+  */
+void sim_uart_restore(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
@@ -0,0 +1,137 @@
+/**
+  ******************************************************************************
+  * @file    sim_adc.c
+  * @brief   Host build: ADC1 reading a healthy, steady board.
+  *
+  *          A DMA scan completes at once with VDDA at 3.3 V, the die at
+  *          25 C, a 3.0 V battery behind the VBAT/3 bridge and the other
+  *          channels at 0 V, oversampled to 16 bits like the firmware's
+  *          configuration. Channels are reported in the order they were
+  *          configured.
+  ******************************************************************************
+  */
+#include "main.h"
+#include "sim.h"
+
+#define SIM_ADC_CHANNELS        16U
+#define SIM_ADC_VDDA_MV         3300U
+#define SIM_ADC_CAL_MV          3000U   /* VDDA the factory values hold for */
+#define SIM_ADC_TEMP_C          25
+#define SIM_ADC_VBAT_MV         3000U
+#define SIM_ADC_FULL_SCALE      (4095UL << 4)
+
+static ADC_HandleTypeDef *sim_adc_hadc;
+static uint32_t sim_adc_channels[SIM_ADC_CHANNELS];
+static uint32_t sim_adc_configured;
+static uint16_t *sim_adc_dest;
+static uint32_t sim_adc_length;
+
+static uint32_t sim_adc_cal_mv(uint16_t cal)
+{
+  return (uint32_t)cal * SIM_ADC_CAL_MV / 4095U;
+}
+
+/**
+  * @brief  What the channel would read, in mV at its input.
+  */
+static uint32_t sim_adc_input_mv(uint32_t channel)
+{
+  int32_t ts1;
+  int32_t ts2;
+
+  if (channel == ADC_CHANNEL_VREFINT) {
+    return sim_adc_cal_mv(sim_vrefint_cal);
+  }
+  if (channel == ADC_CHANNEL_TEMPSENSOR) {
+    ts1 = (int32_t)sim_adc_cal_mv(sim_ts_cal1);
+    ts2 = (int32_t)sim_adc_cal_mv(sim_ts_cal2);
+    return (uint32_t)(ts1 + (ts2 - ts1) * (SIM_ADC_TEMP_C - TEMPSENSOR_CAL1_TEMP) /
+                      (TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP));
+  }
+  if (channel == ADC_CHANNEL_VBAT) {
+    return SIM_ADC_VBAT_MV / 3U;
+  }
+  return 0U;
+}
+
+__weak void HAL_ADC_MspInit(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+}
+
+__weak void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+}
+
+__weak void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+}
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+  HAL_ADC_MspInit(hadc);
+  sim_adc_hadc = hadc;
+  sim_adc_configured = 0U;
+  hadc->ErrorCode = HAL_ADC_ERROR_NONE;
+  hadc->State = HAL_ADC_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc,
+                                        const ADC_ChannelConfTypeDef *pConfig)
+{
+  (void)hadc;
+  if (sim_adc_configured >= SIM_ADC_CHANNELS) {
+    return HAL_ERROR;
+  }
+  sim_adc_channels[sim_adc_configured++] = pConfig->Channel;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc)
+{
+  (void)hadc;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length)
+{
+  if (hadc->State & HAL_ADC_STATE_REG_BUSY) {
+    return HAL_BUSY;
+  }
+  /* The firmware's DMA moves half-words */
+  sim_adc_dest = (uint16_t *)pData;
+  sim_adc_length = (Length < sim_adc_configured) ? Length : sim_adc_configured;
+  hadc->State = HAL_ADC_STATE_REG_BUSY;
+  sim_irq_raise(SIM_IRQ_ADC1);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc)
+{
+  hadc->State = HAL_ADC_STATE_READY;
+  return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetError(const ADC_HandleTypeDef *hadc)
+{
+  return hadc->ErrorCode;
+}
+
+void sim_adc_isr(void)
+{
+  ADC_HandleTypeDef *hadc = sim_adc_hadc;
+  uint32_t i;
+
+  if (hadc == NULL || (hadc->State & HAL_ADC_STATE_REG_BUSY) == 0U) {
+    return;                             /* Stopped */
+  }
+  for (i = 0; i < sim_adc_length; i++) {
+    sim_adc_dest[i] = (uint16_t)((sim_adc_input_mv(sim_adc_channels[i]) * SIM_ADC_FULL_SCALE +
+                                  SIM_ADC_VDDA_MV / 2U) / SIM_ADC_VDDA_MV);
+  }
+  hadc->State = HAL_ADC_STATE_READY | HAL_ADC_STATE_REG_EOC;
+  HAL_ADC_ConvCpltCallback(hadc);
+}
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file    sim_flash.c
+  * @brief   Host build: the config and flight log pages, kept in a file.
+  *
+  *          sim_flash_image stands in for flash from the CONFIG region to
+  *          the end of FLIGHTLOG; the link maps the linker script's region
+  *          symbols onto it (host/CMakeLists.txt). Every program and erase
+  *          is written through to PICOAPRS_FLASH, so stored settings and
+  *          logs survive a restart like they survive a power cycle.
+  *
+  *          Programming a double-word that is not erased fails, as PROGERR
+  *          would. ECC errors never happen here.
+  ******************************************************************************
+  */
+#include "main.h"
+#include "sim.h"
+#include "stm32u0xx_it.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIM_FLASH_SIZE          0x9000U /* CONFIG 4K + FLIGHTLOG 32K */
+
+uint8_t sim_flash_image[SIM_FLASH_SIZE] __attribute__((aligned(FLASH_PAGE_SIZE)));
+volatile uint32_t flash_ecc_errors;
+FLASH_ProcessTypeDef pFlash = { .Lock = HAL_UNLOCKED };   /* Held as the HAL holds it */
+
+static int sim_flash_fd = -1;
+
+static void sim_flash_sync(uint32_t offset, uint32_t len)
+{
+  if (sim_flash_fd >= 0 &&
+      pwrite(sim_flash_fd, &sim_flash_image[offset], len, (off_t)offset) != (ssize_t)len) {
+    perror("sim: flash");
+  }
+}
+
+void sim_flash_init(void)
+{
+  const char *path = getenv("PICOAPRS_FLASH");
+
+  memset(sim_flash_image, 0xFF, sizeof(sim_flash_image));
+  sim_flash_fd = open((path != NULL) ? path : "picoaprs_flash.bin", O_RDWR | O_CREAT, 0644);
+  if (sim_flash_fd < 0) {
+    perror("sim: flash, running without a backing file");
+    return;
+  }
+  if (read(sim_flash_fd, sim_flash_image, sizeof(sim_flash_image)) !=
+      (ssize_t)sizeof(sim_flash_image)) {
+    /* New or short file: start from an erased part */
+    memset(sim_flash_image, 0xFF, sizeof(sim_flash_image));
+    sim_flash_sync(0, sizeof(sim_flash_image));
+  }
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+  uint32_t offset = Address - (uint32_t)(uintptr_t)sim_flash_image;
+  static const uint8_t erased[sizeof(uint64_t)] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  };
+
+  __HAL_LOCK(&pFlash);
+  if (TypeProgram != FLASH_TYPEPROGRAM_DOUBLEWORD || offset >= SIM_FLASH_SIZE ||
+      (offset % sizeof(uint64_t)) != 0U ||
+      memcmp(&sim_flash_image[offset], erased, sizeof(erased)) != 0) {
+    __HAL_UNLOCK(&pFlash);
+    return HAL_ERROR;
+  }
+  memcpy(&sim_flash_image[offset], &Data, sizeof(Data));
+  sim_flash_sync(offset, sizeof(Data));
+  __HAL_UNLOCK(&pFlash);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+  /* Page numbers count from FLASH_BASE; the arithmetic wraps the same way
+   * flash_stm32.c's did */
+  uint32_t offset = (FLASH_BASE + pEraseInit->Page * FLASH_PAGE_SIZE) -
+                    (uint32_t)(uintptr_t)sim_flash_image;
+  uint32_t len = pEraseInit->NbPages * FLASH_PAGE_SIZE;
+
+  __HAL_LOCK(&pFlash);
+  *PageError = 0xFFFFFFFFU;
+  if (offset >= SIM_FLASH_SIZE || len > SIM_FLASH_SIZE - offset) {
+    *PageError = pEraseInit->Page;
+    __HAL_UNLOCK(&pFlash);
+    return HAL_ERROR;
+  }
+  memset(&sim_flash_image[offset], 0xFF, len);
+  sim_flash_sync(offset, len);
+  __HAL_UNLOCK(&pFlash);
+  return HAL_OK;
+}
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    sim_gpio.c
+  * @brief   Host build: GPIO ports as their ODR/IDR registers, with a log.
+  *
+  *          Outputs land in ODR and are logged on change as
+  *          "<ms> P<port><pin> <level>" to PICOAPRS_GPIO_LOG when it is set.
+  *          Inputs read IDR, idle at reset except the user button, which the
+  *          board pulls up.
+  ******************************************************************************
+  */
+#include "main.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static FILE *sim_gpio_log;
+
+static char sim_gpio_port_name(const GPIO_TypeDef *port)
+{
+  if (port == GPIOA) {
+    return 'A';
+  }
+  if (port == GPIOB) {
+    return 'B';
+  }
+  if (port == GPIOC) {
+    return 'C';
+  }
+  if (port == GPIOD) {
+    return 'D';
+  }
+  return (port == GPIOF) ? 'F' : '?';
+}
+
+/**
+  * @brief  Drive pins to the levels in odr, logging the ones that change.
+  */
+static void sim_gpio_drive(GPIO_TypeDef *port, uint32_t odr)
+{
+  uint32_t changed = (port->ODR ^ odr) & 0xFFFFU;
+  uint32_t pin;
+
+  port->ODR = odr;
+  if (sim_gpio_log == NULL) {
+    return;
+  }
+  for (pin = 0; pin < 16U; pin++) {
+    if (changed & (1UL << pin)) {
+      fprintf(sim_gpio_log, "%lu P%c%lu %lu\n", (unsigned long)sim_millis(),
+              sim_gpio_port_name(port), (unsigned long)pin, (unsigned long)((odr >> pin) & 1U));
+    }
+  }
+  (void)fflush(sim_gpio_log);
+}
+
+void sim_gpio_init(void)
+{
+  const char *path = getenv("PICOAPRS_GPIO_LOG");
+
+  User_button_GPIO_Port->IDR |= User_button_Pin;
+  if (path != NULL) {
+    sim_gpio_log = fopen(path, "a");
+    if (sim_gpio_log == NULL) {
+      perror("sim: GPIO log");
+    }
+  }
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, const GPIO_InitTypeDef *GPIO_Init)
+{
+  (void)GPIOx;
+  (void)GPIO_Init;
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+  sim_gpio_drive(GPIOx, GPIOx->ODR & ~GPIO_Pin);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(const GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  sim_gpio_drive(GPIOx, (PinState != GPIO_PIN_RESET) ? (GPIOx->ODR | GPIO_Pin) :
+                                                       (GPIOx->ODR & ~(uint32_t)GPIO_Pin));
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  sim_gpio_drive(GPIOx, GPIOx->ODR ^ GPIO_Pin);
+}
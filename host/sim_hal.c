@@ -0,0 +1,329 @@
+/**
+  ******************************************************************************
+  * @file    sim_hal.c
+  * @brief   Host build: HAL core, clocks, power, RTC, DMA, NVIC, IWDG and
+  *          reset.
+  *
+  *          Configuration calls succeed without doing anything: there is
+  *          nothing to clock or power on a host. The IWDG really counts, in
+  *          wall-clock time, unless a debugger is attached and the firmware
+  *          asked for it to freeze.
+  ******************************************************************************
+  */
+#include "main.h"
+#include "sim.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_CMDLINE_SIZE        4096U
+#define SIM_ARGS_MAX            32U
+
+sim_regs_t sim_regs;
+
+const uint16_t sim_vrefint_cal = SIM_VREFINT_CAL;
+const uint16_t sim_ts_cal1 = SIM_TS_CAL1;
+const uint16_t sim_ts_cal2 = SIM_TS_CAL2;
+
+uint32_t SystemCoreClock = HSI_VALUE;
+__IO uint32_t uwTick;
+uint32_t uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+uint32_t uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+TIM_HandleTypeDef htim6 = { .Instance = TIM6 };
+
+static struct timespec sim_start;
+static volatile uint32_t sim_iwdg_period;   /* ms, 0 while stopped */
+static volatile uint32_t sim_iwdg_deadline;
+
+uint32_t sim_millis(void)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((now.tv_sec - sim_start.tv_sec) * 1000L +
+                    (now.tv_nsec - sim_start.tv_nsec) / 1000000L);
+}
+
+/**
+  * @brief  Reset flags left by the run that re-exec'd us; power-on otherwise.
+  */
+static uint32_t sim_reset_flags(void)
+{
+  const char *csr = getenv("PICOAPRS_RESET_CSR");
+
+  return (csr != NULL) ? (uint32_t)strtoul(csr, NULL, 16) : RCC_CSR_PWRRSTF | RCC_CSR_PINRSTF;
+}
+
+/**
+  * @brief  Out of reset, before main(): the flags are there for its first
+  *         read, as on target, and the crystal has started.
+  */
+__attribute__((constructor)) static void sim_power_on(void)
+{
+  RCC->CSR = sim_reset_flags();
+  (void)unsetenv("PICOAPRS_RESET_CSR");
+  RCC->BDCR = RCC_BDCR_LSERDY;
+}
+
+void sim_reset(uint32_t cause)
+{
+  static char cmdline[SIM_CMDLINE_SIZE];
+  char *argv[SIM_ARGS_MAX + 1U];
+  char csr[9];
+  uint32_t argc = 0;
+  uint32_t value = cause | RCC_CSR_PINRSTF;
+  sigset_t none;
+  ssize_t len = 0;
+  int fd;
+  int i;
+
+  /* Hold off the scheduler and the interrupt thread for good */
+  sim_disable_irq();
+  sim_uart_restore();
+
+  for (i = 7; i >= 0; i--) {
+    csr[i] = "0123456789abcdef"[value & 0xFU];
+    value >>= 4;
+  }
+  csr[8] = '\0';
+  (void)setenv("PICOAPRS_RESET_CSR", csr, 1);
+
+  fd = open("/proc/self/cmdline", O_RDONLY);
+  if (fd >= 0) {
+    len = read(fd, cmdline, sizeof(cmdline) - 1U);
+    (void)close(fd);
+  }
+  for (i = 0; i < len && argc < SIM_ARGS_MAX; i += (int)strlen(&cmdline[i]) + 1) {
+    argv[argc++] = &cmdline[i];
+  }
+  argv[argc] = NULL;
+
+  /* The signal mask survives exec; the new image starts with none blocked */
+  (void)sigemptyset(&none);
+  (void)pthread_sigmask(SIG_SETMASK, &none, NULL);
+  if (argc > 0U) {
+    (void)execv("/proc/self/exe", argv);
+  }
+  perror("sim: reset");
+  _exit(EXIT_FAILURE);
+}
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+  (void)clock_gettime(CLOCK_MONOTONIC, &sim_start);
+
+  sim_gpio_init();
+  sim_flash_init();
+  sim_uart_init();
+  sim_irq_init();
+
+  (void)HAL_InitTick(TICK_INT_PRIORITY);
+  HAL_MspInit();
+  return HAL_OK;
+}
+
+__weak void HAL_MspInit(void)
+{
+}
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+  uwTickPrio = TickPriority;
+  return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+  uwTick += uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+  uwTick = sim_millis();
+  return uwTick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  (void)usleep(Delay * 1000U);
+}
+
+void HAL_DBGMCU_EnableDBGStopMode(void)
+{
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+  (void)RCC_OscInitStruct;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(const RCC_ClkInitTypeDef *RCC_ClkInitStruct,
+                                      uint32_t FLatency)
+{
+  (void)FLatency;
+  SystemCoreClock = (RCC_ClkInitStruct->SYSCLKSource == RCC_SYSCLKSOURCE_HSI) ?
+                    HSI_VALUE : MSI_VALUE;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(const RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+  /* Only the RTC source is kept, for code that checks what the RTC runs on */
+  if ((PeriphClkInit->PeriphClockSelection & RCC_PERIPHCLK_RTC) != 0U) {
+    MODIFY_REG(RCC->BDCR, RCC_BDCR_RTCSEL, PeriphClkInit->RTCClockSelection);
+  }
+  return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+  return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+  return SystemCoreClock;
+}
+
+HAL_StatusTypeDef HAL_PWREx_ControlVoltageScaling(uint32_t VoltageScaling)
+{
+  (void)VoltageScaling;
+  return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+HAL_StatusTypeDef HAL_PWR_ConfigPVD(const PWR_PVDTypeDef *sConfigPVD)
+{
+  (void)sConfigPVD;
+  return HAL_OK;
+}
+
+void HAL_PWR_EnablePVD(void)
+{
+}
+
+/**
+  * @brief  VDD never sags on a host: only a drill pends this.
+  */
+__weak void PVD_PVM_IRQHandler(void)
+{
+}
+
+void sim_pvd_isr(void)
+{
+  PVD_PVM_IRQHandler();
+}
+
+__weak void HAL_RTC_MspInit(RTC_HandleTypeDef *hrtc)
+{
+  (void)hrtc;
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc)
+{
+  HAL_RTC_MspInit(hrtc);
+  hrtc->State = HAL_RTC_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_EnableBypassShadow(RTC_HandleTypeDef *hrtc)
+{
+  (void)hrtc;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+  hdma->State = HAL_DMA_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+  hdma->State = HAL_DMA_STATE_RESET;
+  return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+  (void)hdma;
+}
+
+/**
+  * @brief  A halted process under a debugger is what the freeze bit is for.
+  */
+static int sim_iwdg_frozen(void)
+{
+  char status[1024];
+  const char *tracer;
+  ssize_t len;
+  int fd;
+
+  if ((DBGMCU->APBFZ1 & DBGMCU_APBFZ1_DBG_IWDG_STOP) == 0U) {
+    return 0;
+  }
+  fd = open("/proc/self/status", O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  len = read(fd, status, sizeof(status) - 1U);
+  (void)close(fd);
+  status[(len > 0) ? len : 0] = '\0';
+  tracer = strstr(status, "TracerPid:");
+  return tracer != NULL && atoi(tracer + strlen("TracerPid:")) != 0;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef *hiwdg)
+{
+  uint32_t divider = 4UL << hiwdg->Init.Prescaler;
+
+  if (sim_iwdg_frozen()) {
+    fprintf(stderr, "sim: debugger attached, IWDG frozen\n");
+    return HAL_OK;
+  }
+  sim_iwdg_period = (hiwdg->Init.Reload + 1U) * divider * 1000U / LSI_VALUE;
+  sim_iwdg_deadline = sim_millis() + sim_iwdg_period;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef *hiwdg)
+{
+  (void)hiwdg;
+  sim_iwdg_deadline = sim_millis() + sim_iwdg_period;
+  return HAL_OK;
+}
+
+void sim_iwdg_poll(void)
+{
+  if (sim_iwdg_period != 0U && (int32_t)(sim_millis() - sim_iwdg_deadline) > 0) {
+    fprintf(stderr, "sim: IWDG expired\n");
+    sim_reset(RCC_CSR_IWDGRSTF);
+  }
+}
@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * @file    sim_i2c.c
+  * @brief   Host build: I2C1 with nothing on the bus.
+  *
+  *          Every transfer ends in the error interrupt with
+  *          HAL_I2C_ERROR_AF, the way an address nobody acknowledges does,
+  *          so drivers take their no-device paths. Sensor behaviour is what
+  *          i2c_replay.h is for.
+  ******************************************************************************
+  */
+#include "main.h"
+#include "sim.h"
+
+static I2C_HandleTypeDef *sim_i2c_hi2c;
+
+__weak void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c)
+{
+  (void)hi2c;
+}
+
+__weak void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c)
+{
+  (void)hi2c;
+}
+
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+  (void)hi2c;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+  HAL_I2C_MspInit(hi2c);
+  sim_i2c_hi2c = hi2c;
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->State = HAL_I2C_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+  HAL_I2C_MspDeInit(hi2c);
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->State = HAL_I2C_STATE_RESET;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef *hi2c, uint32_t AnalogFilter)
+{
+  (void)hi2c;
+  (void)AnalogFilter;
+  return HAL_OK;
+}
+
+/**
+  * @brief  Address phase: NACKed once the interrupt comes round.
+  */
+static HAL_StatusTypeDef sim_i2c_start(I2C_HandleTypeDef *hi2c, HAL_I2C_StateTypeDef state)
+{
+  if (hi2c->State != HAL_I2C_STATE_READY) {
+    return HAL_BUSY;
+  }
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->State = state;
+  sim_irq_raise(SIM_IRQ_I2C1);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                       uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+                                       uint16_t Size)
+{
+  (void)DevAddress;
+  (void)MemAddress;
+  (void)MemAddSize;
+  (void)pData;
+  (void)Size;
+  return sim_i2c_start(hi2c, HAL_I2C_STATE_BUSY_TX);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress,
+                                      uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+                                      uint16_t Size)
+{
+  (void)DevAddress;
+  (void)MemAddress;
+  (void)MemAddSize;
+  (void)pData;
+  (void)Size;
+  return sim_i2c_start(hi2c, HAL_I2C_STATE_BUSY_RX);
+}
+
+uint32_t HAL_I2C_GetError(const I2C_HandleTypeDef *hi2c)
+{
+  return hi2c->ErrorCode;
+}
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+  (void)hi2c;
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+  (void)hi2c;
+}
+
+void sim_i2c_isr(void)
+{
+  I2C_HandleTypeDef *hi2c = sim_i2c_hi2c;
+
+  if (hi2c == NULL || (hi2c->State != HAL_I2C_STATE_BUSY_TX &&
+                       hi2c->State != HAL_I2C_STATE_BUSY_RX)) {
+    return;                             /* Reset underneath the transfer */
+  }
+  hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+  hi2c->State = HAL_I2C_STATE_READY;
+  HAL_I2C_ErrorCallback(hi2c);
+}
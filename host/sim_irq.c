@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    sim_irq.c
+  * @brief   Host build: simulated interrupts, delivered on their own thread.
+  ******************************************************************************
+  */
+#include "sim.h"
+#include "tx_api.h"
+#include "tx_initialize.h"
+#include "tx_thread.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SIM_IRQ_POLL_MS         5U      /* sim_iwdg_poll() interval */
+#define SIM_IRQ_EXC_BASE        16U     /* Exception number of IRQ 0 */
+
+static void (*const sim_irq_handlers[SIM_IRQS])(void) = {
+  [SIM_IRQ_USART2_TX] = sim_uart_tx_isr,
+  [SIM_IRQ_USART2_RX] = sim_uart_rx_isr,
+  [SIM_IRQ_ADC1] = sim_adc_isr,
+  [SIM_IRQ_I2C1] = sim_i2c_isr,
+  [SIM_IRQ_PVD] = sim_pvd_isr,
+};
+
+static pthread_t sim_irq_thread;
+static sem_t sim_irq_sem;
+static volatile uint32_t sim_irq_pending;
+static __thread uint32_t sim_exception;
+
+uint32_t sim_ipsr(void)
+{
+  return sim_exception;
+}
+
+uint32_t sim_sp(void)
+{
+  return (uint32_t)(uintptr_t)__builtin_frame_address(0);
+}
+
+/**
+  * @brief  Interrupts only flow once the scheduler runs, as on target where
+  *         the handlers would find the kernel objects missing before that.
+  */
+static int sim_kernel_started(void)
+{
+  return _tx_thread_system_state != TX_INITIALIZE_IN_PROGRESS;
+}
+
+void sim_disable_irq(void)
+{
+  if (sim_kernel_started()) {
+    (void)tx_interrupt_control(TX_INT_DISABLE);
+  }
+}
+
+void sim_enable_irq(void)
+{
+  if (sim_kernel_started()) {
+    (void)tx_interrupt_control(TX_INT_ENABLE);
+  }
+}
+
+void sim_irq_raise(sim_irq_t irq)
+{
+  if ((__atomic_fetch_or(&sim_irq_pending, 1UL << irq, __ATOMIC_SEQ_CST) & (1UL << irq)) == 0U) {
+    (void)sem_post(&sim_irq_sem);
+  }
+}
+
+void sim_nvic_pend(IRQn_Type irqn)
+{
+  if (irqn == PVD_PVM_IRQn) {
+    sim_irq_raise(SIM_IRQ_PVD);
+  }
+}
+
+/**
+  * @brief  Run one handler the way the port runs its timer interrupt.
+  */
+static void sim_irq_dispatch(sim_irq_t irq)
+{
+  _tx_thread_context_save();
+  sim_exception = SIM_IRQ_EXC_BASE + (uint32_t)irq;
+  sim_irq_handlers[irq]();
+  sim_exception = 0U;
+  _tx_thread_context_restore();
+}
+
+static void *sim_irq_main(void *arg)
+{
+  struct timespec until;
+  uint32_t pending;
+  uint32_t irq;
+  (void)arg;
+
+  for (;;) {
+    (void)clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += (long)SIM_IRQ_POLL_MS * 1000000L;
+    if (until.tv_nsec >= 1000000000L) {
+      until.tv_sec++;
+      until.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&sim_irq_sem, &until) != 0 && errno != ETIMEDOUT && errno != EINTR) {
+      perror("sim: interrupt thread");
+      exit(EXIT_FAILURE);
+    }
+    sim_iwdg_poll();
+    if (!sim_kernel_started()) {
+      continue;
+    }
+    pending = __atomic_exchange_n(&sim_irq_pending, 0U, __ATOMIC_SEQ_CST);
+    for (irq = 0; irq < SIM_IRQS; irq++) {
+      if (pending & (1UL << irq)) {
+        sim_irq_dispatch((sim_irq_t)irq);
+      }
+    }
+  }
+  return NULL;
+}
+
+void sim_irq_init(void)
+{
+  if (sem_init(&sim_irq_sem, 0, 0) != 0 ||
+      pthread_create(&sim_irq_thread, NULL, sim_irq_main, NULL) != 0) {
+    perror("sim: interrupt thread");
+    exit(EXIT_FAILURE);
+  }
+}
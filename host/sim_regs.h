@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    sim_regs.h
+  * @brief   Host build: the peripherals the firmware touches, as plain memory.
+  *
+  *          Included ahead of the HAL by the shadow stm32u0xx_hal_conf.h, so
+  *          every RCC->CR, GPIOA or __HAL_RCC_GPIOA_CLK_ENABLE() in the
+  *          firmware and in the HAL's inline code lands in sim_regs instead
+  *          of the bus. Nothing behind these registers reacts to a write on
+  *          its own: the simulated HAL functions (sim_*.c) play the
+  *          peripherals, and code that spins on a status bit needs a model
+  *          of its own (see clock_mock.h).
+  ******************************************************************************
+  */
+#ifndef SIM_REGS_H
+#define SIM_REGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32u0xx.h"
+
+#define SIM_DMA1_CHANNELS       7U
+
+typedef struct {
+  RCC_TypeDef rcc;
+  PWR_TypeDef pwr;
+  FLASH_TypeDef flash;
+  RTC_TypeDef rtc;
+  TAMP_TypeDef tamp;
+  EXTI_TypeDef exti;
+  DBGMCU_TypeDef dbgmcu;
+  IWDG_TypeDef iwdg;
+  SYSCFG_TypeDef syscfg;
+  USART_TypeDef usart2;
+  TIM_TypeDef tim2;
+  TIM_TypeDef tim6;
+  ADC_TypeDef adc1;
+  ADC_Common_TypeDef adc1_common;
+  I2C_TypeDef i2c1;
+  DMA_TypeDef dma1;
+  DMA_Channel_TypeDef dma1_channel[SIM_DMA1_CHANNELS];
+  GPIO_TypeDef gpioa;
+  GPIO_TypeDef gpiob;
+  GPIO_TypeDef gpioc;
+  GPIO_TypeDef gpiod;
+  GPIO_TypeDef gpiof;
+  SCB_Type scb;
+  SysTick_Type systick;
+  NVIC_Type nvic;
+} sim_regs_t;
+
+extern sim_regs_t sim_regs;
+
+#undef RCC
+#undef PWR
+#undef FLASH
+#undef RTC
+#undef TAMP
+#undef EXTI
+#undef DBGMCU
+#undef IWDG
+#undef SYSCFG
+#undef USART2
+#undef TIM2
+#undef TIM6
+#undef ADC1
+#undef ADC1_COMMON
+#undef I2C1
+#undef DMA1
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef DMA1_Channel6
+#undef DMA1_Channel7
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOF
+#undef SCB
+#undef SysTick
+#undef NVIC
+
+#define RCC                     (&sim_regs.rcc)
+#define PWR                     (&sim_regs.pwr)
+#define FLASH                   (&sim_regs.flash)
+#define RTC                     (&sim_regs.rtc)
+#define TAMP                    (&sim_regs.tamp)
+#define EXTI                    (&sim_regs.exti)
+#define DBGMCU                  (&sim_regs.dbgmcu)
+#define IWDG                    (&sim_regs.iwdg)
+#define SYSCFG                  (&sim_regs.syscfg)
+#define USART2                  (&sim_regs.usart2)
+#define TIM2                    (&sim_regs.tim2)
+#define TIM6                    (&sim_regs.tim6)
+#define ADC1                    (&sim_regs.adc1)
+#define ADC1_COMMON             (&sim_regs.adc1_common)
+#define I2C1                    (&sim_regs.i2c1)
+#define DMA1                    (&sim_regs.dma1)
+#define DMA1_Channel1           (&sim_regs.dma1_channel[0])
+#define DMA1_Channel2           (&sim_regs.dma1_channel[1])
+#define DMA1_Channel3           (&sim_regs.dma1_channel[2])
+#define DMA1_Channel4           (&sim_regs.dma1_channel[3])
+#define DMA1_Channel5           (&sim_regs.dma1_channel[4])
+#define DMA1_Channel6           (&sim_regs.dma1_channel[5])
+#define DMA1_Channel7           (&sim_regs.dma1_channel[6])
+#define GPIOA                   (&sim_regs.gpioa)
+#define GPIOB                   (&sim_regs.gpiob)
+#define GPIOC                   (&sim_regs.gpioc)
+#define GPIOD                   (&sim_regs.gpiod)
+#define GPIOF                   (&sim_regs.gpiof)
+#define SCB                     (&sim_regs.scb)
+#define SysTick                 (&sim_regs.systick)
+#define NVIC                    (&sim_regs.nvic)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_REGS_H */
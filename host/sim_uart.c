@@ -0,0 +1,316 @@
+/**
+  ******************************************************************************
+  * @file    sim_uart.c
+  * @brief   Host build: USART2 on stdin/stdout or on a pseudo-terminal.
+  *
+  *          DMA transmissions are written out from the TX interrupt, which
+  *          then completes them; the blocking transmit used before the
+  *          kernel starts writes directly. A reader thread collects input
+  *          and raises the RX interrupt, which fills armed Receive_IT
+  *          buffers. Input waits there while reception is not armed, up to
+  *          SIM_UART_RX_SIZE bytes; past that it overruns and is lost.
+  *
+  *          On a terminal, stdin is switched to byte-at-a-time input without
+  *          echo; Ctrl-C still ends the process. A pseudo-terminal is kept
+  *          open across a simulated reset so the same /dev/pts path stays
+  *          connected, and output to it is dropped while nobody reads, as a
+  *          UART's would be.
+  ******************************************************************************
+  */
+#define _GNU_SOURCE
+#include "main.h"
+#include "sim.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SIM_UART_RX_SIZE        256U    /* Power of two */
+
+static UART_HandleTypeDef *sim_uart_huart;
+static int sim_uart_in = STDIN_FILENO;
+static int sim_uart_out = STDOUT_FILENO;
+static int sim_uart_slave = -1;
+static struct termios sim_uart_saved;
+static int sim_uart_restore_tty;
+
+static uint8_t sim_uart_rx[SIM_UART_RX_SIZE];
+static volatile uint32_t sim_uart_rx_head;  /* Written by the reader thread */
+static volatile uint32_t sim_uart_rx_tail;  /* ... and by the RX interrupt */
+static uint32_t sim_uart_overruns;
+
+void sim_uart_restore(void)
+{
+  if (sim_uart_restore_tty) {
+    (void)tcsetattr(STDIN_FILENO, TCSAFLUSH, &sim_uart_saved);
+  }
+}
+
+static void sim_uart_signal(int sig)
+{
+  sim_uart_restore();
+  (void)signal(sig, SIG_DFL);
+  (void)raise(sig);
+}
+
+/**
+  * @brief  Byte-at-a-time console on the terminal we were started from.
+  */
+static void sim_uart_open_stdio(void)
+{
+  struct termios raw;
+
+  if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &sim_uart_saved) != 0) {
+    return;
+  }
+  raw = sim_uart_saved;
+  raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+  raw.c_iflag &= ~(tcflag_t)(ICRNL | IXON);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0) {
+    sim_uart_restore_tty = 1;
+    (void)atexit(sim_uart_restore);
+    (void)signal(SIGINT, sim_uart_signal);
+    (void)signal(SIGTERM, sim_uart_signal);
+  }
+}
+
+/**
+  * @brief  New pseudo-terminal, or the one a previous run handed down.
+  */
+static void sim_uart_open_pty(void)
+{
+  const char *inherited = getenv("PICOAPRS_UART_FD");
+  char fd_text[12];
+  struct termios raw;
+  const char *path;
+  int master;
+
+  if (inherited != NULL) {
+    master = atoi(inherited);
+  } else {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+      perror("sim: pty");
+      exit(EXIT_FAILURE);
+    }
+    (void)snprintf(fd_text, sizeof(fd_text), "%d", master);
+    (void)setenv("PICOAPRS_UART_FD", fd_text, 1);
+  }
+  path = ptsname(master);
+  if (path == NULL) {
+    perror("sim: pty");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Holding the slave open keeps the master readable with nobody attached */
+  sim_uart_slave = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (tcgetattr(master, &raw) == 0) {
+    cfmakeraw(&raw);
+    (void)tcsetattr(master, TCSANOW, &raw);
+  }
+  (void)fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  sim_uart_in = master;
+  sim_uart_out = master;
+  if (inherited == NULL) {
+    fprintf(stderr, "sim: USART2 on %s\n", path);
+  }
+}
+
+static void *sim_uart_reader(void *arg)
+{
+  struct pollfd pfd = { .fd = sim_uart_in, .events = POLLIN };
+  uint8_t buf[64];
+  ssize_t len;
+  ssize_t i;
+  (void)arg;
+
+  for (;;) {
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+      break;
+    }
+    len = read(sim_uart_in, buf, sizeof(buf));
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+      break;                            /* End of input: the line goes quiet */
+    }
+    for (i = 0; i < len; i++) {
+      if (sim_uart_rx_head - sim_uart_rx_tail < SIM_UART_RX_SIZE) {
+        sim_uart_rx[sim_uart_rx_head % SIM_UART_RX_SIZE] = buf[i];
+        __atomic_store_n(&sim_uart_rx_head, sim_uart_rx_head + 1U, __ATOMIC_RELEASE);
+      } else {
+        sim_uart_overruns++;
+      }
+    }
+    if (len > 0) {
+      sim_irq_raise(SIM_IRQ_USART2_RX);
+    }
+  }
+  return NULL;
+}
+
+void sim_uart_init(void)
+{
+  pthread_t reader;
+  const char *mode = getenv("PICOAPRS_UART");
+
+  if (mode != NULL && strcmp(mode, "pty") == 0) {
+    sim_uart_open_pty();
+  } else {
+    sim_uart_open_stdio();
+  }
+  if (pthread_create(&reader, NULL, sim_uart_reader, NULL) != 0) {
+    perror("sim: USART2 reader");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+  * @brief  Write it all; on a pseudo-terminal nobody reads, drop the rest.
+  */
+static void sim_uart_write(const uint8_t *data, uint32_t len)
+{
+  ssize_t n;
+
+  while (len > 0U) {
+    n = write(sim_uart_out, data, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += n;
+    len -= (uint32_t)n;
+  }
+}
+
+__weak void HAL_UART_MspInit(UART_HandleTypeDef *huart)
+{
+  (void)huart;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  (void)huart;
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  (void)huart;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+  if (huart->Instance != USART2) {
+    return HAL_ERROR;
+  }
+  HAL_UART_MspInit(huart);
+  sim_uart_huart = huart;
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetTxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold)
+{
+  (void)huart;
+  (void)Threshold;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetRxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold)
+{
+  (void)huart;
+  (void)Threshold;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_DisableFifoMode(UART_HandleTypeDef *huart)
+{
+  (void)huart;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData,
+                                    uint16_t Size, uint32_t Timeout)
+{
+  (void)Timeout;
+  if (huart->gState != HAL_UART_STATE_READY) {
+    return HAL_BUSY;
+  }
+  sim_uart_write(pData, Size);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData,
+                                        uint16_t Size)
+{
+  if (huart->gState != HAL_UART_STATE_READY) {
+    return HAL_BUSY;
+  }
+  huart->pTxBuffPtr = pData;
+  huart->TxXferSize = Size;
+  huart->TxXferCount = Size;
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+  sim_irq_raise(SIM_IRQ_USART2_TX);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+  huart->TxXferCount = 0U;
+  huart->gState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  if (huart->RxState != HAL_UART_STATE_READY) {
+    return HAL_BUSY;
+  }
+  huart->pRxBuffPtr = pData;
+  huart->RxXferSize = Size;
+  huart->RxXferCount = Size;
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+  if (__atomic_load_n(&sim_uart_rx_head, __ATOMIC_ACQUIRE) != sim_uart_rx_tail) {
+    sim_irq_raise(SIM_IRQ_USART2_RX);
+  }
+  return HAL_OK;
+}
+
+void sim_uart_tx_isr(void)
+{
+  UART_HandleTypeDef *huart = sim_uart_huart;
+
+  if (huart == NULL || huart->gState != HAL_UART_STATE_BUSY_TX) {
+    return;                             /* Aborted */
+  }
+  sim_uart_write(huart->pTxBuffPtr, huart->TxXferCount);
+  huart->TxXferCount = 0U;
+  huart->gState = HAL_UART_STATE_READY;
+  HAL_UART_TxCpltCallback(huart);
+}
+
+void sim_uart_rx_isr(void)
+{
+  UART_HandleTypeDef *huart = sim_uart_huart;
+
+  while (huart != NULL && huart->RxState == HAL_UART_STATE_BUSY_RX &&
+         sim_uart_rx_tail != __atomic_load_n(&sim_uart_rx_head, __ATOMIC_ACQUIRE)) {
+    *huart->pRxBuffPtr++ = sim_uart_rx[sim_uart_rx_tail % SIM_UART_RX_SIZE];
+    sim_uart_rx_tail++;
+    if (--huart->RxXferCount == 0U) {
+      huart->RxState = HAL_UART_STATE_READY;
+      HAL_UART_RxCpltCallback(huart);
+    }
+  }
+}
@@ -0,0 +1,21 @@
+/**
+  ******************************************************************************
+  * @file    stm32u0xx_hal_conf.h
+  * @brief   Host build: shadows CubeMX/Inc/stm32u0xx_hal_conf.h.
+  *
+  *          host/ comes first on the include path, so stm32u0xx_hal.h
+  *          includes this. The peripherals are pointed at the simulated
+  *          registers before the real configuration brings in the HAL
+  *          headers, and the core intrinsics and factory values after.
+  ******************************************************************************
+  */
+#ifndef HOST_STM32U0XX_HAL_CONF_H
+#define HOST_STM32U0XX_HAL_CONF_H
+
+#pragma GCC system_header
+
+#include "sim_regs.h"
+#include_next "stm32u0xx_hal_conf.h"
+#include "sim.h"
+
+#endif /* HOST_STM32U0XX_HAL_CONF_H */
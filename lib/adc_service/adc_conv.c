@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    adc_conv.c
+  * @brief   Fixed-point conversion of oversampled ADC readings.
+  ******************************************************************************
+  */
+#include "adc_conv.h"
+
+int adc_conv_cal_valid(const adc_cal_t *cal)
+{
+  return cal->vrefint != 0U && cal->vrefint != 0xFFFFU &&
+         cal->ts_cal1 != 0U && cal->ts_cal2 != 0xFFFFU && cal->ts_cal2 > cal->ts_cal1;
+}
+
+uint32_t adc_conv_vdda_mv(const adc_cal_t *cal, uint32_t vrefint_raw)
+{
+  /* VREFINT read cal counts at 3.0 V, so VDDA scales inversely with it.
+   * 3000 * 4095 * 16 stays well inside 32 bits. */
+  uint32_t num = ADC_CONV_CAL_VDDA_MV * ((uint32_t)cal->vrefint << ADC_CONV_OVS_BITS);
+
+  if (vrefint_raw == 0U) {
+    return 0U;
+  }
+  return (num + vrefint_raw / 2U) / vrefint_raw;
+}
+
+uint32_t adc_conv_mv(uint32_t raw, uint32_t vdda_mv)
+{
+  /* 65520 * 3600 < 2^32 */
+  return (raw * vdda_mv + ADC_CONV_FULL_SCALE / 2U) / ADC_CONV_FULL_SCALE;
+}
+
+uint32_t adc_conv_divider_mv(uint32_t raw, uint32_t vdda_mv, uint32_t r_top,
+                             uint32_t r_bottom)
+{
+  uint32_t sum = r_top + r_bottom;
+
+  if (r_bottom == 0U) {
+    return 0U;
+  }
+  return (adc_conv_mv(raw, vdda_mv) * sum + r_bottom / 2U) / r_bottom;
+}
+
+int32_t adc_conv_temp_cdeg(const adc_cal_t *cal, uint32_t ts_raw, uint32_t vdda_mv)
+{
+  int32_t ts;
+  int32_t num;
+  int32_t cal1 = (int32_t)((uint32_t)cal->ts_cal1 << ADC_CONV_OVS_BITS);
+  int32_t span = (int32_t)((uint32_t)(cal->ts_cal2 - cal->ts_cal1) << ADC_CONV_OVS_BITS);
+
+  if (span <= 0) {
+    return 0;
+  }
+  /* The reading as it would be at the calibration VDDA */
+  ts = (int32_t)((ts_raw * vdda_mv + ADC_CONV_CAL_VDDA_MV / 2U) / ADC_CONV_CAL_VDDA_MV);
+  /* |ts - cal1| < 2^17, times 10000 stays inside 31 bits */
+  num = (ts - cal1) * (ADC_CONV_TS_CAL2_CDEG - ADC_CONV_TS_CAL1_CDEG);
+  num += (num < 0) ? -(span / 2) : span / 2;
+  return ADC_CONV_TS_CAL1_CDEG + num / span;
+}
+
+int32_t adc_filter_update(adc_filter_t *filter, int32_t sample, uint32_t shift)
+{
+  if (!filter->primed) {
+    filter->acc = sample * (1L << shift);
+    filter->primed = 1U;
+  } else {
+    filter->acc += sample - (filter->acc >> shift);
+  }
+  return filter->acc >> shift;
+}
@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * @file    adc_conv.h
+  * @brief   Fixed-point conversion of oversampled ADC readings.
+  *
+  *          Raw values are 16-bit: 12-bit conversions oversampled and shifted
+  *          so that full scale is 4095 << ADC_CONV_OVS_BITS. Factory values
+  *          from system memory are 12-bit counts taken at 3.0 V VDDA, and
+  *          every result here is integer millivolts or hundredths of a
+  *          degree, with no floating point and no 64-bit division.
+  *
+  *          Pure C, also builds on the host.
+  ******************************************************************************
+  */
+#ifndef ADC_CONV_H
+#define ADC_CONV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define ADC_CONV_OVS_BITS       4U
+#define ADC_CONV_FULL_SCALE     (4095UL << ADC_CONV_OVS_BITS)
+
+/* Conditions the factory values were taken at (VREFINT_CAL_VREF,
+ * TEMPSENSOR_CAL1_TEMP and TEMPSENSOR_CAL2_TEMP on the STM32U0) */
+#define ADC_CONV_CAL_VDDA_MV    3000U
+#define ADC_CONV_TS_CAL1_CDEG   3000
+#define ADC_CONV_TS_CAL2_CDEG   13000
+
+typedef struct {
+  uint16_t vrefint;             /*!< VREFINT_CAL */
+  uint16_t ts_cal1;             /*!< TS_CAL1, at ADC_CONV_TS_CAL1_CDEG */
+  uint16_t ts_cal2;             /*!< TS_CAL2, at ADC_CONV_TS_CAL2_CDEG */
+} adc_cal_t;
+
+/**
+  * @brief  First-order low-pass, y += (x - y) / 2^shift, kept with shift
+  *         extra fraction bits. The first sample initializes it.
+  */
+typedef struct {
+  int32_t acc;
+  uint8_t primed;
+} adc_filter_t;
+
+/**
+  * @brief  Whether calibration values look like they were programmed.
+  */
+int adc_conv_cal_valid(const adc_cal_t *cal);
+
+/**
+  * @brief  Actual VDDA from a VREFINT reading.
+  * @retval millivolts, 0 if the reading is 0
+  */
+uint32_t adc_conv_vdda_mv(const adc_cal_t *cal, uint32_t vrefint_raw);
+
+/**
+  * @brief  Voltage at an ADC input.
+  * @retval millivolts
+  */
+uint32_t adc_conv_mv(uint32_t raw, uint32_t vdda_mv);
+
+/**
+  * @brief  Voltage ahead of a resistor divider.
+  * @param  r_top: resistor to the source, r_bottom: resistor to ground. Any
+  *         unit, as long as their sum stays below 1000000
+  * @retval millivolts
+  */
+uint32_t adc_conv_divider_mv(uint32_t raw, uint32_t vdda_mv, uint32_t r_top,
+                             uint32_t r_bottom);
+
+/**
+  * @brief  Die temperature from the sensor reading, interpolated between
+  *         the two factory points after scaling the reading to 3.0 V.
+  * @retval hundredths of a degree Celsius
+  */
+int32_t adc_conv_temp_cdeg(const adc_cal_t *cal, uint32_t ts_raw, uint32_t vdda_mv);
+
+/**
+  * @brief  Feed one sample into a filter.
+  * @retval the filtered value
+  */
+int32_t adc_filter_update(adc_filter_t *filter, int32_t sample, uint32_t shift);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_CONV_H */
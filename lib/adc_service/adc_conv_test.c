@@ -0,0 +1,112 @@
+/**
+  ******************************************************************************
+  * @file    adc_conv_test.c
+  * @brief   Host build: adc_conv against readings worked out from the
+  *          datasheet's typical values.
+  *
+  *          The factory values are the ones a typical part would carry:
+  *          VREFINT 1.212 V and the sensor's 0.76 V at 30 C with 2.5 mV/C,
+  *          each as a 12-bit count at 3.0 V. The readings are those values
+  *          seen at other supplies and temperatures, oversampled to 16 bits:
+  *            adc_conv_test
+  *          The exit status is 0 if every result is within its tolerance.
+  ******************************************************************************
+  */
+#include "adc_conv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* 1.212 / 3.0 * 4095, 0.76 / 3.0 * 4095 and 1.01 / 3.0 * 4095 */
+static const adc_cal_t adc_conv_test_cal = { 1654U, 1037U, 1379U };
+
+static int adc_conv_test_failed;
+
+/* The 16-bit reading of a voltage given in 12-bit counts at 3.0 V, at vdda_mv */
+static uint32_t adc_conv_test_raw(uint32_t counts_at_cal, uint32_t vdda_mv)
+{
+  return ((counts_at_cal << ADC_CONV_OVS_BITS) * ADC_CONV_CAL_VDDA_MV + vdda_mv / 2U) / vdda_mv;
+}
+
+static void adc_conv_test_expect(const char *what, long got, long want, long tolerance)
+{
+  int ok = labs(got - want) <= tolerance;
+
+  printf("  %-34s %7ld  want %7ld +/- %ld  %s\n", what, got, want, tolerance, ok ? "ok" : "FAIL");
+  adc_conv_test_failed += !ok;
+}
+
+int main(void)
+{
+  const adc_cal_t *cal = &adc_conv_test_cal;
+  adc_cal_t bad;
+  adc_filter_t filter = { 0, 0U };
+  int32_t out = 0;
+  int i;
+
+  /* VDDA from VREFINT: exact at the calibration supply, a millivolt elsewhere */
+  adc_conv_test_expect("vdda at VREFINT_CAL",
+                       (long)adc_conv_vdda_mv(cal, (uint32_t)cal->vrefint << ADC_CONV_OVS_BITS),
+                       3000L, 0L);
+  adc_conv_test_expect("vdda 3.3 V", (long)adc_conv_vdda_mv(cal, adc_conv_test_raw(1654U, 3300U)),
+                       3300L, 1L);
+  adc_conv_test_expect("vdda 1.8 V", (long)adc_conv_vdda_mv(cal, adc_conv_test_raw(1654U, 1800U)),
+                       1800L, 1L);
+  adc_conv_test_expect("vdda 3.6 V", (long)adc_conv_vdda_mv(cal, adc_conv_test_raw(1654U, 3600U)),
+                       3600L, 1L);
+  adc_conv_test_expect("vdda, no reading", (long)adc_conv_vdda_mv(cal, 0U), 0L, 0L);
+
+  /* Input voltages */
+  adc_conv_test_expect("full scale at 3.3 V", (long)adc_conv_mv(ADC_CONV_FULL_SCALE, 3300U),
+                       3300L, 0L);
+  adc_conv_test_expect("half scale at 3.3 V", (long)adc_conv_mv(ADC_CONV_FULL_SCALE / 2U, 3300U),
+                       1650L, 1L);
+  /* 1.0 V and 1.599 V are 1365 and 2182 counts at 3.0 V */
+  adc_conv_test_expect("VBAT/3 of 3.0 V at 3.3 V",
+                       (long)adc_conv_divider_mv(adc_conv_test_raw(1365U, 3300U), 3300U, 2U, 1U),
+                       3000L, 4L);
+  adc_conv_test_expect("solar 5.0 V, 100k/47k, at 3.0 V",
+                       (long)adc_conv_divider_mv(adc_conv_test_raw(2182U, 3000U), 3000U, 100U, 47U),
+                       5000L, 4L);
+
+  /* Die temperature: exact at the factory points, then interpolated and
+   * extrapolated along 2.5 mV/C */
+  adc_conv_test_expect("TS_CAL1 at 3.0 V, cdeg",
+                       adc_conv_temp_cdeg(cal, (uint32_t)cal->ts_cal1 << ADC_CONV_OVS_BITS, 3000U),
+                       3000L, 0L);
+  adc_conv_test_expect("TS_CAL2 at 3.0 V, cdeg",
+                       adc_conv_temp_cdeg(cal, (uint32_t)cal->ts_cal2 << ADC_CONV_OVS_BITS, 3000U),
+                       13000L, 0L);
+  adc_conv_test_expect("80 C at 3.0 V, cdeg",
+                       adc_conv_temp_cdeg(cal, 1208U << ADC_CONV_OVS_BITS, 3000U), 8000L, 0L);
+  adc_conv_test_expect("-20 C at 3.0 V, cdeg",
+                       adc_conv_temp_cdeg(cal, 866U << ADC_CONV_OVS_BITS, 3000U), -2000L, 1L);
+  adc_conv_test_expect("30 C at 3.3 V, cdeg",
+                       adc_conv_temp_cdeg(cal, adc_conv_test_raw(1037U, 3300U), 3300U), 3000L, 5L);
+  /* 0.585 V, 798.5 counts at 3.0 V, so -39.88 C from the count */
+  adc_conv_test_expect("-40 C at 2.2 V, cdeg",
+                       adc_conv_temp_cdeg(cal, adc_conv_test_raw(798U, 2200U), 2200U), -3988L, 10L);
+
+  /* Calibration values that were never programmed */
+  bad = *cal;
+  bad.vrefint = 0xFFFFU;
+  adc_conv_test_expect("typical cal valid", adc_conv_cal_valid(cal), 1L, 0L);
+  adc_conv_test_expect("erased VREFINT_CAL invalid", adc_conv_cal_valid(&bad), 0L, 0L);
+  bad = *cal;
+  bad.ts_cal2 = bad.ts_cal1;
+  adc_conv_test_expect("TS_CAL2 = TS_CAL1 invalid", adc_conv_cal_valid(&bad), 0L, 0L);
+  adc_conv_test_expect("temperature, no span", adc_conv_temp_cdeg(&bad, 20000U, 3000U), 0L, 0L);
+
+  /* Filter: starts at the first sample, settles on a step without overshoot */
+  adc_conv_test_expect("filter first sample", adc_filter_update(&filter, 3000, 3U), 3000L, 0L);
+  for (i = 0; i < 64; i++) {
+    out = adc_filter_update(&filter, 3300, 3U);
+    if (out > 3300) {
+      break;
+    }
+  }
+  adc_conv_test_expect("filter after 64 steps to 3300", out, 3300L, 8L);
+
+  printf("  %-34s %s\n", "adc_conv", (adc_conv_test_failed == 0) ? "ok" : "FAIL");
+  return (adc_conv_test_failed == 0) ? 0 : 1;
+}
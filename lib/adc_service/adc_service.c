@@ -0,0 +1,314 @@
+/**
+  ******************************************************************************
+  * @file    adc_service.c
+  * @brief   Supply voltage and die temperature sampling.
+  ******************************************************************************
+  */
+#include "adc_service.h"
+#include "adc_conv.h"
+#include "main.h"
+#include "clock.h"
+#include "power.h"
+#include "console.h"
+#include "dlog.h"
+#include "sections.h"
+#include "watchdog.h"
+
+#include <stdio.h>
+
+#define ADC_SERVICE_PATHS       (LL_ADC_PATH_INTERNAL_VREFINT | LL_ADC_PATH_INTERNAL_TEMPSENSOR | \
+                                 LL_ADC_PATH_INTERNAL_VBAT)
+
+/* Scan order, which is also the order of adc_service_raw[] */
+enum {
+  ADC_SERVICE_VREFINT,
+  ADC_SERVICE_TEMP,
+  ADC_SERVICE_VBAT,
+  ADC_SERVICE_SOLAR,
+  ADC_SERVICE_CHANNELS
+};
+
+static const uint32_t adc_service_channels[ADC_SERVICE_CHANNELS] = {
+  ADC_CHANNEL_VREFINT,
+  ADC_CHANNEL_TEMPSENSOR,
+  ADC_CHANNEL_VBAT,
+  ADC_CHANNEL_0,
+};
+
+static const uint32_t adc_service_ranks[ADC_SERVICE_CHANNELS] = {
+  ADC_REGULAR_RANK_1,
+  ADC_REGULAR_RANK_2,
+  ADC_REGULAR_RANK_3,
+  ADC_REGULAR_RANK_4,
+};
+
+ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
+
+static TX_THREAD adc_service_thread;
+static TX_SEMAPHORE adc_service_done;
+static watchdog_handle_t adc_service_wdg;
+static adc_cal_t adc_service_cal;
+static volatile uint16_t adc_service_raw[ADC_SERVICE_CHANNELS] DMA_BUFFER;
+static volatile uint8_t adc_service_error;
+static adc_filter_t adc_service_filters[ADC_SERVICE_CHANNELS];
+static adc_readings_t adc_service_readings;
+
+static void adc_service_thread_entry(ULONG thread_input);
+
+UINT adc_service_init(TX_BYTE_POOL *byte_pool)
+{
+  CHAR *pointer;
+  UINT ret;
+
+  ret = tx_semaphore_create(&adc_service_done, "ADC Done", 0);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_byte_allocate(byte_pool, (VOID **)&pointer, ADC_SERVICE_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_thread_create(&adc_service_thread, "ADC", adc_service_thread_entry, 0,
+                         pointer, ADC_SERVICE_THREAD_STACK_SIZE,
+                         ADC_SERVICE_THREAD_PRIORITY, ADC_SERVICE_THREAD_PRIORITY,
+                         TX_NO_TIME_SLICE, TX_AUTO_START);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  adc_service_wdg = watchdog_register(&adc_service_thread,
+                                      ADC_SERVICE_PERIOD + 2U * ADC_SERVICE_SCAN_TIMEOUT);
+  return (adc_service_wdg != NULL) ? TX_SUCCESS : TX_NO_INSTANCE;
+}
+
+int adc_service_get(adc_readings_t *readings)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  *readings = adc_service_readings;
+  TX_RESTORE
+  return readings->time != 0U;
+}
+
+void HAL_ADC_MspInit(ADC_HandleTypeDef *adcHandle)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  if (adcHandle->Instance == ADC1) {
+    __HAL_RCC_ADC_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /* PA0 ------> ADC1_IN0 */
+    GPIO_InitStruct.Pin = GPIO_PIN_0;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    hdma_adc1.Instance = DMA1_Channel2;
+    hdma_adc1.Init.Request = DMA_REQUEST_ADC;
+    hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc1.Init.Mode = DMA_NORMAL;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) {
+      Error_Handler();
+    }
+    __HAL_LINKDMA(adcHandle, DMA_Handle, hdma_adc1);
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+  }
+}
+
+/**
+  * @brief  DMA1 channels 2 and 3 share this vector. Channel 3 is unused; a
+  *         driver that takes it must be dispatched from here too.
+  */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_adc1);
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc == &hadc1) {
+    (void)tx_semaphore_put(&adc_service_done);
+  }
+}
+
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc == &hadc1) {
+    adc_service_error = 1U;
+    (void)tx_semaphore_put(&adc_service_done);
+  }
+}
+
+/**
+  * @brief  Configure ADC1 for one oversampled, DMA-driven scan per start,
+  *         calibrate it, and read the factory values.
+  */
+static void adc_service_start(void)
+{
+  ADC_ChannelConfTypeDef sConfig = {0};
+  uint32_t i;
+
+  hadc1.Instance = ADC1;
+  hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV2;
+  hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+  hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+  hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+  hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+  hadc1.Init.LowPowerAutoWait = DISABLE;
+  hadc1.Init.LowPowerAutoPowerOff = DISABLE;
+  hadc1.Init.ContinuousConvMode = DISABLE;
+  hadc1.Init.NbrOfConversion = ADC_SERVICE_CHANNELS;
+  hadc1.Init.DiscontinuousConvMode = DISABLE;
+  hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+  hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+  hadc1.Init.DMAContinuousRequests = DISABLE;
+  hadc1.Init.Overrun = ADC_OVR_DATA_PRESERVED;
+  /* The temperature sensor needs at least 5 us: 160.5 cycles at 8 MHz */
+  hadc1.Init.SamplingTimeCommon1 = ADC_SAMPLETIME_160CYCLES_5;
+  hadc1.Init.SamplingTimeCommon2 = ADC_SAMPLETIME_160CYCLES_5;
+  /* 64 conversions summed are 18 bits, shifted down to 16 */
+  hadc1.Init.OversamplingMode = ENABLE;
+  hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_64;
+  hadc1.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_2;
+  hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+  hadc1.Init.TriggerFrequencyMode = ADC_TRIGGER_FREQ_LOW;
+  if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+    Error_Handler();
+  }
+
+  for (i = 0; i < ADC_SERVICE_CHANNELS; i++) {
+    sConfig.Channel = adc_service_channels[i];
+    sConfig.Rank = adc_service_ranks[i];
+    sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+    if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+      Error_Handler();
+    }
+  }
+  if (HAL_ADCEx_Calibration_Start(&hadc1) != HAL_OK) {
+    Error_Handler();
+  }
+  /* ConfigChannel turned the internal paths on; they stay off between scans */
+  LL_ADC_SetCommonPathInternalCh(__LL_ADC_COMMON_INSTANCE(ADC1), LL_ADC_PATH_INTERNAL_NONE);
+
+  adc_service_cal.vrefint = *VREFINT_CAL_ADDR;
+  adc_service_cal.ts_cal1 = *TEMPSENSOR_CAL1_ADDR;
+  adc_service_cal.ts_cal2 = *TEMPSENSOR_CAL2_ADDR;
+  if (!adc_conv_cal_valid(&adc_service_cal)) {
+    DLOG_WARN("adc: factory calibration missing, readings will be off");
+  }
+}
+
+/**
+  * @brief  Run one scan into adc_service_raw[].
+  * @retval TX_SUCCESS, or an error if the DMA did not complete
+  */
+static UINT adc_service_scan(void)
+{
+  UINT ret;
+
+  /* The ADC is disabled here, as changing the paths requires */
+  LL_ADC_SetCommonPathInternalCh(__LL_ADC_COMMON_INSTANCE(ADC1), ADC_SERVICE_PATHS);
+  /* One tick covers the sensor and reference start-up (120 us) */
+  tx_thread_sleep(1);
+
+  adc_service_error = 0U;
+  if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *)adc_service_raw, ADC_SERVICE_CHANNELS) != HAL_OK) {
+    ret = TX_NOT_DONE;
+  } else {
+    ret = tx_semaphore_get(&adc_service_done, ADC_SERVICE_SCAN_TIMEOUT);
+    if (ret == TX_SUCCESS && adc_service_error) {
+      ret = TX_NOT_DONE;
+    }
+  }
+  (void)HAL_ADC_Stop_DMA(&hadc1);
+  LL_ADC_SetCommonPathInternalCh(__LL_ADC_COMMON_INSTANCE(ADC1), LL_ADC_PATH_INTERNAL_NONE);
+  /* A late completion must not satisfy the next scan */
+  while (tx_semaphore_get(&adc_service_done, TX_NO_WAIT) == TX_SUCCESS) {
+  }
+  return ret;
+}
+
+/**
+  * @brief  Convert and filter the latest scan, then publish it.
+  */
+static void adc_service_publish(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+  adc_readings_t r;
+  adc_filter_t *f = adc_service_filters;
+  uint32_t vdda = adc_conv_vdda_mv(&adc_service_cal, adc_service_raw[ADC_SERVICE_VREFINT]);
+
+  vdda = (uint32_t)adc_filter_update(&f[ADC_SERVICE_VREFINT], (int32_t)vdda,
+                                     ADC_SERVICE_FILTER_SHIFT);
+  r.vdda_mv = (uint16_t)vdda;
+  r.temp_cdeg = (int16_t)adc_filter_update(&f[ADC_SERVICE_TEMP],
+      adc_conv_temp_cdeg(&adc_service_cal, adc_service_raw[ADC_SERVICE_TEMP], vdda),
+      ADC_SERVICE_FILTER_SHIFT);
+  r.vbat_mv = (uint16_t)adc_filter_update(&f[ADC_SERVICE_VBAT],
+      (int32_t)(3U * adc_conv_mv(adc_service_raw[ADC_SERVICE_VBAT], vdda)),
+      ADC_SERVICE_FILTER_SHIFT);
+  r.solar_mv = (uint16_t)adc_filter_update(&f[ADC_SERVICE_SOLAR],
+      (int32_t)adc_conv_divider_mv(adc_service_raw[ADC_SERVICE_SOLAR], vdda,
+                                   ADC_SERVICE_SOLAR_R_TOP, ADC_SERVICE_SOLAR_R_BOTTOM),
+      ADC_SERVICE_FILTER_SHIFT);
+  r.time = tx_time_get() | 1U;      /* Never 0, which means no reading */
+
+  TX_DISABLE
+  adc_service_readings = r;
+  TX_RESTORE
+}
+
+static void adc_service_thread_entry(ULONG thread_input)
+{
+  UINT ret;
+  (void)thread_input;
+
+  adc_service_start();
+
+  for (;;) {
+    watchdog_checkin(adc_service_wdg);
+    /* PCLK/2 clocks the ADC; the sampling times assume 8 MHz, and the DMA
+     * has to keep running while the thread waits */
+    clock_request(CLOCK_LEVEL_HIGH);
+    power_stop_inhibit();
+    ret = adc_service_scan();
+    power_stop_allow();
+    clock_release(CLOCK_LEVEL_HIGH);
+    if (ret == TX_SUCCESS) {
+      adc_service_publish();
+    } else {
+      DLOG_WARN("adc: scan failed, error 0x%x", (uint32_t)HAL_ADC_GetError(&hadc1));
+    }
+    tx_thread_sleep(ADC_SERVICE_PERIOD);
+  }
+}
+
+static int console_cmd_adc(int argc, char *argv[])
+{
+  adc_readings_t r;
+  int32_t t;
+  (void)argc;
+  (void)argv;
+
+  if (!adc_service_get(&r)) {
+    printf("  no readings yet\n");
+    return 0;
+  }
+  t = r.temp_cdeg;
+  printf("  vdda %u mV, vbat %u mV, solar %u mV, die %s%ld.%02ld C, at tick %lu\n",
+         r.vdda_mv, r.vbat_mv, r.solar_mv, (t < 0) ? "-" : "",
+         (long)((t < 0) ? -t : t) / 100L, (long)((t < 0) ? -t : t) % 100L,
+         (unsigned long)r.time);
+  return 0;
+}
+
+CONSOLE_COMMAND(adc, "show supply voltages and die temperature", console_cmd_adc, NULL);
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    adc_service.h
+  * @brief   Supply voltage and die temperature sampling.
+  *
+  *          A low-priority thread wakes every ADC_SERVICE_PERIOD, powers the
+  *          internal measurement paths, and has the DMA collect one scan of
+  *          VREFINT, the temperature sensor, VBAT/3 and the solar divider,
+  *          each oversampled 64x in hardware. The ADC and the paths are off
+  *          between scans. Readings are converted with the factory
+  *          calibration (adc_conv.c), low-pass filtered, and published for
+  *          adc_service_get().
+  ******************************************************************************
+  */
+#ifndef ADC_SERVICE_H
+#define ADC_SERVICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+#include <stdint.h>
+
+#define ADC_SERVICE_THREAD_STACK_SIZE   512U
+#define ADC_SERVICE_THREAD_PRIORITY     15U
+#define ADC_SERVICE_PERIOD              500U  /* ticks between scans */
+#define ADC_SERVICE_SCAN_TIMEOUT        10U   /* ticks, a scan takes ~6 ms */
+#define ADC_SERVICE_FILTER_SHIFT        2U    /* each scan moves 1/4 of the way */
+
+/* Solar panel divider into PA0 (ADC_IN0, A0 on the Nucleo header), kOhm */
+#define ADC_SERVICE_SOLAR_R_TOP         100U
+#define ADC_SERVICE_SOLAR_R_BOTTOM      47U
+
+typedef struct {
+  uint16_t vdda_mv;
+  uint16_t vbat_mv;
+  uint16_t solar_mv;
+  int16_t temp_cdeg;                /*!< Hundredths of a degree Celsius */
+  ULONG time;                       /*!< Tick of the latest scan */
+} adc_readings_t;
+
+/**
+  * @brief  Create the sampling thread. The ADC is calibrated when it first
+  *         runs.
+  * @param  byte_pool: pool for the thread stack
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT adc_service_init(TX_BYTE_POOL *byte_pool);
+
+/**
+  * @brief  Latest filtered readings.
+  * @retval 1 if readings was filled in, 0 before the first scan
+  */
+int adc_service_get(adc_readings_t *readings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_SERVICE_H */
@@ -0,0 +1,185 @@
+/**
+  ******************************************************************************
+  * @file    afsk.c
+  * @brief   Bell 202 AFSK modulator: NRZI line levels to 12-bit DAC samples.
+  ******************************************************************************
+  */
+#include "afsk.h"
+#include "ramfunc.h"
+
+#include <stddef.h>
+
+#define AFSK_STEP(hz)           ((uint32_t)(((uint64_t)(hz) << 32) / AFSK_SAMPLE_RATE))
+#define AFSK_STEP_MARK          AFSK_STEP(AFSK_MARK_HZ)
+#define AFSK_STEP_SPACE         AFSK_STEP(AFSK_SPACE_HZ)
+
+/* One cycle, 12 bits, 1900 counts of swing about the midpoint */
+static const uint16_t afsk_sine[256] = {
+  2048, 2095, 2141, 2188, 2234, 2281, 2327, 2373,
+  2419, 2464, 2510, 2555, 2600, 2644, 2688, 2732,
+  2775, 2818, 2860, 2902, 2944, 2985, 3025, 3064,
+  3104, 3142, 3180, 3217, 3253, 3289, 3324, 3358,
+  3392, 3424, 3456, 3487, 3517, 3546, 3574, 3601,
+  3628, 3653, 3678, 3701, 3724, 3745, 3766, 3785,
+  3803, 3821, 3837, 3852, 3866, 3879, 3891, 3902,
+  3911, 3920, 3927, 3934, 3939, 3943, 3946, 3947,
+  3948, 3947, 3946, 3943, 3939, 3934, 3927, 3920,
+  3911, 3902, 3891, 3879, 3866, 3852, 3837, 3821,
+  3803, 3785, 3766, 3745, 3724, 3701, 3678, 3653,
+  3628, 3601, 3574, 3546, 3517, 3487, 3456, 3424,
+  3392, 3358, 3324, 3289, 3253, 3217, 3180, 3142,
+  3104, 3064, 3025, 2985, 2944, 2902, 2860, 2818,
+  2775, 2732, 2688, 2644, 2600, 2555, 2510, 2464,
+  2419, 2373, 2327, 2281, 2234, 2188, 2141, 2095,
+  2048, 2001, 1955, 1908, 1862, 1815, 1769, 1723,
+  1677, 1632, 1586, 1541, 1496, 1452, 1408, 1364,
+  1321, 1278, 1236, 1194, 1152, 1111, 1071, 1032,
+   992,  954,  916,  879,  843,  807,  772,  738,
+   704,  672,  640,  609,  579,  550,  522,  495,
+   468,  443,  418,  395,  372,  351,  330,  311,
+   293,  275,  259,  244,  230,  217,  205,  194,
+   185,  176,  169,  162,  157,  153,  150,  149,
+   148,  149,  150,  153,  157,  162,  169,  176,
+   185,  194,  205,  217,  230,  244,  259,  275,
+   293,  311,  330,  351,  372,  395,  418,  443,
+   468,  495,  522,  550,  579,  609,  640,  672,
+   704,  738,  772,  807,  843,  879,  916,  954,
+   992, 1032, 1071, 1111, 1152, 1194, 1236, 1278,
+  1321, 1364, 1408, 1452, 1496, 1541, 1586, 1632,
+  1677, 1723, 1769, 1815, 1862, 1908, 1955, 2001,
+};
+
+static inline uint32_t afsk_step(uint32_t level)
+{
+  return (level != 0U) ? AFSK_STEP_MARK : AFSK_STEP_SPACE;
+}
+
+/* Called from afsk_modulate() in SRAM: always inlined, so no copy of it is
+ * left in flash for the per-bit path to call out to */
+static inline __attribute__((always_inline)) void afsk_render(uint16_t *out, uint32_t phase,
+                                                              uint32_t step)
+{
+  uint32_t i;
+
+  for (i = 0U; i < AFSK_SPB; i++) {
+    out[i] = afsk_sine[phase >> 24];
+    phase += step;
+  }
+}
+
+int afsk_init(afsk_t *afsk, uint16_t *table, uint32_t levels)
+{
+  uint32_t tone;
+  uint32_t k;
+
+  if (levels > 256U || (levels & (levels - 1U)) != 0U || (levels != 0U && table == NULL)) {
+    return -1;
+  }
+  afsk->phase = 0U;
+  afsk->levels = levels;
+  afsk->table = table;
+  afsk->shift = 32U;
+  if (levels == 0U) {
+    return 0;
+  }
+
+  for (k = levels; k > 1U; k >>= 1) {
+    afsk->shift--;
+  }
+  for (tone = 0U; tone < 2U; tone++) {
+    for (k = 0U; k < levels; k++) {
+      /* Level k starts k/levels of a cycle in; shifting by 32 is undefined */
+      afsk_render(&table[(tone * levels + k) * AFSK_SPB],
+                  (afsk->shift < 32U) ? k << afsk->shift : 0U, afsk_step(tone));
+    }
+  }
+  return 0;
+}
+
+RAMFUNC const uint16_t *afsk_block(afsk_t *afsk, uint32_t level)
+{
+  uint32_t tone = (level != 0U) ? 1U : 0U;
+  uint32_t levels = afsk->levels;
+  uint32_t k = 0U;
+
+  if (levels > 1U) {
+    /* Nearest rendered starting phase; rounding up past the last wraps to 0 */
+    k = ((afsk->phase + (1UL << (afsk->shift - 1U))) >> afsk->shift) & (levels - 1U);
+  }
+  afsk->phase += afsk_step(level) * AFSK_SPB;
+  return &afsk->table[(tone * levels + k) * AFSK_SPB];
+}
+
+RAMFUNC void afsk_modulate(afsk_t *afsk, const uint8_t *bits, uint32_t first, uint32_t nbits,
+                   uint16_t *out)
+{
+  uint32_t end = first + nbits;
+  const uint16_t *block;
+  uint32_t level;
+  uint32_t i;
+  uint32_t k;
+
+  for (i = first; i < end; i++) {
+    level = (bits[i >> 3] >> (i & 7U)) & 1U;
+    if (afsk->levels != 0U) {
+      /* Not memcpy(): newlib's is in flash. The empty asm stops -Os from
+       * turning the loop back into a call to it */
+      block = afsk_block(afsk, level);
+      for (k = 0U; k < AFSK_SPB; k++) {
+        out[k] = block[k];
+        __asm volatile("");
+      }
+    } else {
+      afsk_render(out, afsk->phase, afsk_step(level));
+      afsk->phase += afsk_step(level) * AFSK_SPB;
+    }
+    out += AFSK_SPB;
+  }
+}
+
+/**
+  * @brief  log2(x) in Q16, x > 0: integer part from the top bit, fraction
+  *         by repeated squaring of the Q15 mantissa.
+  */
+static int32_t afsk_log2_q16(uint64_t x)
+{
+  int32_t top = 63 - __builtin_clzll(x);
+  uint32_t m = (top >= 15) ? (uint32_t)(x >> (top - 15)) : (uint32_t)(x << (15 - top));
+  int32_t result = top << 16;
+  int32_t bit;
+
+  for (bit = 15; bit >= 0; bit--) {
+    m = (m * m) >> 15;
+    if (m >= 0x10000U) {
+      m >>= 1;
+      result |= 1 << bit;
+    }
+  }
+  return result;
+}
+
+void afsk_error_add(afsk_error_t *err, const uint16_t *a, const uint16_t *b, uint32_t n)
+{
+  int32_t d;
+  uint32_t i;
+
+  for (i = 0U; i < n; i++) {
+    d = (int32_t)a[i] - (int32_t)AFSK_DAC_MID;
+    err->signal += (uint32_t)(d * d);
+    d = (int32_t)b[i] - (int32_t)a[i];
+    err->error += (uint32_t)(d * d);
+  }
+}
+
+int32_t afsk_error_db10(const afsk_error_t *err)
+{
+  if (err->error == 0U) {
+    return INT32_MIN;
+  }
+  if (err->signal == 0U) {
+    return INT32_MAX;
+  }
+  /* 100 log10(x) = 30.103 log2(x) */
+  return (int32_t)(((int64_t)(afsk_log2_q16(err->error) - afsk_log2_q16(err->signal)) * 30103) /
+                   (1000 * 65536));
+}
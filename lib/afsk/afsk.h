@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    afsk.h
+  * @brief   Bell 202 AFSK modulator: NRZI line levels to 12-bit DAC samples.
+  *
+  *          1200 Bd, mark 1200 Hz for a high line level, space 2200 Hz for
+  *          a low one, AFSK_SPB samples per bit. The tone is phase
+  *          continuous across bits.
+  *
+  *          Two ways to produce a bit:
+  *            - exact: a 32-bit phase accumulator steps through a 256-entry
+  *              sine table, one lookup and add per sample;
+  *            - cached: the samples of a whole bit were rendered at init for
+  *              each tone and each of `levels` starting phases, so a bit is
+  *              one block: afsk_block() hands it out for a DMA descriptor,
+  *              afsk_modulate() copies it. The true phase is still tracked
+  *              and each bit starts from the nearest rendered one, so the
+  *              phase error stays under half a level and never builds up.
+  *          The cache costs afsk_table_bytes(levels) of RAM; how much
+  *          signal error each level count leaves is what the afsk console
+  *          command reports, next to the memory.
+  *
+  *          Pure C, also builds on the host.
+  ******************************************************************************
+  */
+#ifndef AFSK_H
+#define AFSK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define AFSK_BAUD               1200U
+#define AFSK_MARK_HZ            1200U
+#define AFSK_SPACE_HZ           2200U
+#define AFSK_SPB                16U                         /* Samples per bit */
+#define AFSK_SAMPLE_RATE        (AFSK_BAUD * AFSK_SPB)      /* 19.2 kHz */
+#define AFSK_DAC_MID            2048U
+
+/* Starting phases rendered per tone: a power of two, at most 256 */
+#define AFSK_PHASE_LEVELS       16U
+
+#define AFSK_TABLE_SAMPLES(levels) (2U * (levels) * AFSK_SPB)
+
+typedef struct {
+  uint32_t phase;                   /*!< True phase, 2^32 per cycle */
+  uint32_t levels;                  /*!< Rendered starting phases, 0: exact */
+  uint32_t shift;                   /*!< Phase bits below one level */
+  const uint16_t *table;            /*!< [tone][level][sample], space first */
+} afsk_t;
+
+typedef struct {
+  uint64_t signal;
+  uint64_t error;
+} afsk_error_t;
+
+/**
+  * @brief  Start at phase 0.
+  * @param  table: AFSK_TABLE_SAMPLES(levels) samples to render the cache
+  *         into, kept by reference; NULL with levels 0 for the exact mode
+  * @param  levels: power of two up to 256, or 0
+  * @retval 0 on success, -1 for a bad level count
+  */
+int afsk_init(afsk_t *afsk, uint16_t *table, uint32_t levels);
+
+/**
+  * @brief  Samples of the next bit, AFSK_SPB of them. Cached mode only.
+  * @param  level: line level, non-zero for mark
+  */
+const uint16_t *afsk_block(afsk_t *afsk, uint32_t level);
+
+/**
+  * @brief  Modulate nbits line levels, packed LSB first as ax25_enc_t
+  *         leaves them, starting at bit first.
+  * @param  out: nbits * AFSK_SPB samples
+  */
+void afsk_modulate(afsk_t *afsk, const uint8_t *bits, uint32_t first, uint32_t nbits,
+                   uint16_t *out);
+
+/**
+  * @brief  RAM a cache of levels starting phases takes.
+  */
+static inline uint32_t afsk_table_bytes(uint32_t levels)
+{
+  return AFSK_TABLE_SAMPLES(levels) * (uint32_t)sizeof(uint16_t);
+}
+
+/**
+  * @brief  Add samples to an error measurement: b's difference from the
+  *         reference a, against a's own energy about the DAC midpoint.
+  */
+void afsk_error_add(afsk_error_t *err, const uint16_t *a, const uint16_t *b, uint32_t n);
+
+/**
+  * @brief  Error energy relative to the signal, in tenths of a dB. By
+  *         Parseval this is also the error summed over the spectrum.
+  * @retval Below 0 for anything worth using; INT32_MIN when there was no
+  *         error at all
+  */
+int32_t afsk_error_db10(const afsk_error_t *err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AFSK_H */
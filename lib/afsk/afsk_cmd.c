@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file    afsk_cmd.c
+  * @brief   afsk console command: memory and signal error of the block
+  *          cache at each phase level count, against the exact modulator.
+  ******************************************************************************
+  */
+#include "afsk.h"
+#include "console.h"
+
+#include <stdio.h>
+
+#define AFSK_CMD_BITS           512U
+
+static uint16_t afsk_cmd_table[AFSK_TABLE_SAMPLES(AFSK_PHASE_LEVELS)];
+
+/**
+  * @brief  Error of a cache of levels phases over a pseudo-random stream.
+  */
+static int32_t afsk_cmd_measure(uint32_t levels)
+{
+  afsk_t exact;
+  afsk_t cached;
+  afsk_error_t err = { 0U, 0U };
+  uint16_t a[AFSK_SPB];
+  uint16_t b[AFSK_SPB];
+  uint16_t lfsr = 0xACE1U;
+  uint8_t bit;
+  uint32_t i;
+
+  (void)afsk_init(&exact, NULL, 0U);
+  (void)afsk_init(&cached, afsk_cmd_table, levels);
+  for (i = 0U; i < AFSK_CMD_BITS; i++) {
+    /* x^16 + x^14 + x^13 + x^11 + 1 */
+    bit = (uint8_t)((lfsr ^ (lfsr >> 2) ^ (lfsr >> 3) ^ (lfsr >> 5)) & 1U);
+    lfsr = (uint16_t)((lfsr >> 1) | ((uint32_t)bit << 15));
+    afsk_modulate(&exact, &bit, 0U, 1U, a);
+    afsk_modulate(&cached, &bit, 0U, 1U, b);
+    afsk_error_add(&err, a, b, AFSK_SPB);
+  }
+  return afsk_error_db10(&err);
+}
+
+static int console_cmd_afsk(int argc, char *argv[])
+{
+  char error[16];
+  uint32_t levels;
+  int32_t db10;
+  (void)argc;
+  (void)argv;
+
+  printf("  %6s %8s %10s\n", "levels", "table", "error");
+  for (levels = 1U; levels <= AFSK_PHASE_LEVELS; levels <<= 1) {
+    db10 = afsk_cmd_measure(levels);
+    if (db10 == INT32_MIN) {
+      (void)snprintf(error, sizeof(error), "none");
+    } else {
+      (void)snprintf(error, sizeof(error), "%s%ld.%ld dB", (db10 < 0) ? "-" : "",
+                     (long)((db10 < 0) ? -db10 : db10) / 10L,
+                     (long)((db10 < 0) ? -db10 : db10) % 10L);
+    }
+    printf("  %6lu %6lu B %10s\n", (unsigned long)levels,
+           (unsigned long)afsk_table_bytes(levels), error);
+  }
+  printf("  built with %u; 'bench afsk_exact' and 'bench afsk_cached' time 64 bits each way\n",
+         AFSK_PHASE_LEVELS);
+  return 0;
+}
+
+CONSOLE_COMMAND(afsk, "phase cache memory and error per level count", console_cmd_afsk, NULL);
@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    afsk_emph.c
+  * @brief   Optional pre-emphasis between the AFSK modulator and the DAC.
+  ******************************************************************************
+  */
+#include "afsk_emph.h"
+
+#include <string.h>
+
+/* DAC codes to q15 and back: 12 bits centred, times 4 stays inside the
+ * fast biquad's +-0.25 input range */
+#define AFSK_EMPH_GAIN_SHIFT    2U
+#define AFSK_DAC_MAX            4095
+
+/* Generated by tools/afsk_emph.py */
+static const afsk_emph_coeffs_t afsk_emph_curves[] = {
+  [AFSK_EMPH_FLAT] = { { 16384, 0, 0, 0, 0, 0 }, 1U },
+  [AFSK_EMPH_PREEMPH] = { { 27724, 0, -25863, 0, -3259, 0 }, 1U },
+};
+
+int afsk_emph_init(afsk_emph_t *emph, afsk_emph_mode_t mode, const afsk_emph_coeffs_t *custom)
+{
+  if (mode == AFSK_EMPH_CUSTOM) {
+    if (custom == NULL) {
+      return -1;
+    }
+    emph->coeffs = *custom;
+  } else {
+    emph->coeffs = afsk_emph_curves[mode];
+  }
+  arm_biquad_cascade_df1_init_q15(&emph->biquad, 1U, emph->coeffs.coeffs, emph->state,
+                                  (int8_t)emph->coeffs.post_shift);
+  return 0;
+}
+
+void afsk_emph_process(afsk_emph_t *emph, uint16_t *samples, uint32_t n)
+{
+  q15_t *q = (q15_t *)samples;
+  int32_t v;
+  uint32_t i;
+
+  for (i = 0U; i < n; i++) {
+    q[i] = (q15_t)(((int32_t)samples[i] - (int32_t)AFSK_DAC_MID) * (1 << AFSK_EMPH_GAIN_SHIFT));
+  }
+  arm_biquad_cascade_df1_fast_q15(&emph->biquad, q, q, n);
+  for (i = 0U; i < n; i++) {
+    v = ((int32_t)q[i] >> AFSK_EMPH_GAIN_SHIFT) + (int32_t)AFSK_DAC_MID;
+    samples[i] = (uint16_t)((v < 0) ? 0 : (v > AFSK_DAC_MAX) ? AFSK_DAC_MAX : v);
+  }
+}
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    afsk_emph.h
+  * @brief   Optional pre-emphasis between the AFSK modulator and the DAC.
+  *
+  *          FM radios de-emphasize their audio input, so 2200 Hz reaches
+  *          the air weaker than 1200 Hz ("twist") and ground stations
+  *          decode fewer frames. One q15 DF1 biquad, run with CMSIS-DSP's
+  *          arm_biquad_cascade_df1_fast_q15(), tilts the tones back.
+  *
+  *          afsk_emph_process() filters a DMA half-buffer in place: DAC
+  *          codes are centred and scaled into the [-0.25, 0.25) the fast
+  *          variant needs, filtered, and mapped back, clamped to 12 bits.
+  *          Filter state carries over between calls, so consecutive
+  *          half-buffers make one continuous signal.
+  *
+  *          Curves are scaled so the louder tone keeps full level:
+  *            AFSK_EMPH_FLAT     identity, for comparison and timing;
+  *            AFSK_EMPH_PREEMPH  750 us, 6 dB/octave: 1200 Hz 5.3 dB down;
+  *            AFSK_EMPH_CUSTOM   caller's coefficients, e.g. a twist from
+  *                               tools/afsk_emph.py --twist <dB>.
+  *          The `bench afsk_emph` case filters one half-buffer and prints
+  *          the refill window it has to fit in as its budget.
+  ******************************************************************************
+  */
+#ifndef AFSK_EMPH_H
+#define AFSK_EMPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arm_math.h"
+#include "afsk.h"
+
+#define AFSK_DAC_HALF           128U    /* Samples per DMA half-buffer, 8 bits */
+
+/* Time a half-buffer plays for, i.e. the time to refill the other one */
+#define AFSK_DAC_HALF_US        (AFSK_DAC_HALF * 1000000UL / AFSK_SAMPLE_RATE)
+
+typedef enum {
+  AFSK_EMPH_FLAT = 0,
+  AFSK_EMPH_PREEMPH,
+  AFSK_EMPH_CUSTOM,
+} afsk_emph_mode_t;
+
+typedef struct {
+  q15_t coeffs[6];                  /*!< b0, 0, b1, b2, a1, a2 as CMSIS wants */
+  uint8_t post_shift;
+} afsk_emph_coeffs_t;
+
+typedef struct {
+  arm_biquad_casd_df1_inst_q15 biquad;
+  afsk_emph_coeffs_t coeffs;
+  q15_t state[4];
+} afsk_emph_t;
+
+/**
+  * @brief  Pick a curve and clear the filter state.
+  * @param  custom: coefficients for AFSK_EMPH_CUSTOM, copied; NULL otherwise
+  * @retval 0 on success, -1 for CUSTOM without coefficients
+  */
+int afsk_emph_init(afsk_emph_t *emph, afsk_emph_mode_t mode, const afsk_emph_coeffs_t *custom);
+
+/**
+  * @brief  Filter DAC samples in place.
+  * @param  n: AFSK_DAC_HALF in the transmit path
+  */
+void afsk_emph_process(afsk_emph_t *emph, uint16_t *samples, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AFSK_EMPH_H */
@@ -0,0 +1,245 @@
+/**
+  ******************************************************************************
+  * @file    ax25.c
+  * @brief   AX.25 UI frames, encoded to the NRZI bit stream the modulator
+  *          sends.
+  ******************************************************************************
+  */
+#include "ax25.h"
+#include "ramfunc.h"
+
+#include <string.h>
+
+#define AX25_FCS_INIT           0xFFFFU
+#define AX25_FCS_POLY           0x8408U     /* 0x1021 reflected */
+#define AX25_SSID_RESERVED      0x60U
+#define AX25_SSID_C             0x80U       /* Command bit, set on dest for a command */
+#define AX25_SSID_LAST          0x01U       /* Extension bit: last address */
+
+/**
+  * @brief  One address from "CALL" or "CALL-n", up to the next ',' or NUL.
+  * @retval Characters consumed, or 0 if malformed
+  */
+static uint32_t ax25_addr(uint8_t *out, const char *text, uint8_t flags)
+{
+  uint32_t ssid = 0U;
+  uint32_t i = 0U;
+  uint32_t n;
+  char c;
+
+  for (n = 0U; text[n] != '\0' && text[n] != ',' && text[n] != '-'; n++) {
+    c = text[n];
+    if (c >= 'a' && c <= 'z') {
+      c = (char)(c - 'a' + 'A');
+    }
+    if (n >= 6U || !((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) {
+      return 0U;
+    }
+    out[n] = (uint8_t)((uint8_t)c << 1);
+  }
+  if (n == 0U) {
+    return 0U;
+  }
+  for (i = n; i < 6U; i++) {
+    out[i] = (uint8_t)(' ' << 1);
+  }
+  if (text[n] == '-') {
+    n++;
+    if (text[n] < '0' || text[n] > '9') {
+      return 0U;
+    }
+    while (text[n] >= '0' && text[n] <= '9') {
+      ssid = ssid * 10U + (uint32_t)(text[n++] - '0');
+      if (ssid > 15U) {
+        return 0U;
+      }
+    }
+  }
+  if (text[n] != '\0' && text[n] != ',') {
+    return 0U;
+  }
+  out[6] = (uint8_t)(AX25_SSID_RESERVED | (ssid << 1) | flags);
+  return n;
+}
+
+uint32_t ax25_header(uint8_t *out, const char *dest, const char *src, const char *path)
+{
+  uint32_t len = 2U * AX25_ADDR_LEN;
+  uint32_t digis = 0U;
+  uint32_t n;
+
+  if (ax25_addr(&out[0], dest, AX25_SSID_C) == 0U ||
+      ax25_addr(&out[AX25_ADDR_LEN], src, 0U) == 0U) {
+    return 0U;
+  }
+  while (*path != '\0') {
+    if (digis == AX25_DIGIS_MAX) {
+      return 0U;
+    }
+    n = ax25_addr(&out[len], path, 0U);
+    if (n == 0U) {
+      return 0U;
+    }
+    path += n;
+    if (*path == ',') {
+      path++;
+    }
+    len += AX25_ADDR_LEN;
+    digis++;
+  }
+  out[len - 1U] |= AX25_SSID_LAST;
+  out[len++] = AX25_CONTROL_UI;
+  out[len++] = AX25_PID_NONE;
+  return len;
+}
+
+/**
+  * @brief  NRZI-code one bit onto the line.
+  */
+static inline void ax25_enc_level(ax25_enc_t *enc, uint32_t bit)
+{
+  uint32_t i = enc->nbits;
+  uint8_t mask = (uint8_t)(1U << (i & 7U));
+
+  if (bit == 0U) {
+    enc->level ^= 1U;
+  }
+  if ((i >> 3) >= enc->size) {
+    enc->overflow = 1U;
+    return;
+  }
+  if (enc->level != 0U) {
+    enc->bits[i >> 3] |= mask;
+  } else {
+    enc->bits[i >> 3] &= (uint8_t)~mask;
+  }
+  enc->nbits = i + 1U;
+}
+
+/**
+  * @brief  One frame bit: stuffed, NRZI-coded, no FCS.
+  */
+static inline void ax25_enc_stuffed(ax25_enc_t *enc, uint32_t bit)
+{
+  ax25_enc_level(enc, bit);
+  if (bit == 0U) {
+    enc->ones = 0U;
+  } else if (++enc->ones == 5U) {
+    ax25_enc_level(enc, 0U);
+    enc->ones = 0U;
+  }
+}
+
+void ax25_enc_init(ax25_enc_t *enc, uint8_t *buf, uint32_t size)
+{
+  enc->bits = buf;
+  enc->size = size;
+  enc->nbits = 0U;
+  enc->fcs = AX25_FCS_INIT;
+  enc->ones = 0U;
+  enc->level = 0U;
+  enc->overflow = 0U;
+}
+
+void ax25_enc_flags(ax25_enc_t *enc, uint32_t count)
+{
+  uint32_t bit;
+
+  while (count-- > 0U) {
+    for (bit = 0U; bit < 8U; bit++) {
+      ax25_enc_level(enc, (AX25_FLAG >> bit) & 1U);
+    }
+  }
+  enc->ones = 0U;
+}
+
+/* The per-bit loop every frame byte goes through: run it from SRAM */
+RAMFUNC void ax25_enc_bytes(ax25_enc_t *enc, const uint8_t *data, uint32_t len)
+{
+  uint32_t fcs = enc->fcs;
+  uint32_t byte;
+  uint32_t bit;
+
+  while (len-- > 0U) {
+    byte = *data++;
+    for (bit = 0U; bit < 8U; bit++) {
+      fcs = ((fcs ^ byte) & 1U) ? (fcs >> 1) ^ AX25_FCS_POLY : fcs >> 1;
+      ax25_enc_stuffed(enc, byte & 1U);
+      byte >>= 1;
+    }
+  }
+  enc->fcs = (uint16_t)fcs;
+}
+
+uint32_t ax25_enc_finish(ax25_enc_t *enc)
+{
+  uint32_t fcs = (uint16_t)~enc->fcs;
+  uint32_t bit;
+
+  /* Sent low byte first, each LSB first: one 16-bit shift does both */
+  for (bit = 0U; bit < 16U; bit++) {
+    ax25_enc_stuffed(enc, fcs & 1U);
+    fcs >>= 1;
+  }
+  ax25_enc_flags(enc, AX25_TAIL_FLAGS);
+  return enc->overflow ? 0U : enc->nbits;
+}
+
+int ax25_prefix_build(ax25_prefix_t *prefix, const uint8_t *header, uint32_t len)
+{
+  ax25_enc_t enc;
+
+  if (len > AX25_HEADER_MAX) {
+    return -1;
+  }
+  ax25_enc_init(&enc, prefix->bits, sizeof(prefix->bits));
+  ax25_enc_flags(&enc, AX25_TXDELAY_FLAGS);
+  ax25_enc_bytes(&enc, header, len);
+  prefix->nbits = enc.nbits;
+  prefix->fcs = enc.fcs;
+  prefix->ones = enc.ones;
+  prefix->level = enc.level;
+  return 0;
+}
+
+int ax25_enc_resume(ax25_enc_t *enc, uint8_t *buf, uint32_t size, const ax25_prefix_t *prefix)
+{
+  uint32_t bytes = (prefix->nbits + 7U) / 8U;
+
+  if (bytes > size) {
+    return -1;
+  }
+  memcpy(buf, prefix->bits, bytes);
+  enc->bits = buf;
+  enc->size = size;
+  enc->nbits = prefix->nbits;
+  enc->fcs = prefix->fcs;
+  enc->ones = prefix->ones;
+  enc->level = prefix->level;
+  enc->overflow = 0U;
+  return 0;
+}
+
+uint32_t ax25_encode(uint8_t *buf, uint32_t size, const uint8_t *header, uint32_t header_len,
+                     const uint8_t *info, uint32_t info_len)
+{
+  ax25_enc_t enc;
+
+  ax25_enc_init(&enc, buf, size);
+  ax25_enc_flags(&enc, AX25_TXDELAY_FLAGS);
+  ax25_enc_bytes(&enc, header, header_len);
+  ax25_enc_bytes(&enc, info, info_len);
+  return ax25_enc_finish(&enc);
+}
+
+uint32_t ax25_encode_from(uint8_t *buf, uint32_t size, const ax25_prefix_t *prefix,
+                          const uint8_t *info, uint32_t info_len)
+{
+  ax25_enc_t enc;
+
+  if (ax25_enc_resume(&enc, buf, size, prefix) != 0) {
+    return 0U;
+  }
+  ax25_enc_bytes(&enc, info, info_len);
+  return ax25_enc_finish(&enc);
+}
@@ -0,0 +1,136 @@
+/**
+  ******************************************************************************
+  * @file    ax25.h
+  * @brief   AX.25 UI frames, encoded to the NRZI bit stream the modulator
+  *          sends.
+  *
+  *          The encoder turns bytes into line levels one bit at a time,
+  *          least significant bit first: it folds each bit into the FCS
+  *          (CRC-16/X.25), inserts a 0 after five 1s, and NRZI-codes the
+  *          result (0 toggles the level, 1 holds it). Flags go out
+  *          unstuffed and outside the FCS. Levels are packed LSB first into
+  *          the caller's buffer.
+  *
+  *          Every beacon shares its flags and address field, so that part
+  *          can be encoded once into an ax25_prefix_t, which keeps the bits
+  *          and the encoder state after them: FCS, run of 1s and line
+  *          level. ax25_enc_resume() copies the bits and carries on from
+  *          that state, so a frame built from a prefix is bit for bit the
+  *          one a full encode produces, at the cost of only its info field.
+  *          Rebuild the prefix whenever the addresses change.
+  *
+  *          Pure C, also builds on the host.
+  ******************************************************************************
+  */
+#ifndef AX25_H
+#define AX25_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define AX25_FLAG               0x7EU
+#define AX25_CONTROL_UI         0x03U
+#define AX25_PID_NONE           0xF0U
+#define AX25_ADDR_LEN           7U
+#define AX25_DIGIS_MAX          8U
+#define AX25_HEADER_MAX         ((2U + AX25_DIGIS_MAX) * AX25_ADDR_LEN + 2U)
+#define AX25_INFO_MAX           256U
+
+#define AX25_APRS_TOCALL        "APZPCO"    /* Experimental range, APRS101 */
+#define AX25_TXDELAY_FLAGS      32U         /* About 210 ms at 1200 Bd */
+#define AX25_TAIL_FLAGS         2U
+
+/* Worst case: flags as is, everything else stuffed after every fifth bit */
+#define AX25_STUFFED_BITS(bytes) ((bytes) * 8U + ((bytes) * 8U) / 5U)
+#define AX25_PREFIX_BYTES                                                      \
+  ((AX25_TXDELAY_FLAGS * 8U + AX25_STUFFED_BITS(AX25_HEADER_MAX) + 7U) / 8U)
+#define AX25_FRAME_BYTES(info_len)                                             \
+  (((AX25_TXDELAY_FLAGS + AX25_TAIL_FLAGS) * 8U +                              \
+    AX25_STUFFED_BITS(AX25_HEADER_MAX + (info_len) + 2U) + 7U) / 8U)
+
+typedef struct {
+  uint8_t *bits;                    /*!< Line levels, LSB first */
+  uint32_t size;                    /*!< Bytes at bits */
+  uint32_t nbits;                   /*!< Levels written so far */
+  uint16_t fcs;                     /*!< Running CRC-16/X.25 */
+  uint8_t ones;                     /*!< Consecutive 1s, for stuffing */
+  uint8_t level;                    /*!< Current NRZI line level */
+  uint8_t overflow;                 /*!< Set once a bit did not fit */
+} ax25_enc_t;
+
+typedef struct {
+  uint8_t bits[AX25_PREFIX_BYTES];
+  uint32_t nbits;
+  uint16_t fcs;
+  uint8_t ones;
+  uint8_t level;
+} ax25_prefix_t;
+
+/**
+  * @brief  Address field and control/PID bytes of a UI frame.
+  * @param  out: at least AX25_HEADER_MAX bytes
+  * @param  dest: destination call, optionally "-ssid"
+  * @param  src: source call, optionally "-ssid"
+  * @param  path: comma-separated digipeaters, e.g. "WIDE1-1,WIDE2-1", or ""
+  * @retval Header length, or 0 if a call is malformed or there are too
+  *         many digipeaters
+  */
+uint32_t ax25_header(uint8_t *out, const char *dest, const char *src, const char *path);
+
+/**
+  * @brief  Start an encode into buf, line level low.
+  */
+void ax25_enc_init(ax25_enc_t *enc, uint8_t *buf, uint32_t size);
+
+/**
+  * @brief  Flags: not stuffed, not in the FCS. The first flag after data
+  *         also ends the run of 1s.
+  */
+void ax25_enc_flags(ax25_enc_t *enc, uint32_t count);
+
+/**
+  * @brief  Frame bytes: into the FCS, stuffed, NRZI-coded.
+  */
+void ax25_enc_bytes(ax25_enc_t *enc, const uint8_t *data, uint32_t len);
+
+/**
+  * @brief  Close the frame: FCS, then AX25_TAIL_FLAGS flags.
+  * @retval Bits in the frame, or 0 if it did not fit the buffer
+  */
+uint32_t ax25_enc_finish(ax25_enc_t *enc);
+
+/**
+  * @brief  Encode AX25_TXDELAY_FLAGS flags and a header into a prefix.
+  * @retval 0 on success, -1 if the header is too long
+  */
+int ax25_prefix_build(ax25_prefix_t *prefix, const uint8_t *header, uint32_t len);
+
+/**
+  * @brief  Start an encode into buf from a prefix, as if its flags and
+  *         header had just been encoded there.
+  * @retval 0 on success, -1 if buf cannot hold the prefix
+  */
+int ax25_enc_resume(ax25_enc_t *enc, uint8_t *buf, uint32_t size, const ax25_prefix_t *prefix);
+
+/**
+  * @brief  Whole frame without a prefix: flags, header, info, FCS, flags.
+  * @retval Bits in the frame, or 0 if it did not fit
+  */
+uint32_t ax25_encode(uint8_t *buf, uint32_t size, const uint8_t *header, uint32_t header_len,
+                     const uint8_t *info, uint32_t info_len);
+
+/**
+  * @brief  The rest of a frame after its prefix: info, FCS, flags.
+  * @retval Bits in the frame, or 0 if it did not fit
+  */
+uint32_t ax25_encode_from(uint8_t *buf, uint32_t size, const ax25_prefix_t *prefix,
+                          const uint8_t *info, uint32_t info_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AX25_H */
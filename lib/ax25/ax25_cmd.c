@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    ax25_cmd.c
+  * @brief   ax25 console command: encode a beacon from the configured
+  *          addresses, with and without a prefix, and compare the two.
+  ******************************************************************************
+  */
+#include "ax25.h"
+#include "config.h"
+#include "console.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define AX25_CMD_INFO           ">PicoAPRS test"
+
+static uint8_t ax25_cmd_full[AX25_FRAME_BYTES(AX25_INFO_MAX)];
+static uint8_t ax25_cmd_cached[AX25_FRAME_BYTES(AX25_INFO_MAX)];
+static ax25_prefix_t ax25_cmd_prefix;
+
+/**
+  * @brief  First bit where two level streams differ, nbits if none.
+  */
+static uint32_t ax25_cmd_compare(const uint8_t *a, const uint8_t *b, uint32_t nbits)
+{
+  uint32_t i;
+
+  for (i = 0U; i < nbits; i++) {
+    if (((a[i >> 3] ^ b[i >> 3]) >> (i & 7U)) & 1U) {
+      break;
+    }
+  }
+  return i;
+}
+
+static int console_cmd_ax25(int argc, char *argv[])
+{
+  const config_t *cfg = config_get();
+  const char *info = (argc >= 2) ? argv[1] : AX25_CMD_INFO;
+  uint8_t header[AX25_HEADER_MAX];
+  char src[CONFIG_CALLSIGN_LEN + 4U];     /* "-" and the SSID */
+  uint32_t info_len = (uint32_t)strlen(info);
+  uint32_t header_len;
+  uint32_t full;
+  uint32_t cached;
+  uint32_t diff;
+
+  (void)snprintf(src, sizeof(src), "%s-%u", cfg->callsign, cfg->ssid);
+  header_len = ax25_header(header, AX25_APRS_TOCALL, src, cfg->path);
+  if (header_len == 0U || ax25_prefix_build(&ax25_cmd_prefix, header, header_len) != 0) {
+    printf("  bad address: %s>%s,%s\n", src, AX25_APRS_TOCALL, cfg->path);
+    return -1;
+  }
+  if (info_len > AX25_INFO_MAX) {
+    info_len = AX25_INFO_MAX;
+  }
+
+  full = ax25_encode(ax25_cmd_full, sizeof(ax25_cmd_full), header, header_len,
+                     (const uint8_t *)info, info_len);
+  cached = ax25_encode_from(ax25_cmd_cached, sizeof(ax25_cmd_cached), &ax25_cmd_prefix,
+                            (const uint8_t *)info, info_len);
+  printf("  %s>%s,%s:%.*s\n", src, AX25_APRS_TOCALL, cfg->path, (int)info_len, info);
+  printf("  header %lu bytes, prefix %lu bits, frame %lu bits\n", (unsigned long)header_len,
+         (unsigned long)ax25_cmd_prefix.nbits, (unsigned long)full);
+
+  diff = ax25_cmd_compare(ax25_cmd_full, ax25_cmd_cached, full);
+  if (full == 0U || cached != full || diff != full) {
+    printf("  prefix encode differs: %lu bits, first difference at bit %lu\n",
+           (unsigned long)cached, (unsigned long)diff);
+    return -1;
+  }
+  printf("  prefix encode identical\n");
+  return 0;
+}
+
+CONSOLE_COMMAND(ax25, "ax25 [info]: encode a beacon both ways and compare", console_cmd_ax25,
+                NULL);
@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * @file    ax25_test.c
+  * @brief   Host build: ax25_encode_from() against ax25_encode() over
+  *          random frames, and both against a decoder written here.
+  *
+  *          Each frame has random calls, SSIDs and digipeater path, and an
+  *          info field of random length whose bytes lean towards 0xFF and
+  *          0x7E, so that bit stuffing runs across byte, header and FCS
+  *          boundaries. The two encodes must agree to the bit. The frame
+  *          is then NRZI-decoded, its flags checked and its bits unstuffed,
+  *          and must give back the header and info with a good FCS. A share
+  *          of the buffers is too small, and there both must return 0:
+  *            ax25_test [frames] [seed]
+  *          The exit status is 0 if every frame matched.
+  ******************************************************************************
+  */
+#include "ax25.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AX25_TEST_FRAMES        20000UL
+#define AX25_TEST_FCS_CHECK     0x906EU     /* CRC-16/X.25 of "123456789" */
+
+static uint8_t ax25_test_full[AX25_FRAME_BYTES(AX25_INFO_MAX)];
+static uint8_t ax25_test_cached[AX25_FRAME_BYTES(AX25_INFO_MAX)];
+static uint8_t ax25_test_frame[AX25_HEADER_MAX + AX25_INFO_MAX + 2U];
+static ax25_prefix_t ax25_test_prefix;
+
+static uint32_t ax25_test_seed;
+static unsigned long ax25_test_failed;
+
+static uint32_t ax25_test_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  ax25_test_seed ^= ax25_test_seed << 13;
+  ax25_test_seed ^= ax25_test_seed >> 17;
+  ax25_test_seed ^= ax25_test_seed << 5;
+  return ax25_test_seed;
+}
+
+static void ax25_test_fail(const char *what, unsigned long frame)
+{
+  if (ax25_test_failed++ < 10UL) {
+    fprintf(stderr, "  frame %lu: %s\n", frame, what);
+  }
+}
+
+/* Bit by bit, so that it shares nothing with the encoder */
+static uint16_t ax25_test_fcs(const uint8_t *data, uint32_t len)
+{
+  uint16_t fcs = 0xFFFFU;
+  uint32_t i;
+  uint32_t b;
+
+  for (i = 0U; i < len; i++) {
+    for (b = 0U; b < 8U; b++) {
+      fcs = (uint16_t)((((fcs ^ (data[i] >> b)) & 1U) != 0U) ? (fcs >> 1) ^ 0x8408U : fcs >> 1);
+    }
+  }
+  return (uint16_t)~fcs;
+}
+
+/**
+  * @brief  "CALL" or "CALL-n" with 1 to 6 letters and digits.
+  */
+static char *ax25_test_call(char *out)
+{
+  static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  uint32_t len = 1U + ax25_test_rand() % 6U;
+  uint32_t i;
+
+  for (i = 0U; i < len; i++) {
+    *out++ = chars[ax25_test_rand() % (sizeof(chars) - 1U)];
+  }
+  if (ax25_test_rand() & 1U) {
+    out += sprintf(out, "-%lu", (unsigned long)(ax25_test_rand() % 16U));
+  }
+  *out = '\0';
+  return out;
+}
+
+static uint32_t ax25_test_info(uint8_t *info)
+{
+  uint32_t len = ax25_test_rand() % (AX25_INFO_MAX + 1U);
+  uint32_t r;
+  uint32_t i;
+
+  for (i = 0U; i < len; i++) {
+    r = ax25_test_rand();
+    info[i] = ((r & 3U) == 0U) ? 0xFFU : ((r & 3U) == 1U) ? (uint8_t)AX25_FLAG : (uint8_t)(r >> 8);
+  }
+  return len;
+}
+
+/**
+  * @brief  Undo the line coding: flags, stuffing, NRZI.
+  * @retval Frame bytes between the flags, FCS included, or -1 if the bits
+  *         are not a well-formed frame
+  */
+static long ax25_test_decode(const uint8_t *bits, uint32_t nbits, uint8_t *out, uint32_t size)
+{
+  uint32_t tail = AX25_TAIL_FLAGS * 8U;
+  uint32_t head = AX25_TXDELAY_FLAGS * 8U;
+  uint8_t level = 0U;
+  uint8_t now;
+  uint8_t bit;
+  uint32_t k;
+  uint32_t ones = 0U;
+  uint32_t n = 0U;
+  uint32_t i;
+
+  if (nbits < head + tail) {
+    return -1L;
+  }
+  memset(out, 0, size);
+  for (i = 0U; i < nbits; i++) {
+    now = (uint8_t)((bits[i / 8U] >> (i % 8U)) & 1U);
+    bit = (now == level);
+    level = now;
+
+    if (i < head || i >= nbits - tail) {
+      /* A flag, 0x7E least significant bit first; the tail is not byte aligned */
+      k = (i < head) ? i % 8U : (i - (nbits - tail)) % 8U;
+      if (bit != ((k != 0U && k != 7U) ? 1U : 0U)) {
+        return -1L;
+      }
+      continue;
+    }
+    if (ones == 5U) {
+      if (bit != 0U) {
+        return -1L;
+      }
+      ones = 0U;
+      continue;
+    }
+    ones = bit ? ones + 1U : 0U;
+    if (n / 8U >= size) {
+      return -1L;
+    }
+    out[n / 8U] |= (uint8_t)(bit << (n % 8U));
+    n++;
+  }
+  return ((n % 8U) == 0U) ? (long)(n / 8U) : -1L;
+}
+
+static void ax25_test_one(unsigned long frame)
+{
+  char path[AX25_DIGIS_MAX * 11U];
+  char src[12];
+  uint8_t header[AX25_HEADER_MAX];
+  uint8_t info[AX25_INFO_MAX];
+  uint8_t decoded[sizeof(ax25_test_frame) + 1U];
+  uint32_t header_len;
+  uint32_t info_len;
+  uint32_t digis = ax25_test_rand() % (AX25_DIGIS_MAX + 1U);
+  uint32_t size = sizeof(ax25_test_full);
+  uint32_t full;
+  uint32_t cached;
+  uint16_t fcs;
+  char *p = path;
+  long len;
+  uint32_t i;
+
+  ax25_test_call(src);
+  *p = '\0';
+  for (i = 0U; i < digis; i++) {
+    p = ax25_test_call(p);
+    *p++ = ',';
+  }
+  p[(digis != 0U) ? -1 : 0] = '\0';
+  header_len = ax25_header(header, AX25_APRS_TOCALL, src, path);
+  if (header_len == 0U || ax25_prefix_build(&ax25_test_prefix, header, header_len) != 0) {
+    ax25_test_fail("header rejected", frame);
+    return;
+  }
+  info_len = ax25_test_info(info);
+
+  /* One frame in eight into a buffer that may be too small */
+  if ((ax25_test_rand() & 7U) == 0U) {
+    size = ax25_test_rand() % (AX25_FRAME_BYTES(info_len) + 1U);
+  }
+  memset(ax25_test_full, 0xA5, sizeof(ax25_test_full));
+  memset(ax25_test_cached, 0x5A, sizeof(ax25_test_cached));
+  full = ax25_encode(ax25_test_full, size, header, header_len, info, info_len);
+  cached = ax25_encode_from(ax25_test_cached, size, &ax25_test_prefix, info, info_len);
+  if (full != cached) {
+    ax25_test_fail("lengths differ", frame);
+    return;
+  }
+  if (full == 0U) {
+    if (size >= AX25_FRAME_BYTES(info_len)) {
+      ax25_test_fail("frame did not fit its worst case", frame);
+    }
+    return;
+  }
+  if (memcmp(ax25_test_full, ax25_test_cached, full / 8U) != 0 ||
+      ((full % 8U) != 0U &&
+       ((ax25_test_full[full / 8U] ^ ax25_test_cached[full / 8U]) & ((1U << (full % 8U)) - 1U)) != 0U)) {
+    ax25_test_fail("bits differ", frame);
+    return;
+  }
+
+  /* And what the two agree on is the frame */
+  memcpy(ax25_test_frame, header, header_len);
+  memcpy(&ax25_test_frame[header_len], info, info_len);
+  fcs = ax25_test_fcs(ax25_test_frame, header_len + info_len);
+  ax25_test_frame[header_len + info_len] = (uint8_t)fcs;
+  ax25_test_frame[header_len + info_len + 1U] = (uint8_t)(fcs >> 8);
+  len = ax25_test_decode(ax25_test_full, full, decoded, sizeof(decoded));
+  if (len != (long)(header_len + info_len + 2U) ||
+      memcmp(decoded, ax25_test_frame, (size_t)len) != 0) {
+    ax25_test_fail("decodes to another frame", frame);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long frames = (argc > 1) ? strtoul(argv[1], NULL, 0) : AX25_TEST_FRAMES;
+  unsigned long frame;
+
+  ax25_test_seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x1F123BB5UL;
+  if (frames == 0UL || ax25_test_seed == 0U) {
+    fprintf(stderr, "usage: %s [frames] [seed]\n", argv[0]);
+    return 2;
+  }
+  if (ax25_test_fcs((const uint8_t *)"123456789", 9U) != AX25_TEST_FCS_CHECK) {
+    ax25_test_fail("the test's own FCS is wrong", 0UL);
+  }
+
+  for (frame = 1UL; frame <= frames; frame++) {
+    ax25_test_one(frame);
+  }
+  printf("  %-22s %7lu frames  %s\n", "prefix == full encode", frames,
+         (ax25_test_failed == 0UL) ? "ok" : "FAIL");
+  return (ax25_test_failed == 0UL) ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/**
+  ******************************************************************************
+  * @file    bench.c
+  * @brief   Microbenchmarks: runner and console command.
+  ******************************************************************************
+  */
+#include "bench.h"
+#include "clock.h"
+#include "console.h"
+#include "cycles.h"
+#include "main.h"
+#include "ramfunc.h"
+#include "tx_api.h"
+#include "watchdog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_OVERHEAD_SAMPLES  8U
+
+extern const bench_case_t __start_bench_cases[];
+extern const bench_case_t __stop_bench_cases[];
+
+volatile uint32_t bench_sink;
+
+static uint32_t bench_samples[BENCH_ITERS_MAX];
+
+uint32_t bench_hz(void)
+{
+  return cycles_hz();
+}
+
+static void bench_nop(void)
+{
+}
+
+/**
+  * @brief  Time n calls of body, one sample each.
+  */
+static void bench_sample(void (*body)(void), uint32_t *samples, uint32_t n)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t start;
+  uint32_t i;
+
+  for (i = 0; i < n; i++) {
+    TX_DISABLE
+    start = cycles_now();
+    body();
+    samples[i] = cycles_now() - start;
+    TX_RESTORE
+  }
+}
+
+static void bench_sort(uint32_t *v, uint32_t n)
+{
+  uint32_t i;
+  uint32_t j;
+  uint32_t x;
+
+  for (i = 1; i < n; i++) {
+    x = v[i];
+    for (j = i; j > 0U && v[j - 1U] > x; j--) {
+      v[j] = v[j - 1U];
+    }
+    v[j] = x;
+  }
+}
+
+void bench_run(const bench_case_t *bc, uint32_t iters, bench_result_t *result)
+{
+  uint32_t overhead;
+  uint32_t i;
+
+  if (iters == 0U) {
+    iters = 1U;
+  }
+  if (iters > BENCH_ITERS_MAX) {
+    iters = BENCH_ITERS_MAX;
+  }
+
+  cycles_start();
+  bench_sample(bench_nop, bench_samples, BENCH_OVERHEAD_SAMPLES);
+  bench_sort(bench_samples, BENCH_OVERHEAD_SAMPLES);
+  overhead = bench_samples[0];
+
+  if (bc->setup != NULL) {
+    bc->setup();
+  }
+  for (i = 0; i < BENCH_WARMUP; i++) {
+    bc->body();
+  }
+  bench_sample(bc->body, bench_samples, iters);
+  cycles_stop();
+
+  for (i = 0; i < iters; i++) {
+    bench_samples[i] = (bench_samples[i] > overhead) ? bench_samples[i] - overhead : 0U;
+  }
+  bench_sort(bench_samples, iters);
+  result->n = iters;
+  result->min = bench_samples[0];
+  result->median = bench_samples[iters / 2U];
+  result->max = bench_samples[iters - 1U];
+}
+
+const bench_case_t *bench_find(const char *name)
+{
+  const bench_case_t *bc;
+
+  for (bc = __start_bench_cases; bc < __stop_bench_cases; bc++) {
+    if (strcmp(bc->name, name) == 0) {
+      return bc;
+    }
+  }
+  return NULL;
+}
+
+static void bench_report(const bench_case_t *bc, uint32_t iters)
+{
+  bench_result_t r;
+  uint32_t budget;
+
+  bench_run(bc, iters, &r);
+  printf("bench name=%s n=%lu min=%lu med=%lu max=%lu unit=%s hz=%lu", bc->name,
+         (unsigned long)r.n, (unsigned long)r.min, (unsigned long)r.median,
+         (unsigned long)r.max,
+#ifdef PICOAPRS_HOST
+         "ns",
+#else
+         "cyc",
+#endif
+         (unsigned long)bench_hz());
+  if (bc->budget_us != 0U) {
+    budget = bc->budget_us * (bench_hz() / 1000000UL);
+    printf(" budget=%lu fits=%u", (unsigned long)budget, (r.max <= budget) ? 1U : 0U);
+  }
+  printf("\n");
+}
+
+static int console_cmd_bench(int argc, char *argv[])
+{
+  const bench_case_t *bc;
+  uint32_t iters = BENCH_ITERS_DEFAULT;
+  int ret = 0;
+
+  if (argc == 1) {
+    for (bc = __start_bench_cases; bc < __stop_bench_cases; bc++) {
+      printf("  %s\n", bc->name);
+    }
+    printf("  (code in SRAM: %lu bytes)\n", (unsigned long)ramfunc_bytes());
+    return 0;
+  }
+  if (argc >= 3) {
+    iters = (uint32_t)strtoul(argv[2], NULL, 10);
+  }
+
+  /* Samples at a fixed frequency compare between runs */
+  clock_request(CLOCK_LEVEL_HIGH);
+  if (strcmp(argv[1], "all") == 0) {
+    printf("ramfunc bytes=%lu\n", (unsigned long)ramfunc_bytes());
+    for (bc = __start_bench_cases; bc < __stop_bench_cases; bc++) {
+      /* The whole list outlasts the console thread's deadline */
+      watchdog_checkin_self();
+      bench_report(bc, iters);
+    }
+  } else if ((bc = bench_find(argv[1])) != NULL) {
+    bench_report(bc, iters);
+  } else {
+    printf("  unknown case '%s'\n", argv[1]);
+    ret = -1;
+  }
+  clock_release(CLOCK_LEVEL_HIGH);
+  return ret;
+}
+
+static const char *console_complete_bench(int argi, uint32_t index)
+{
+  if (argi != 1) {
+    return NULL;
+  }
+  if (index == 0U) {
+    return "all";
+  }
+  return (&__start_bench_cases[index - 1U] < __stop_bench_cases) ?
+         __start_bench_cases[index - 1U].name : NULL;
+}
+
+CONSOLE_COMMAND(bench, "bench [case|all [n]]: time code in cycles",
+                console_cmd_bench, console_complete_bench);
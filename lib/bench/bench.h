@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    bench.h
+  * @brief   Microbenchmarks: cycle counts for short kernels, run from the
+  *          console.
+  *
+  *          The M0+ has no DWT cycle counter, so TIM2 stands in for one
+  *          (lib/cycles): 32 bits at SYSCLK, running only while a benchmark
+  *          does. The host build reads CLOCK_MONOTONIC instead and reports
+  *          nanoseconds.
+  *
+  *          Cases are registered anywhere with BENCH_CASE() and land in the
+  *          bench_cases linker section, like console commands. A run calls
+  *          the case's setup once, its body a few times untimed to warm up,
+  *          then times each of n calls separately with interrupts disabled,
+  *          so a body must stay well under a kernel tick. The cost of
+  *          reading the counter is measured once and subtracted.
+  *
+  *          Results are printed one per line as key=value pairs:
+  *            bench name=crc32_256 n=32 min=9512 med=9512 max=9530 unit=cyc hz=16000000
+  *          A case with a budget adds it in the same unit, and whether the
+  *          worst call fit: budget=106666 fits=1.
+  *          Captures from two builds compare with tools/bench_diff.py.
+  ******************************************************************************
+  */
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define BENCH_WARMUP            4U
+#define BENCH_ITERS_DEFAULT     32U
+#define BENCH_ITERS_MAX         64U
+
+typedef struct {
+  const char *name;
+  void (*setup)(void);              /*!< Optional, untimed, once per run */
+  void (*body)(void);               /*!< The code under test, one call per sample */
+  uint32_t budget_us;               /*!< Time a call must fit in, 0 for none */
+} bench_case_t;
+
+typedef struct {
+  uint32_t n;
+  uint32_t min;
+  uint32_t median;
+  uint32_t max;
+} bench_result_t;
+
+/**
+  * @brief  Register a case with a time budget, e.g. a DMA refill window.
+  *         Use at file scope.
+  */
+#define BENCH_CASE_BUDGET(case_name, case_setup, case_body, case_budget_us)    \
+  static const bench_case_t bench_entry_##case_name                            \
+    __attribute__((section("bench_cases"), used, aligned(sizeof(void *)))) =  \
+    { #case_name, (case_setup), (case_body), (case_budget_us) }
+
+/**
+  * @brief  Register a case. Use at file scope.
+  */
+#define BENCH_CASE(case_name, case_setup, case_body)                           \
+  BENCH_CASE_BUDGET(case_name, case_setup, case_body, 0U)
+
+/**
+  * @brief  Results a body stores here count as used, so the compiler keeps
+  *         the work that produced them.
+  */
+extern volatile uint32_t bench_sink;
+
+/**
+  * @brief  Counter frequency: SYSCLK on target, 1 GHz on the host.
+  */
+uint32_t bench_hz(void);
+
+/**
+  * @brief  Run a case: setup, BENCH_WARMUP untimed calls, then iters timed
+  *         ones (at most BENCH_ITERS_MAX). Thread context only.
+  */
+void bench_run(const bench_case_t *bc, uint32_t iters, bench_result_t *result);
+
+/**
+  * @brief  Case by name, NULL if unknown.
+  */
+const bench_case_t *bench_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
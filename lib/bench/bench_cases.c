@@ -0,0 +1,223 @@
+/**
+  ******************************************************************************
+  * @file    bench_cases.c
+  * @brief   Benchmark cases for the shared modules: CRC, ring buffer,
+  *          console parsing, formatting, AX.25 encoding and AFSK modulation.
+  *
+  *          Each body does a fixed amount of work on fixed data, so results
+  *          from two builds compare directly. Kernels that run from SRAM also
+  *          have a *_flash case running the same code from its load image,
+  *          which is what the SRAM buys.
+  ******************************************************************************
+  */
+#include "afsk.h"
+#include "afsk_emph.h"
+#include "ax25.h"
+#include "bench.h"
+#include "console.h"
+#include "crc32.h"
+#include "fmt.h"
+#include "ramfunc.h"
+#include "ring_buffer.h"
+
+#include <string.h>
+
+static uint8_t bench_data[256];
+
+static void bench_data_fill(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < sizeof(bench_data); i++) {
+    bench_data[i] = (uint8_t)(i * 7U + 3U);
+  }
+}
+
+static void bench_crc32_256(void)
+{
+  bench_sink = crc32(bench_data, sizeof(bench_data));
+}
+
+BENCH_CASE(crc32_256, bench_data_fill, bench_crc32_256);
+
+static void bench_crc32_256_flash(void)
+{
+  bench_sink = crc32_final(RAMFUNC_FLASH_COPY(crc32_update)(CRC32_INIT, bench_data,
+                                                            sizeof(bench_data)));
+}
+
+BENCH_CASE(crc32_256_flash, bench_data_fill, bench_crc32_256_flash);
+
+RING_BUFFER_DEFINE(bench_rb, 128);
+
+/**
+  * @brief  64 bytes through the ring, a byte at a time each way, across the
+  *         wrap every other call.
+  */
+static void bench_ring_bytes_64(void)
+{
+  uint8_t byte = 0U;
+  uint32_t i;
+
+  for (i = 0; i < 64U; i++) {
+    (void)ring_buffer_put(&bench_rb, bench_data[i]);
+  }
+  for (i = 0; i < 64U; i++) {
+    (void)ring_buffer_get(&bench_rb, &byte);
+  }
+  bench_sink = byte;
+}
+
+BENCH_CASE(ring_bytes_64, bench_data_fill, bench_ring_bytes_64);
+
+static void bench_ring_block_64(void)
+{
+  uint8_t out[64];
+
+  (void)ring_buffer_write(&bench_rb, bench_data, sizeof(out));
+  bench_sink = ring_buffer_read(&bench_rb, out, sizeof(out));
+}
+
+BENCH_CASE(ring_block_64, bench_data_fill, bench_ring_block_64);
+
+static void bench_tokenize(void)
+{
+  static const char line[] = "config path \"WIDE1-1,WIDE2-1\" extra words";
+  char buf[sizeof(line)];
+  char *argv[CONSOLE_MAX_ARGS];
+
+  memcpy(buf, line, sizeof(line));
+  bench_sink = (uint32_t)console_tokenize(buf, argv, (int)CONSOLE_MAX_ARGS);
+}
+
+BENCH_CASE(tokenize, NULL, bench_tokenize);
+
+static void bench_format(void)
+{
+  char buf[64];
+
+  bench_sink = (uint32_t)fmt_snprintf(buf, sizeof(buf), "%s-%u %ld.%02u %08lx", "N0CALL", 11U,
+                                      -1234L, 56U, 0xDEADBEEFUL);
+}
+
+BENCH_CASE(format, NULL, bench_format);
+
+/* A typical position beacon; the header and info stay fixed between builds */
+static const char bench_ax25_info[] = "!4530.00N/12240.00WO/A=001234 PicoAPRS 3.31V";
+static uint8_t bench_ax25_header[AX25_HEADER_MAX];
+static uint32_t bench_ax25_header_len;
+static ax25_prefix_t bench_ax25_prefix;
+static uint8_t bench_ax25_frame[AX25_FRAME_BYTES(sizeof(bench_ax25_info))];
+
+static void bench_ax25_setup(void)
+{
+  bench_ax25_header_len = ax25_header(bench_ax25_header, AX25_APRS_TOCALL, "N0CALL-11",
+                                      "WIDE1-1,WIDE2-1");
+  (void)ax25_prefix_build(&bench_ax25_prefix, bench_ax25_header, bench_ax25_header_len);
+}
+
+static void bench_ax25_full(void)
+{
+  bench_sink = ax25_encode(bench_ax25_frame, sizeof(bench_ax25_frame), bench_ax25_header,
+                           bench_ax25_header_len, (const uint8_t *)bench_ax25_info,
+                           sizeof(bench_ax25_info) - 1U);
+}
+
+BENCH_CASE(ax25_full, bench_ax25_setup, bench_ax25_full);
+
+/**
+  * @brief  The same frame from the prefix: the difference to ax25_full is
+  *         what the cache saves per beacon.
+  */
+static void bench_ax25_cached(void)
+{
+  bench_sink = ax25_encode_from(bench_ax25_frame, sizeof(bench_ax25_frame), &bench_ax25_prefix,
+                                (const uint8_t *)bench_ax25_info, sizeof(bench_ax25_info) - 1U);
+}
+
+BENCH_CASE(ax25_cached, bench_ax25_setup, bench_ax25_cached);
+
+/* The stuffing loop alone, over 64 bytes of the info field */
+static void bench_ax25_stuff_64(void)
+{
+  ax25_enc_t enc;
+
+  ax25_enc_init(&enc, bench_ax25_frame, sizeof(bench_ax25_frame));
+  ax25_enc_bytes(&enc, (const uint8_t *)bench_ax25_info, 32U);
+  ax25_enc_bytes(&enc, (const uint8_t *)bench_ax25_info, 32U);
+  bench_sink = enc.nbits;
+}
+
+BENCH_CASE(ax25_stuff_64, NULL, bench_ax25_stuff_64);
+
+static void bench_ax25_stuff_64_flash(void)
+{
+  ax25_enc_t enc;
+
+  ax25_enc_init(&enc, bench_ax25_frame, sizeof(bench_ax25_frame));
+  RAMFUNC_FLASH_COPY(ax25_enc_bytes)(&enc, (const uint8_t *)bench_ax25_info, 32U);
+  RAMFUNC_FLASH_COPY(ax25_enc_bytes)(&enc, (const uint8_t *)bench_ax25_info, 32U);
+  bench_sink = enc.nbits;
+}
+
+BENCH_CASE(ax25_stuff_64_flash, NULL, bench_ax25_stuff_64_flash);
+
+/* 64 bits of the frame above, exact modulator against the block cache */
+#define BENCH_AFSK_BITS         64U
+
+static afsk_t bench_afsk;
+static uint16_t bench_afsk_table[AFSK_TABLE_SAMPLES(AFSK_PHASE_LEVELS)];
+static uint16_t bench_afsk_out[BENCH_AFSK_BITS * AFSK_SPB];
+
+static void bench_afsk_exact_setup(void)
+{
+  bench_ax25_setup();
+  bench_ax25_full();
+  (void)afsk_init(&bench_afsk, NULL, 0U);
+}
+
+static void bench_afsk_exact(void)
+{
+  afsk_modulate(&bench_afsk, bench_ax25_frame, 0U, BENCH_AFSK_BITS, bench_afsk_out);
+  bench_sink = bench_afsk_out[0];
+}
+
+BENCH_CASE(afsk_exact, bench_afsk_exact_setup, bench_afsk_exact);
+
+static void bench_afsk_exact_flash(void)
+{
+  RAMFUNC_FLASH_COPY(afsk_modulate)(&bench_afsk, bench_ax25_frame, 0U, BENCH_AFSK_BITS,
+                                    bench_afsk_out);
+  bench_sink = bench_afsk_out[0];
+}
+
+BENCH_CASE(afsk_exact_flash, bench_afsk_exact_setup, bench_afsk_exact_flash);
+
+static void bench_afsk_cached_setup(void)
+{
+  bench_ax25_setup();
+  bench_ax25_full();
+  (void)afsk_init(&bench_afsk, bench_afsk_table, AFSK_PHASE_LEVELS);
+}
+
+BENCH_CASE(afsk_cached, bench_afsk_cached_setup, bench_afsk_exact);
+BENCH_CASE(afsk_cached_flash, bench_afsk_cached_setup, bench_afsk_exact_flash);
+
+/* One DAC half-buffer through the pre-emphasis biquad, against the time
+ * that half-buffer plays for */
+static afsk_emph_t bench_emph;
+static uint16_t bench_emph_half[AFSK_DAC_HALF];
+
+static void bench_afsk_emph_setup(void)
+{
+  bench_afsk_exact_setup();
+  afsk_modulate(&bench_afsk, bench_ax25_frame, 0U, AFSK_DAC_HALF / AFSK_SPB, bench_emph_half);
+  (void)afsk_emph_init(&bench_emph, AFSK_EMPH_PREEMPH, NULL);
+}
+
+static void bench_afsk_emph(void)
+{
+  afsk_emph_process(&bench_emph, bench_emph_half, AFSK_DAC_HALF);
+}
+
+BENCH_CASE_BUDGET(afsk_emph, bench_afsk_emph_setup, bench_afsk_emph, AFSK_DAC_HALF_US);
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    bench_qmath.c
+  * @brief   Benchmark cases for the integer math in lib/qmath, and, built
+  *          with PICOAPRS_BENCH_SOFTFLOAT, the same work done with float or
+  *          double through libm for comparison.
+  *
+  *          The libm cases are off by default: they would link the soft-
+  *          float routines into every image only to time them. Each pair
+  *          does the same calls on the same inputs, so qmath_sin against
+  *          libm_sinf and so on is the saving per call times the calls.
+  ******************************************************************************
+  */
+#include "bench.h"
+#include "qgeo.h"
+#include "qmath.h"
+
+#include <stddef.h>
+#ifdef PICOAPRS_BENCH_SOFTFLOAT
+#include <math.h>
+#endif
+
+#define BENCH_QMATH_CALLS       8U
+
+/* A flight's worth of positions, degrees * 1e7, and pressures */
+static const int32_t bench_qmath_pos[BENCH_QMATH_CALLS + 1U][2] = {
+  { 481234567, 115678901 }, { 481301234, 115812345 }, { 481498765, 116034567 },
+  { 481702345, 116290123 }, { 482011223, 116612345 }, { 482398765, 117001234 },
+  { 482765432, 117390123 }, { 483111111, 117801234 }, { 483456789, 118234567 },
+};
+
+static const uint32_t bench_qmath_pa[BENCH_QMATH_CALLS] = {
+  101325U, 89876U, 70108U, 46563U, 26500U, 12111U, 5529U, 1197U,
+};
+
+static void bench_qmath_sin(void)
+{
+  uint32_t angle = 0x12345678UL;
+  int32_t sum = 0;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += qmath_sin(angle);
+    angle += 0x1F2E3D4CUL;
+  }
+  bench_sink = (uint32_t)sum;
+}
+
+BENCH_CASE(qmath_sin, NULL, bench_qmath_sin);
+
+static void bench_qmath_atan2(void)
+{
+  uint32_t sum = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += qmath_atan2(bench_qmath_pos[i][0], bench_qmath_pos[i][1] - 200000000L);
+  }
+  bench_sink = sum;
+}
+
+BENCH_CASE(qmath_atan2, NULL, bench_qmath_atan2);
+
+static void bench_qmath_distance(void)
+{
+  uint32_t sum = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += qgeo_distance_m(bench_qmath_pos[i][0], bench_qmath_pos[i][1],
+                           bench_qmath_pos[i + 1U][0], bench_qmath_pos[i + 1U][1]);
+  }
+  bench_sink = sum;
+}
+
+BENCH_CASE(qmath_distance, NULL, bench_qmath_distance);
+
+static void bench_qmath_bearing(void)
+{
+  uint32_t sum = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += qgeo_bearing(bench_qmath_pos[i][0], bench_qmath_pos[i][1],
+                        bench_qmath_pos[i + 1U][0], bench_qmath_pos[i + 1U][1]);
+  }
+  bench_sink = sum;
+}
+
+BENCH_CASE(qmath_bearing, NULL, bench_qmath_bearing);
+
+static void bench_qmath_baro(void)
+{
+  int32_t sum = 0;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += qmath_baro_altitude_cm(bench_qmath_pa[i], QMATH_BARO_P0_PA);
+  }
+  bench_sink = (uint32_t)sum;
+}
+
+BENCH_CASE(qmath_baro, NULL, bench_qmath_baro);
+
+static void bench_qmath_dm(void)
+{
+  qgeo_dm_t dm;
+  uint32_t sum = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    qgeo_e7_to_dm(bench_qmath_pos[i][1], &dm);
+    sum += dm.min_e4;
+  }
+  bench_sink = sum;
+}
+
+BENCH_CASE(qmath_dm, NULL, bench_qmath_dm);
+
+#ifdef PICOAPRS_BENCH_SOFTFLOAT
+
+#define BENCH_LIBM_RAD          (3.14159265358979 / 180e7)
+
+static void bench_libm_sinf(void)
+{
+  uint32_t angle = 0x12345678UL;
+  float sum = 0.0f;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += sinf((float)angle * (6.2831853f / 4294967296.0f));
+    angle += 0x1F2E3D4CUL;
+  }
+  bench_sink = (uint32_t)(int32_t)(sum * 1e6f);
+}
+
+BENCH_CASE(libm_sinf, NULL, bench_libm_sinf);
+
+static void bench_libm_atan2(void)
+{
+  double sum = 0.0;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += atan2((double)bench_qmath_pos[i][0], (double)(bench_qmath_pos[i][1] - 200000000L));
+  }
+  bench_sink = (uint32_t)(int32_t)(sum * 1e6);
+}
+
+BENCH_CASE(libm_atan2, NULL, bench_libm_atan2);
+
+/* Haversine in double, as a float version would lose metres at this range */
+static void bench_libm_distance(void)
+{
+  double sum = 0.0;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    double p1 = bench_qmath_pos[i][0] * BENCH_LIBM_RAD;
+    double p2 = bench_qmath_pos[i + 1U][0] * BENCH_LIBM_RAD;
+    double dl = (bench_qmath_pos[i + 1U][1] - bench_qmath_pos[i][1]) * BENCH_LIBM_RAD;
+    double s1 = sin((p2 - p1) / 2.0);
+    double s2 = sin(dl / 2.0);
+    double a = s1 * s1 + cos(p1) * cos(p2) * s2 * s2;
+
+    sum += 2.0 * QGEO_EARTH_RADIUS_M * atan2(sqrt(a), sqrt(1.0 - a));
+  }
+  bench_sink = (uint32_t)sum;
+}
+
+BENCH_CASE(libm_distance, NULL, bench_libm_distance);
+
+static void bench_libm_bearing(void)
+{
+  double sum = 0.0;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    double p1 = bench_qmath_pos[i][0] * BENCH_LIBM_RAD;
+    double p2 = bench_qmath_pos[i + 1U][0] * BENCH_LIBM_RAD;
+    double dl = (bench_qmath_pos[i + 1U][1] - bench_qmath_pos[i][1]) * BENCH_LIBM_RAD;
+
+    sum += atan2(sin(dl) * cos(p2), cos(p1) * sin(p2) - sin(p1) * cos(p2) * cos(dl));
+  }
+  bench_sink = (uint32_t)(int32_t)(sum * 1e6);
+}
+
+BENCH_CASE(libm_bearing, NULL, bench_libm_bearing);
+
+static void bench_libm_baro(void)
+{
+  float sum = 0.0f;
+  uint32_t i;
+
+  /* The troposphere formula only: the cheapest float version there is */
+  for (i = 0U; i < BENCH_QMATH_CALLS; i++) {
+    sum += 44330.77f * (1.0f - powf((float)bench_qmath_pa[i] / 101325.0f, 0.190263f));
+  }
+  bench_sink = (uint32_t)(int32_t)sum;
+}
+
+BENCH_CASE(libm_baro, NULL, bench_libm_baro);
+
+#endif /* PICOAPRS_BENCH_SOFTFLOAT */
@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * @file    bme280.c
+  * @brief   Bosch BME280 pressure, temperature and humidity sensor.
+  ******************************************************************************
+  */
+#include "bme280.h"
+
+#define BME280_REG_CALIB_TP     0x88U
+#define BME280_REG_ID           0xD0U
+#define BME280_REG_CALIB_H      0xE1U
+#define BME280_REG_CTRL_HUM     0xF2U
+#define BME280_REG_STATUS       0xF3U
+#define BME280_REG_CTRL_MEAS    0xF4U
+#define BME280_REG_CONFIG       0xF5U
+#define BME280_REG_DATA         0xF7U
+
+#define BME280_CALIB_TP_LEN     26U
+#define BME280_CALIB_H_LEN      7U
+#define BME280_DATA_LEN         8U
+
+#define BME280_STATUS_MEASURING 0x08U
+#define BME280_OSRS_X1          1U
+#define BME280_MODE_SLEEP       0U
+#define BME280_MODE_FORCED      1U
+
+#define BME280_CTRL_MEAS(mode)  ((BME280_OSRS_X1 << 5) | (BME280_OSRS_X1 << 2) | (mode))
+
+static uint16_t bme280_u16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void bme280_parse_calib(bme280_calib_t *calib, const uint8_t *tp, const uint8_t *h)
+{
+  calib->t1 = bme280_u16(&tp[0]);
+  calib->t2 = (int16_t)bme280_u16(&tp[2]);
+  calib->t3 = (int16_t)bme280_u16(&tp[4]);
+  calib->p1 = bme280_u16(&tp[6]);
+  calib->p2 = (int16_t)bme280_u16(&tp[8]);
+  calib->p3 = (int16_t)bme280_u16(&tp[10]);
+  calib->p4 = (int16_t)bme280_u16(&tp[12]);
+  calib->p5 = (int16_t)bme280_u16(&tp[14]);
+  calib->p6 = (int16_t)bme280_u16(&tp[16]);
+  calib->p7 = (int16_t)bme280_u16(&tp[18]);
+  calib->p8 = (int16_t)bme280_u16(&tp[20]);
+  calib->p9 = (int16_t)bme280_u16(&tp[22]);
+  calib->h1 = tp[25];                   /* 0xA1; 0xA0 is unused */
+  calib->h2 = (int16_t)bme280_u16(&h[0]);
+  calib->h3 = h[2];
+  /* h4 and h5 are 12-bit, sharing the nibbles of 0xE5 */
+  calib->h4 = (int16_t)(((int16_t)(int8_t)h[3] * 16) | (h[4] & 0x0F));
+  calib->h5 = (int16_t)(((int16_t)(int8_t)h[5] * 16) | (h[4] >> 4));
+  calib->h6 = (int8_t)h[6];
+}
+
+/* The datasheet's integer compensation, section 4.2.3 (BME280 rev 1.6) */
+
+static int32_t bme280_t_fine(const bme280_calib_t *c, int32_t adc_t)
+{
+  int32_t var1 = ((((adc_t >> 3) - ((int32_t)c->t1 << 1))) * (int32_t)c->t2) >> 11;
+  int32_t var2 = (((((adc_t >> 4) - (int32_t)c->t1) * ((adc_t >> 4) - (int32_t)c->t1)) >> 12) *
+                  (int32_t)c->t3) >> 14;
+
+  return var1 + var2;
+}
+
+static uint32_t bme280_pressure(const bme280_calib_t *c, int32_t t_fine, int32_t adc_p)
+{
+  int32_t var1;
+  int32_t var2;
+  uint32_t p;
+
+  var1 = (t_fine >> 1) - 64000;
+  var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)c->p6;
+  var2 = var2 + ((var1 * (int32_t)c->p5) * 2);
+  var2 = (var2 >> 2) + ((int32_t)c->p4 * 65536);
+  var1 = ((((int32_t)c->p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) +
+          (((int32_t)c->p2 * var1) >> 1)) >> 18;
+  var1 = ((32768 + var1) * (int32_t)c->p1) >> 15;
+  if (var1 == 0) {
+    return 0U;
+  }
+  p = ((uint32_t)(1048576 - adc_p) - (uint32_t)(var2 >> 12)) * 3125U;
+  if (p < 0x80000000UL) {
+    p = (p << 1) / (uint32_t)var1;
+  } else {
+    p = (p / (uint32_t)var1) * 2U;
+  }
+  var1 = ((int32_t)c->p9 * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+  var2 = ((int32_t)(p >> 2) * (int32_t)c->p8) >> 13;
+  return (uint32_t)((int32_t)p + ((var1 + var2 + c->p7) >> 4));
+}
+
+static uint32_t bme280_humidity(const bme280_calib_t *c, int32_t t_fine, int32_t adc_h)
+{
+  int32_t v = t_fine - 76800;
+
+  v = (((((adc_h << 14) - ((int32_t)c->h4 * 1048576) - ((int32_t)c->h5 * v)) + 16384) >> 15) *
+       (((((((v * (int32_t)c->h6) >> 10) * (((v * (int32_t)c->h3) >> 11) + 32768)) >> 10) +
+          2097152) * (int32_t)c->h2 + 8192) >> 14));
+  v = v - (((((v >> 15) * (v >> 15)) >> 7) * (int32_t)c->h1) >> 4);
+  v = (v < 0) ? 0 : v;
+  v = (v > 419430400) ? 419430400 : v;
+  return (uint32_t)(v >> 12);
+}
+
+void bme280_compensate(const bme280_calib_t *calib, const uint8_t *data,
+                       bme280_sample_t *sample)
+{
+  int32_t adc_p = (int32_t)(((uint32_t)data[0] << 12) | ((uint32_t)data[1] << 4) | (data[2] >> 4));
+  int32_t adc_t = (int32_t)(((uint32_t)data[3] << 12) | ((uint32_t)data[4] << 4) | (data[5] >> 4));
+  int32_t adc_h = (int32_t)(((uint32_t)data[6] << 8) | data[7]);
+  int32_t t_fine = bme280_t_fine(calib, adc_t);
+
+  sample->temp_cdeg = (t_fine * 5 + 128) >> 8;
+  sample->pressure_pa = bme280_pressure(calib, t_fine, adc_p);
+  sample->humidity_q10 = bme280_humidity(calib, t_fine, adc_h);
+}
+
+static int bme280_write_reg(const bme280_t *bme, uint8_t reg, uint8_t value)
+{
+  return bme->dev->write(bme->dev->ctx, reg, &value, 1U);
+}
+
+bme280_status_t bme280_init(bme280_t *bme, const i2c_dev_t *dev)
+{
+  uint8_t tp[BME280_CALIB_TP_LEN];
+  uint8_t h[BME280_CALIB_H_LEN];
+  uint8_t id;
+
+  bme->dev = dev;
+  if (dev->read(dev->ctx, BME280_REG_ID, &id, 1U) != 0) {
+    return BME280_ERR_IO;
+  }
+  if (id != BME280_CHIP_ID) {
+    return BME280_ERR_ID;
+  }
+  if (dev->read(dev->ctx, BME280_REG_CALIB_TP, tp, sizeof(tp)) != 0 ||
+      dev->read(dev->ctx, BME280_REG_CALIB_H, h, sizeof(h)) != 0) {
+    return BME280_ERR_IO;
+  }
+  bme280_parse_calib(&bme->calib, tp, h);
+
+  /* ctrl_hum only takes effect on the next ctrl_meas write. No IIR filter:
+   * forced samples are far apart. */
+  if (bme280_write_reg(bme, BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS(BME280_MODE_SLEEP)) != 0 ||
+      bme280_write_reg(bme, BME280_REG_CONFIG, 0U) != 0 ||
+      bme280_write_reg(bme, BME280_REG_CTRL_HUM, BME280_OSRS_X1) != 0) {
+    return BME280_ERR_IO;
+  }
+  return BME280_OK;
+}
+
+bme280_status_t bme280_start(bme280_t *bme)
+{
+  return (bme280_write_reg(bme, BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS(BME280_MODE_FORCED)) == 0) ?
+         BME280_OK : BME280_ERR_IO;
+}
+
+bme280_status_t bme280_read(bme280_t *bme, bme280_sample_t *sample)
+{
+  const i2c_dev_t *dev = bme->dev;
+  uint8_t data[BME280_DATA_LEN];
+  uint8_t status;
+
+  if (dev->read(dev->ctx, BME280_REG_STATUS, &status, 1U) != 0) {
+    return BME280_ERR_IO;
+  }
+  if (status & BME280_STATUS_MEASURING) {
+    return BME280_BUSY;
+  }
+  if (dev->read(dev->ctx, BME280_REG_DATA, data, sizeof(data)) != 0) {
+    return BME280_ERR_IO;
+  }
+  bme280_compensate(&bme->calib, data, sample);
+  return BME280_OK;
+}
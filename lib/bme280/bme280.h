@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    bme280.h
+  * @brief   Bosch BME280 pressure, temperature and humidity sensor.
+  *
+  *          Forced mode: bme280_start() takes one measurement and the sensor
+  *          goes back to sleep; read it with bme280_read() once
+  *          BME280_MEASURE_TIME_MS have passed. Compensation is the
+  *          datasheet's 32-bit integer code, with no 64-bit division, so it
+  *          stays cheap on the M0+.
+  *
+  *          Pure C over i2c_dev_t; also runs on the host against
+  *          i2c_replay.
+  ******************************************************************************
+  */
+#ifndef BME280_H
+#define BME280_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "i2c_dev.h"
+
+#define BME280_ADDR             0x76U   /* SDO low; 0x77 with SDO high */
+#define BME280_CHIP_ID          0x60U
+
+/* 1x oversampling on every channel, 1.25 + 3 * 2.3 + 2 * 0.575 ms worst case */
+#define BME280_MEASURE_TIME_MS  10U
+
+typedef enum {
+  BME280_OK = 0,
+  BME280_BUSY = 1,                  /*!< Measurement still running */
+  BME280_ERR_IO = -1,
+  BME280_ERR_ID = -2,               /*!< Something else answered */
+} bme280_status_t;
+
+typedef struct {
+  uint16_t t1;
+  int16_t t2, t3;
+  uint16_t p1;
+  int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+  uint8_t h1, h3;
+  int16_t h2, h4, h5;
+  int8_t h6;
+} bme280_calib_t;
+
+typedef struct {
+  const i2c_dev_t *dev;
+  bme280_calib_t calib;
+} bme280_t;
+
+typedef struct {
+  int32_t temp_cdeg;                /*!< Hundredths of a degree Celsius */
+  uint32_t pressure_pa;
+  uint32_t humidity_q10;            /*!< %RH in Q22.10 */
+} bme280_sample_t;
+
+/**
+  * @brief  Check the chip ID, load the calibration and set up forced mode.
+  * @param  dev: register access, kept by reference
+  */
+bme280_status_t bme280_init(bme280_t *bme, const i2c_dev_t *dev);
+
+/**
+  * @brief  Start one forced-mode measurement.
+  */
+bme280_status_t bme280_start(bme280_t *bme);
+
+/**
+  * @brief  Read and compensate the last measurement.
+  * @retval BME280_OK, BME280_BUSY if it is not done yet, or an error
+  */
+bme280_status_t bme280_read(bme280_t *bme, bme280_sample_t *sample);
+
+/**
+  * @brief  Unpack the calibration registers: 26 bytes from 0x88 and 7 from
+  *         0xE1.
+  */
+void bme280_parse_calib(bme280_calib_t *calib, const uint8_t *tp, const uint8_t *h);
+
+/**
+  * @brief  Compensate raw readings from the 8 data bytes at 0xF7.
+  */
+void bme280_compensate(const bme280_calib_t *calib, const uint8_t *data,
+                       bme280_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BME280_H */
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    bme280_test.c
+  * @brief   Host build: the BME280 driver against i2c_replay.
+  *
+  *          The register file carries the calibration and the raw readings
+  *          of the datasheet's worked example (BMP280 rev 1.19, section
+  *          8.1, which the BME280 shares for temperature and pressure);
+  *          the 32-bit integer code gives 25.08 C and 100656 Pa for them.
+  *          Around that, the driver's own path: the chip ID, the setup it
+  *          writes, a measurement still running and a device that does not
+  *          answer:
+  *            bme280_test
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "bme280.h"
+#include "i2c_replay.h"
+
+#include <stdio.h>
+
+/* dig_T1..T3, dig_P1..P9, 0xA0, dig_H1: little-endian from 0x88 */
+static const uint8_t bme280_test_calib_tp[26] = {
+  0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,   /* 27504, 26435, -1000 */
+  0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,   /* 36477, -10685, 3024 */
+  0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF,   /* 2855, 140, -7 */
+  0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,   /* 15500, -14600, 6000 */
+  0x00, 0x4B,                           /* 75 */
+};
+
+/* dig_H2..H6 from 0xE1, as a typical part has them: 362, 0, 313, 50, 30 */
+static const uint8_t bme280_test_calib_h[7] = {
+  0x6A, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E,
+};
+
+/* adc_P 415148, adc_T 519888, then adc_H, from 0xF7 */
+static const uint8_t bme280_test_data[8] = {
+  0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x6E, 0x00,
+};
+
+static int bme280_test_failed;
+
+#define BME280_TEST_CHECK(cond)                                                \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s:%d: %s\n", __FILE__, __LINE__, #cond);             \
+      bme280_test_failed++;                                                    \
+    }                                                                          \
+  } while (0)
+
+static void bme280_test_load(i2c_replay_t *replay)
+{
+  const uint8_t id = BME280_CHIP_ID;
+
+  i2c_replay_init(replay);
+  i2c_replay_load(replay, 0xD0U, &id, 1U);
+  i2c_replay_load(replay, 0x88U, bme280_test_calib_tp, sizeof(bme280_test_calib_tp));
+  i2c_replay_load(replay, 0xE1U, bme280_test_calib_h, sizeof(bme280_test_calib_h));
+  i2c_replay_load(replay, 0xF7U, bme280_test_data, sizeof(bme280_test_data));
+}
+
+int main(void)
+{
+  static const uint8_t measuring = 0x08U;
+  static const uint8_t idle = 0x00U;
+  static const uint8_t other_id = 0x58U;  /* A BMP280 */
+  i2c_replay_t replay;
+  i2c_dev_t dev;
+  bme280_t bme;
+  bme280_sample_t sample = { 0, 0U, 0U };
+
+  bme280_test_load(&replay);
+  i2c_replay_dev(&replay, &dev);
+  BME280_TEST_CHECK(bme280_init(&bme, &dev) == BME280_OK);
+  BME280_TEST_CHECK(bme.calib.t1 == 27504U && bme.calib.t3 == -1000);
+  BME280_TEST_CHECK(bme.calib.p1 == 36477U && bme.calib.p9 == 6000);
+  BME280_TEST_CHECK(bme.calib.h1 == 75U && bme.calib.h4 == 313 && bme.calib.h5 == 50);
+  /* Sleep mode and x1 humidity, no IIR filter */
+  BME280_TEST_CHECK(replay.regs[0xF2] == 0x01U);
+  BME280_TEST_CHECK(replay.regs[0xF4] == 0x24U);
+  BME280_TEST_CHECK(replay.regs[0xF5] == 0x00U);
+
+  BME280_TEST_CHECK(bme280_start(&bme) == BME280_OK);
+  BME280_TEST_CHECK(replay.regs[0xF4] == 0x25U);
+  i2c_replay_load(&replay, 0xF3U, &measuring, 1U);
+  BME280_TEST_CHECK(bme280_read(&bme, &sample) == BME280_BUSY);
+  i2c_replay_load(&replay, 0xF3U, &idle, 1U);
+  BME280_TEST_CHECK(bme280_read(&bme, &sample) == BME280_OK);
+  printf("  %-22s %ld cdeg, %lu Pa, %lu.%02lu %%RH\n", "datasheet example",
+         (long)sample.temp_cdeg, (unsigned long)sample.pressure_pa,
+         (unsigned long)(sample.humidity_q10 >> 10),
+         (unsigned long)(((sample.humidity_q10 & 1023U) * 100U) >> 10));
+  BME280_TEST_CHECK(sample.temp_cdeg == 2508);
+  BME280_TEST_CHECK(sample.pressure_pa == 100656U);
+  BME280_TEST_CHECK(sample.humidity_q10 <= (100UL << 10));
+
+  /* Something else at the address, then nothing at all */
+  bme280_test_load(&replay);
+  i2c_replay_load(&replay, 0xD0U, &other_id, 1U);
+  BME280_TEST_CHECK(bme280_init(&bme, &dev) == BME280_ERR_ID);
+  BME280_TEST_CHECK(replay.writes == 0U);
+  replay.fail = 1;
+  BME280_TEST_CHECK(bme280_init(&bme, &dev) == BME280_ERR_IO);
+  BME280_TEST_CHECK(bme280_read(&bme, &sample) == BME280_ERR_IO);
+
+  printf("  %-22s %s\n", "bme280", (bme280_test_failed == 0) ? "ok" : "FAIL");
+  return (bme280_test_failed == 0) ? 0 : 1;
+}
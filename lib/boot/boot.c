@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    boot.c
+  * @brief   Boot profiler: TIM2 phase timestamps in .noinit, report and
+  *          console command.
+  ******************************************************************************
+  */
+#include "boot.h"
+#include "console.h"
+#include "cycles.h"
+#include "main.h"
+#include "sections.h"
+#include "tx_api.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BOOT_MAGIC              0xB0071A5EUL
+#define BOOT_FLAG_FAST          0x01U
+
+typedef struct {
+  uint32_t magic;
+  uint32_t flags;                       /*!< BOOT_FLAG_* */
+  uint32_t marked;                      /*!< Bit per phase reached */
+  uint32_t us[BOOT_PHASES];             /*!< Since main(), per phase */
+} boot_record_t;
+
+/* Outside .bss so that a boot which never got up is still there next time */
+static boot_record_t boot_record NOINIT;
+
+static boot_record_t boot_previous;
+static int boot_previous_valid;
+
+static int boot_running;
+static uint32_t boot_count;             /* Counter at the last mark */
+static uint32_t boot_mhz;               /* ... and its rate then */
+static uint32_t boot_elapsed;
+
+static const char *const boot_phase_names[BOOT_PHASES] = {
+  "main", "hal", "clock", "periph", "config", "reports",
+  "power", "kernel", "app", "thread", "deferred",
+};
+
+void boot_start(void)
+{
+  if (boot_record.magic == BOOT_MAGIC && boot_record.marked < (1UL << BOOT_PHASES)) {
+    boot_previous = boot_record;
+    boot_previous_valid = 1;
+  }
+  memset(&boot_record, 0, sizeof(boot_record));
+  boot_record.magic = BOOT_MAGIC;
+#ifdef PICOAPRS_FAST_BOOT
+  boot_record.flags = BOOT_FLAG_FAST;
+#endif
+  boot_record.marked = 1UL << BOOT_PHASE_MAIN;
+
+  cycles_start();
+  boot_count = cycles_now();
+  boot_mhz = cycles_mhz();
+  boot_elapsed = 0U;
+  boot_running = 1;
+}
+
+void boot_mark(boot_phase_t phase)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t now;
+
+  TX_DISABLE
+  if (boot_running && (boot_record.marked & (1UL << phase)) == 0U) {
+    now = cycles_now();
+    boot_elapsed += (now - boot_count) / boot_mhz;
+    boot_count = now;
+    boot_mhz = cycles_mhz();
+    boot_record.us[phase] = boot_elapsed;
+    boot_record.marked |= 1UL << phase;
+  }
+  TX_RESTORE
+}
+
+uint32_t boot_us(boot_phase_t phase)
+{
+  return boot_record.us[phase];
+}
+
+void boot_report(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  boot_running = 0;
+  cycles_stop();
+  TX_RESTORE
+
+  printf("boot: first thread at %lu us%s\n", (unsigned long)boot_record.us[BOOT_PHASE_THREAD],
+         (boot_record.flags & BOOT_FLAG_FAST) ? ", fast boot" : "");
+}
+
+/**
+  * @brief  One record as a table: each phase reached, its time and the
+  *         running total.
+  */
+static void boot_print(const boot_record_t *rec)
+{
+  uint32_t last = 0U;
+  uint32_t i;
+
+  printf("  %-8s %8s %8s\n", "phase", "us", "total");
+  for (i = BOOT_PHASE_MAIN + 1U; i < BOOT_PHASES; i++) {
+    if ((rec->marked & (1UL << i)) == 0U) {
+      continue;
+    }
+    printf("  %-8s %8lu %8lu\n", boot_phase_names[i], (unsigned long)(rec->us[i] - last),
+           (unsigned long)rec->us[i]);
+    last = rec->us[i];
+  }
+}
+
+static int console_cmd_boot(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+
+  printf("this boot%s:\n", (boot_record.flags & BOOT_FLAG_FAST) ? " (fast)" : "");
+  boot_print(&boot_record);
+  if (boot_previous_valid) {
+    printf("previous boot%s:\n", (boot_previous.flags & BOOT_FLAG_FAST) ? " (fast)" : "");
+    boot_print(&boot_previous);
+  }
+  return 0;
+}
+
+CONSOLE_COMMAND(boot, "time from main() to each boot phase", console_cmd_boot, NULL);
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    boot.h
+  * @brief   Boot profiler: how long each step from main() to the first
+  *          application thread takes.
+  *
+  *          boot_start() is the first thing main() does. It starts TIM2
+  *          free-running at the bus clock, before HAL_Init(), and each
+  *          boot_mark() afterwards adds the time since the previous mark,
+  *          in microseconds, to a record in .noinit. An interval is counted
+  *          at the clock in effect when it began, so the SystemClock_Config
+  *          step reads a little long. boot_report() stops the timer and
+  *          prints one line once the system is up; the `boot` command shows
+  *          the breakdown for this boot and the one before. A boot that
+  *          never got up (a brownout at dawn) leaves its partial record for
+  *          the next one to show.
+  *
+  *          Built with -DPICOAPRS_FAST_BOOT=ON, the app moves work that the
+  *          first beacon does not need (the banner, the flight log scan, the
+  *          RTC and its wait for LSE) into the console thread, and ThreadX
+  *          skips clearing globals that startup has already zeroed
+  *          (TX_DISABLE_REDUNDANT_CLEARING).
+  *          Deferred work ends with BOOT_PHASE_DEFERRED.
+  ******************************************************************************
+  */
+#ifndef BOOT_H
+#define BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* In boot order; a phase is timed from the last one marked before it */
+typedef enum {
+  BOOT_PHASE_MAIN = 0,                  /*!< main() entered: time 0 */
+  BOOT_PHASE_HAL,                       /*!< HAL_Init() */
+  BOOT_PHASE_CLOCK,                     /*!< SystemClock_Config() */
+  BOOT_PHASE_PERIPH,                    /*!< GPIO, DMA and USART2 */
+  BOOT_PHASE_CONFIG,                    /*!< Configuration loaded, UART re-timed */
+  BOOT_PHASE_REPORTS,                   /*!< Banner, crash report, flight log */
+  BOOT_PHASE_POWER,                     /*!< RTC, low power; not in fast boot */
+  BOOT_PHASE_KERNEL,                    /*!< tx_application_define() entered */
+  BOOT_PHASE_APP,                       /*!< Threads and services created */
+  BOOT_PHASE_THREAD,                    /*!< First application thread running */
+  BOOT_PHASE_DEFERRED,                  /*!< Fast boot: deferred work done */
+  BOOT_PHASES
+} boot_phase_t;
+
+/**
+  * @brief  Start the timer and a new record. First thing in main().
+  */
+void boot_start(void);
+
+/**
+  * @brief  Record that a phase is done. Later marks of the same phase, and
+  *         any after boot_report(), are ignored. Any context.
+  */
+void boot_mark(boot_phase_t phase);
+
+/**
+  * @brief  Microseconds from main() to a phase, 0 if not reached.
+  */
+uint32_t boot_us(boot_phase_t phase);
+
+/**
+  * @brief  Stop the timer and print the time to the first thread. Thread
+  *         context, once the boot work is done.
+  */
+void boot_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_H */
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * @file    clock.c
+  * @brief   System clock policy: subsystems ask for a performance level.
+  ******************************************************************************
+  */
+#include "clock.h"
+#include "console.h"
+#include "uart_tx.h"
+#ifdef PICOAPRS_HOST
+#include "clock_mock.h"
+#endif
+
+#include <stdio.h>
+
+extern TIM_HandleTypeDef htim6;
+
+static TX_MUTEX clock_mutex;
+static UART_HandleTypeDef *clock_huart;
+static uint8_t clock_requests[CLOCK_LEVELS];
+static clock_level_t clock_current = CLOCK_LEVEL_HIGH;
+static uint32_t clock_switches;
+
+#ifdef PICOAPRS_HOST
+/* The simulated part has no oscillators to come ready: the register model
+ * plays them */
+static clock_mock_t clock_host;
+static clock_regs_t clock_stm32;
+#else
+/* The USART's registers are filled in by clock_init() */
+static volatile uint32_t *clock_stm32_regs[CLOCK_REGS] = {
+  [CLOCK_REG_RCC_CR] = &RCC->CR,
+  [CLOCK_REG_RCC_CFGR] = &RCC->CFGR,
+  [CLOCK_REG_FLASH_ACR] = &FLASH->ACR,
+  [CLOCK_REG_PWR_CR1] = &PWR->CR1,
+  [CLOCK_REG_PWR_SR2] = &PWR->SR2,
+  [CLOCK_REG_RCC_CCIPR] = &RCC->CCIPR,
+};
+
+static uint32_t clock_stm32_read(void *ctx, clock_reg_t reg)
+{
+  (void)ctx;
+  return *clock_stm32_regs[reg];
+}
+
+static void clock_stm32_write(void *ctx, clock_reg_t reg, uint32_t value)
+{
+  (void)ctx;
+  *clock_stm32_regs[reg] = value;
+}
+
+static const clock_regs_t clock_stm32 = { clock_stm32_read, clock_stm32_write, NULL };
+#endif
+
+UINT clock_init(UART_HandleTypeDef *huart)
+{
+  clock_huart = huart;
+#ifdef PICOAPRS_HOST
+  /* The model starts at MSI 4 MHz, with the USART running from it */
+  clock_mock_init(&clock_host, 1U);
+  clock_mock_regs(&clock_host, &clock_stm32);
+  clock_host.baud = huart->Init.BaudRate;
+  clock_host.regs[CLOCK_REG_USART_BRR] = clock_uart_brr(clock_mock_sysclk(&clock_host),
+                                                        huart->Init.BaudRate);
+  clock_host.regs[CLOCK_REG_USART_CR1] = CLOCK_USART_CR1_UE;
+#else
+  clock_stm32_regs[CLOCK_REG_USART_CR1] = &huart->Instance->CR1;
+  clock_stm32_regs[CLOCK_REG_USART_BRR] = &huart->Instance->BRR;
+#endif
+  return tx_mutex_create(&clock_mutex, "Clock", TX_INHERIT);
+}
+
+/**
+  * @brief  Switch to level and re-time everything that depends on SYSCLK.
+  */
+static void clock_apply(clock_level_t level)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t hz = clock_level_desc(level)->hz;
+  uint32_t tick_freq = (hz < 1000000U) ? HAL_TICK_FREQ_100HZ : HAL_TICK_FREQ_1KHZ;
+
+  /* Nothing may be shifting out while the baud rate changes under it */
+  (void)uart_tx_lock(TX_WAIT_FOREVER);
+
+  TX_DISABLE
+  /* The USART is re-enabled with its BRR for the new clock */
+  if (clock_seq_switch_uart(&clock_stm32, level, clock_huart->Init.BaudRate) != 0) {
+    Error_Handler();
+  }
+  SystemCoreClock = hz;
+
+  SysTick->LOAD = clock_systick_reload(hz, TX_TIMER_TICKS_PER_SECOND);
+  SysTick->VAL = 0U;
+
+  /* The HAL tick counts in uwTickFreq ms steps; below 1 MHz a 1 kHz
+   * interrupt would eat the CPU, so it drops to 100 Hz */
+  uwTickFreq = tick_freq;
+  __HAL_TIM_SET_PRESCALER(&htim6, 0U);
+  __HAL_TIM_SET_AUTORELOAD(&htim6, hz / (1000U / tick_freq) - 1U);
+  htim6.Instance->EGR = TIM_EGR_UG;
+  __HAL_TIM_CLEAR_FLAG(&htim6, TIM_FLAG_UPDATE);
+
+  clock_current = level;
+  TX_RESTORE
+
+  uart_tx_unlock();
+  clock_switches++;
+}
+
+/**
+  * @brief  Move to the highest level requested. Called with clock_mutex held.
+  */
+static void clock_update(void)
+{
+  clock_level_t level = CLOCK_LEVEL_MIN;
+  uint32_t i;
+
+  for (i = 0; i < CLOCK_LEVELS; i++) {
+    if (clock_requests[i] != 0U) {
+      level = (clock_level_t)i;
+    }
+  }
+  if (level != clock_current) {
+    clock_apply(level);
+  }
+}
+
+void clock_request(clock_level_t level)
+{
+  (void)tx_mutex_get(&clock_mutex, TX_WAIT_FOREVER);
+  clock_requests[level]++;
+  clock_update();
+  tx_mutex_put(&clock_mutex);
+}
+
+void clock_release(clock_level_t level)
+{
+  (void)tx_mutex_get(&clock_mutex, TX_WAIT_FOREVER);
+  if (clock_requests[level] > 0U) {
+    clock_requests[level]--;
+  }
+  clock_update();
+  tx_mutex_put(&clock_mutex);
+}
+
+void clock_resume(void)
+{
+  /* Stop mode also stopped HSI16, which the USART may run from */
+  if (clock_seq_switch_uart(&clock_stm32, clock_current, clock_huart->Init.BaudRate) != 0) {
+    Error_Handler();
+  }
+}
+
+clock_level_t clock_level(void)
+{
+  return clock_current;
+}
+
+static int console_cmd_clock(int argc, char *argv[])
+{
+  const clock_level_desc_t *desc;
+  uint32_t i;
+  (void)argc;
+  (void)argv;
+
+  desc = clock_level_desc(clock_current);
+  printf("  %s, %lu Hz, %lu switches\n", desc->name, (unsigned long)desc->hz,
+         (unsigned long)clock_switches);
+  for (i = 0; i < CLOCK_LEVELS; i++) {
+    printf("  %-5s %u requests\n", clock_level_desc((clock_level_t)i)->name, clock_requests[i]);
+  }
+  return 0;
+}
+
+CONSOLE_COMMAND(clock, "show the clock level and who holds it up", console_cmd_clock, NULL);
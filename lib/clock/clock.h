@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    clock.h
+  * @brief   System clock policy: subsystems ask for a performance level.
+  *
+  *          Each subsystem holds requests for the level it needs while it
+  *          needs it; SYSCLK runs at the highest level held, or at
+  *          CLOCK_LEVEL_MIN when nothing is. Levels and the switching
+  *          sequence are in clock_seq.h.
+  *
+  *          A switch waits for the console UART to go idle and holds off
+  *          its writers, then with interrupts off changes the clock and
+  *          re-derives everything timed from it: SystemCoreClock, the UART
+  *          BRR, the ThreadX SysTick reload and the HAL's TIM6 time base.
+  *          Below the level the baud rate needs, the UART runs from HSI16.
+  *          A byte arriving during those few microseconds is lost.
+  ******************************************************************************
+  */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "tx_api.h"
+#include "clock_seq.h"
+
+/**
+  * @brief  Take over from SystemClock_Config(), which leaves SYSCLK at
+  *         CLOCK_LEVEL_HIGH. Nothing changes until the first request.
+  * @param  huart: UART whose baud rate follows the clock
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT clock_init(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  Hold a request for at least level. Thread context only; may
+  *         switch the clock before returning.
+  */
+void clock_request(clock_level_t level);
+
+/**
+  * @brief  Drop a request taken with clock_request().
+  */
+void clock_release(clock_level_t level);
+
+/**
+  * @brief  Put oscillator, wait states and low-power run back the way the
+  *         current level has them, e.g. after Stop mode. Interrupts must be
+  *         disabled; nothing derived from the clock is touched since the
+  *         frequency comes back the same.
+  */
+void clock_resume(void);
+
+/**
+  * @brief  Level SYSCLK runs at.
+  */
+clock_level_t clock_level(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_H */
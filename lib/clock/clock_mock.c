@@ -0,0 +1,182 @@
+/**
+  ******************************************************************************
+  * @file    clock_mock.c
+  * @brief   Host-side register model for testing clock_seq.
+  ******************************************************************************
+  */
+#include "clock_mock.h"
+
+#include <string.h>
+
+static const uint32_t clock_mock_msi_hz[16] = {
+  100000U, 200000U, 400000U, 800000U, 1000000U, 2000000U, 4000000U, 8000000U,
+  16000000U, 24000000U, 32000000U, 48000000U,
+};
+
+static void clock_mock_violation(clock_mock_t *mock, const char *what)
+{
+  if (mock->violations++ == 0U) {
+    mock->violation = what;
+  }
+}
+
+uint32_t clock_mock_sysclk(const clock_mock_t *mock)
+{
+  uint32_t sws = (mock->regs[CLOCK_REG_RCC_CFGR] & CLOCK_RCC_CFGR_SWS) >> CLOCK_RCC_CFGR_SWS_Pos;
+  uint32_t range = (mock->regs[CLOCK_REG_RCC_CR] & CLOCK_RCC_CR_MSIRANGE) >>
+                   CLOCK_RCC_CR_MSIRANGE_Pos;
+
+  return (sws == CLOCK_RCC_CFGR_SW_HSI) ? 16000000U : clock_mock_msi_hz[range];
+}
+
+uint32_t clock_mock_uart_hz(const clock_mock_t *mock)
+{
+  if ((mock->regs[CLOCK_REG_RCC_CCIPR] & CLOCK_RCC_CCIPR_USART2SEL) ==
+      CLOCK_RCC_CCIPR_USART2SEL_HSI) {
+    return (mock->regs[CLOCK_REG_RCC_CR] & CLOCK_RCC_CR_HSIRDY) ? CLOCK_HSI_HZ : 0U;
+  }
+  return clock_mock_sysclk(mock);
+}
+
+static void clock_mock_check(clock_mock_t *mock);
+
+/**
+  * @brief  Settle whatever the enable bits ask for.
+  */
+static void clock_mock_settle(clock_mock_t *mock)
+{
+  uint32_t *cr = &mock->regs[CLOCK_REG_RCC_CR];
+  uint32_t *cfgr = &mock->regs[CLOCK_REG_RCC_CFGR];
+  uint32_t sw = *cfgr & CLOCK_RCC_CFGR_SW;
+  uint32_t ready;
+
+  *cr = (*cr & CLOCK_RCC_CR_MSION) ? (*cr | CLOCK_RCC_CR_MSIRDY) : (*cr & ~CLOCK_RCC_CR_MSIRDY);
+  if ((*cr & CLOCK_RCC_CR_HSION) && !mock->stuck_hsi) {
+    *cr |= CLOCK_RCC_CR_HSIRDY;
+  } else {
+    *cr &= ~CLOCK_RCC_CR_HSIRDY;
+  }
+  ready = (sw == CLOCK_RCC_CFGR_SW_HSI) ? (*cr & CLOCK_RCC_CR_HSIRDY) : (*cr & CLOCK_RCC_CR_MSIRDY);
+  if (ready) {
+    *cfgr = (*cfgr & ~CLOCK_RCC_CFGR_SWS) | (sw << CLOCK_RCC_CFGR_SWS_Pos);
+  }
+  if (mock->regs[CLOCK_REG_PWR_CR1] & CLOCK_PWR_CR1_LPR) {
+    mock->regs[CLOCK_REG_PWR_SR2] |= CLOCK_PWR_SR2_REGLPF;
+  } else {
+    mock->regs[CLOCK_REG_PWR_SR2] &= ~CLOCK_PWR_SR2_REGLPF;
+  }
+}
+
+static uint32_t clock_mock_read(void *ctx, clock_reg_t reg)
+{
+  clock_mock_t *mock = ctx;
+
+  if (mock->pending[reg] > 0U && --mock->pending[reg] == 0U) {
+    clock_mock_settle(mock);
+    clock_mock_check(mock);
+  }
+  return mock->regs[reg];
+}
+
+/**
+  * @brief  The rules a running system must keep after every write.
+  */
+static void clock_mock_check(clock_mock_t *mock)
+{
+  uint32_t hz = clock_mock_sysclk(mock);
+  uint32_t cr = mock->regs[CLOCK_REG_RCC_CR];
+  uint32_t sws = (mock->regs[CLOCK_REG_RCC_CFGR] & CLOCK_RCC_CFGR_SWS) >> CLOCK_RCC_CFGR_SWS_Pos;
+
+  if (hz > CLOCK_WS0_MAX_HZ && (mock->regs[CLOCK_REG_FLASH_ACR] & CLOCK_FLASH_ACR_LATENCY) == 0U) {
+    clock_mock_violation(mock, "flash wait states too low for SYSCLK");
+  }
+  if (hz > CLOCK_LPR_MAX_HZ && (mock->regs[CLOCK_REG_PWR_SR2] & CLOCK_PWR_SR2_REGLPF)) {
+    clock_mock_violation(mock, "SYSCLK above 2 MHz in low-power run");
+  }
+  if (sws == CLOCK_RCC_CFGR_SW_HSI && !(cr & CLOCK_RCC_CR_HSION)) {
+    clock_mock_violation(mock, "HSI stopped while selected");
+  }
+  if (sws == CLOCK_RCC_CFGR_SW_MSI && !(cr & CLOCK_RCC_CR_MSION)) {
+    clock_mock_violation(mock, "MSI stopped while selected");
+  }
+  if (mock->regs[CLOCK_REG_USART_CR1] & CLOCK_USART_CR1_UE) {
+    if (clock_mock_uart_hz(mock) == 0U) {
+      clock_mock_violation(mock, "USART kernel clock stopped while enabled");
+    } else if (mock->baud != 0U &&
+               mock->regs[CLOCK_REG_USART_BRR] != clock_uart_brr(clock_mock_uart_hz(mock),
+                                                                 mock->baud)) {
+      clock_mock_violation(mock, "USART enabled with a BRR for another clock");
+    } else if (mock->regs[CLOCK_REG_USART_BRR] < 16U) {
+      clock_mock_violation(mock, "USART enabled with a BRR below 16");
+    }
+  }
+}
+
+static void clock_mock_write(void *ctx, clock_reg_t reg, uint32_t value)
+{
+  clock_mock_t *mock = ctx;
+  uint32_t old = mock->regs[reg];
+  uint32_t changed = old ^ value;
+  uint32_t sw = value & CLOCK_RCC_CFGR_SW;
+
+  mock->writes++;
+  if (reg == CLOCK_REG_RCC_CR && (changed & CLOCK_RCC_CR_MSIRANGE) &&
+      (old & CLOCK_RCC_CR_MSION) && !(old & CLOCK_RCC_CR_MSIRDY)) {
+    clock_mock_violation(mock, "MSIRANGE changed while MSI not ready");
+  }
+  if (reg == CLOCK_REG_RCC_CFGR && (changed & CLOCK_RCC_CFGR_SW) &&
+      !(mock->regs[CLOCK_REG_RCC_CR] &
+        ((sw == CLOCK_RCC_CFGR_SW_HSI) ? CLOCK_RCC_CR_HSIRDY : CLOCK_RCC_CR_MSIRDY))) {
+    clock_mock_violation(mock, "SYSCLK switched to an oscillator not ready");
+  }
+  if ((reg == CLOCK_REG_USART_BRR ||
+       (reg == CLOCK_REG_RCC_CCIPR && (changed & CLOCK_RCC_CCIPR_USART2SEL))) &&
+      (mock->regs[CLOCK_REG_USART_CR1] & CLOCK_USART_CR1_UE)) {
+    clock_mock_violation(mock, "USART clock or BRR changed while enabled");
+  }
+  if (reg == CLOCK_REG_PWR_CR1 && (value & CLOCK_PWR_CR1_LPR) && !(old & CLOCK_PWR_CR1_LPR) &&
+      clock_mock_sysclk(mock) > CLOCK_LPR_MAX_HZ) {
+    clock_mock_violation(mock, "low-power run entered above 2 MHz");
+  }
+
+  mock->regs[reg] = value;
+  /* Status bits are read-only */
+  if (reg == CLOCK_REG_RCC_CR) {
+    mock->regs[reg] = (value & ~(CLOCK_RCC_CR_MSIRDY | CLOCK_RCC_CR_HSIRDY)) |
+                      (old & (CLOCK_RCC_CR_MSIRDY | CLOCK_RCC_CR_HSIRDY));
+  } else if (reg == CLOCK_REG_RCC_CFGR) {
+    mock->regs[reg] = (value & ~CLOCK_RCC_CFGR_SWS) | (old & CLOCK_RCC_CFGR_SWS);
+  }
+
+  /* Turning things off takes effect at once, turning them on takes a while */
+  if (mock->delay == 0U) {
+    clock_mock_settle(mock);
+  } else {
+    if (reg == CLOCK_REG_RCC_CR) {
+      mock->regs[reg] &= ~((value & CLOCK_RCC_CR_MSION) ? 0U : CLOCK_RCC_CR_MSIRDY);
+      mock->regs[reg] &= ~((value & CLOCK_RCC_CR_HSION) ? 0U : CLOCK_RCC_CR_HSIRDY);
+      if (changed & CLOCK_RCC_CR_MSIRANGE) {
+        mock->regs[reg] &= ~CLOCK_RCC_CR_MSIRDY;
+      }
+    }
+    mock->pending[CLOCK_REG_RCC_CR] = mock->delay;
+    mock->pending[CLOCK_REG_RCC_CFGR] = mock->delay;
+    mock->pending[CLOCK_REG_PWR_SR2] = mock->delay;
+  }
+  clock_mock_check(mock);
+}
+
+void clock_mock_init(clock_mock_t *mock, uint32_t delay)
+{
+  memset(mock, 0, sizeof(*mock));
+  mock->delay = delay;
+  mock->regs[CLOCK_REG_RCC_CR] = CLOCK_RCC_CR_MSION | CLOCK_RCC_CR_MSIRDY |
+                                 (6UL << CLOCK_RCC_CR_MSIRANGE_Pos);
+}
+
+void clock_mock_regs(clock_mock_t *mock, clock_regs_t *regs)
+{
+  regs->read = clock_mock_read;
+  regs->write = clock_mock_write;
+  regs->ctx = mock;
+}
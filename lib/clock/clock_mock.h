@@ -0,0 +1,62 @@
+/**
+  ******************************************************************************
+  * @file    clock_mock.h
+  * @brief   Host-side register model for testing clock_seq.
+  *
+  *          Holds RCC_CR, RCC_CFGR, FLASH_ACR, PWR_CR1 and PWR_SR2, RCC_CCIPR
+  *          and the console USART's CR1 and BRR, and plays the hardware's
+  *          part: ready flags follow their enable bits after a few reads,
+  *          SWS follows SW once the oscillator is ready, and REGLPF follows
+  *          LPR. Every write, and every change the hardware makes, is
+  *          checked against the rules the sequence must keep; a broken one
+  *          is counted and described in violation.
+  *
+  *          Plain C with no target dependencies; not part of the firmware.
+  ******************************************************************************
+  */
+#ifndef CLOCK_MOCK_H
+#define CLOCK_MOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "clock_seq.h"
+
+typedef struct {
+  uint32_t regs[CLOCK_REGS];
+  uint32_t delay;               /*!< Reads before a flag settles */
+  uint32_t pending[CLOCK_REGS]; /*!< Reads left until it does */
+  uint32_t writes;
+  uint32_t violations;
+  const char *violation;        /*!< The first one */
+  int stuck_hsi;                /*!< Non-zero: HSIRDY never comes up */
+  uint32_t baud;                /*!< The USART's; 0 leaves its BRR unchecked */
+} clock_mock_t;
+
+/**
+  * @brief  Reset values: MSI at 4 MHz selected, no wait states, range 2.
+  */
+void clock_mock_init(clock_mock_t *mock, uint32_t delay);
+
+/**
+  * @brief  clock_regs_t view of the model.
+  */
+void clock_mock_regs(clock_mock_t *mock, clock_regs_t *regs);
+
+/**
+  * @brief  SYSCLK the model currently runs at, in Hz.
+  */
+uint32_t clock_mock_sysclk(const clock_mock_t *mock);
+
+/**
+  * @brief  Kernel clock the USART currently gets, in Hz; 0 if it is stopped.
+  */
+uint32_t clock_mock_uart_hz(const clock_mock_t *mock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_MOCK_H */
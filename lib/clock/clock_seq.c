@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file    clock_seq.c
+  * @brief   System clock levels and the register sequence between them.
+  ******************************************************************************
+  */
+#include "clock_seq.h"
+
+#include <stddef.h>
+
+static const clock_level_desc_t clock_levels[CLOCK_LEVELS] = {
+  /* name     hz         hsi  msirange  latency  lpr */
+  { "min",    100000UL,  0U,  0U,       0U,      1U },
+  { "low",    2000000UL, 0U,  5U,       0U,      1U },
+  { "mid",    4000000UL, 0U,  6U,       0U,      0U },
+  { "high",   16000000UL, 1U, 0U,       1U,      0U },
+};
+
+const clock_level_desc_t *clock_level_desc(clock_level_t level)
+{
+  return ((uint32_t)level < CLOCK_LEVELS) ? &clock_levels[level] : NULL;
+}
+
+static void clock_seq_modify(const clock_regs_t *regs, clock_reg_t reg, uint32_t clear,
+                             uint32_t set)
+{
+  regs->write(regs->ctx, reg, (regs->read(regs->ctx, reg) & ~clear) | set);
+}
+
+/**
+  * @brief  Poll until (reg & mask) == value.
+  */
+static int clock_seq_wait(const clock_regs_t *regs, clock_reg_t reg, uint32_t mask,
+                          uint32_t value)
+{
+  uint32_t n;
+
+  for (n = 0; n < CLOCK_SEQ_POLLS; n++) {
+    if ((regs->read(regs->ctx, reg) & mask) == value) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static int clock_seq_select(const clock_regs_t *regs, uint32_t sw)
+{
+  clock_seq_modify(regs, CLOCK_REG_RCC_CFGR, CLOCK_RCC_CFGR_SW, sw);
+  return clock_seq_wait(regs, CLOCK_REG_RCC_CFGR, CLOCK_RCC_CFGR_SWS,
+                        sw << CLOCK_RCC_CFGR_SWS_Pos);
+}
+
+/**
+  * @brief  Bring MSI to the wanted range and run from it.
+  */
+static int clock_seq_msi(const clock_regs_t *regs, uint32_t range)
+{
+  uint32_t cr = regs->read(regs->ctx, CLOCK_REG_RCC_CR);
+  uint32_t sws = (regs->read(regs->ctx, CLOCK_REG_RCC_CFGR) & CLOCK_RCC_CFGR_SWS) >>
+                 CLOCK_RCC_CFGR_SWS_Pos;
+  uint32_t field = (range << CLOCK_RCC_CR_MSIRANGE_Pos) | CLOCK_RCC_CR_MSIRGSEL;
+
+  /* MSIRANGE may only change with MSI off, or on and ready */
+  if ((cr & CLOCK_RCC_CR_MSION) &&
+      clock_seq_wait(regs, CLOCK_REG_RCC_CR, CLOCK_RCC_CR_MSIRDY, CLOCK_RCC_CR_MSIRDY) != 0) {
+    return -1;
+  }
+  if ((cr & (CLOCK_RCC_CR_MSIRANGE | CLOCK_RCC_CR_MSIRGSEL)) != field) {
+    clock_seq_modify(regs, CLOCK_REG_RCC_CR, CLOCK_RCC_CR_MSIRANGE, field);
+  }
+  clock_seq_modify(regs, CLOCK_REG_RCC_CR, 0U, CLOCK_RCC_CR_MSION);
+  if (clock_seq_wait(regs, CLOCK_REG_RCC_CR, CLOCK_RCC_CR_MSIRDY, CLOCK_RCC_CR_MSIRDY) != 0) {
+    return -1;
+  }
+  return (sws == CLOCK_RCC_CFGR_SW_MSI) ? 0 : clock_seq_select(regs, CLOCK_RCC_CFGR_SW_MSI);
+}
+
+static int clock_seq_hsi(const clock_regs_t *regs)
+{
+  clock_seq_modify(regs, CLOCK_REG_RCC_CR, 0U, CLOCK_RCC_CR_HSION);
+  if (clock_seq_wait(regs, CLOCK_REG_RCC_CR, CLOCK_RCC_CR_HSIRDY, CLOCK_RCC_CR_HSIRDY) != 0) {
+    return -1;
+  }
+  return clock_seq_select(regs, CLOCK_RCC_CFGR_SW_HSI);
+}
+
+int clock_seq_switch(const clock_regs_t *regs, clock_level_t level)
+{
+  const clock_level_desc_t *to = clock_level_desc(level);
+  uint32_t latency;
+  int ret;
+
+  if (to == NULL) {
+    return -1;
+  }
+
+  /* Speeding up: out of low-power run, then enough wait states */
+  if (!to->lpr && (regs->read(regs->ctx, CLOCK_REG_PWR_CR1) & CLOCK_PWR_CR1_LPR)) {
+    clock_seq_modify(regs, CLOCK_REG_PWR_CR1, CLOCK_PWR_CR1_LPR, 0U);
+    if (clock_seq_wait(regs, CLOCK_REG_PWR_SR2, CLOCK_PWR_SR2_REGLPF, 0U) != 0) {
+      return -1;
+    }
+  }
+  latency = regs->read(regs->ctx, CLOCK_REG_FLASH_ACR) & CLOCK_FLASH_ACR_LATENCY;
+  if (to->latency > latency) {
+    clock_seq_modify(regs, CLOCK_REG_FLASH_ACR, CLOCK_FLASH_ACR_LATENCY, to->latency);
+    if (clock_seq_wait(regs, CLOCK_REG_FLASH_ACR, CLOCK_FLASH_ACR_LATENCY, to->latency) != 0) {
+      return -1;
+    }
+  }
+
+  ret = to->hsi ? clock_seq_hsi(regs) : clock_seq_msi(regs, to->msirange);
+  if (ret != 0) {
+    return ret;
+  }
+
+  /* Slowed down: shed the wait states, the idle oscillator, and enter
+   * low-power run last */
+  if (to->latency < latency) {
+    clock_seq_modify(regs, CLOCK_REG_FLASH_ACR, CLOCK_FLASH_ACR_LATENCY, to->latency);
+  }
+  clock_seq_modify(regs, CLOCK_REG_RCC_CR, to->hsi ? CLOCK_RCC_CR_MSION : CLOCK_RCC_CR_HSION, 0U);
+  if (to->lpr) {
+    clock_seq_modify(regs, CLOCK_REG_PWR_CR1, 0U, CLOCK_PWR_CR1_LPR);
+  }
+  return 0;
+}
+
+int clock_seq_switch_uart(const clock_regs_t *regs, clock_level_t level, uint32_t baud)
+{
+  uint32_t hsi = (level < clock_level_for_baud(baud));
+  int ret;
+
+  if (clock_level_desc(level) == NULL) {
+    return -1;
+  }
+  /* BRR and the kernel clock only change with the USART disabled */
+  clock_seq_modify(regs, CLOCK_REG_USART_CR1, CLOCK_USART_CR1_UE, 0U);
+  ret = clock_seq_switch(regs, level);
+  if (ret != 0) {
+    return ret;
+  }
+
+  /* Below the baud rate's floor HSI16 runs for the USART alone */
+  if (hsi) {
+    clock_seq_modify(regs, CLOCK_REG_RCC_CR, 0U, CLOCK_RCC_CR_HSION);
+    if (clock_seq_wait(regs, CLOCK_REG_RCC_CR, CLOCK_RCC_CR_HSIRDY, CLOCK_RCC_CR_HSIRDY) != 0) {
+      return -1;
+    }
+  }
+  clock_seq_modify(regs, CLOCK_REG_RCC_CCIPR, CLOCK_RCC_CCIPR_USART2SEL,
+                   hsi ? CLOCK_RCC_CCIPR_USART2SEL_HSI : 0U);
+  regs->write(regs->ctx, CLOCK_REG_USART_BRR, clock_uart_brr(clock_uart_kernel_hz(level, baud),
+                                                             baud));
+  clock_seq_modify(regs, CLOCK_REG_USART_CR1, 0U, CLOCK_USART_CR1_UE);
+  return 0;
+}
+
+uint32_t clock_uart_kernel_hz(clock_level_t level, uint32_t baud)
+{
+  const clock_level_desc_t *desc = clock_level_desc(level);
+
+  if (desc == NULL || level < clock_level_for_baud(baud)) {
+    return CLOCK_HSI_HZ;
+  }
+  return desc->hz;
+}
+
+uint32_t clock_systick_reload(uint32_t hz, uint32_t tick_hz)
+{
+  return (hz + tick_hz / 2U) / tick_hz - 1U;
+}
+
+uint32_t clock_uart_brr(uint32_t hz, uint32_t baud)
+{
+  return (hz + baud / 2U) / baud;
+}
+
+clock_level_t clock_level_for_baud(uint32_t baud)
+{
+  const clock_level_desc_t *desc;
+  uint32_t level;
+  uint32_t brr;
+  uint32_t actual;
+  uint32_t error;
+
+  for (level = 0; level < CLOCK_LEVELS - 1U; level++) {
+    desc = &clock_levels[level];
+    brr = clock_uart_brr(desc->hz, baud);
+    if (brr < 16U) {
+      continue;
+    }
+    actual = desc->hz / brr;
+    error = (actual > baud) ? actual - baud : baud - actual;
+    if (error * 50U <= baud) {
+      break;
+    }
+  }
+  return (clock_level_t)level;
+}
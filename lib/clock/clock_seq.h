@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * @file    clock_seq.h
+  * @brief   System clock levels and the register sequence between them.
+  *
+  *          Four levels, all in voltage range 2 with AHB and APB undivided:
+  *            CLOCK_LEVEL_MIN   MSI 100 kHz, low-power run
+  *            CLOCK_LEVEL_LOW   MSI 2 MHz, low-power run
+  *            CLOCK_LEVEL_MID   MSI 4 MHz
+  *            CLOCK_LEVEL_HIGH  HSI16, one flash wait state
+  *
+  *          clock_seq_switch() moves between any two of them in the order
+  *          RM0503 asks for: leave low-power run and add wait states before
+  *          speeding up, remove them and re-enter low-power run after slowing
+  *          down, only select an oscillator once it is ready, and only stop
+  *          the one no longer in use. It touches the hardware through
+  *          clock_regs_t, so the same code runs against the real RCC, FLASH
+  *          and PWR registers on target and against clock_mock on the host.
+  *
+  *          clock_seq_switch_uart() does the same with the console USART
+  *          stopped around it. Where SYSCLK cannot carry the baud rate, the
+  *          USART comes back on HSI16 instead, so its BRR is valid at every
+  *          level.
+  *
+  *          The helpers below re-derive what depends on the clock. Pure C,
+  *          also builds on the host.
+  ******************************************************************************
+  */
+#ifndef CLOCK_SEQ_H
+#define CLOCK_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Register bits used by the sequence (RM0503) */
+#define CLOCK_RCC_CR_MSION          (1UL << 0)
+#define CLOCK_RCC_CR_MSIRDY         (1UL << 1)
+#define CLOCK_RCC_CR_MSIRGSEL       (1UL << 3)
+#define CLOCK_RCC_CR_MSIRANGE_Pos   4U
+#define CLOCK_RCC_CR_MSIRANGE       (0xFUL << CLOCK_RCC_CR_MSIRANGE_Pos)
+#define CLOCK_RCC_CR_HSION          (1UL << 8)
+#define CLOCK_RCC_CR_HSIRDY         (1UL << 10)
+#define CLOCK_RCC_CFGR_SW           (0x7UL << 0)
+#define CLOCK_RCC_CFGR_SWS_Pos      3U
+#define CLOCK_RCC_CFGR_SWS          (0x7UL << CLOCK_RCC_CFGR_SWS_Pos)
+#define CLOCK_RCC_CFGR_SW_MSI       0U
+#define CLOCK_RCC_CFGR_SW_HSI       1U
+#define CLOCK_FLASH_ACR_LATENCY     (0x7UL << 0)
+#define CLOCK_PWR_CR1_LPR           (1UL << 14)
+#define CLOCK_PWR_SR2_REGLPF        (1UL << 9)
+#define CLOCK_RCC_CCIPR_USART2SEL   (0x3UL << 2)
+#define CLOCK_RCC_CCIPR_USART2SEL_HSI (0x2UL << 2)
+#define CLOCK_USART_CR1_UE          (1UL << 0)
+
+#define CLOCK_HSI_HZ                16000000UL
+
+#define CLOCK_LPR_MAX_HZ            2000000UL   /* Low-power run ceiling */
+#define CLOCK_WS0_MAX_HZ            8000000UL   /* Range 2, zero wait states */
+#define CLOCK_SEQ_POLLS             10000U      /* Ready-flag polls before giving up */
+
+typedef enum {
+  CLOCK_LEVEL_MIN = 0,
+  CLOCK_LEVEL_LOW,
+  CLOCK_LEVEL_MID,
+  CLOCK_LEVEL_HIGH,
+  CLOCK_LEVELS
+} clock_level_t;
+
+typedef enum {
+  CLOCK_REG_RCC_CR,
+  CLOCK_REG_RCC_CFGR,
+  CLOCK_REG_FLASH_ACR,
+  CLOCK_REG_PWR_CR1,
+  CLOCK_REG_PWR_SR2,
+  CLOCK_REG_RCC_CCIPR,
+  CLOCK_REG_USART_CR1,              /*!< The console USART's */
+  CLOCK_REG_USART_BRR,
+  CLOCK_REGS
+} clock_reg_t;
+
+typedef struct {
+  uint32_t (*read)(void *ctx, clock_reg_t reg);
+  void (*write)(void *ctx, clock_reg_t reg, uint32_t value);
+  void *ctx;
+} clock_regs_t;
+
+typedef struct {
+  const char *name;
+  uint32_t hz;
+  uint8_t hsi;                      /*!< 1: HSI16, 0: MSI at msirange */
+  uint8_t msirange;
+  uint8_t latency;                  /*!< Flash wait states */
+  uint8_t lpr;                      /*!< Low-power run */
+} clock_level_desc_t;
+
+/**
+  * @brief  What a level runs at, NULL past the last one.
+  */
+const clock_level_desc_t *clock_level_desc(clock_level_t level);
+
+/**
+  * @brief  Switch SYSCLK to a level from whatever it runs at now.
+  * @retval 0 on success, -1 if an oscillator or the regulator never got ready
+  */
+int clock_seq_switch(const clock_regs_t *regs, clock_level_t level);
+
+/**
+  * @brief  clock_seq_switch() with the console USART disabled around it.
+  *         The USART is enabled again from clock_uart_kernel_hz(), with
+  *         BRR re-derived for that clock first.
+  * @retval 0 on success, -1 as clock_seq_switch(); the USART stays disabled
+  */
+int clock_seq_switch_uart(const clock_regs_t *regs, clock_level_t level, uint32_t baud);
+
+/**
+  * @brief  Kernel clock of the console USART at level: SYSCLK, as PCLK,
+  *         from clock_level_for_baud() up, HSI16 below it.
+  */
+uint32_t clock_uart_kernel_hz(clock_level_t level, uint32_t baud);
+
+/**
+  * @brief  SysTick reload for tick_hz interrupts at SYSCLK hz.
+  */
+uint32_t clock_systick_reload(uint32_t hz, uint32_t tick_hz);
+
+/**
+  * @brief  16x-oversampled USART BRR for baud at kernel clock hz, rounded.
+  */
+uint32_t clock_uart_brr(uint32_t hz, uint32_t baud);
+
+/**
+  * @brief  Lowest level that can carry baud: BRR of at least 16 and a rate
+  *         within 2% of the nominal one.
+  */
+clock_level_t clock_level_for_baud(uint32_t baud);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_SEQ_H */
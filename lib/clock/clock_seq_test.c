@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file    clock_seq_test.c
+  * @brief   Host build: clock_seq_switch_uart() between every pair of levels
+  *          against clock_mock, at several ready latencies and baud rates.
+  *
+  *          On top of the rules clock_mock enforces on each access, every
+  *          access is traced to check the order of a switch:
+  *            - wait states go up before SYSCLK does, and come down only
+  *              after it has;
+  *            - the USART is disabled before SYSCLK changes, and its BRR is
+  *              written after the last change and before it is enabled;
+  *          and where each switch leaves the clock tree and the USART:
+  *            clock_seq_test
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "clock_mock.h"
+#include "clock_seq.h"
+
+#include <stdio.h>
+
+#define CLOCK_SEQ_TEST_DELAYS   4U      /* Ready latencies 0 to 3 polls */
+
+static const uint32_t clock_seq_test_bauds[] = { 9600U, 115200U };
+
+/* Step numbers of the events that have an order, 0 for not seen */
+typedef struct {
+  clock_mock_t mock;
+  uint32_t step;
+  uint32_t sysclk;
+  uint32_t latency;
+  uint32_t sysclk_first;
+  uint32_t sysclk_last;
+  uint32_t latency_step;
+  uint32_t ue_off;
+  uint32_t ue_on;
+  uint32_t brr_write;
+} clock_seq_test_trace_t;
+
+static clock_regs_t clock_seq_test_mock_regs;
+static int clock_seq_test_failed;
+
+#define CLOCK_SEQ_TEST_CHECK(cond, from, to)                                   \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s -> %s: %s\n", clock_level_desc(from)->name,         \
+              clock_level_desc(to)->name, #cond);                              \
+      clock_seq_test_failed++;                                                 \
+    }                                                                          \
+  } while (0)
+
+/**
+  * @brief  After each access: note when SYSCLK or the wait states changed.
+  */
+static void clock_seq_test_observe(clock_seq_test_trace_t *t)
+{
+  uint32_t sysclk = clock_mock_sysclk(&t->mock);
+  uint32_t latency = t->mock.regs[CLOCK_REG_FLASH_ACR] & CLOCK_FLASH_ACR_LATENCY;
+
+  t->step++;
+  if (sysclk != t->sysclk) {
+    t->sysclk_first = (t->sysclk_first == 0U) ? t->step : t->sysclk_first;
+    t->sysclk_last = t->step;
+    t->sysclk = sysclk;
+  }
+  if (latency != t->latency) {
+    t->latency_step = t->step;
+    t->latency = latency;
+  }
+}
+
+static uint32_t clock_seq_test_read(void *ctx, clock_reg_t reg)
+{
+  clock_seq_test_trace_t *t = ctx;
+  uint32_t value = clock_seq_test_mock_regs.read(&t->mock, reg);
+
+  clock_seq_test_observe(t);
+  return value;
+}
+
+static void clock_seq_test_write(void *ctx, clock_reg_t reg, uint32_t value)
+{
+  clock_seq_test_trace_t *t = ctx;
+  uint32_t ue = t->mock.regs[CLOCK_REG_USART_CR1] & CLOCK_USART_CR1_UE;
+
+  clock_seq_test_mock_regs.write(&t->mock, reg, value);
+  clock_seq_test_observe(t);
+  if (reg == CLOCK_REG_USART_CR1 && ue && !(value & CLOCK_USART_CR1_UE)) {
+    t->ue_off = t->step;
+  } else if (reg == CLOCK_REG_USART_CR1 && !ue && (value & CLOCK_USART_CR1_UE)) {
+    t->ue_on = t->step;
+  } else if (reg == CLOCK_REG_USART_BRR) {
+    t->brr_write = t->step;
+  }
+}
+
+static void clock_seq_test_mark(clock_seq_test_trace_t *t)
+{
+  t->step = 0U;
+  t->sysclk = clock_mock_sysclk(&t->mock);
+  t->latency = t->mock.regs[CLOCK_REG_FLASH_ACR] & CLOCK_FLASH_ACR_LATENCY;
+  t->sysclk_first = 0U;
+  t->sysclk_last = 0U;
+  t->latency_step = 0U;
+  t->ue_off = 0U;
+  t->ue_on = 0U;
+  t->brr_write = 0U;
+}
+
+/**
+  * @brief  Reset, go to from, then trace the switch to to.
+  */
+static void clock_seq_test_pair(clock_level_t from, clock_level_t to, uint32_t delay,
+                                uint32_t baud)
+{
+  static clock_seq_test_trace_t t;
+  const clock_level_desc_t *a = clock_level_desc(from);
+  const clock_level_desc_t *b = clock_level_desc(to);
+  clock_regs_t regs = { clock_seq_test_read, clock_seq_test_write, &t };
+  uint32_t kernel = clock_uart_kernel_hz(to, baud);
+  uint32_t cr;
+
+  /* Out of reset with the USART running from MSI 4 MHz */
+  clock_mock_init(&t.mock, delay);
+  clock_mock_regs(&t.mock, &clock_seq_test_mock_regs);
+  t.mock.baud = baud;
+  t.mock.regs[CLOCK_REG_USART_BRR] = clock_uart_brr(clock_mock_sysclk(&t.mock), baud);
+  t.mock.regs[CLOCK_REG_USART_CR1] = CLOCK_USART_CR1_UE;
+  CLOCK_SEQ_TEST_CHECK(clock_seq_switch_uart(&regs, from, baud) == 0, from, to);
+
+  clock_seq_test_mark(&t);
+  CLOCK_SEQ_TEST_CHECK(clock_seq_switch_uart(&regs, to, baud) == 0, from, to);
+  if (t.mock.violations != 0U) {
+    fprintf(stderr, "  %s -> %s, %lu polls, %lu Bd: %s\n", a->name, b->name,
+            (unsigned long)delay, (unsigned long)baud, t.mock.violation);
+    clock_seq_test_failed++;
+  }
+
+  /* Wait states: up before the clock, down after it */
+  if (b->latency > a->latency) {
+    CLOCK_SEQ_TEST_CHECK(t.latency_step != 0U && t.latency_step < t.sysclk_first, from, to);
+  } else if (b->latency < a->latency) {
+    CLOCK_SEQ_TEST_CHECK(t.latency_step > t.sysclk_last, from, to);
+  } else {
+    CLOCK_SEQ_TEST_CHECK(t.latency_step == 0U, from, to);
+  }
+
+  /* USART: off before the clock moves, BRR after it settles, then on */
+  CLOCK_SEQ_TEST_CHECK(t.ue_off != 0U && t.brr_write != 0U && t.ue_on != 0U, from, to);
+  CLOCK_SEQ_TEST_CHECK(t.sysclk_first == 0U || t.ue_off < t.sysclk_first, from, to);
+  CLOCK_SEQ_TEST_CHECK(t.brr_write > t.sysclk_last && t.brr_write < t.ue_on, from, to);
+
+  /* Where it ends up */
+  cr = t.mock.regs[CLOCK_REG_RCC_CR];
+  CLOCK_SEQ_TEST_CHECK(clock_mock_sysclk(&t.mock) == b->hz, from, to);
+  CLOCK_SEQ_TEST_CHECK((t.mock.regs[CLOCK_REG_FLASH_ACR] & CLOCK_FLASH_ACR_LATENCY) == b->latency,
+                       from, to);
+  CLOCK_SEQ_TEST_CHECK(((t.mock.regs[CLOCK_REG_PWR_CR1] & CLOCK_PWR_CR1_LPR) != 0U) == b->lpr,
+                       from, to);
+  CLOCK_SEQ_TEST_CHECK(((cr & CLOCK_RCC_CR_MSION) != 0U) == !b->hsi, from, to);
+  CLOCK_SEQ_TEST_CHECK(((cr & CLOCK_RCC_CR_HSION) != 0U) == (b->hsi || kernel != b->hz),
+                       from, to);
+  CLOCK_SEQ_TEST_CHECK(clock_mock_uart_hz(&t.mock) == kernel, from, to);
+  CLOCK_SEQ_TEST_CHECK(t.mock.regs[CLOCK_REG_USART_BRR] == clock_uart_brr(kernel, baud),
+                       from, to);
+  CLOCK_SEQ_TEST_CHECK(t.mock.regs[CLOCK_REG_USART_BRR] >= 16U, from, to);
+  CLOCK_SEQ_TEST_CHECK((t.mock.regs[CLOCK_REG_USART_CR1] & CLOCK_USART_CR1_UE) != 0U, from, to);
+}
+
+/**
+  * @brief  HSI16 never comes ready: the switches that need it fail, and
+  *         the USART is left disabled rather than on a dead clock.
+  */
+static void clock_seq_test_stuck(clock_level_t to, uint32_t baud)
+{
+  clock_mock_t mock;
+  clock_regs_t regs;
+
+  clock_mock_init(&mock, 1U);
+  clock_mock_regs(&mock, &regs);
+  mock.stuck_hsi = 1;
+  mock.baud = baud;
+  mock.regs[CLOCK_REG_USART_BRR] = clock_uart_brr(clock_mock_sysclk(&mock), baud);
+  mock.regs[CLOCK_REG_USART_CR1] = CLOCK_USART_CR1_UE;
+  CLOCK_SEQ_TEST_CHECK(clock_seq_switch_uart(&regs, to, baud) == -1, CLOCK_LEVEL_MID, to);
+  CLOCK_SEQ_TEST_CHECK(mock.violations == 0U, CLOCK_LEVEL_MID, to);
+  CLOCK_SEQ_TEST_CHECK((mock.regs[CLOCK_REG_USART_CR1] & CLOCK_USART_CR1_UE) == 0U,
+                       CLOCK_LEVEL_MID, to);
+}
+
+int main(void)
+{
+  uint32_t pairs = 0U;
+  uint32_t from;
+  uint32_t to;
+  uint32_t delay;
+  uint32_t i;
+
+  /* The floors the levels are chosen against */
+  CLOCK_SEQ_TEST_CHECK(clock_level_for_baud(115200U) == CLOCK_LEVEL_MID, CLOCK_LEVEL_MID,
+                       CLOCK_LEVEL_MID);
+  CLOCK_SEQ_TEST_CHECK(clock_level_for_baud(9600U) == CLOCK_LEVEL_LOW, CLOCK_LEVEL_LOW,
+                       CLOCK_LEVEL_LOW);
+  CLOCK_SEQ_TEST_CHECK(clock_level_for_baud(1200U) == CLOCK_LEVEL_MIN, CLOCK_LEVEL_MIN,
+                       CLOCK_LEVEL_MIN);
+
+  for (i = 0U; i < sizeof(clock_seq_test_bauds) / sizeof(clock_seq_test_bauds[0]); i++) {
+    for (delay = 0U; delay < CLOCK_SEQ_TEST_DELAYS; delay++) {
+      for (from = 0U; from < CLOCK_LEVELS; from++) {
+        for (to = 0U; to < CLOCK_LEVELS; to++) {
+          clock_seq_test_pair((clock_level_t)from, (clock_level_t)to, delay,
+                              clock_seq_test_bauds[i]);
+          pairs++;
+        }
+      }
+    }
+  }
+  printf("  %-22s %lu switches  %s\n", "level pairs", (unsigned long)pairs,
+         (clock_seq_test_failed == 0) ? "ok" : "FAIL");
+
+  clock_seq_test_stuck(CLOCK_LEVEL_HIGH, 115200U);
+  clock_seq_test_stuck(CLOCK_LEVEL_MIN, 115200U);
+
+  printf("  %-22s %s\n", "clock sequence", (clock_seq_test_failed == 0) ? "ok" : "FAIL");
+  return (clock_seq_test_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/**
+  ******************************************************************************
+  * @file    config.c
+  * @brief   Persistent payload configuration with A/B flash copies.
+  ******************************************************************************
+  */
+#include "config.h"
+#include "crc32.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONFIG_DWORD            8U
+#define CONFIG_HEADER_SIZE      16U     /* magic/version/length + generation/crc */
+
+#define CONFIG_DEFAULTS_INIT    {                                              \
+    .callsign = "N0CALL",                                                      \
+    .ssid = 11U,                                                               \
+    .path = "WIDE2-1",                                                         \
+    .beacon_interval = 60U,                                                    \
+    .led_interval = 100U,                                                      \
+    .uart_baud = 115200U,                                                      \
+  }
+
+#define CONFIG_FIELD(name, type, min, max)                                     \
+  { #name, (type), offsetof(config_t, name), sizeof(((config_t *)0)->name), (min), (max) }
+
+config_t config_cache = CONFIG_DEFAULTS_INIT;
+
+static const config_t config_defaults = CONFIG_DEFAULTS_INIT;
+
+static const config_field_t config_fields[] = {
+  CONFIG_FIELD(callsign, CONFIG_FIELD_STR, 3U, CONFIG_CALLSIGN_LEN - 1U),
+  CONFIG_FIELD(ssid, CONFIG_FIELD_U8, 0U, 15U),
+  CONFIG_FIELD(path, CONFIG_FIELD_STR, 0U, CONFIG_PATH_LEN - 1U),
+  CONFIG_FIELD(beacon_interval, CONFIG_FIELD_U16, 10U, 3600U),
+  CONFIG_FIELD(led_interval, CONFIG_FIELD_U16, 10U, 1000U),
+  CONFIG_FIELD(uart_baud, CONFIG_FIELD_U32, 9600U, 921600U),
+};
+
+#define CONFIG_FIELD_COUNT      (sizeof(config_fields) / sizeof(config_fields[0]))
+
+/* config_migrations[v] upgrades a version v image, already loaded over the
+ * defaults, to version v + 1. NULL when appending fields was all it took. */
+typedef void (*config_migrate_t)(config_t *cfg);
+
+static const config_migrate_t config_migrations[CONFIG_VERSION] = {
+  NULL,                           /* [0] unused, versions start at 1 */
+};
+
+static const flash_dev_t *config_flash;
+static uint32_t config_page;      /* Page holding the copy in charge */
+static uint32_t config_gen;       /* Its generation, 0 if none */
+
+static uint32_t config_field_get(const config_t *cfg, const config_field_t *field)
+{
+  const uint8_t *p = (const uint8_t *)cfg + field->offset;
+  uint16_t u16;
+  uint32_t u32;
+
+  switch (field->type) {
+  case CONFIG_FIELD_U8:
+    return *p;
+  case CONFIG_FIELD_U16:
+    memcpy(&u16, p, sizeof(u16));
+    return u16;
+  case CONFIG_FIELD_U32:
+    memcpy(&u32, p, sizeof(u32));
+    return u32;
+  default:
+    return (uint32_t)strlen((const char *)p);
+  }
+}
+
+static void config_field_put(config_t *cfg, const config_field_t *field, uint32_t value)
+{
+  uint8_t *p = (uint8_t *)cfg + field->offset;
+  uint16_t u16 = (uint16_t)value;
+
+  switch (field->type) {
+  case CONFIG_FIELD_U8:
+    *p = (uint8_t)value;
+    break;
+  case CONFIG_FIELD_U16:
+    memcpy(p, &u16, sizeof(u16));
+    break;
+  case CONFIG_FIELD_U32:
+    memcpy(p, &value, sizeof(value));
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+  * @brief  Replace anything out of range (from a schema whose limits have
+  *         since changed) with its default, and terminate strings.
+  */
+static void config_sanitize(config_t *cfg)
+{
+  const config_field_t *field;
+  uint32_t value;
+  uint32_t i;
+
+  for (i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    field = &config_fields[i];
+    if (field->type == CONFIG_FIELD_STR) {
+      ((char *)cfg)[field->offset + field->size - 1U] = '\0';
+    }
+    value = config_field_get(cfg, field);
+    if (value < field->min || value > field->max) {
+      memcpy((uint8_t *)cfg + field->offset, (const uint8_t *)&config_defaults + field->offset,
+             field->size);
+    }
+  }
+}
+
+/**
+  * @brief  Load one copy over the defaults.
+  * @retval 1 if the copy is complete and intact, 0 otherwise
+  */
+static int config_read_copy(uint32_t page, config_t *cfg, uint32_t *gen, uint32_t *version)
+{
+  const flash_dev_t *flash = config_flash;
+  uint32_t base = page * flash->page_size;
+  uint64_t header;
+  uint64_t dword;
+  uint32_t length;
+  uint32_t crc;
+  uint32_t offset;
+  uint32_t n;
+  uint8_t *dst = (uint8_t *)cfg;
+
+  if (flash->read(flash->ctx, base, &header) != 0 || (uint32_t)header != CONFIG_MAGIC) {
+    return 0;
+  }
+  *version = (uint32_t)(header >> 32) & 0xFFFFU;
+  length = (uint32_t)(header >> 48);
+  if (*version == 0U ||
+      CONFIG_HEADER_SIZE + ((length + CONFIG_DWORD - 1U) & ~(CONFIG_DWORD - 1U)) + CONFIG_DWORD >
+      flash->page_size) {
+    return 0;
+  }
+  if (flash->read(flash->ctx, base + CONFIG_DWORD, &dword) != 0) {
+    return 0;
+  }
+  *gen = (uint32_t)dword;
+  crc = crc32_update(CRC32_INIT, &header, sizeof(header));
+  crc = crc32_update(crc, gen, sizeof(*gen));
+
+  *cfg = config_defaults;
+  for (offset = 0; offset < length; offset += CONFIG_DWORD) {
+    uint64_t data;
+
+    if (flash->read(flash->ctx, base + CONFIG_HEADER_SIZE + offset, &data) != 0) {
+      return 0;
+    }
+    n = ((length - offset) < CONFIG_DWORD) ? (length - offset) : CONFIG_DWORD;
+    crc = crc32_update(crc, &data, n);
+    /* Bytes past our config_t are fields from newer firmware */
+    if (offset < sizeof(config_t)) {
+      n = ((sizeof(config_t) - offset) < n) ? (uint32_t)(sizeof(config_t) - offset) : n;
+      memcpy(&dst[offset], &data, n);
+    }
+  }
+  if (crc32_final(crc) != (uint32_t)(dword >> 32)) {
+    return 0;
+  }
+
+  offset = CONFIG_HEADER_SIZE + ((length + CONFIG_DWORD - 1U) & ~(CONFIG_DWORD - 1U));
+  return flash->read(flash->ctx, base + offset, &dword) == 0 && dword == CONFIG_COMMIT;
+}
+
+config_status_t config_init(const flash_dev_t *flash)
+{
+  config_t copy;
+  uint32_t gen;
+  uint32_t version;
+  uint32_t best_version = 0U;
+  uint32_t page;
+  uint32_t v;
+
+  if (flash == NULL || flash->page_count < 2U ||
+      flash->page_size < CONFIG_HEADER_SIZE + sizeof(config_t) + 2U * CONFIG_DWORD) {
+    return CONFIG_ERR_PARAM;
+  }
+  config_flash = flash;
+  config_cache = config_defaults;
+  config_gen = 0U;
+  config_page = 1U;               /* So the first save goes to page 0 */
+
+  for (page = 0; page < 2U; page++) {
+    if (config_read_copy(page, &copy, &gen, &version) && gen > config_gen) {
+      config_cache = copy;
+      config_gen = gen;
+      config_page = page;
+      best_version = version;
+    }
+  }
+  if (config_gen == 0U) {
+    return CONFIG_DEFAULTS;
+  }
+
+  for (v = best_version; v < CONFIG_VERSION; v++) {
+    if (config_migrations[v] != NULL) {
+      config_migrations[v](&config_cache);
+    }
+  }
+  config_sanitize(&config_cache);
+  return (best_version < CONFIG_VERSION) ? CONFIG_MIGRATED : CONFIG_OK;
+}
+
+config_status_t config_save(void)
+{
+  const flash_dev_t *flash = config_flash;
+  uint32_t target = config_page ^ 1U;
+  uint32_t base;
+  uint32_t gen = config_gen + 1U;
+  uint32_t length = sizeof(config_t);
+  const uint8_t *src = (const uint8_t *)&config_cache;
+  uint8_t chunk[CONFIG_DWORD];
+  uint64_t header;
+  uint64_t dword;
+  uint32_t crc;
+  uint32_t offset;
+  uint32_t n;
+
+  if (flash == NULL) {
+    return CONFIG_ERR_PARAM;
+  }
+  base = target * flash->page_size;
+
+  header = CONFIG_MAGIC | ((uint64_t)CONFIG_VERSION << 32) | ((uint64_t)length << 48);
+  crc = crc32_update(CRC32_INIT, &header, sizeof(header));
+  crc = crc32_update(crc, &gen, sizeof(gen));
+  crc = crc32_final(crc32_update(crc, src, length));
+
+  if (flash->erase(flash->ctx, target) != 0 ||
+      flash->program(flash->ctx, base, header) != 0 ||
+      flash->program(flash->ctx, base + CONFIG_DWORD, ((uint64_t)crc << 32) | gen) != 0) {
+    return CONFIG_ERR_IO;
+  }
+  for (offset = 0; offset < length; offset += CONFIG_DWORD) {
+    n = ((length - offset) < CONFIG_DWORD) ? (length - offset) : CONFIG_DWORD;
+    memset(chunk, 0xFF, sizeof(chunk));
+    memcpy(chunk, &src[offset], n);
+    memcpy(&dword, chunk, sizeof(dword));
+    if (flash->program(flash->ctx, base + CONFIG_HEADER_SIZE + offset, dword) != 0) {
+      return CONFIG_ERR_IO;
+    }
+  }
+  offset = CONFIG_HEADER_SIZE + ((length + CONFIG_DWORD - 1U) & ~(CONFIG_DWORD - 1U));
+  if (flash->program(flash->ctx, base + offset, CONFIG_COMMIT) != 0) {
+    return CONFIG_ERR_IO;
+  }
+
+  config_page = target;
+  config_gen = gen;
+  return CONFIG_OK;
+}
+
+void config_reset(void)
+{
+  config_cache = config_defaults;
+}
+
+const config_field_t *config_field(uint32_t index)
+{
+  return (index < CONFIG_FIELD_COUNT) ? &config_fields[index] : NULL;
+}
+
+const config_field_t *config_field_find(const char *key)
+{
+  uint32_t i;
+
+  for (i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (strcmp(config_fields[i].key, key) == 0) {
+      return &config_fields[i];
+    }
+  }
+  return NULL;
+}
+
+config_status_t config_set(const char *key, const char *value)
+{
+  const config_field_t *field = config_field_find(key);
+  unsigned long number;
+  uint32_t len;
+  char *end;
+
+  if (field == NULL) {
+    return CONFIG_ERR_KEY;
+  }
+  if (value == NULL) {
+    return CONFIG_ERR_VALUE;
+  }
+
+  if (field->type == CONFIG_FIELD_STR) {
+    len = (uint32_t)strlen(value);
+    if (len < field->min || len > field->max) {
+      return CONFIG_ERR_VALUE;
+    }
+    memcpy((uint8_t *)&config_cache + field->offset, value, len + 1U);
+    return CONFIG_OK;
+  }
+
+  number = strtoul(value, &end, 10);
+  if (end == value || *end != '\0' || number < field->min || number > field->max) {
+    return CONFIG_ERR_VALUE;
+  }
+  config_field_put(&config_cache, field, (uint32_t)number);
+  return CONFIG_OK;
+}
+
+int config_format(const config_field_t *field, char *buf, uint32_t size)
+{
+  const char *p = (const char *)&config_cache + field->offset;
+
+  if (field->type == CONFIG_FIELD_STR) {
+    return snprintf(buf, size, "%s", p);
+  }
+  return snprintf(buf, size, "%lu", (unsigned long)config_field_get(&config_cache, field));
+}
+
+uint32_t config_generation(void)
+{
+  return config_gen;
+}
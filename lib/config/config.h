@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * @file    config.h
+  * @brief   Persistent payload configuration with A/B flash copies.
+  *
+  *          Settings live in config_t, a RAM copy loaded once at boot, so a
+  *          read is a plain struct access through config_get(). Changes go
+  *          through config_set(), by key and value string (what the console
+  *          hands over), and reach flash on config_save().
+  *
+  *          Flash holds two copies, one per page of a dedicated page pair.
+  *          A save erases the page not holding the newest copy and writes a
+  *          new image there with the next generation number, its commit
+  *          marker last, so a reset mid-save leaves the previous copy in
+  *          charge. Boot picks the newest copy whose CRC and marker check
+  *          out, or the defaults if neither does.
+  *
+  *          Schema: fields are only ever appended to config_t, and each
+  *          append bumps CONFIG_VERSION. Loading an older image keeps the
+  *          prefix it has and takes defaults for the rest; per-version
+  *          hooks in config_migrations[] handle anything more involved.
+  *          An image from newer firmware loads the fields this one knows.
+  *
+  *          Pure C over flash_dev_t; also runs on the host against
+  *          flash_sim. Single writer: readers are not locked out while
+  *          config_set() changes a field.
+  ******************************************************************************
+  */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "flash_dev.h"
+
+#define CONFIG_MAGIC            0x47464E43UL    /* "CNFG" */
+#define CONFIG_COMMIT           0x3C3CC3C35A5AA5A5ULL
+#define CONFIG_VERSION          1U
+
+#define CONFIG_CALLSIGN_LEN     7U              /* 6 characters + NUL */
+#define CONFIG_PATH_LEN         24U
+
+typedef struct {
+  /* Version 1 */
+  char callsign[CONFIG_CALLSIGN_LEN];
+  uint8_t ssid;                     /*!< 0-15 */
+  char path[CONFIG_PATH_LEN];       /*!< Digipeater path, e.g. "WIDE2-1" */
+  uint16_t beacon_interval;         /*!< Seconds between position beacons */
+  uint16_t led_interval;            /*!< Heartbeat LED period, ticks */
+  uint32_t uart_baud;               /*!< Console USART2 baud rate */
+  /* Append new fields here and bump CONFIG_VERSION */
+} config_t;
+
+typedef enum {
+  CONFIG_OK = 0,
+  CONFIG_DEFAULTS = 1,              /*!< No valid copy in flash */
+  CONFIG_MIGRATED = 2,              /*!< Loaded from an older schema */
+  CONFIG_ERR_PARAM = -1,
+  CONFIG_ERR_IO = -2,
+  CONFIG_ERR_KEY = -3,
+  CONFIG_ERR_VALUE = -4,
+} config_status_t;
+
+typedef enum {
+  CONFIG_FIELD_STR,
+  CONFIG_FIELD_U8,
+  CONFIG_FIELD_U16,
+  CONFIG_FIELD_U32,
+} config_field_type_t;
+
+typedef struct {
+  const char *key;
+  config_field_type_t type;
+  uint16_t offset;                  /*!< In config_t */
+  uint16_t size;                    /*!< Bytes, including the NUL for strings */
+  uint32_t min;                     /*!< Numbers: range. Strings: minimum length */
+  uint32_t max;
+} config_field_t;
+
+extern config_t config_cache;
+
+/**
+  * @brief  Current settings. Valid from boot; defaults until config_init().
+  */
+static inline const config_t *config_get(void)
+{
+  return &config_cache;
+}
+
+/**
+  * @brief  Load the newest valid copy from a two-page region.
+  * @param  flash: region of exactly 2 pages, kept by reference
+  * @retval CONFIG_OK, CONFIG_MIGRATED, CONFIG_DEFAULTS or CONFIG_ERR_PARAM
+  */
+config_status_t config_init(const flash_dev_t *flash);
+
+/**
+  * @brief  Change one setting in RAM after parsing and range-checking it.
+  * @param  key: field name, see config_field()
+  * @param  value: decimal number or string
+  */
+config_status_t config_set(const char *key, const char *value);
+
+/**
+  * @brief  Write the RAM settings to the older flash copy.
+  */
+config_status_t config_save(void);
+
+/**
+  * @brief  Put the defaults back in RAM. Flash is untouched until a save.
+  */
+void config_reset(void);
+
+/**
+  * @brief  Field descriptor by index, NULL past the last one.
+  */
+const config_field_t *config_field(uint32_t index);
+
+/**
+  * @brief  Field descriptor by key, NULL if unknown.
+  */
+const config_field_t *config_field_find(const char *key);
+
+/**
+  * @brief  Current value of a field as text.
+  * @retval length written, excluding the NUL
+  */
+int config_format(const config_field_t *field, char *buf, uint32_t size);
+
+/**
+  * @brief  Generation number of the copy in charge, 0 if none.
+  */
+uint32_t config_generation(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_H */
@@ -0,0 +1,253 @@
+/**
+  ******************************************************************************
+  * @file    config_test.c
+  * @brief   Host build: the configuration store on flash_sim, through
+  *          every way a copy in flash can be stale or broken.
+  *
+  *          Images are written by config_save() where it can make them and
+  *          by hand, in the same layout, where it can't: a shorter image
+  *          from an older schema, one from newer firmware, out-of-range
+  *          values, a bad CRC. A save is also cut by a power loss at every
+  *          program and erase it makes:
+  *            config_test
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "config.h"
+#include "crc32.h"
+#include "flash_sim.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CONFIG_TEST_PAGE_SIZE   2048U
+#define CONFIG_TEST_BYTES       (2U * CONFIG_TEST_PAGE_SIZE)
+
+static uint8_t config_test_mem[CONFIG_TEST_BYTES];
+static uint8_t config_test_torn[CONFIG_TEST_BYTES / 8U];
+
+static flash_sim_t config_test_sim;
+static flash_dev_t config_test_dev;
+
+static int config_test_failed;
+
+#define CONFIG_TEST_CHECK(cond)                                                \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s:%d: %s\n", __FILE__, __LINE__, #cond);             \
+      config_test_failed++;                                                    \
+    }                                                                          \
+  } while (0)
+
+static void config_test_blank(void)
+{
+  flash_sim_init(&config_test_sim, config_test_mem, config_test_torn, NULL,
+                 CONFIG_TEST_PAGE_SIZE, 2U);
+  flash_sim_dev(&config_test_sim, &config_test_dev);
+}
+
+/**
+  * @brief  Write an image in config_save()'s layout, with any header.
+  * @param  crc_xor: nonzero to store a wrong CRC
+  */
+static void config_test_image(uint32_t page, uint32_t version, uint32_t length, uint32_t gen,
+                              const void *data, uint32_t crc_xor)
+{
+  uint32_t base = page * CONFIG_TEST_PAGE_SIZE;
+  const uint8_t *src = (const uint8_t *)data;
+  uint8_t chunk[8];
+  uint64_t header;
+  uint64_t dword;
+  uint32_t offset;
+  uint32_t crc;
+  uint32_t n;
+
+  header = CONFIG_MAGIC | ((uint64_t)version << 32) | ((uint64_t)length << 48);
+  crc = crc32_update(CRC32_INIT, &header, sizeof(header));
+  crc = crc32_update(crc, &gen, sizeof(gen));
+  crc = crc32_final(crc32_update(crc, src, length)) ^ crc_xor;
+
+  CONFIG_TEST_CHECK(config_test_dev.erase(config_test_dev.ctx, page) == 0);
+  CONFIG_TEST_CHECK(config_test_dev.program(config_test_dev.ctx, base, header) == 0);
+  CONFIG_TEST_CHECK(config_test_dev.program(config_test_dev.ctx, base + 8U,
+                                            ((uint64_t)crc << 32) | gen) == 0);
+  for (offset = 0U; offset < length; offset += 8U) {
+    n = ((length - offset) < 8U) ? (length - offset) : 8U;
+    memset(chunk, 0xFF, sizeof(chunk));
+    memcpy(chunk, &src[offset], n);
+    memcpy(&dword, chunk, sizeof(dword));
+    CONFIG_TEST_CHECK(config_test_dev.program(config_test_dev.ctx, base + 16U + offset,
+                                              dword) == 0);
+  }
+  offset = 16U + ((length + 7U) & ~7U);
+  CONFIG_TEST_CHECK(config_test_dev.program(config_test_dev.ctx, base + offset,
+                                            CONFIG_COMMIT) == 0);
+}
+
+static void config_test_defaults(void)
+{
+  config_test_blank();
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_DEFAULTS);
+  CONFIG_TEST_CHECK(config_generation() == 0U);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "N0CALL") == 0);
+  CONFIG_TEST_CHECK(config_get()->uart_baud == 115200U);
+}
+
+static void config_test_round_trip(void)
+{
+  config_test_blank();
+  (void)config_init(&config_test_dev);
+  CONFIG_TEST_CHECK(config_set("callsign", "DL1ABC") == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_set("beacon_interval", "120") == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_set("beacon_interval", "5") == CONFIG_ERR_VALUE);
+  CONFIG_TEST_CHECK(config_set("ssid", "16") == CONFIG_ERR_VALUE);
+  CONFIG_TEST_CHECK(config_set("callsign", "AB") == CONFIG_ERR_VALUE);
+  CONFIG_TEST_CHECK(config_set("nosuchkey", "1") == CONFIG_ERR_KEY);
+  CONFIG_TEST_CHECK(config_save() == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_set("ssid", "9") == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_save() == CONFIG_OK);
+
+  /* Reboot: the second save, in the other page, is in charge */
+  config_reset();
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_generation() == 2U);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "DL1ABC") == 0);
+  CONFIG_TEST_CHECK(config_get()->beacon_interval == 120U);
+  CONFIG_TEST_CHECK(config_get()->ssid == 9U);
+}
+
+/**
+  * @brief  An image from before led_interval and uart_baud were appended:
+  *         the fields it has load, the rest take their defaults.
+  */
+static void config_test_old_schema(void)
+{
+  config_t old = *config_get();
+
+  config_test_blank();
+  memcpy(old.callsign, "G4XYZ", sizeof("G4XYZ"));
+  old.beacon_interval = 300U;
+  old.uart_baud = 9600U;
+  config_test_image(0U, 1U, offsetof(config_t, led_interval), 7U, &old, 0U);
+
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) ==
+                    ((1U < CONFIG_VERSION) ? CONFIG_MIGRATED : CONFIG_OK));
+  CONFIG_TEST_CHECK(config_generation() == 7U);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "G4XYZ") == 0);
+  CONFIG_TEST_CHECK(config_get()->beacon_interval == 300U);
+  CONFIG_TEST_CHECK(config_get()->uart_baud == 115200U);
+}
+
+/**
+  * @brief  An image from newer firmware, with fields past config_t, and
+  *         a value outside this firmware's range.
+  */
+static void config_test_new_schema(void)
+{
+  uint8_t image[sizeof(config_t) + 16U];
+  config_t cfg = *config_get();
+
+  config_test_blank();
+  memcpy(cfg.callsign, "VK2AB", sizeof("VK2AB"));
+  cfg.led_interval = 5U;                /* Below the minimum of 10 */
+  memset(image, 0xA5, sizeof(image));
+  memcpy(image, &cfg, sizeof(cfg));
+  config_test_image(1U, CONFIG_VERSION + 1U, sizeof(image), 3U, image, 0U);
+
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_generation() == 3U);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "VK2AB") == 0);
+  CONFIG_TEST_CHECK(config_get()->led_interval == 100U);
+}
+
+/**
+  * @brief  A CRC mismatch, stored wrong or from a damaged byte, drops that
+  *         copy for the other one, however new it claims to be.
+  */
+static void config_test_crc(void)
+{
+  config_t cfg = *config_get();
+
+  config_test_blank();
+  memcpy(cfg.callsign, "OLDER", sizeof("OLDER"));
+  config_test_image(0U, CONFIG_VERSION, sizeof(config_t), 10U, &cfg, 0U);
+  memcpy(cfg.callsign, "NEWER", sizeof("NEWER"));
+  config_test_image(1U, CONFIG_VERSION, sizeof(config_t), 11U, &cfg, 0x00010000UL);
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_generation() == 10U);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "OLDER") == 0);
+
+  /* A good CRC over the image, then a bit of the stored callsign flips */
+  config_test_image(1U, CONFIG_VERSION, sizeof(config_t), 11U, &cfg, 0U);
+  config_test_mem[CONFIG_TEST_PAGE_SIZE + 16U] ^= 0x01U;
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_OK);
+  CONFIG_TEST_CHECK(config_generation() == 10U);
+
+  /* Both copies bad: defaults */
+  config_test_mem[16U] ^= 0x01U;
+  CONFIG_TEST_CHECK(config_init(&config_test_dev) == CONFIG_DEFAULTS);
+  CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "N0CALL") == 0);
+}
+
+/**
+  * @brief  Cut the power at each program or erase of a save in turn: after
+  *         the reboot, either the new copy or the previous one is in charge,
+  *         never a mix and never the defaults.
+  */
+static void config_test_torn_save(void)
+{
+  uint32_t ops;
+  uint32_t cut;
+  uint32_t seed;
+  config_status_t status;
+
+  for (cut = 1U; ; cut++) {
+    for (seed = 1U; seed <= 8U; seed++) {
+      config_test_blank();
+      (void)config_init(&config_test_dev);
+      CONFIG_TEST_CHECK(config_set("callsign", "OLD") == CONFIG_OK);
+      CONFIG_TEST_CHECK(config_save() == CONFIG_OK);
+      CONFIG_TEST_CHECK(config_set("callsign", "OLD2") == CONFIG_OK);
+      CONFIG_TEST_CHECK(config_save() == CONFIG_OK);
+
+      /* This save goes over the first copy's page */
+      CONFIG_TEST_CHECK(config_set("callsign", "NEW") == CONFIG_OK);
+      CONFIG_TEST_CHECK(config_set("uart_baud", "9600") == CONFIG_OK);
+      ops = config_test_sim.ops;
+      flash_sim_cut_after(&config_test_sim, cut, seed * 0x9E3779B9UL);
+      status = config_save();
+      flash_sim_power_on(&config_test_sim);
+
+      config_reset();
+      (void)config_init(&config_test_dev);
+      if (status == CONFIG_OK) {
+        CONFIG_TEST_CHECK(config_generation() == 3U);
+        CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "NEW") == 0);
+        CONFIG_TEST_CHECK(config_get()->uart_baud == 9600U);
+      } else {
+        CONFIG_TEST_CHECK(config_generation() == 2U);
+        CONFIG_TEST_CHECK(strcmp(config_get()->callsign, "OLD2") == 0);
+        CONFIG_TEST_CHECK(config_get()->uart_baud == 115200U);
+      }
+    }
+    /* The cut fell after the last operation: the save completed */
+    if (config_test_sim.ops - ops < cut) {
+      break;
+    }
+  }
+  printf("  %-22s %lu cut points\n", "torn save", (unsigned long)cut - 1UL);
+}
+
+int main(void)
+{
+  config_test_defaults();
+  config_test_round_trip();
+  config_test_old_schema();
+  config_test_new_schema();
+  config_test_crc();
+  config_test_torn_save();
+
+  printf("  %-22s %s\n", "config store", (config_test_failed == 0) ? "ok" : "FAIL");
+  return (config_test_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+/**
+  ******************************************************************************
+  * @file    console.c
+  * @brief   Line-oriented command console: editor, tokenizer, dispatch.
+  ******************************************************************************
+  */
+#include "console.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Bounds of the command table, provided by the linker */
+extern const console_cmd_t __start_console_cmds[];
+extern const console_cmd_t __stop_console_cmds[];
+
+#define CONSOLE_ESC_NONE        0U
+#define CONSOLE_ESC_START       1U      /* Got ESC */
+#define CONSOLE_ESC_CSI         2U      /* Got ESC [, skip to the final byte */
+
+static void console_puts(const console_t *console, const char *s)
+{
+  console->write(s, (uint32_t)strlen(s));
+}
+
+static void console_prompt(const console_t *console)
+{
+  console_puts(console, CONSOLE_PROMPT);
+  console->write(console->line, console->len);
+}
+
+static const console_cmd_t *console_find_n(const char *name, uint32_t len)
+{
+  const console_cmd_t *cmd;
+
+  for (cmd = __start_console_cmds; cmd < __stop_console_cmds; cmd++) {
+    if (strncmp(cmd->name, name, len) == 0 && cmd->name[len] == '\0') {
+      return cmd;
+    }
+  }
+  return NULL;
+}
+
+const console_cmd_t *console_find(const char *name)
+{
+  return console_find_n(name, (uint32_t)strlen(name));
+}
+
+int console_tokenize(char *line, char *argv[], int max)
+{
+  char *p = line;
+  int argc = 0;
+
+  while (*p != '\0' && argc < max) {
+    while (*p == ' ') {
+      p++;
+    }
+    if (*p == '\0') {
+      break;
+    }
+    if (*p == '"') {
+      argv[argc++] = ++p;
+      while (*p != '\0' && *p != '"') {
+        p++;
+      }
+    } else {
+      argv[argc++] = p;
+      while (*p != '\0' && *p != ' ') {
+        p++;
+      }
+    }
+    if (*p != '\0') {
+      *p++ = '\0';
+    }
+  }
+  return argc;
+}
+
+int console_execute(char *line)
+{
+  char *argv[CONSOLE_MAX_ARGS];
+  const console_cmd_t *cmd;
+  int argc;
+  int ret;
+
+  argc = console_tokenize(line, argv, (int)CONSOLE_MAX_ARGS);
+  if (argc == 0) {
+    return 0;
+  }
+  cmd = console_find(argv[0]);
+  if (cmd == NULL) {
+    printf("unknown command: %s (try help)\n", argv[0]);
+    return -1;
+  }
+  ret = cmd->fn(argc, argv);
+  if (ret != 0) {
+    printf("%s: error %d\n", argv[0], ret);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Completion candidate number index for argument argi of cmd
+  *         (argi 0 is the command name itself).
+  */
+static const char *console_candidate(const console_cmd_t *cmd, int argi, uint32_t index)
+{
+  if (argi == 0) {
+    return (&__start_console_cmds[index] < __stop_console_cmds) ?
+           __start_console_cmds[index].name : NULL;
+  }
+  return (cmd != NULL && cmd->complete != NULL) ? cmd->complete(argi, index) : NULL;
+}
+
+static void console_complete(console_t *console)
+{
+  const console_cmd_t *cmd = NULL;
+  const char *word;
+  const char *name;
+  const char *common = NULL;
+  uint32_t start = console->len;
+  uint32_t word_len;
+  uint32_t common_len = 0;
+  uint32_t matches = 0;
+  uint32_t i;
+  uint32_t n;
+  int argi = 0;
+
+  while (start > 0U && console->line[start - 1U] != ' ') {
+    start--;
+  }
+  word = &console->line[start];
+  word_len = console->len - start;
+
+  /* Which argument is being typed, and for which command */
+  for (i = 0; i < start; i++) {
+    if (console->line[i] != ' ' && (i == 0U || console->line[i - 1U] == ' ')) {
+      argi++;
+    }
+  }
+  if (argi > 0) {
+    for (n = 0; n < start && console->line[n] != ' '; n++) {
+    }
+    cmd = console_find_n(console->line, n);
+  }
+
+  for (i = 0; (name = console_candidate(cmd, argi, i)) != NULL; i++) {
+    if (strncmp(name, word, word_len) != 0) {
+      continue;
+    }
+    if (matches++ == 0U) {
+      common = name;
+      common_len = (uint32_t)strlen(name);
+    } else {
+      for (n = word_len; n < common_len && common[n] == name[n]; n++) {
+      }
+      common_len = n;
+    }
+  }
+
+  if (matches == 0U) {
+    console_puts(console, "\a");
+  } else if (common_len > word_len) {
+    /* Extend to the longest shared prefix, plus a space if it is unique */
+    for (n = word_len; n < common_len && console->len < CONSOLE_LINE_SIZE - 1U; n++) {
+      console->line[console->len++] = common[n];
+    }
+    if (matches == 1U && console->len < CONSOLE_LINE_SIZE - 1U) {
+      console->line[console->len++] = ' ';
+    }
+    console->write(&console->line[start + word_len], console->len - start - word_len);
+  } else if (matches > 1U) {
+    console_puts(console, "\r\n");
+    for (i = 0; (name = console_candidate(cmd, argi, i)) != NULL; i++) {
+      if (strncmp(name, word, word_len) == 0) {
+        console_puts(console, name);
+        console_puts(console, "  ");
+      }
+    }
+    console_puts(console, "\r\n");
+    console_prompt(console);
+  }
+}
+
+void console_init(console_t *console, console_write_t write)
+{
+  console->write = write;
+  console->len = 0U;
+  console->escape = CONSOLE_ESC_NONE;
+  console->last = '\0';
+  console_prompt(console);
+}
+
+void console_feed(console_t *console, char c)
+{
+  char last = console->last;
+
+  console->last = c;
+
+  /* Cursor keys and friends: swallow the whole sequence */
+  if (console->escape == CONSOLE_ESC_START) {
+    console->escape = (c == '[') ? CONSOLE_ESC_CSI : CONSOLE_ESC_NONE;
+    return;
+  }
+  if (console->escape == CONSOLE_ESC_CSI) {
+    if (c >= 0x40 && c <= 0x7E) {
+      console->escape = CONSOLE_ESC_NONE;
+    }
+    return;
+  }
+
+  switch (c) {
+  case '\n':
+    if (last == '\r') {
+      break;                        /* Second half of CR LF */
+    }
+    /* fall through */
+  case '\r':
+    console_puts(console, "\r\n");
+    console->line[console->len] = '\0';
+    console->len = 0U;
+    (void)console_execute(console->line);
+    console_prompt(console);
+    break;
+
+  case '\b':
+  case 0x7F:
+    if (console->len > 0U) {
+      console->len--;
+      console_puts(console, "\b \b");
+    }
+    break;
+
+  case 0x03:                        /* Ctrl-C: drop the line */
+    console->len = 0U;
+    console_puts(console, "^C\r\n");
+    console_prompt(console);
+    break;
+
+  case '\t':
+    console_complete(console);
+    break;
+
+  case 0x1B:
+    console->escape = CONSOLE_ESC_START;
+    break;
+
+  default:
+    if (c >= 0x20 && c < 0x7F && console->len < CONSOLE_LINE_SIZE - 1U) {
+      console->line[console->len++] = c;
+      console->write(&c, 1U);
+    } else {
+      console_puts(console, "\a");
+    }
+    break;
+  }
+}
+
+static int console_cmd_help(int argc, char *argv[])
+{
+  const console_cmd_t *cmd;
+  (void)argc;
+  (void)argv;
+
+  for (cmd = __start_console_cmds; cmd < __stop_console_cmds; cmd++) {
+    printf("  %-10s %s\n", cmd->name, cmd->help);
+  }
+  return 0;
+}
+
+CONSOLE_COMMAND(help, "list commands", console_cmd_help, NULL);
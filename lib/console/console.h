@@ -0,0 +1,105 @@
+/**
+  ******************************************************************************
+  * @file    console.h
+  * @brief   Line-oriented command console: editor, tokenizer, dispatch.
+  *
+  *          Bytes from the UART go to console_feed() one at a time. The line
+  *          editor echoes them, handles backspace, Ctrl-C and tab completion,
+  *          and on Enter splits the line in place into argv[] and runs the
+  *          matching command. Nothing is allocated: the line buffer lives in
+  *          console_t and argv points into it.
+  *
+  *          Commands are registered anywhere with CONSOLE_COMMAND(). Each
+  *          one lands in the console_cmds linker section, and the console
+  *          walks that section between the __start_/__stop_ symbols the
+  *          linker provides. Command output goes through printf().
+  *
+  *          Everything in console.c is plain C and runs on the host fed from
+  *          stdin. Target-only built-ins are in console_builtins.c.
+  ******************************************************************************
+  */
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define CONSOLE_LINE_SIZE       80U
+#define CONSOLE_MAX_ARGS        8U
+#define CONSOLE_PROMPT          "> "
+
+/**
+  * @brief  Command handler.
+  * @retval 0 on success, anything else is reported as an error
+  */
+typedef int (*console_cmd_fn_t)(int argc, char *argv[]);
+
+/**
+  * @brief  Argument completion: candidate number index for argument argi,
+  *         NULL when there are no more.
+  */
+typedef const char *(*console_complete_fn_t)(int argi, uint32_t index);
+
+typedef struct {
+  const char *name;
+  const char *help;
+  console_cmd_fn_t fn;
+  console_complete_fn_t complete;   /*!< Optional */
+} console_cmd_t;
+
+/**
+  * @brief  Register a command. Use at file scope.
+  */
+#define CONSOLE_COMMAND(cmd_name, cmd_help, cmd_fn, cmd_complete)              \
+  static const console_cmd_t console_entry_##cmd_name                          \
+    __attribute__((section("console_cmds"), used, aligned(sizeof(void *)))) = \
+    { #cmd_name, (cmd_help), (cmd_fn), (cmd_complete) }
+
+/**
+  * @brief  Raw output for echo and editing, bypassing stdio buffering.
+  */
+typedef void (*console_write_t)(const char *buf, uint32_t len);
+
+typedef struct {
+  console_write_t write;
+  uint8_t len;
+  uint8_t escape;                   /*!< Escape sequence parser state */
+  char last;                        /*!< Previous byte, to fold CR LF */
+  char line[CONSOLE_LINE_SIZE];
+} console_t;
+
+/**
+  * @brief  Reset the editor and print the prompt.
+  */
+void console_init(console_t *console, console_write_t write);
+
+/**
+  * @brief  Process one received byte.
+  */
+void console_feed(console_t *console, char c);
+
+/**
+  * @brief  Split a line in place on spaces; double quotes group words.
+  * @retval argc, at most max
+  */
+int console_tokenize(char *line, char *argv[], int max);
+
+/**
+  * @brief  Tokenize a line and run its command.
+  * @retval the command's result, or -1 for an unknown command
+  */
+int console_execute(char *line);
+
+/**
+  * @brief  Command by name, NULL if unknown.
+  */
+const console_cmd_t *console_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_H */
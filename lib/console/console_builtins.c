@@ -0,0 +1,191 @@
+/**
+  ******************************************************************************
+  * @file    console_builtins.c
+  * @brief   Built-in console commands that need the target: kernel objects,
+  *          time, configuration and reset.
+  ******************************************************************************
+  */
+#include "console.h"
+#include "config.h"
+#include "main.h"
+#include "tx_api.h"
+#include "tx_byte_pool.h"
+#include "tx_thread.h"
+#include "uart_stdio.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *const console_thread_states[] = {
+  "ready", "completed", "terminated", "suspended", "sleep", "queue",
+  "semaphore", "events", "block", "byte", "io", "file", "tcpip", "mutex",
+};
+
+/**
+  * @brief  Bytes at the bottom of a stack still holding ThreadX's fill
+  *         pattern: the thread's high-water mark, seen from below.
+  */
+static ULONG console_stack_unused(const TX_THREAD *thread)
+{
+  const ULONG *p = (const ULONG *)thread->tx_thread_stack_start;
+  const ULONG *end = (const ULONG *)thread->tx_thread_stack_end;
+
+  while (p < end && *p == TX_STACK_FILL) {
+    p++;
+  }
+  return (ULONG)((const UCHAR *)p - (const UCHAR *)thread->tx_thread_stack_start);
+}
+
+static int console_cmd_threads(int argc, char *argv[])
+{
+  TX_THREAD *thread = _tx_thread_created_ptr;
+  TX_THREAD *next;
+  CHAR *name;
+  UINT state;
+  ULONG runs;
+  UINT priority;
+  ULONG count = _tx_thread_created_count;
+  (void)argc;
+  (void)argv;
+
+  /* Threads are created at init and never deleted, so the list is stable */
+  printf("  %-16s %4s %-10s %11s %8s\n", "name", "prio", "state", "stack used", "runs");
+  while (count-- > 0U && thread != TX_NULL) {
+    if (tx_thread_info_get(thread, &name, &state, &runs, &priority, TX_NULL, TX_NULL,
+                           &next, TX_NULL) != TX_SUCCESS) {
+      return -1;
+    }
+    printf("  %-16.16s %4u %-10s %5lu/%-5lu %8lu\n", name, priority,
+           (state < sizeof(console_thread_states) / sizeof(console_thread_states[0])) ?
+           console_thread_states[state] : "?",
+           (unsigned long)(thread->tx_thread_stack_size - console_stack_unused(thread)),
+           (unsigned long)thread->tx_thread_stack_size, (unsigned long)runs);
+    thread = next;
+  }
+  return 0;
+}
+
+CONSOLE_COMMAND(threads, "list threads with stack high-water marks", console_cmd_threads, NULL);
+
+static int console_cmd_pools(int argc, char *argv[])
+{
+  TX_BYTE_POOL *pool = _tx_byte_pool_created_ptr;
+  TX_BYTE_POOL *next;
+  CHAR *name;
+  ULONG available;
+  ULONG fragments;
+  ULONG count = _tx_byte_pool_created_count;
+  (void)argc;
+  (void)argv;
+
+  printf("  %-16s %6s %6s %9s\n", "name", "size", "free", "fragments");
+  while (count-- > 0U && pool != TX_NULL) {
+    if (tx_byte_pool_info_get(pool, &name, &available, &fragments, TX_NULL, TX_NULL,
+                              &next) != TX_SUCCESS) {
+      return -1;
+    }
+    printf("  %-16.16s %6lu %6lu %9lu\n", name, (unsigned long)pool->tx_byte_pool_size,
+           (unsigned long)available, (unsigned long)fragments);
+    pool = next;
+  }
+  return 0;
+}
+
+CONSOLE_COMMAND(pools, "list byte pools", console_cmd_pools, NULL);
+
+static int console_cmd_time(int argc, char *argv[])
+{
+  ULONG ticks = tx_time_get();
+  uint32_t ms = HAL_GetTick();
+  uint32_t s = ms / 1000U;
+  (void)argc;
+  (void)argv;
+
+  printf("  uptime %lud %02lu:%02lu:%02lu.%03lu, %lu ticks\n",
+         (unsigned long)(s / 86400U), (unsigned long)((s / 3600U) % 24U),
+         (unsigned long)((s / 60U) % 60U), (unsigned long)(s % 60U),
+         (unsigned long)(ms % 1000U), (unsigned long)ticks);
+  return 0;
+}
+
+CONSOLE_COMMAND(time, "show uptime", console_cmd_time, NULL);
+
+static void console_config_show(const config_field_t *field)
+{
+  char value[CONFIG_PATH_LEN + 1U];
+
+  (void)config_format(field, value, sizeof(value));
+  printf("  %-16s %s\n", field->key, value);
+}
+
+static int console_cmd_config(int argc, char *argv[])
+{
+  const config_field_t *field;
+  config_status_t status;
+  uint32_t i;
+
+  if (argc == 1) {
+    for (i = 0; (field = config_field(i)) != NULL; i++) {
+      console_config_show(field);
+    }
+    printf("  (generation %lu)\n", (unsigned long)config_generation());
+    return 0;
+  }
+  if (strcmp(argv[1], "save") == 0) {
+    status = config_save();
+    printf("  %s\n", (status == CONFIG_OK) ? "saved" : "save failed");
+    return (int)status;
+  }
+  if (strcmp(argv[1], "defaults") == 0) {
+    config_reset();
+    printf("  defaults loaded, 'config save' to keep them\n");
+    return 0;
+  }
+
+  field = config_field_find(argv[1]);
+  if (field == NULL) {
+    printf("  unknown key '%s'\n", argv[1]);
+    return (int)CONFIG_ERR_KEY;
+  }
+  if (argc >= 3) {
+    status = config_set(argv[1], argv[2]);
+    if (status != CONFIG_OK) {
+      printf("  %s: value out of range (%lu..%lu%s)\n", field->key, (unsigned long)field->min,
+             (unsigned long)field->max, (field->type == CONFIG_FIELD_STR) ? " chars" : "");
+      return (int)status;
+    }
+  }
+  console_config_show(field);
+  return 0;
+}
+
+static const char *console_complete_config(int argi, uint32_t index)
+{
+  static const char *const verbs[] = { "save", "defaults" };
+  const config_field_t *field;
+
+  if (argi != 1) {
+    return NULL;
+  }
+  if (index < sizeof(verbs) / sizeof(verbs[0])) {
+    return verbs[index];
+  }
+  field = config_field(index - (uint32_t)(sizeof(verbs) / sizeof(verbs[0])));
+  return (field != NULL) ? field->key : NULL;
+}
+
+CONSOLE_COMMAND(config, "config [key [value]] | save | defaults", console_cmd_config,
+                console_complete_config);
+
+static int console_cmd_reset(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+
+  printf("  resetting\n");
+  uart_stdio_flush();
+  NVIC_SystemReset();
+  return 0;
+}
+
+CONSOLE_COMMAND(reset, "reboot the payload", console_cmd_reset, NULL);
@@ -0,0 +1,242 @@
+/**
+  ******************************************************************************
+  * @file    crash.c
+  * @brief   Crash capture: fault context snapshot that survives a reset.
+  ******************************************************************************
+  */
+#include "crash.h"
+#include "crc32.h"
+#include "main.h"
+#include "sections.h"
+#include "tx_api.h"
+#include "tx_thread.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+extern uint32_t _estack;          /* End of RAM, from the linker script */
+extern uint32_t _etext;           /* End of code, from the linker script */
+
+/* Outside .bss/.data so startup leaves it alone across a warm reset */
+static crash_record_t crash_record NOINIT;
+static uint32_t crash_count NOINIT;
+static uint32_t crash_count_check NOINIT;
+
+/* Copy of the previous run's record for telemetry, valid after boot report */
+static crash_record_t crash_previous;
+static int crash_previous_valid;
+
+static const char *const crash_reason_names[] = {
+  "none",
+  "HardFault",
+  "Error_Handler",
+  "watchdog",
+};
+
+static int crash_in_ram(uint32_t addr, uint32_t len)
+{
+  return (addr >= SRAM1_BASE) && ((addr & 3U) == 0U) &&
+         (addr + len <= (uint32_t)&_estack);
+}
+
+/**
+  * @brief  Whether a stack word looks like a Thumb return address: odd, in
+  *         .text, and just after a BL or BLX instruction.
+  */
+static int crash_is_return_address(uint32_t word)
+{
+  uint32_t addr = word & ~1UL;
+
+  if (!(word & 1U) || addr < (FLASH_BASE + 4U) || addr > (uint32_t)&_etext) {
+    return 0;
+  }
+  /* BL is a 32-bit pair whose first halfword is 0b11110xxx_xxxxxxxx */
+  if ((*(const uint16_t *)(addr - 4U) & 0xF800U) == 0xF000U) {
+    return 1;
+  }
+  /* BLX Rm */
+  return (*(const uint16_t *)(addr - 2U) & 0xFF87U) == 0x4780U;
+}
+
+static void crash_capture_context(uint32_t sp, TX_THREAD *thread)
+{
+  uint32_t end = (uint32_t)&_estack;
+  uint32_t depth = 0;
+  uint32_t i;
+
+  crash_record.magic = CRASH_MAGIC;
+  crash_record.tick = HAL_GetTick();
+  crash_record.msp = __get_MSP();
+  crash_record.psp = __get_PSP();
+
+  if (crash_in_ram((uint32_t)thread, sizeof(TX_THREAD)) && thread->tx_thread_id == TX_THREAD_ID) {
+    crash_record.thread = (uint32_t)thread;
+    if (thread->tx_thread_name != NULL) {
+      strncpy(crash_record.thread_name, thread->tx_thread_name, CRASH_THREAD_NAME_LEN - 1U);
+    }
+    /* Scan the thread stack if the fault happened on it */
+    if (sp >= (uint32_t)thread->tx_thread_stack_start && sp < (uint32_t)thread->tx_thread_stack_end) {
+      end = (uint32_t)thread->tx_thread_stack_end;
+    }
+  }
+
+  crash_record.stack_start = sp;
+  crash_record.stack_end = end;
+  if (crash_in_ram(sp, 4U)) {
+    for (i = 0; i < CRASH_SCAN_WORDS && (sp + (i * 4U)) < end && depth < CRASH_TRACE_DEPTH; i++) {
+      uint32_t word = ((const uint32_t *)sp)[i];
+      if (crash_is_return_address(word)) {
+        crash_record.trace[depth++] = word;
+      }
+    }
+  }
+
+  if (crash_count_check != ~crash_count) {
+    crash_count = 0;
+  }
+  crash_count++;
+  crash_count_check = ~crash_count;
+  crash_record.count = crash_count;
+
+  crash_record.crc = crc32(&crash_record, offsetof(crash_record_t, crc));
+}
+
+static void crash_copy_frame(const uint32_t *frame)
+{
+  crash_record.r0 = frame[0];
+  crash_record.r1 = frame[1];
+  crash_record.r2 = frame[2];
+  crash_record.r3 = frame[3];
+  crash_record.r12 = frame[4];
+  crash_record.lr = frame[5];
+  crash_record.pc = frame[6];
+  crash_record.xpsr = frame[7];
+}
+
+/* Trace starts above the 8 word hardware frame (plus the alignment pad) */
+static uint32_t crash_frame_end(const uint32_t *frame)
+{
+  return (uint32_t)frame + 32U + ((frame[7] & (1UL << 9)) ? 4U : 0U);
+}
+
+void crash_hardfault(uint32_t *frame, uint32_t exc_return)
+{
+  memset(&crash_record, 0, sizeof(crash_record));
+  crash_record.reason = CRASH_REASON_HARDFAULT;
+  crash_record.exc_return = exc_return;
+
+  if (!crash_in_ram((uint32_t)frame, 8U * sizeof(uint32_t))) {
+    /* Stack pointer itself was bad; record what we can */
+    crash_capture_context((uint32_t)frame, tx_thread_identify());
+  } else {
+    crash_copy_frame(frame);
+    crash_capture_context(crash_frame_end(frame), tx_thread_identify());
+  }
+  NVIC_SystemReset();
+}
+
+/**
+  * @brief  Error_Handler() hook, overriding the weak default in main.c.
+  * @param  caller: return address of the Error_Handler() call
+  */
+void error_handler_hook(uint32_t caller)
+{
+  memset(&crash_record, 0, sizeof(crash_record));
+  crash_record.reason = CRASH_REASON_ERROR_HANDLER;
+  crash_record.pc = caller;
+  /* Threads run on PSP; handlers and pre-kernel code on MSP */
+  crash_capture_context(((__get_IPSR() == 0U) && (__get_CONTROL() & CONTROL_SPSEL_Msk)) ?
+                        __get_PSP() : __get_MSP(), tx_thread_identify());
+  NVIC_SystemReset();
+}
+
+void crash_watchdog(TX_THREAD *thread)
+{
+  const uint32_t *frame;
+
+  memset(&crash_record, 0, sizeof(crash_record));
+  crash_record.reason = CRASH_REASON_WATCHDOG;
+
+  if (thread == NULL || !crash_in_ram((uint32_t)thread, sizeof(TX_THREAD)) ||
+      thread->tx_thread_id != TX_THREAD_ID) {
+    crash_capture_context(__get_PSP(), NULL);
+  } else {
+    /* A suspended thread's saved context: EXC_RETURN, r8-r11, r4-r7, then
+     * the hardware frame (see tx_thread_schedule.S) */
+    frame = (const uint32_t *)thread->tx_thread_stack_ptr + 9;
+    if (crash_in_ram((uint32_t)frame, 8U * sizeof(uint32_t))) {
+      crash_record.exc_return = frame[-9];
+      crash_copy_frame(frame);
+      crash_capture_context(crash_frame_end(frame), thread);
+    } else {
+      crash_capture_context((uint32_t)frame, thread);
+    }
+  }
+  NVIC_SystemReset();
+}
+
+#ifndef PICOAPRS_HOST
+/**
+  * @brief  HardFault entry: pick the stack the exception frame was pushed to
+  *         (EXC_RETURN bit 2) and hand it to crash_hardfault() untouched.
+  */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+  __asm volatile(
+    "  movs r0, #4                \n"
+    "  mov  r1, lr                \n"
+    "  tst  r0, r1                \n"
+    "  beq  1f                    \n"
+    "  mrs  r0, psp               \n"
+    "  b    2f                    \n"
+    "1:                           \n"
+    "  mrs  r0, msp               \n"
+    "2:                           \n"
+    "  ldr  r2, =crash_hardfault  \n"
+    "  bx   r2                    \n"
+    "  .ltorg                     \n");
+}
+#endif
+
+int crash_boot_report(void)
+{
+  const crash_record_t *rec = &crash_record;
+  uint32_t i;
+
+  if (rec->magic != CRASH_MAGIC ||
+      rec->crc != crc32(rec, offsetof(crash_record_t, crc)) ||
+      rec->reason > CRASH_REASON_WATCHDOG) {
+    crash_record.magic = 0;
+    return 0;
+  }
+
+  crash_previous = *rec;
+  crash_previous_valid = 1;
+  crash_record.magic = 0;
+
+  rec = &crash_previous;
+  printf("CRASH reason=%s count=%lu tick=%lu thread=%s (0x%08lx)\n",
+         crash_reason_names[rec->reason], (unsigned long)rec->count, (unsigned long)rec->tick,
+         rec->thread ? rec->thread_name : "-", (unsigned long)rec->thread);
+  printf("CRASH pc=0x%08lx lr=0x%08lx xpsr=0x%08lx exc_return=0x%08lx\n",
+         (unsigned long)rec->pc, (unsigned long)rec->lr, (unsigned long)rec->xpsr,
+         (unsigned long)rec->exc_return);
+  printf("CRASH r0=0x%08lx r1=0x%08lx r2=0x%08lx r3=0x%08lx r12=0x%08lx\n",
+         (unsigned long)rec->r0, (unsigned long)rec->r1, (unsigned long)rec->r2,
+         (unsigned long)rec->r3, (unsigned long)rec->r12);
+  printf("CRASH msp=0x%08lx psp=0x%08lx stack=0x%08lx-0x%08lx\n",
+         (unsigned long)rec->msp, (unsigned long)rec->psp,
+         (unsigned long)rec->stack_start, (unsigned long)rec->stack_end);
+  printf("CRASH trace=");
+  for (i = 0; i < CRASH_TRACE_DEPTH && rec->trace[i] != 0U; i++) {
+    printf("%s0x%08lx", (i == 0U) ? "" : ",", (unsigned long)rec->trace[i]);
+  }
+  printf("\n");
+  return 1;
+}
+
+const crash_record_t *crash_last(void)
+{
+  return crash_previous_valid ? &crash_previous : NULL;
+}
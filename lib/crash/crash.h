@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    crash.h
+  * @brief   Crash capture: fault context snapshot that survives a reset.
+  *
+  *          HardFault_Handler (defined here, replacing the CubeMX spin loop)
+  *          and Error_Handler() (through error_handler_hook()) record the
+  *          stacked registers, the interrupted ThreadX thread, both stack
+  *          pointers and a heuristic call trace into a .noinit RAM record,
+  *          then reset via NVIC_SystemReset(). The watchdog supervisor
+  *          does the same through crash_watchdog() for a thread that missed
+  *          its check-in, recording that thread's saved context instead.
+  *          On the next boot crash_boot_report() validates the record,
+  *          prints it on the console and keeps a copy for telemetry.
+  *
+  *          The printed CRASH lines are what tools/crash_symbolize.py
+  *          resolves against the ELF.
+  ******************************************************************************
+  */
+#ifndef CRASH_H
+#define CRASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "tx_api.h"
+
+#define CRASH_MAGIC             0x43524153UL    /* "CRAS" */
+#define CRASH_TRACE_DEPTH       8U              /* return addresses kept */
+#define CRASH_SCAN_WORDS        256U            /* stack words searched for them */
+#define CRASH_THREAD_NAME_LEN   16U
+
+typedef enum {
+  CRASH_REASON_NONE = 0,
+  CRASH_REASON_HARDFAULT,
+  CRASH_REASON_ERROR_HANDLER,
+  CRASH_REASON_WATCHDOG,
+} crash_reason_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t reason;                  /*!< crash_reason_t */
+  uint32_t r0, r1, r2, r3, r12;     /*!< Exception frame; zero for Error_Handler */
+  uint32_t lr;
+  uint32_t pc;                      /*!< Faulting PC, Error_Handler's caller, or
+                                         where a stalled thread was switched out */
+  uint32_t xpsr;
+  uint32_t exc_return;
+  uint32_t msp;
+  uint32_t psp;
+  uint32_t thread;                  /*!< TX_THREAD address, 0 outside a thread */
+  char thread_name[CRASH_THREAD_NAME_LEN];
+  uint32_t stack_start;             /*!< Bounds of the stack that was scanned */
+  uint32_t stack_end;
+  uint32_t tick;                    /*!< HAL tick at the time of the crash */
+  uint32_t count;                   /*!< Crashes since the last power-on */
+  uint32_t trace[CRASH_TRACE_DEPTH];
+  uint32_t crc;                     /*!< CRC-32 over everything above */
+} crash_record_t;
+
+/**
+  * @brief  Check for a record left by the previous run, print it and keep a
+  *         copy for crash_last(). Call once after the console UART is up.
+  * @retval 1 if the previous run crashed, 0 otherwise
+  */
+int crash_boot_report(void);
+
+/**
+  * @brief  Record from the previous run, or NULL if it ended cleanly.
+  *         Valid after crash_boot_report(); intended for telemetry.
+  */
+const crash_record_t *crash_last(void);
+
+/**
+  * @brief  Snapshot from the HardFault entry stub. Does not return.
+  * @param  frame: exception frame on the active stack
+  * @param  exc_return: EXC_RETURN value from LR
+  */
+void crash_hardfault(uint32_t *frame, uint32_t exc_return);
+
+/**
+  * @brief  Snapshot a thread that stopped checking in. Does not return.
+  * @param  thread: the stalled thread; its saved context is recorded
+  */
+void crash_watchdog(TX_THREAD *thread);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRASH_H */
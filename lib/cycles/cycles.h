@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file    cycles.h
+  * @brief   Free-running cycle counter for timing code on the M0+.
+  *
+  *          The core has no DWT cycle counter, so TIM2 stands in for one:
+  *          32 bits, no prescaler, clocked from the undivided APB at SYSCLK.
+  *          It only runs between cycles_start() and cycles_stop(), and has
+  *          one user at a time: boot profiling, then benchmarks, and the
+  *          power-fail path, which never hands it back. The host build
+  *          reads CLOCK_MONOTONIC instead and counts nanoseconds.
+  ******************************************************************************
+  */
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+
+#include <stdint.h>
+#ifdef PICOAPRS_HOST
+#include <time.h>
+#endif
+
+#ifdef PICOAPRS_HOST
+static inline void cycles_start(void)
+{
+}
+
+static inline void cycles_stop(void)
+{
+}
+
+static inline uint32_t cycles_now(void)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)now.tv_sec * 1000000000UL + (uint32_t)now.tv_nsec;
+}
+
+/**
+  * @brief  Counter frequency: SYSCLK on target, 1 GHz on the host.
+  */
+static inline uint32_t cycles_hz(void)
+{
+  return 1000000000UL;
+}
+#else
+/**
+  * @brief  Start counting from 0.
+  */
+static inline void cycles_start(void)
+{
+  __HAL_RCC_TIM2_CLK_ENABLE();
+  TIM2->CR1 = 0U;
+  TIM2->PSC = 0U;
+  TIM2->ARR = 0xFFFFFFFFUL;
+  TIM2->EGR = TIM_EGR_UG;
+  TIM2->CR1 = TIM_CR1_CEN;
+}
+
+static inline void cycles_stop(void)
+{
+  TIM2->CR1 = 0U;
+  __HAL_RCC_TIM2_CLK_DISABLE();
+}
+
+static inline uint32_t cycles_now(void)
+{
+  return TIM2->CNT;
+}
+
+/**
+  * @brief  Counter frequency: SYSCLK on target, 1 GHz on the host.
+  */
+static inline uint32_t cycles_hz(void)
+{
+  /* AHB and APB are undivided at every clock level, so TIM2 runs at SYSCLK */
+  return SystemCoreClock;
+}
+#endif
+
+/**
+  * @brief  Counter frequency in whole MHz, at least 1: counts per us.
+  */
+static inline uint32_t cycles_mhz(void)
+{
+  uint32_t mhz = cycles_hz() / 1000000UL;
+
+  return (mhz != 0U) ? mhz : 1U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYCLES_H */
@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    dlog.c
+  * @brief   Deferred binary logging: record encoder and UART drain thread.
+  ******************************************************************************
+  */
+#include "dlog.h"
+#include "main.h"
+#include "ring_buffer.h"
+#include "sections.h"
+#include "uart_tx.h"
+
+_Static_assert(RING_BUFFER_IS_POW2(DLOG_RING_SIZE) && (DLOG_RING_SIZE % 4U) == 0U,
+               "DLOG_RING_SIZE must be a power of two");
+
+/* Word aligned so that records, all a multiple of 4 bytes, never split a
+ * word across the wrap and can be stored with single STRs. In SRAM2: only
+ * ever read behind the write index, so it needs no zeroing at startup. */
+static uint8_t dlog_storage[DLOG_RING_SIZE] TRACE_BUFFER __attribute__((aligned(4)));
+static ring_buffer_t dlog_ring = RING_BUFFER_INIT(dlog_storage, DLOG_RING_SIZE);
+
+static volatile uint32_t dlog_drop_count;
+static uint32_t dlog_drop_reported;
+
+static TX_THREAD dlog_thread;
+
+static void dlog_thread_entry(ULONG thread_input);
+
+static inline void dlog_store(uint32_t offset, uint32_t word)
+{
+  *(uint32_t *)(void *)ring_buffer_slot(&dlog_ring, offset) = word;
+}
+
+void dlog_write(uint32_t level, uint32_t id, const uint32_t *args, uint32_t nargs)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t size = (2U + nargs) * 4U;
+  uint32_t i;
+
+  /* Producers are threads and ISRs alike, so the ring's single-producer
+   * side is claimed by masking interrupts for the few stores below. */
+  TX_DISABLE
+  if (ring_buffer_free(&dlog_ring) < size) {
+    dlog_drop_count++;
+  } else {
+    dlog_store(0U, DLOG_SYNC | (((level << 4) | nargs) << 8) | (id << 16));
+    dlog_store(4U, HAL_GetTick());
+    for (i = 0; i < nargs; i++) {
+      dlog_store(8U + (i * 4U), args[i]);
+    }
+    ring_buffer_commit(&dlog_ring, size);
+  }
+  TX_RESTORE
+}
+
+uint32_t dlog_dropped(void)
+{
+  return dlog_drop_count;
+}
+
+UINT dlog_init(TX_BYTE_POOL *byte_pool)
+{
+  CHAR *pointer;
+  UINT status;
+
+  status = tx_byte_allocate(byte_pool, (VOID **)&pointer, DLOG_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (status != TX_SUCCESS) {
+    return status;
+  }
+  return tx_thread_create(&dlog_thread, "DLog Drain", dlog_thread_entry, 0, pointer,
+                          DLOG_THREAD_STACK_SIZE, DLOG_THREAD_PRIORITY, DLOG_THREAD_PRIORITY,
+                          TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+/**
+  * @brief  Drain thread: hands contiguous ring spans straight to the UART DMA.
+  * @param  thread_input: unused
+  * @retval None
+  */
+static void dlog_thread_entry(ULONG thread_input)
+{
+  const uint8_t *span;
+  uint32_t len;
+  uint32_t dropped;
+  (void)thread_input;
+
+  for (;;) {
+    dropped = dlog_drop_count;
+    if (dropped != dlog_drop_reported) {
+      DLOG_WARN("dlog: %u records dropped", dropped - dlog_drop_reported);
+      dlog_drop_reported = dropped;
+    }
+
+    len = ring_buffer_peek(&dlog_ring, &span);
+    if (len == 0U) {
+      tx_thread_sleep(DLOG_DRAIN_INTERVAL);
+      continue;
+    }
+    if (len > UINT16_MAX) {
+      len = UINT16_MAX;
+    }
+    /* Zero-copy: DMA reads the ring storage, released once the transfer ends */
+    (void)uart_tx_write(span, (uint16_t)len, TX_WAIT_FOREVER);
+    ring_buffer_consume(&dlog_ring, len);
+  }
+}
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file    dlog.h
+  * @brief   Deferred binary logging.
+  *
+  *          A log call never formats anything on target. It stores the
+  *          address of its format string plus the raw 32-bit arguments into a
+  *          RAM ring, and a low-priority thread streams the ring to the UART
+  *          over DMA. Format strings live in the non-loaded .dlog_fmt ELF
+  *          section at address 0 (see STM32U083xx_FLASH.ld, and
+  *          host/dlog_fmt.ld for the host build), so they cost no flash;
+  *          tools/dlog_decode.py reads them back from the ELF to render the
+  *          stream on the host.
+  *
+  *          Safe to call from threads and ISRs. Arguments are converted to
+  *          uint32_t: integers, chars and pointers only, no floats. A %s
+  *          argument is only its address, so it must be a constant string
+  *          in flash (a literal, a thread name), which the decoder finds in
+  *          the ELF.
+  *
+  *          Wire format, little-endian, every record a multiple of 4 bytes:
+  *            u8  sync      DLOG_SYNC
+  *            u8  info      level << 4 | nargs
+  *            u16 id        offset of the format string in .dlog_fmt
+  *            u32 timestamp HAL tick (ms)
+  *            u32 args[nargs]
+  ******************************************************************************
+  */
+#ifndef DLOG_H
+#define DLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "tx_api.h"
+
+/* Log levels, stored in the record header */
+#define DLOG_LEVEL_ERROR        0U
+#define DLOG_LEVEL_WARN         1U
+#define DLOG_LEVEL_INFO         2U
+#define DLOG_LEVEL_DEBUG        3U
+
+/* Calls above this level compile to nothing */
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL              DLOG_LEVEL_INFO
+#endif
+
+/* RAM ring size in bytes, power of two */
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE          1024U
+#endif
+
+#define DLOG_MAX_ARGS           8U
+#define DLOG_SYNC               0xA5U
+
+#define DLOG_THREAD_STACK_SIZE  512U
+#define DLOG_THREAD_PRIORITY    30U
+#define DLOG_DRAIN_INTERVAL     10U   /* ticks between polls of an empty ring */
+
+#define DLOG_STR_(x)            #x
+#define DLOG_STR(x)             DLOG_STR_(x)
+
+/* The decoder splits the stored string on the unit separator into the
+ * call site and the user format. */
+#define DLOG_(level, fmt, ...)                                                 \
+  do {                                                                         \
+    if ((level) <= DLOG_LEVEL) {                                               \
+      static const char dlog_fmt_[]                                            \
+        __attribute__((section(".dlog_fmt"), used)) =                          \
+        __FILE__ ":" DLOG_STR(__LINE__) "\x1f" fmt;                            \
+      const uint32_t dlog_args_[] = { 0U, ##__VA_ARGS__ };                     \
+      _Static_assert(sizeof(dlog_args_) / sizeof(uint32_t) - 1U <= DLOG_MAX_ARGS, \
+                     "too many dlog arguments");                               \
+      dlog_write((level), (uint32_t)(uintptr_t)dlog_fmt_, &dlog_args_[1],      \
+                 sizeof(dlog_args_) / sizeof(uint32_t) - 1U);                  \
+    }                                                                          \
+  } while (0)
+
+#define DLOG_ERROR(fmt, ...)    DLOG_(DLOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define DLOG_WARN(fmt, ...)     DLOG_(DLOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define DLOG_INFO(fmt, ...)     DLOG_(DLOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define DLOG_DEBUG(fmt, ...)    DLOG_(DLOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+/**
+  * @brief  Create the drain thread. Logging before this call is fine; the
+  *         records wait in the ring.
+  * @param  byte_pool: pool to allocate the thread stack from
+  * @retval TX_SUCCESS or the failing ThreadX status
+  */
+UINT dlog_init(TX_BYTE_POOL *byte_pool);
+
+/**
+  * @brief  Append one record to the ring. Use the DLOG_* macros instead.
+  * @param  level: DLOG_LEVEL_*
+  * @param  id: format string address inside .dlog_fmt
+  * @param  args: nargs raw arguments
+  * @param  nargs: argument count, at most DLOG_MAX_ARGS
+  * @retval None; the record is counted as dropped if the ring is full
+  */
+void dlog_write(uint32_t level, uint32_t id, const uint32_t *args, uint32_t nargs);
+
+/**
+  * @brief  Number of records lost to a full ring since boot.
+  */
+uint32_t dlog_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DLOG_H */
@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    flash_dev.h
+  * @brief   Page-erase, double-word-program flash region interface.
+  *
+  *          What the flash-backed stores are written against. Addresses are
+  *          byte offsets into the region and always double-word aligned.
+  *          Callbacks return 0 on success.
+  *
+  *          Like the STM32U0 array, a double-word can only be programmed
+  *          once between erases, and erased flash reads back as all ones.
+  *          read() fails on an uncorrectable ECC error, which is how a
+  *          double-word torn by a reset mid-program reads back.
+  ******************************************************************************
+  */
+#ifndef FLASH_DEV_H
+#define FLASH_DEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define FLASH_DEV_ERASED        0xFFFFFFFFFFFFFFFFULL
+
+typedef struct {
+  uint32_t page_size;           /*!< Erase unit in bytes */
+  uint32_t page_count;
+  int (*read)(void *ctx, uint32_t addr, uint64_t *dword);
+  int (*program)(void *ctx, uint32_t addr, uint64_t dword);
+  int (*erase)(void *ctx, uint32_t page);
+  void *ctx;
+} flash_dev_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_DEV_H */
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file    flash_sim.c
+  * @brief   Host-side flash_dev_t simulator with power-cut injection.
+  ******************************************************************************
+  */
+#include "flash_sim.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define FLASH_SIM_DWORD         8U
+
+/* xorshift32, enough to scatter the damage of a cut */
+static uint32_t flash_sim_rand(flash_sim_t *sim)
+{
+  uint32_t x = sim->rng;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sim->rng = x;
+  return x;
+}
+
+/**
+  * @brief  Count an operation; returns 1 if power is lost during this one.
+  */
+static int flash_sim_cut_now(flash_sim_t *sim)
+{
+  sim->ops++;
+  if (sim->cut_in == 0U) {
+    return 0;
+  }
+  if (--sim->cut_in == 0U) {
+    sim->powered = 0;
+    return 1;
+  }
+  return 0;
+}
+
+static int flash_sim_read(void *ctx, uint32_t addr, uint64_t *dword)
+{
+  flash_sim_t *sim = (flash_sim_t *)ctx;
+
+  if ((addr % FLASH_SIM_DWORD) != 0U || addr >= sim->page_size * sim->page_count) {
+    return -1;
+  }
+  memcpy(dword, &sim->mem[addr], sizeof(*dword));
+  return sim->torn[addr / FLASH_SIM_DWORD] ? -1 : 0;
+}
+
+static int flash_sim_program(void *ctx, uint32_t addr, uint64_t dword)
+{
+  flash_sim_t *sim = (flash_sim_t *)ctx;
+  uint64_t current;
+  uint64_t partial;
+
+  if (!sim->powered || (addr % FLASH_SIM_DWORD) != 0U ||
+      addr >= sim->page_size * sim->page_count) {
+    return -1;
+  }
+  memcpy(&current, &sim->mem[addr], sizeof(current));
+  if (current != FLASH_DEV_ERASED || sim->torn[addr / FLASH_SIM_DWORD]) {
+    return -1;
+  }
+
+  if (flash_sim_cut_now(sim)) {
+    if ((flash_sim_rand(sim) & 3U) == 0U) {
+      /* Power went before the program started */
+      return -1;
+    }
+    /* Some of the zero bits made it */
+    partial = ((uint64_t)flash_sim_rand(sim) << 32) | flash_sim_rand(sim);
+    dword |= partial;
+    memcpy(&sim->mem[addr], &dword, sizeof(dword));
+    sim->torn[addr / FLASH_SIM_DWORD] = 1U;
+    return -1;
+  }
+  memcpy(&sim->mem[addr], &dword, sizeof(dword));
+  return 0;
+}
+
+static int flash_sim_erase(void *ctx, uint32_t page)
+{
+  flash_sim_t *sim = (flash_sim_t *)ctx;
+  uint32_t base = page * sim->page_size;
+  uint32_t i;
+
+  if (!sim->powered || page >= sim->page_count) {
+    return -1;
+  }
+  if (sim->erase_counts != NULL) {
+    sim->erase_counts[page]++;
+  }
+
+  if (flash_sim_cut_now(sim)) {
+    for (i = 0; i < sim->page_size; i += FLASH_SIM_DWORD) {
+      switch (flash_sim_rand(sim) % 3U) {
+      case 0:
+        memset(&sim->mem[base + i], 0xFF, FLASH_SIM_DWORD);
+        sim->torn[(base + i) / FLASH_SIM_DWORD] = 0U;
+        break;
+      case 1:
+        sim->torn[(base + i) / FLASH_SIM_DWORD] = 1U;
+        break;
+      default:
+        break;
+      }
+    }
+    return -1;
+  }
+  memset(&sim->mem[base], 0xFF, sim->page_size);
+  memset(&sim->torn[base / FLASH_SIM_DWORD], 0, sim->page_size / FLASH_SIM_DWORD);
+  return 0;
+}
+
+void flash_sim_init(flash_sim_t *sim, uint8_t *mem, uint8_t *torn, uint32_t *erase_counts,
+                    uint32_t page_size, uint32_t page_count)
+{
+  sim->mem = mem;
+  sim->torn = torn;
+  sim->erase_counts = erase_counts;
+  sim->page_size = page_size;
+  sim->page_count = page_count;
+  sim->ops = 0U;
+  sim->cut_in = 0U;
+  sim->rng = 1U;
+  sim->powered = 1;
+
+  memset(mem, 0xFF, page_size * page_count);
+  memset(torn, 0, page_size * page_count / FLASH_SIM_DWORD);
+  if (erase_counts != NULL) {
+    memset(erase_counts, 0, page_count * sizeof(*erase_counts));
+  }
+}
+
+void flash_sim_dev(flash_sim_t *sim, flash_dev_t *dev)
+{
+  dev->page_size = sim->page_size;
+  dev->page_count = sim->page_count;
+  dev->read = flash_sim_read;
+  dev->program = flash_sim_program;
+  dev->erase = flash_sim_erase;
+  dev->ctx = sim;
+}
+
+void flash_sim_cut_after(flash_sim_t *sim, uint32_t ops, uint32_t seed)
+{
+  sim->cut_in = ops;
+  sim->rng = (seed != 0U) ? seed : 1U;
+}
+
+void flash_sim_power_on(flash_sim_t *sim)
+{
+  sim->cut_in = 0U;
+  sim->powered = 1;
+}
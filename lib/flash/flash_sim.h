@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    flash_sim.h
+  * @brief   Host-side flash_dev_t simulator with power-cut injection.
+  *
+  *          Models the rules the stores rely on: erased reads all ones, a
+  *          double-word programs once between erases, and a cut operation
+  *          leaves damage behind. flash_sim_cut_after() schedules a power
+  *          loss on the Nth program/erase from now:
+  *            - a cut program leaves the double-word torn: reads fail, as an
+  *              ECC error would on target, and it can't be programmed again;
+  *              one time in four the power goes just before it starts and
+  *              the double-word stays erased;
+  *            - a cut erase leaves each double-word of the page erased,
+  *              untouched, or torn, at random.
+  *          Every operation after the cut fails until flash_sim_power_on().
+  *
+  *          Plain C with no target dependencies; not part of the firmware.
+  ******************************************************************************
+  */
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "flash_dev.h"
+
+typedef struct {
+  uint8_t *mem;                 /*!< page_size * page_count bytes */
+  uint8_t *torn;                /*!< One flag per double-word */
+  uint32_t *erase_counts;       /*!< One per page, may be NULL */
+  uint32_t page_size;
+  uint32_t page_count;
+  uint32_t ops;                 /*!< Program and erase calls so far */
+  uint32_t cut_in;              /*!< Operations until the cut, 0 for none */
+  uint32_t rng;
+  int powered;
+} flash_sim_t;
+
+/**
+  * @brief  Set up a simulator over caller-provided storage, fully erased.
+  * @param  mem: page_size * page_count bytes
+  * @param  torn: page_size * page_count / 8 bytes
+  * @param  erase_counts: page_count counters for wear statistics, or NULL
+  */
+void flash_sim_init(flash_sim_t *sim, uint8_t *mem, uint8_t *torn, uint32_t *erase_counts,
+                    uint32_t page_size, uint32_t page_count);
+
+/**
+  * @brief  flash_dev_t view of the simulator.
+  */
+void flash_sim_dev(flash_sim_t *sim, flash_dev_t *dev);
+
+/**
+  * @brief  Lose power during the ops-th program or erase from now (1 is the
+  *         next one). seed drives what the interrupted operation leaves.
+  */
+void flash_sim_cut_after(flash_sim_t *sim, uint32_t ops, uint32_t seed);
+
+/**
+  * @brief  Restore power after a cut; the array keeps its contents.
+  */
+void flash_sim_power_on(flash_sim_t *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_SIM_H */
@@ -0,0 +1,57 @@
+/**
+  ******************************************************************************
+  * @file    flash_stm32.c
+  * @brief   flash_dev_t over a region of the STM32U0 internal flash.
+  ******************************************************************************
+  */
+#include "flash_stm32.h"
+#include "main.h"
+#include "stm32u0xx_it.h"
+
+static int flash_stm32_read(void *ctx, uint32_t addr, uint64_t *dword)
+{
+  const volatile uint32_t *p = (const volatile uint32_t *)((uint32_t)ctx + addr);
+  uint32_t errors = flash_ecc_errors;
+  uint32_t lo = p[0];
+  uint32_t hi = p[1];
+
+  *dword = ((uint64_t)hi << 32) | lo;
+  return (flash_ecc_errors != errors) ? -1 : 0;
+}
+
+static int flash_stm32_program(void *ctx, uint32_t addr, uint64_t dword)
+{
+  HAL_StatusTypeDef status;
+
+  HAL_FLASH_Unlock();
+  status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, (uint32_t)ctx + addr, dword);
+  HAL_FLASH_Lock();
+  return (status == HAL_OK) ? 0 : -1;
+}
+
+static int flash_stm32_erase(void *ctx, uint32_t page)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t page_error;
+  HAL_StatusTypeDef status;
+
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks = FLASH_BANK_1;
+  erase.Page = (((uint32_t)ctx - FLASH_BASE) / FLASH_PAGE_SIZE) + page;
+  erase.NbPages = 1U;
+
+  HAL_FLASH_Unlock();
+  status = HAL_FLASHEx_Erase(&erase, &page_error);
+  HAL_FLASH_Lock();
+  return (status == HAL_OK) ? 0 : -1;
+}
+
+void flash_stm32_init(flash_dev_t *dev, uint32_t start, uint32_t end)
+{
+  dev->page_size = FLASH_PAGE_SIZE;
+  dev->page_count = (end - start) / FLASH_PAGE_SIZE;
+  dev->read = flash_stm32_read;
+  dev->program = flash_stm32_program;
+  dev->erase = flash_stm32_erase;
+  dev->ctx = (void *)start;
+}
@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file    flash_stm32.h
+  * @brief   flash_dev_t over a region of the STM32U0 internal flash.
+  *
+  *          Programs and erases through the HAL with the flash unlocked only
+  *          for the duration of each operation. The CPU stalls while code
+  *          fetches wait on the array: about 85 us per double-word and 22 ms
+  *          per page erase.
+  *
+  *          ECC double errors raise an NMI on this part. NMI_Handler counts
+  *          and clears them in flash_ecc_errors (stm32u0xx_it.c), and read()
+  *          reports failure when the count moves across its access.
+  ******************************************************************************
+  */
+#ifndef FLASH_STM32_H
+#define FLASH_STM32_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flash_dev.h"
+
+/**
+  * @brief  Describe a region of internal flash.
+  * @param  dev: filled in
+  * @param  start: first byte, page aligned
+  * @param  end: one past the last byte, page aligned
+  */
+void flash_stm32_init(flash_dev_t *dev, uint32_t start, uint32_t end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_STM32_H */
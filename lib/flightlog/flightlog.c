@@ -0,0 +1,303 @@
+/**
+  ******************************************************************************
+  * @file    flightlog.c
+  * @brief   Append-only, wear-leveled record log in internal flash.
+  ******************************************************************************
+  */
+#include "flightlog.h"
+#include "crc32.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define FLIGHTLOG_DWORD         8U
+#define FLIGHTLOG_ERASED        0xFFFFFFFFFFFFFFFFULL
+
+static int flightlog_read(const flightlog_t *log, uint32_t page, uint32_t offset,
+                          uint64_t *dword)
+{
+  const flash_dev_t *flash = log->flash;
+
+  return flash->read(flash->ctx, (page * flash->page_size) + offset, dword);
+}
+
+static int flightlog_program(const flightlog_t *log, uint32_t page, uint32_t offset,
+                             uint64_t dword)
+{
+  const flash_dev_t *flash = log->flash;
+
+  return flash->program(flash->ctx, (page * flash->page_size) + offset, dword);
+}
+
+/**
+  * @brief  Sequence number of a page, 0 if its header is blank, torn or not
+  *         ours.
+  */
+static uint32_t flightlog_page_seq(const flightlog_t *log, uint32_t page)
+{
+  uint64_t header;
+  uint32_t seq;
+
+  if (flightlog_read(log, page, 0U, &header) != 0 ||
+      (uint32_t)header != FLIGHTLOG_PAGE_MAGIC) {
+    return 0U;
+  }
+  seq = (uint32_t)(header >> 32);
+  return (seq == 0xFFFFFFFFUL) ? 0U : seq;
+}
+
+/**
+  * @brief  Decode a record header double-word.
+  * @retval 1 if the self-check holds, 0 for erased or garbage
+  */
+static int flightlog_header_decode(uint64_t header, uint8_t *type, uint8_t *len)
+{
+  uint32_t lo = (uint32_t)header & 0xFFFFU;
+  uint32_t check = ((uint32_t)header >> 16) & 0xFFFFU;
+
+  if (check != (~lo & 0xFFFFU)) {
+    return 0;
+  }
+  *type = (uint8_t)lo;
+  *len = (uint8_t)(lo >> 8);
+  return (*type != FLIGHTLOG_TYPE_ERASED) && (*len <= FLIGHTLOG_MAX_PAYLOAD);
+}
+
+static uint32_t flightlog_crc(uint8_t type, uint8_t len, const void *payload)
+{
+  uint8_t prefix[2];
+  uint32_t crc;
+
+  prefix[0] = type;
+  prefix[1] = len;
+  crc = crc32_update(CRC32_INIT, prefix, sizeof(prefix));
+  return crc32_final(crc32_update(crc, payload, len));
+}
+
+uint32_t flightlog_record_size(uint8_t len)
+{
+  return FLIGHTLOG_DWORD + ((len + FLIGHTLOG_DWORD - 1U) & ~(FLIGHTLOG_DWORD - 1U)) +
+         FLIGHTLOG_DWORD;
+}
+
+/**
+  * @brief  First free offset in a page: walk the record headers until the
+  *         first erased double-word. Anything unreadable closes the page.
+  */
+static uint32_t flightlog_find_end(const flightlog_t *log, uint32_t page)
+{
+  uint32_t page_size = log->flash->page_size;
+  uint32_t offset = FLIGHTLOG_DWORD;
+  uint64_t header;
+  uint8_t type;
+  uint8_t len;
+
+  while (offset < page_size) {
+    if (flightlog_read(log, page, offset, &header) != 0) {
+      return page_size;
+    }
+    if (header == FLIGHTLOG_ERASED) {
+      return offset;
+    }
+    if (!flightlog_header_decode(header, &type, &len) ||
+        offset + flightlog_record_size(len) > page_size) {
+      return page_size;
+    }
+    offset += flightlog_record_size(len);
+  }
+  return page_size;
+}
+
+flightlog_status_t flightlog_init(flightlog_t *log, const flash_dev_t *flash)
+{
+  uint32_t page;
+  uint32_t seq;
+
+  if (flash == NULL || flash->page_count < 2U || (flash->page_size % FLIGHTLOG_DWORD) != 0U ||
+      flash->page_size < FLIGHTLOG_DWORD + flightlog_record_size(FLIGHTLOG_MAX_PAYLOAD)) {
+    return FLIGHTLOG_ERR_PARAM;
+  }
+
+  /* Blank region: the last page counts as full, so the first append opens page 0 */
+  log->flash = flash;
+  log->head_page = flash->page_count - 1U;
+  log->head_offset = flash->page_size;
+  log->head_seq = 0U;
+  log->reserve = 0U;
+  log->busy = 0U;
+
+  for (page = 0; page < flash->page_count; page++) {
+    seq = flightlog_page_seq(log, page);
+    if (seq > log->head_seq) {
+      log->head_seq = seq;
+      log->head_page = page;
+    }
+  }
+  if (log->head_seq != 0U) {
+    log->head_offset = flightlog_find_end(log, log->head_page);
+  }
+  return FLIGHTLOG_OK;
+}
+
+static flightlog_status_t flightlog_open_next(flightlog_t *log)
+{
+  const flash_dev_t *flash = log->flash;
+  uint32_t next = (log->head_page + 1U) % flash->page_count;
+
+  /* Move on first: if the erase or header fails, the next append skips
+   * this page instead of programming into it */
+  log->head_page = next;
+  log->head_seq++;
+  log->head_offset = flash->page_size;
+
+  if (flash->erase(flash->ctx, next) != 0 ||
+      flightlog_program(log, next, 0U,
+                        ((uint64_t)log->head_seq << 32) | FLIGHTLOG_PAGE_MAGIC) != 0) {
+    return FLIGHTLOG_ERR_IO;
+  }
+  log->head_offset = FLIGHTLOG_DWORD;
+  return FLIGHTLOG_OK;
+}
+
+/**
+  * @brief  Program one record at the head, which has room for it.
+  */
+static flightlog_status_t flightlog_write(flightlog_t *log, uint8_t type, const void *payload,
+                                         uint8_t len, uint32_t size)
+{
+  const uint8_t *src = (const uint8_t *)payload;
+  uint32_t offset;
+  uint32_t lo;
+  uint64_t dword;
+  uint8_t chunk[FLIGHTLOG_DWORD];
+  uint32_t i;
+  uint32_t n;
+
+  /* Claim the space up front: double-words can't be programmed twice, so a
+   * failed record is abandoned, never retried in place */
+  offset = log->head_offset;
+  log->head_offset += size;
+
+  lo = (uint32_t)type | ((uint32_t)len << 8);
+  lo |= (~lo & 0xFFFFU) << 16;
+  dword = ((uint64_t)flightlog_crc(type, len, payload) << 32) | lo;
+  if (flightlog_program(log, log->head_page, offset, dword) != 0) {
+    return FLIGHTLOG_ERR_IO;
+  }
+  offset += FLIGHTLOG_DWORD;
+
+  for (i = 0; i < len; i += FLIGHTLOG_DWORD) {
+    n = ((len - i) < FLIGHTLOG_DWORD) ? (len - i) : FLIGHTLOG_DWORD;
+    memset(chunk, 0xFF, sizeof(chunk));
+    memcpy(chunk, &src[i], n);
+    memcpy(&dword, chunk, sizeof(dword));
+    if (flightlog_program(log, log->head_page, offset, dword) != 0) {
+      return FLIGHTLOG_ERR_IO;
+    }
+    offset += FLIGHTLOG_DWORD;
+  }
+
+  if (flightlog_program(log, log->head_page, offset, FLIGHTLOG_COMMIT) != 0) {
+    return FLIGHTLOG_ERR_IO;
+  }
+  return FLIGHTLOG_OK;
+}
+
+flightlog_status_t flightlog_append(flightlog_t *log, uint8_t type, const void *payload,
+                                    uint8_t len)
+{
+  uint32_t size = flightlog_record_size(len);
+  flightlog_status_t status = FLIGHTLOG_OK;
+
+  if (type == FLIGHTLOG_TYPE_ERASED || len > FLIGHTLOG_MAX_PAYLOAD ||
+      (len > 0U && payload == NULL)) {
+    return FLIGHTLOG_ERR_PARAM;
+  }
+  log->busy = 1U;
+  if (log->head_offset + size + log->reserve > log->flash->page_size) {
+    status = flightlog_open_next(log);
+  }
+  if (status == FLIGHTLOG_OK) {
+    status = flightlog_write(log, type, payload, len, size);
+  }
+  log->busy = 0U;
+  return status;
+}
+
+uint32_t flightlog_room(const flightlog_t *log)
+{
+  return log->flash->page_size - log->head_offset;
+}
+
+void flightlog_iter_begin(const flightlog_t *log, flightlog_iter_t *it)
+{
+  /* The page after the head is the oldest one still holding data */
+  it->page = (log->head_page + 1U) % log->flash->page_count;
+  it->offset = 0U;
+  it->seq = 0U;
+  it->pages_left = (log->head_seq != 0U) ? log->flash->page_count : 0U;
+}
+
+static void flightlog_iter_next_page(const flightlog_t *log, flightlog_iter_t *it)
+{
+  it->page = (it->page + 1U) % log->flash->page_count;
+  it->offset = 0U;
+  it->pages_left--;
+}
+
+flightlog_status_t flightlog_iter_next(const flightlog_t *log, flightlog_iter_t *it,
+                                       flightlog_record_t *rec)
+{
+  uint32_t page_size = log->flash->page_size;
+  uint32_t offset;
+  uint64_t header;
+  uint64_t dword;
+  uint8_t type;
+  uint8_t len;
+  uint32_t i;
+  uint32_t n;
+  int torn;
+
+  while (it->pages_left > 0U) {
+    if (it->offset == 0U) {
+      it->seq = flightlog_page_seq(log, it->page);
+      if (it->seq == 0U || it->seq > log->head_seq) {
+        flightlog_iter_next_page(log, it);
+        continue;
+      }
+      it->offset = FLIGHTLOG_DWORD;
+    }
+
+    offset = it->offset;
+    if (offset >= page_size ||
+        flightlog_read(log, it->page, offset, &header) != 0 ||
+        !flightlog_header_decode(header, &type, &len) ||
+        offset + flightlog_record_size(len) > page_size) {
+      flightlog_iter_next_page(log, it);
+      continue;
+    }
+    it->offset += flightlog_record_size(len);
+
+    torn = 0;
+    for (i = 0; i < len && !torn; i += FLIGHTLOG_DWORD) {
+      offset += FLIGHTLOG_DWORD;
+      n = ((len - i) < FLIGHTLOG_DWORD) ? (len - i) : FLIGHTLOG_DWORD;
+      torn = (flightlog_read(log, it->page, offset, &dword) != 0);
+      memcpy(&rec->payload[i], &dword, n);
+    }
+    if (torn) {
+      continue;
+    }
+    offset += FLIGHTLOG_DWORD;
+    if (flightlog_read(log, it->page, offset, &dword) != 0 || dword != FLIGHTLOG_COMMIT ||
+        flightlog_crc(type, len, rec->payload) != (uint32_t)(header >> 32)) {
+      continue;
+    }
+
+    rec->type = type;
+    rec->len = len;
+    rec->seq = it->seq;
+    return FLIGHTLOG_OK;
+  }
+  return FLIGHTLOG_END;
+}
@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file    flightlog.h
+  * @brief   Append-only, wear-leveled record log in internal flash.
+  *
+  *          The log region is a ring of erase pages. Each page starts with a
+  *          header double-word (FLIGHTLOG_PAGE_MAGIC and a sequence number
+  *          that increases with every page opened), followed by records:
+  *
+  *            u64 header   type | len << 8 | ~(type | len << 8) << 16 |
+  *                         crc32(type, len, payload) << 32
+  *            u64 payload  len bytes, padded to a double-word with 0xFF
+  *            u64 commit   FLIGHTLOG_COMMIT, programmed last
+  *
+  *          Everything is programmed one 64-bit double-word at a time, the
+  *          flash's native unit. A record without its commit marker, or with
+  *          a bad CRC, was cut short by a reset and is skipped. When the head
+  *          page fills up, the next page in the ring is erased, dropping the
+  *          oldest records, so every page sees the same erase count.
+  *
+  *          Boot rebuilds the index from the page headers plus one walk of
+  *          the newest page: at most page_count + page_size / 8 double-word
+  *          reads, no matter how many records the log holds.
+  *
+  *          The flash is reached through flash_dev_t, so the same code
+  *          runs against the STM32 HAL (flash_stm32.c) or the host
+  *          simulator (flash_sim.c). Not thread-safe: serialize calls.
+  *          The one exception is the power-fail interrupt, which checks
+  *          `busy` and then appends its last record into `reserve` bytes
+  *          that ordinary appends leave free at the end of the head page.
+  ******************************************************************************
+  */
+#ifndef FLIGHTLOG_H
+#define FLIGHTLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "flash_dev.h"
+
+#define FLIGHTLOG_PAGE_MAGIC    0x474F4C46UL              /* "FLOG" */
+#define FLIGHTLOG_COMMIT        0xC3C33C3CA5A55A5AULL
+#define FLIGHTLOG_MAX_PAYLOAD   64U
+
+/* Record types; 0xFF reads back from erased flash and is never stored */
+#define FLIGHTLOG_TYPE_BOOT         0x01U
+#define FLIGHTLOG_TYPE_POSITION     0x02U
+#define FLIGHTLOG_TYPE_TELEMETRY    0x03U
+#define FLIGHTLOG_TYPE_POWERFAIL    0x04U
+#define FLIGHTLOG_TYPE_ERASED       0xFFU
+
+typedef enum {
+  FLIGHTLOG_OK = 0,
+  FLIGHTLOG_END = 1,            /*!< Iteration finished */
+  FLIGHTLOG_ERR_PARAM = -1,
+  FLIGHTLOG_ERR_IO = -2,        /*!< Backend program or erase failed */
+} flightlog_status_t;
+
+typedef struct {
+  const flash_dev_t *flash;
+  uint32_t head_page;           /*!< Page being appended to */
+  uint32_t head_offset;         /*!< First free byte in head_page */
+  uint32_t head_seq;            /*!< Sequence number of head_page, 0 if empty */
+  uint32_t reserve;             /*!< Bytes appends leave free at the end of a page */
+  volatile uint8_t busy;        /*!< Inside flightlog_append() */
+} flightlog_t;
+
+typedef struct {
+  uint32_t page;
+  uint32_t offset;              /*!< 0 before the page header is checked */
+  uint32_t seq;
+  uint32_t pages_left;
+} flightlog_iter_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t len;
+  uint32_t seq;                 /*!< Sequence number of the page holding it */
+  uint8_t payload[FLIGHTLOG_MAX_PAYLOAD];
+} flightlog_record_t;
+
+/**
+  * @brief  Attach to a region and rebuild the head index from flash.
+  *         Never erases or programs; a blank region is fine.
+  * @param  flash: region of at least 2 pages, kept by reference
+  */
+flightlog_status_t flightlog_init(flightlog_t *log, const flash_dev_t *flash);
+
+/**
+  * @brief  Append one record, opening (erasing) the next page if needed.
+  * @param  type: record type, not FLIGHTLOG_TYPE_ERASED
+  * @param  payload: record data
+  * @param  len: up to FLIGHTLOG_MAX_PAYLOAD bytes
+  */
+flightlog_status_t flightlog_append(flightlog_t *log, uint8_t type, const void *payload,
+                                    uint8_t len);
+
+/**
+  * @brief  Free bytes left in the head page, reserve included.
+  */
+uint32_t flightlog_room(const flightlog_t *log);
+
+/**
+  * @brief  Start iterating from the oldest record.
+  */
+void flightlog_iter_begin(const flightlog_t *log, flightlog_iter_t *it);
+
+/**
+  * @brief  Next committed record, oldest first; torn records are skipped.
+  * @retval FLIGHTLOG_OK with rec filled in, or FLIGHTLOG_END
+  */
+flightlog_status_t flightlog_iter_next(const flightlog_t *log, flightlog_iter_t *it,
+                                       flightlog_record_t *rec);
+
+/**
+  * @brief  Flash space one record of len payload bytes occupies.
+  */
+uint32_t flightlog_record_size(uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLIGHTLOG_H */
@@ -0,0 +1,253 @@
+/**
+  ******************************************************************************
+  * @file    flightlog_fuzz.c
+  * @brief   Host build: append to the flight log on flash_sim, cut the power
+  *          at random, reboot and check what the log kept.
+  *
+  *          Every record carries its own append number and a payload
+  *          derived from it, so a read-back record shows whether it is
+  *          intact. After each reboot:
+  *            - every record is one that was appended, intact, oldest first;
+  *            - the record being appended when the power went is not there:
+  *              its commit marker never made it;
+  *            - every record committed to the head page is there, so the
+  *              newest committed record always is.
+  *          A second pass marks random programmed double-words torn, as an
+  *          ECC error, and checks that the log still reads in order and
+  *          takes new records:
+  *            flightlog_fuzz [cuts] [seed]
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "flash_sim.h"
+#include "flightlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLIGHTLOG_FUZZ_CUTS         20000UL
+#define FLIGHTLOG_FUZZ_TEARS        2000UL
+#define FLIGHTLOG_FUZZ_PAGE_SIZE    2048U   /* The STM32U0's */
+#define FLIGHTLOG_FUZZ_PAGES        4U      /* Few, so the ring wraps often */
+#define FLIGHTLOG_FUZZ_MAX_OPS      80U     /* Program/erase calls before a cut */
+#define FLIGHTLOG_FUZZ_BYTES        (FLIGHTLOG_FUZZ_PAGE_SIZE * FLIGHTLOG_FUZZ_PAGES)
+
+static uint8_t flightlog_fuzz_mem[FLIGHTLOG_FUZZ_BYTES];
+static uint8_t flightlog_fuzz_torn[FLIGHTLOG_FUZZ_BYTES / 8U];
+static uint32_t flightlog_fuzz_erases[FLIGHTLOG_FUZZ_PAGES];
+
+static flash_sim_t flightlog_fuzz_sim;
+static flash_dev_t flightlog_fuzz_dev;
+static flightlog_t flightlog_fuzz_log;
+
+static uint32_t flightlog_fuzz_seed;
+static unsigned long flightlog_fuzz_failed;
+
+/* Append numbers of records whose append failed; one per cut at most */
+static uint8_t *flightlog_fuzz_lost;
+static uint32_t flightlog_fuzz_next;        /* Next append number */
+static uint32_t flightlog_fuzz_newest;      /* Last committed, 0 for none */
+static uint32_t flightlog_fuzz_page_first;  /* First appended to the head page */
+
+static uint32_t flightlog_fuzz_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  flightlog_fuzz_seed ^= flightlog_fuzz_seed << 13;
+  flightlog_fuzz_seed ^= flightlog_fuzz_seed >> 17;
+  flightlog_fuzz_seed ^= flightlog_fuzz_seed << 5;
+  return flightlog_fuzz_seed;
+}
+
+/* Payload length and bytes, from the append number alone */
+static uint8_t flightlog_fuzz_len(uint32_t n)
+{
+  return (uint8_t)(4U + (n * 2654435761UL >> 7) % (FLIGHTLOG_MAX_PAYLOAD - 3U));
+}
+
+static void flightlog_fuzz_payload(uint32_t n, uint8_t *payload)
+{
+  uint8_t len = flightlog_fuzz_len(n);
+  uint32_t i;
+
+  memcpy(payload, &n, sizeof(n));
+  for (i = sizeof(n); i < len; i++) {
+    payload[i] = (uint8_t)(n * 31U + i * 7U);
+  }
+}
+
+static void flightlog_fuzz_fail(const char *what, unsigned long round, uint32_t n)
+{
+  if (flightlog_fuzz_failed++ < 10UL) {
+    fprintf(stderr, "  round %lu: %s (record %lu)\n", round, what, (unsigned long)n);
+  }
+}
+
+/**
+  * @brief  Append the next record and keep track of what it should leave.
+  */
+static flightlog_status_t flightlog_fuzz_append(void)
+{
+  uint8_t payload[FLIGHTLOG_MAX_PAYLOAD];
+  uint32_t n = flightlog_fuzz_next++;
+  uint32_t page = flightlog_fuzz_log.head_page;
+  flightlog_status_t status;
+
+  flightlog_fuzz_payload(n, payload);
+  status = flightlog_append(&flightlog_fuzz_log, FLIGHTLOG_TYPE_TELEMETRY, payload,
+                            flightlog_fuzz_len(n));
+  /* A new page, even if this record did not make it into it */
+  if (flightlog_fuzz_log.head_page != page || flightlog_fuzz_page_first == 0U) {
+    flightlog_fuzz_page_first = n;
+  }
+  if (status != FLIGHTLOG_OK) {
+    flightlog_fuzz_lost[n] = 1U;
+    return status;
+  }
+  flightlog_fuzz_newest = n;
+  return FLIGHTLOG_OK;
+}
+
+typedef enum {
+  FLIGHTLOG_FUZZ_INTACT = 0,            /*!< Records intact and in order */
+  FLIGHTLOG_FUZZ_NEWEST,                /*!< ... and the newest committed one there */
+  FLIGHTLOG_FUZZ_HEAD_PAGE,             /*!< ... and every one in the head page */
+} flightlog_fuzz_level_t;
+
+/**
+  * @brief  Reboot: rebuild the index, then read the whole log back.
+  */
+static void flightlog_fuzz_check(unsigned long round, flightlog_fuzz_level_t level)
+{
+  uint8_t expect[FLIGHTLOG_MAX_PAYLOAD];
+  flightlog_record_t rec;
+  flightlog_iter_t it;
+  uint32_t prev = 0U;
+  uint32_t head_count = 0U;
+  uint32_t committed = 0U;
+  uint32_t n;
+  int seen_newest = 0;
+
+  if (flightlog_init(&flightlog_fuzz_log, &flightlog_fuzz_dev) != FLIGHTLOG_OK) {
+    flightlog_fuzz_fail("init failed", round, 0U);
+    return;
+  }
+  flightlog_iter_begin(&flightlog_fuzz_log, &it);
+  while (flightlog_iter_next(&flightlog_fuzz_log, &it, &rec) == FLIGHTLOG_OK) {
+    memcpy(&n, rec.payload, sizeof(n));
+    flightlog_fuzz_payload(n, expect);
+    if (rec.type != FLIGHTLOG_TYPE_TELEMETRY || n == 0U || n >= flightlog_fuzz_next ||
+        rec.len != flightlog_fuzz_len(n) || memcmp(rec.payload, expect, rec.len) != 0) {
+      flightlog_fuzz_fail("record damaged", round, n);
+      continue;
+    }
+    if (n <= prev) {
+      flightlog_fuzz_fail("record out of order", round, n);
+    }
+    if (flightlog_fuzz_lost[n]) {
+      flightlog_fuzz_fail("uncommitted record read back", round, n);
+    }
+    if (n >= flightlog_fuzz_page_first) {
+      head_count++;
+    }
+    seen_newest |= (n == flightlog_fuzz_newest);
+    prev = n;
+  }
+
+  if (level >= FLIGHTLOG_FUZZ_NEWEST && flightlog_fuzz_newest != 0U && !seen_newest) {
+    flightlog_fuzz_fail("newest committed record missing", round, flightlog_fuzz_newest);
+  }
+  if (level >= FLIGHTLOG_FUZZ_HEAD_PAGE && flightlog_fuzz_newest != 0U) {
+    for (n = flightlog_fuzz_page_first; n <= flightlog_fuzz_newest; n++) {
+      committed += !flightlog_fuzz_lost[n];
+    }
+    if (head_count != committed) {
+      flightlog_fuzz_fail("committed record in the head page missing", round,
+                          flightlog_fuzz_page_first);
+    }
+  }
+}
+
+/**
+  * @brief  Tear one double-word that holds data, as an ECC error would.
+  */
+static void flightlog_fuzz_tear(void)
+{
+  uint32_t addr;
+  uint32_t tries;
+  uint64_t dword;
+
+  for (tries = 0U; tries < 64U; tries++) {
+    addr = (flightlog_fuzz_rand() % (FLIGHTLOG_FUZZ_BYTES / 8U)) * 8U;
+    memcpy(&dword, &flightlog_fuzz_mem[addr], sizeof(dword));
+    if (dword != FLASH_DEV_ERASED) {
+      flightlog_fuzz_torn[addr / 8U] = 1U;
+      return;
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long cuts = (argc > 1) ? strtoul(argv[1], NULL, 0) : FLIGHTLOG_FUZZ_CUTS;
+  unsigned long round;
+  uint32_t min_erases = UINT32_MAX;
+  uint32_t max_erases = 0U;
+  uint32_t ops;
+  uint32_t i;
+
+  flightlog_fuzz_seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x2545F491UL;
+  if (cuts == 0UL || flightlog_fuzz_seed == 0U) {
+    fprintf(stderr, "usage: %s [cuts] [seed]\n", argv[0]);
+    return 2;
+  }
+  /* Each round appends FLIGHTLOG_FUZZ_MAX_OPS records at most */
+  flightlog_fuzz_lost = calloc((cuts + FLIGHTLOG_FUZZ_TEARS + 1UL) * FLIGHTLOG_FUZZ_MAX_OPS, 1U);
+  if (flightlog_fuzz_lost == NULL) {
+    return 2;
+  }
+  flightlog_fuzz_next = 1U;
+
+  flash_sim_init(&flightlog_fuzz_sim, flightlog_fuzz_mem, flightlog_fuzz_torn,
+                 flightlog_fuzz_erases, FLIGHTLOG_FUZZ_PAGE_SIZE, FLIGHTLOG_FUZZ_PAGES);
+  flash_sim_dev(&flightlog_fuzz_sim, &flightlog_fuzz_dev);
+  flightlog_fuzz_check(0UL, FLIGHTLOG_FUZZ_HEAD_PAGE);
+
+  /* Power cuts: anywhere in a program or an erase, including a page open */
+  for (round = 1UL; round <= cuts; round++) {
+    ops = 1U + flightlog_fuzz_rand() % FLIGHTLOG_FUZZ_MAX_OPS;
+    flash_sim_cut_after(&flightlog_fuzz_sim, ops, flightlog_fuzz_rand());
+    while (flightlog_fuzz_append() == FLIGHTLOG_OK) {
+    }
+    flash_sim_power_on(&flightlog_fuzz_sim);
+    flightlog_fuzz_check(round, FLIGHTLOG_FUZZ_HEAD_PAGE);
+  }
+  printf("  %-22s %7lu rounds, %lu records  %s\n", "power cuts", cuts,
+         (unsigned long)flightlog_fuzz_next - 1UL, (flightlog_fuzz_failed == 0UL) ? "ok" : "FAIL");
+
+  for (i = 0U; i < FLIGHTLOG_FUZZ_PAGES; i++) {
+    min_erases = (flightlog_fuzz_erases[i] < min_erases) ? flightlog_fuzz_erases[i] : min_erases;
+    max_erases = (flightlog_fuzz_erases[i] > max_erases) ? flightlog_fuzz_erases[i] : max_erases;
+  }
+  printf("  %-22s %7lu to %lu per page\n", "erases", (unsigned long)min_erases,
+         (unsigned long)max_erases);
+
+  /* ECC errors in data already written: nothing damaged may come back, and
+   * the log must still take records */
+  for (round = 1UL; round <= FLIGHTLOG_FUZZ_TEARS; round++) {
+    flightlog_fuzz_tear();
+    flightlog_fuzz_check(cuts + round, FLIGHTLOG_FUZZ_INTACT);
+    for (i = flightlog_fuzz_rand() % 8U; i > 0U; i--) {
+      (void)flightlog_fuzz_append();
+    }
+    if (flightlog_fuzz_append() != FLIGHTLOG_OK) {
+      flightlog_fuzz_fail("append failed after a torn double-word", cuts + round, 0U);
+    }
+    flightlog_fuzz_check(cuts + round, FLIGHTLOG_FUZZ_NEWEST);
+  }
+  printf("  %-22s %7lu rounds  %s\n", "torn double-words", FLIGHTLOG_FUZZ_TEARS,
+         (flightlog_fuzz_failed == 0UL) ? "ok" : "FAIL");
+
+  free(flightlog_fuzz_lost);
+  return (flightlog_fuzz_failed == 0UL) ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+/**
+  ******************************************************************************
+  * @file    fmt.c
+  * @brief   Small integer-only printf-style formatter.
+  ******************************************************************************
+  */
+#include "fmt.h"
+
+#include <stdint.h>
+
+#define FMT_LEFT     0x01U
+#define FMT_ZERO     0x02U
+#define FMT_PLUS     0x04U
+#define FMT_SPACE    0x08U
+#define FMT_UPPER    0x10U
+
+typedef struct {
+  fmt_putc_t putc;
+  void *ctx;
+  int count;
+} fmt_state_t;
+
+static void fmt_emit(fmt_state_t *st, char c)
+{
+  st->putc(st->ctx, c);
+  st->count++;
+}
+
+static void fmt_pad(fmt_state_t *st, char c, int n)
+{
+  while (n-- > 0) {
+    fmt_emit(st, c);
+  }
+}
+
+static void fmt_string(fmt_state_t *st, const char *s, int width, int prec, unsigned flags)
+{
+  int len = 0;
+
+  if (s == NULL) {
+    s = "(null)";
+  }
+  while (s[len] != '\0' && (prec < 0 || len < prec)) {
+    len++;
+  }
+  if (!(flags & FMT_LEFT)) {
+    fmt_pad(st, ' ', width - len);
+  }
+  for (int i = 0; i < len; i++) {
+    fmt_emit(st, s[i]);
+  }
+  if (flags & FMT_LEFT) {
+    fmt_pad(st, ' ', width - len);
+  }
+}
+
+static void fmt_number(fmt_state_t *st, unsigned long value, int negative, unsigned base,
+                       int width, int prec, unsigned flags)
+{
+  /* Enough for 64-bit longs in octal on the host build */
+  char digits[24];
+  const char *set = (flags & FMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+  int ndigits = 0;
+  int zeros;
+  int len;
+  char sign = 0;
+
+  if (negative) {
+    sign = '-';
+  } else if (flags & FMT_PLUS) {
+    sign = '+';
+  } else if (flags & FMT_SPACE) {
+    sign = ' ';
+  }
+
+  /* C: precision 0 with value 0 prints no digits */
+  if (!(value == 0U && prec == 0)) {
+    do {
+      digits[ndigits++] = set[value % base];
+      value /= base;
+    } while (value != 0U);
+  }
+
+  zeros = (prec > ndigits) ? (prec - ndigits) : 0;
+  len = ndigits + zeros + (sign ? 1 : 0);
+
+  /* '0' flag pads with zeros after the sign, ignored with a precision */
+  if ((flags & FMT_ZERO) && !(flags & FMT_LEFT) && prec < 0 && width > len) {
+    zeros += width - len;
+    len = width;
+  }
+
+  if (!(flags & FMT_LEFT)) {
+    fmt_pad(st, ' ', width - len);
+  }
+  if (sign) {
+    fmt_emit(st, sign);
+  }
+  fmt_pad(st, '0', zeros);
+  while (ndigits > 0) {
+    fmt_emit(st, digits[--ndigits]);
+  }
+  if (flags & FMT_LEFT) {
+    fmt_pad(st, ' ', width - len);
+  }
+}
+
+int fmt_vformat(fmt_putc_t putc, void *ctx, const char *fmt, va_list ap)
+{
+  fmt_state_t st = { putc, ctx, 0 };
+  va_list args;
+
+  /* Work on a copy so the va_list can be walked through helper calls */
+  va_copy(args, ap);
+
+  while (*fmt != '\0') {
+    unsigned flags = 0;
+    int width = 0;
+    int prec = -1;
+    char length = 0;
+    char conv;
+
+    if (*fmt != '%') {
+      fmt_emit(&st, *fmt++);
+      continue;
+    }
+    fmt++;
+
+    for (;; fmt++) {
+      if (*fmt == '-') {
+        flags |= FMT_LEFT;
+      } else if (*fmt == '0') {
+        flags |= FMT_ZERO;
+      } else if (*fmt == '+') {
+        flags |= FMT_PLUS;
+      } else if (*fmt == ' ') {
+        flags |= FMT_SPACE;
+      } else if (*fmt != '#') {
+        break;
+      }
+    }
+
+    if (*fmt == '*') {
+      width = va_arg(args, int);
+      if (width < 0) {
+        flags |= FMT_LEFT;
+        width = -width;
+      }
+      fmt++;
+    } else {
+      while (*fmt >= '0' && *fmt <= '9') {
+        width = (width * 10) + (*fmt++ - '0');
+      }
+    }
+
+    if (*fmt == '.') {
+      fmt++;
+      prec = 0;
+      if (*fmt == '*') {
+        prec = va_arg(args, int);
+        fmt++;
+      } else {
+        while (*fmt >= '0' && *fmt <= '9') {
+          prec = (prec * 10) + (*fmt++ - '0');
+        }
+      }
+    }
+
+    /* 'H' stands for hh */
+    while (*fmt == 'h' || *fmt == 'l' || *fmt == 'z' || *fmt == 't') {
+      length = (length == 'h' && *fmt == 'h') ? 'H' : *fmt;
+      fmt++;
+    }
+
+    conv = *fmt;
+    if (conv == '\0') {
+      break;
+    }
+    fmt++;
+
+    switch (conv) {
+      case 'd':
+      case 'i': {
+        long v = (length == 'l') ? va_arg(args, long)
+               : (length == 'z' || length == 't') ? (long)va_arg(args, ptrdiff_t)
+               : va_arg(args, int);
+        if (length == 'h') {
+          v = (short)v;
+        } else if (length == 'H') {
+          v = (signed char)v;
+        }
+        fmt_number(&st, (v < 0) ? (0UL - (unsigned long)v) : (unsigned long)v, v < 0, 10U,
+                   width, prec, flags);
+        break;
+      }
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o': {
+        unsigned long v = (length == 'l') ? va_arg(args, unsigned long)
+                        : (length == 'z' || length == 't') ? (unsigned long)va_arg(args, size_t)
+                        : va_arg(args, unsigned int);
+        if (length == 'h') {
+          v = (unsigned short)v;
+        } else if (length == 'H') {
+          v = (unsigned char)v;
+        }
+        if (conv == 'X') {
+          flags |= FMT_UPPER;
+        }
+        fmt_number(&st, v, 0, (conv == 'u') ? 10U : (conv == 'o') ? 8U : 16U, width, prec,
+                   flags & ~(FMT_PLUS | FMT_SPACE));
+        break;
+      }
+      case 'p':
+        fmt_string(&st, "0x", 0, -1, 0);
+        fmt_number(&st, (unsigned long)(uintptr_t)va_arg(args, void *), 0, 16U,
+                   0, (int)(sizeof(void *) * 2U), 0);
+        break;
+      case 'c': {
+        char c = (char)va_arg(args, int);
+        if (!(flags & FMT_LEFT)) {
+          fmt_pad(&st, ' ', width - 1);
+        }
+        fmt_emit(&st, c);
+        if (flags & FMT_LEFT) {
+          fmt_pad(&st, ' ', width - 1);
+        }
+        break;
+      }
+      case 's':
+        fmt_string(&st, va_arg(args, const char *), width, prec, flags);
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+        /* Keep the argument list in step, but never link soft-float */
+        (void)va_arg(args, double);
+        fmt_emit(&st, '?');
+        break;
+      case '%':
+        fmt_emit(&st, '%');
+        break;
+      default:
+        /* Unknown conversion: echo it so the mistake is visible */
+        fmt_emit(&st, '%');
+        fmt_emit(&st, conv);
+        break;
+    }
+  }
+
+  va_end(args);
+  return st.count;
+}
+
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t pos;
+} fmt_buf_t;
+
+static void fmt_buf_putc(void *ctx, char c)
+{
+  fmt_buf_t *b = (fmt_buf_t *)ctx;
+
+  if (b->pos + 1U < b->size) {
+    b->buf[b->pos] = c;
+  }
+  b->pos++;
+}
+
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+  fmt_buf_t b = { buf, size, 0 };
+  int n = fmt_vformat(fmt_buf_putc, &b, fmt, ap);
+
+  if (size > 0U) {
+    buf[(b.pos < size) ? b.pos : (size - 1U)] = '\0';
+  }
+  return n;
+}
+
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = fmt_vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
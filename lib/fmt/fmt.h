@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    fmt.h
+  * @brief   Small integer-only printf-style formatter.
+  *
+  *          Replaces newlib's vfprintf for console output: no heap, no
+  *          locale, no floating point, a few hundred bytes of code.
+  *
+  *          Supported: %d %i %u %x %X %o %c %s %p %%, flags '-' '0' '+' ' ',
+  *          width and precision (digits or '*'), length modifiers hh h l z t.
+  *          %f/%e/%g consume their double and print '?'. %ll is not
+  *          supported, to keep 64-bit division out of the image.
+  ******************************************************************************
+  */
+#ifndef FMT_H
+#define FMT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+  * @brief  Character sink called once per output character.
+  */
+typedef void (*fmt_putc_t)(void *ctx, char c);
+
+/**
+  * @brief  Format into an arbitrary sink.
+  * @param  putc: sink
+  * @param  ctx: passed through to putc
+  * @param  fmt: format string
+  * @param  ap: arguments
+  * @retval Number of characters emitted
+  */
+int fmt_vformat(fmt_putc_t putc, void *ctx, const char *fmt, va_list ap);
+
+/**
+  * @brief  vsnprintf() equivalent; always NUL terminates when size > 0.
+  * @retval Length the full output would have had, as per C99
+  */
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+  __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMT_H */
@@ -0,0 +1,250 @@
+/**
+  ******************************************************************************
+  * @file    i2c_bus.c
+  * @brief   I2C1 bus manager: queued, interrupt-driven register transfers.
+  ******************************************************************************
+  */
+#include "i2c_bus.h"
+#include "main.h"
+#include "clock.h"
+#include "power.h"
+
+I2C_HandleTypeDef hi2c1;
+
+static TX_THREAD i2c_bus_thread;
+static TX_QUEUE i2c_bus_queue;
+static TX_SEMAPHORE i2c_bus_done;
+static ULONG i2c_bus_queue_storage[I2C_BUS_QUEUE_DEPTH];
+static volatile uint32_t i2c_bus_error;
+
+static void i2c_bus_thread_entry(ULONG thread_input);
+
+void HAL_I2C_MspInit(I2C_HandleTypeDef *i2cHandle)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+
+  if (i2cHandle->Instance == I2C1) {
+    PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_I2C1;
+    PeriphClkInit.I2c1ClockSelection = RCC_I2C1CLKSOURCE_HSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK) {
+      Error_Handler();
+    }
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    /* PB8 ------> I2C1_SCL, PB9 ------> I2C1_SDA (D15/D14 on the Nucleo) */
+    GPIO_InitStruct.Pin = GPIO_PIN_8 | GPIO_PIN_9;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF4_I2C1;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    __HAL_RCC_I2C1_CLK_ENABLE();
+    HAL_NVIC_SetPriority(I2C1_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+  }
+}
+
+void HAL_I2C_MspDeInit(I2C_HandleTypeDef *i2cHandle)
+{
+  if (i2cHandle->Instance == I2C1) {
+    __HAL_RCC_I2C1_CLK_DISABLE();
+    HAL_GPIO_DeInit(GPIOB, GPIO_PIN_8 | GPIO_PIN_9);
+    HAL_NVIC_DisableIRQ(I2C1_IRQn);
+  }
+}
+
+static void i2c_bus_hw_init(void)
+{
+  hi2c1.Instance = I2C1;
+  hi2c1.Init.Timing = I2C_BUS_TIMING;
+  hi2c1.Init.OwnAddress1 = 0;
+  hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+  hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+  hi2c1.Init.OwnAddress2 = 0;
+  hi2c1.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+  hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+  hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+  if (HAL_I2C_Init(&hi2c1) != HAL_OK) {
+    Error_Handler();
+  }
+  if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+    Error_Handler();
+  }
+}
+
+UINT i2c_bus_init(TX_BYTE_POOL *byte_pool)
+{
+  CHAR *pointer;
+  UINT ret;
+
+  i2c_bus_hw_init();
+
+  ret = tx_queue_create(&i2c_bus_queue, "I2C Queue", TX_1_ULONG, i2c_bus_queue_storage,
+                        sizeof(i2c_bus_queue_storage));
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_semaphore_create(&i2c_bus_done, "I2C Done", 0);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_byte_allocate(byte_pool, (VOID **)&pointer, I2C_BUS_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  return tx_thread_create(&i2c_bus_thread, "I2C Bus", i2c_bus_thread_entry, 0,
+                          pointer, I2C_BUS_THREAD_STACK_SIZE,
+                          I2C_BUS_THREAD_PRIORITY, I2C_BUS_THREAD_PRIORITY,
+                          TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+i2c_bus_status_t i2c_bus_submit(i2c_xfer_t *xfer, ULONG wait)
+{
+  ULONG message = (ULONG)(uintptr_t)xfer;
+
+  xfer->status = I2C_BUS_PENDING;
+  if (tx_queue_send(&i2c_bus_queue, &message, wait) != TX_SUCCESS) {
+    xfer->status = I2C_BUS_ERR_QUEUE;
+  }
+  return xfer->status;
+}
+
+void I2C1_IRQHandler(void)
+{
+  HAL_I2C_EV_IRQHandler(&hi2c1);
+  HAL_I2C_ER_IRQHandler(&hi2c1);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  if (hi2c == &hi2c1) {
+    (void)tx_semaphore_put(&i2c_bus_done);
+  }
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  if (hi2c == &hi2c1) {
+    (void)tx_semaphore_put(&i2c_bus_done);
+  }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+  if (hi2c == &hi2c1) {
+    i2c_bus_error = HAL_I2C_GetError(hi2c);
+    (void)tx_semaphore_put(&i2c_bus_done);
+  }
+}
+
+/**
+  * @brief  Run one transfer to completion on the bus thread.
+  */
+static i2c_bus_status_t i2c_bus_run(const i2c_xfer_t *xfer)
+{
+  uint16_t addr = (uint16_t)(xfer->addr << 1);
+  HAL_StatusTypeDef hal;
+
+  i2c_bus_error = HAL_I2C_ERROR_NONE;
+  if (xfer->write) {
+    hal = HAL_I2C_Mem_Write_IT(&hi2c1, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->buf, xfer->len);
+  } else {
+    hal = HAL_I2C_Mem_Read_IT(&hi2c1, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->buf, xfer->len);
+  }
+  if (hal != HAL_OK) {
+    return I2C_BUS_ERR_BUS;
+  }
+
+  if (tx_semaphore_get(&i2c_bus_done, I2C_BUS_XFER_TIMEOUT) != TX_SUCCESS) {
+    /* A device holding SDA or a lost interrupt: start the peripheral over */
+    (void)HAL_I2C_DeInit(&hi2c1);
+    i2c_bus_hw_init();
+    (void)tx_semaphore_get(&i2c_bus_done, TX_NO_WAIT);
+    return I2C_BUS_ERR_TIMEOUT;
+  }
+  if (i2c_bus_error & HAL_I2C_ERROR_AF) {
+    return I2C_BUS_ERR_NACK;
+  }
+  return (i2c_bus_error == HAL_I2C_ERROR_NONE) ? I2C_BUS_OK : I2C_BUS_ERR_BUS;
+}
+
+static void i2c_bus_thread_entry(ULONG thread_input)
+{
+  ULONG message;
+  i2c_xfer_t *xfer;
+  (void)thread_input;
+
+  /* Idle on the queue: the bus has no deadline to keep, each transfer has
+   * its own timeout */
+  for (;;) {
+    (void)tx_queue_receive(&i2c_bus_queue, &message, TX_WAIT_FOREVER);
+    xfer = (i2c_xfer_t *)(uintptr_t)message;
+    /* The kernel clock is HSI16. Only CLOCK_LEVEL_HIGH is sure to run it:
+     * below the baud rate's floor it runs for the USART, otherwise not, and
+     * it stops in STOP2 */
+    clock_request(CLOCK_LEVEL_HIGH);
+    power_stop_inhibit();
+    xfer->status = i2c_bus_run(xfer);
+    power_stop_allow();
+    clock_release(CLOCK_LEVEL_HIGH);
+    if (xfer->done != NULL) {
+      (void)tx_semaphore_put(xfer->done);
+    }
+  }
+}
+
+UINT i2c_bus_client_init(i2c_bus_client_t *client, CHAR *name, uint8_t addr)
+{
+  client->addr = addr;
+  client->wait = I2C_BUS_QUEUE_DEPTH * (I2C_BUS_XFER_TIMEOUT + 1U);
+  client->xfer.done = &client->done;
+  return tx_semaphore_create(&client->done, name, 0);
+}
+
+/**
+  * @brief  Submit the client's transfer and wait for it. Once queued it is
+  *         waited for to the end, since the bus thread still owns xfer and
+  *         buf. That wait is bounded all the same: the bus thread times
+  *         out ours and every transfer ahead of it.
+  */
+static int i2c_bus_client_run(i2c_bus_client_t *client, uint8_t reg, uint8_t *buf,
+                              uint16_t len, uint8_t write)
+{
+  i2c_xfer_t *xfer = &client->xfer;
+
+  xfer->addr = client->addr;
+  xfer->reg = reg;
+  xfer->write = write;
+  xfer->buf = buf;
+  xfer->len = len;
+  /* Nothing is outstanding here, so a count left over is stale */
+  while (tx_semaphore_get(&client->done, TX_NO_WAIT) == TX_SUCCESS) {
+  }
+  if (i2c_bus_submit(xfer, client->wait) != I2C_BUS_PENDING) {
+    return -1;
+  }
+  if (tx_semaphore_get(&client->done, TX_WAIT_FOREVER) != TX_SUCCESS) {
+    return -1;
+  }
+  return (xfer->status == I2C_BUS_OK) ? 0 : -1;
+}
+
+static int i2c_bus_client_read(void *ctx, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+  return i2c_bus_client_run(ctx, reg, buf, len, 0U);
+}
+
+static int i2c_bus_client_write(void *ctx, uint8_t reg, const uint8_t *buf, uint16_t len)
+{
+  /* The HAL takes a non-const buffer but only reads it for a write */
+  return i2c_bus_client_run(ctx, reg, (uint8_t *)(uintptr_t)buf, len, 1U);
+}
+
+void i2c_bus_client_dev(i2c_bus_client_t *client, i2c_dev_t *dev)
+{
+  dev->read = i2c_bus_client_read;
+  dev->write = i2c_bus_client_write;
+  dev->ctx = client;
+}
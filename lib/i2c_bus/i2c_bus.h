@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    i2c_bus.h
+  * @brief   I2C1 bus manager: queued, interrupt-driven register transfers.
+  *
+  *          Drivers describe a register read or write in an i2c_xfer_t and
+  *          submit it. A bus thread takes transfers off a queue one at a
+  *          time, in submission order, runs each with the HAL's interrupt
+  *          API, and sleeps on a semaphore given by the completion callback
+  *          instead of polling. When a transfer finishes, its status is
+  *          filled in and its done semaphore given.
+  *
+  *          i2c_bus_client_t wraps that into a blocking i2c_dev_t for
+  *          drivers that just want register access.
+  *
+  *          The I2C kernel clock is HSI16 whatever SYSCLK is, so the timing
+  *          below holds across clock changes.
+  ******************************************************************************
+  */
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+#include "i2c_dev.h"
+#include <stdint.h>
+
+#define I2C_BUS_THREAD_STACK_SIZE       512U
+#define I2C_BUS_THREAD_PRIORITY         3U    /* Above every client */
+#define I2C_BUS_QUEUE_DEPTH             8U
+#define I2C_BUS_XFER_TIMEOUT            5U    /* ticks for one transfer */
+
+/* 100 kHz from the 16 MHz HSI16 kernel clock */
+#define I2C_BUS_TIMING                  0x00303D5BUL
+
+typedef enum {
+  I2C_BUS_OK = 0,
+  I2C_BUS_PENDING = 1,
+  I2C_BUS_ERR_NACK = -1,            /*!< Device did not answer */
+  I2C_BUS_ERR_BUS = -2,             /*!< Bus error or arbitration lost */
+  I2C_BUS_ERR_TIMEOUT = -3,         /*!< No completion, the bus was reset */
+  I2C_BUS_ERR_QUEUE = -4,           /*!< Not queued */
+} i2c_bus_status_t;
+
+typedef struct {
+  uint8_t addr;                     /*!< 7-bit device address */
+  uint8_t reg;
+  uint8_t write;                    /*!< 0: read into buf, 1: write from buf */
+  uint16_t len;
+  uint8_t *buf;
+  volatile i2c_bus_status_t status;
+  TX_SEMAPHORE *done;               /*!< Given on completion, may be NULL */
+} i2c_xfer_t;
+
+typedef struct {
+  uint8_t addr;
+  ULONG wait;                       /*!< Longest wait for queue space, ticks */
+  TX_SEMAPHORE done;
+  i2c_xfer_t xfer;
+} i2c_bus_client_t;
+
+/**
+  * @brief  Bring up I2C1 and create the bus thread.
+  * @param  byte_pool: pool for the bus thread stack
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT i2c_bus_init(TX_BYTE_POOL *byte_pool);
+
+/**
+  * @brief  Queue a transfer and return. xfer must stay valid until its
+  *         status is no longer I2C_BUS_PENDING.
+  * @param  wait: how long to wait for queue space
+  * @retval I2C_BUS_PENDING, or I2C_BUS_ERR_QUEUE
+  */
+i2c_bus_status_t i2c_bus_submit(i2c_xfer_t *xfer, ULONG wait);
+
+/**
+  * @brief  Set up a blocking client for the device at addr.
+  */
+UINT i2c_bus_client_init(i2c_bus_client_t *client, CHAR *name, uint8_t addr);
+
+/**
+  * @brief  i2c_dev_t view of a client, for sensor drivers. Must be used
+  *         from a thread.
+  */
+void i2c_bus_client_dev(i2c_bus_client_t *client, i2c_dev_t *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_BUS_H */
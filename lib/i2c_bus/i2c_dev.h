@@ -0,0 +1,30 @@
+/**
+  ******************************************************************************
+  * @file    i2c_dev.h
+  * @brief   Register-level access to one I2C device.
+  *
+  *          What sensor drivers are written against. On target it is backed
+  *          by an i2c_bus client; on the host by i2c_replay. Callbacks
+  *          return 0 on success.
+  ******************************************************************************
+  */
+#ifndef I2C_DEV_H
+#define I2C_DEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct {
+  int (*read)(void *ctx, uint8_t reg, uint8_t *buf, uint16_t len);
+  int (*write)(void *ctx, uint8_t reg, const uint8_t *buf, uint16_t len);
+  void *ctx;
+} i2c_dev_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_DEV_H */
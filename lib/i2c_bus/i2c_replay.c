@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file    i2c_replay.c
+  * @brief   Host-side i2c_dev_t that replays a captured register dump.
+  ******************************************************************************
+  */
+#include "i2c_replay.h"
+
+#include <string.h>
+
+static int i2c_replay_read(void *ctx, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+  i2c_replay_t *replay = ctx;
+  uint16_t i;
+
+  if (replay->fail) {
+    return -1;
+  }
+  for (i = 0; i < len; i++) {
+    buf[i] = replay->regs[(uint8_t)(reg + i)];
+  }
+  replay->reads++;
+  return 0;
+}
+
+static int i2c_replay_write(void *ctx, uint8_t reg, const uint8_t *buf, uint16_t len)
+{
+  i2c_replay_t *replay = ctx;
+  uint16_t i;
+
+  if (replay->fail) {
+    return -1;
+  }
+  for (i = 0; i < len; i++) {
+    replay->regs[(uint8_t)(reg + i)] = buf[i];
+  }
+  replay->writes++;
+  return 0;
+}
+
+void i2c_replay_init(i2c_replay_t *replay)
+{
+  memset(replay, 0, sizeof(*replay));
+}
+
+void i2c_replay_load(i2c_replay_t *replay, uint8_t reg, const uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  for (i = 0; i < len; i++) {
+    replay->regs[(uint8_t)(reg + i)] = data[i];
+  }
+}
+
+void i2c_replay_dev(i2c_replay_t *replay, i2c_dev_t *dev)
+{
+  dev->read = i2c_replay_read;
+  dev->write = i2c_replay_write;
+  dev->ctx = replay;
+}
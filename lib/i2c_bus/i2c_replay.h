@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    i2c_replay.h
+  * @brief   Host-side i2c_dev_t that replays a captured register dump.
+  *
+  *          The device is a 256-byte register file loaded from a dump of
+  *          the real part. Reads return it, auto-incrementing like most
+  *          sensors do, and writes land in it and are counted, so a driver
+  *          under test sees its own configuration read back. Frames of
+  *          measurement data can be swapped in between reads with
+  *          i2c_replay_load().
+  *
+  *          Plain C with no target dependencies; not part of the firmware.
+  ******************************************************************************
+  */
+#ifndef I2C_REPLAY_H
+#define I2C_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "i2c_dev.h"
+
+typedef struct {
+  uint8_t regs[256];
+  uint32_t reads;
+  uint32_t writes;
+  int fail;                     /*!< Non-zero: every access fails, as a NACK */
+} i2c_replay_t;
+
+/**
+  * @brief  Start from all zeros, then load the dumps.
+  */
+void i2c_replay_init(i2c_replay_t *replay);
+
+/**
+  * @brief  Copy len bytes of a dump into the register file from reg on.
+  */
+void i2c_replay_load(i2c_replay_t *replay, uint8_t reg, const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  i2c_dev_t view of the replay device.
+  */
+void i2c_replay_dev(i2c_replay_t *replay, i2c_dev_t *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_REPLAY_H */
@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file    gpsduty.c
+  * @brief   GPS duty cycling on the filter's predicted error.
+  ******************************************************************************
+  */
+#include "gpsduty.h"
+
+/**
+  * @brief  How long from now the receiver may stay off: until lead_ms
+  *         before the first beacon whose predicted error is too large, at
+  *         most max_off_ms. The error only grows, so the first such beacon
+  *         is the one that matters.
+  */
+static uint32_t gpsduty_off_for(const gpsduty_t *duty, const navkf_t *kf, uint32_t now_ms,
+                                uint32_t next_beacon_ms, uint32_t period_ms)
+{
+  const gpsduty_config_t *config = duty->config;
+  uint32_t ahead = next_beacon_ms - now_ms;
+
+  if (period_ms == 0U) {
+    return config->max_off_ms;
+  }
+  while (ahead <= config->max_off_ms + config->lead_ms) {
+    if (navkf_herr_cm(kf, ahead) > config->herr_max_cm) {
+      return (ahead > config->lead_ms) ? ahead - config->lead_ms : 0U;
+    }
+    ahead += period_ms;
+  }
+  return config->max_off_ms;
+}
+
+void gpsduty_init(gpsduty_t *duty, const gpsduty_config_t *config, uint32_t now_ms)
+{
+  *duty = (gpsduty_t){ 0 };
+  duty->config = config;
+  duty->on = 1U;
+  duty->last_ms = now_ms;
+}
+
+void gpsduty_fix(gpsduty_t *duty)
+{
+  duty->fixes++;
+}
+
+int gpsduty_step(gpsduty_t *duty, const navkf_t *kf, uint32_t now_ms,
+                 uint32_t next_beacon_ms, uint32_t period_ms)
+{
+  uint32_t dt = now_ms - duty->last_ms;
+  uint32_t off_for;
+
+  if ((int32_t)dt > 0) {
+    if (duty->on) {
+      duty->on_ms += dt;
+    } else {
+      duty->off_ms += dt;
+    }
+    duty->last_ms = now_ms;
+  }
+
+  if (!duty->on) {
+    if ((int32_t)(now_ms - duty->off_until_ms) < 0) {
+      return 0;
+    }
+    duty->on = 1U;
+    duty->fixes = 0U;
+    return 1;
+  }
+
+  if (!kf->primed || duty->fixes < duty->config->min_fixes) {
+    return 0;
+  }
+  off_for = gpsduty_off_for(duty, kf, now_ms, next_beacon_ms, period_ms);
+  if (off_for < duty->config->min_off_ms) {
+    return 0;
+  }
+  duty->on = 0U;
+  duty->off_until_ms = now_ms + off_for;
+  duty->cycles++;
+  return 1;
+}
@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    gpsduty.h
+  * @brief   GPS duty cycling: keep the receiver off while the filter's
+  *          prediction is good enough for the beacons, and on again in
+  *          time for the first one it would not be.
+  *
+  *          While on, once min_fixes have come in, the policy looks along
+  *          the beacon schedule for the first beacon at which the predicted
+  *          horizontal error (navkf_herr_cm) passes herr_max_cm. It wakes
+  *          the receiver lead_ms before that beacon, for the warm or hot
+  *          start to finish, and switches it off now if that leaves at
+  *          least min_off_ms. No off period is longer than max_off_ms, so
+  *          the filter never runs on a prediction older than that.
+  *
+  *          Pure C like navkf: nav_service.c runs it once a second on
+  *          target, nav_replay runs it over recorded tracks on the host.
+  ******************************************************************************
+  */
+#ifndef GPSDUTY_H
+#define GPSDUTY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "navkf.h"
+
+typedef struct {
+  uint32_t herr_max_cm;                 /*!< Predicted error allowed at a beacon, 1 sigma */
+  uint32_t lead_ms;                     /*!< On this long before a beacon that needs a fix */
+  uint32_t min_fixes;                   /*!< Fixes per on period before going off */
+  uint32_t min_off_ms;                  /*!< Not worth switching off for less */
+  uint32_t max_off_ms;
+} gpsduty_config_t;
+
+/* 100 m for an APRS position at 1/100 minute, a hot start with warm-boot aiding */
+#define GPSDUTY_CONFIG_DEFAULT                                                 \
+  {                                                                            \
+    10000UL, 30000UL, 5UL, 120000UL, 1800000UL,                                \
+  }
+
+typedef struct {
+  const gpsduty_config_t *config;
+  uint8_t on;
+  uint32_t fixes;                       /*!< In this on period */
+  uint32_t off_until_ms;                /*!< While off */
+  uint32_t last_ms;
+  uint32_t on_ms;                       /*!< Totals, for the on-time ratio */
+  uint32_t off_ms;
+  uint32_t cycles;                      /*!< Off periods so far */
+} gpsduty_t;
+
+/**
+  * @brief  Start with the receiver on: there is nothing to predict from.
+  * @param  config: kept by reference
+  */
+void gpsduty_init(gpsduty_t *duty, const gpsduty_config_t *config, uint32_t now_ms);
+
+/**
+  * @brief  Count a fix towards min_fixes. Call it with navkf_fix().
+  */
+void gpsduty_fix(gpsduty_t *duty);
+
+/**
+  * @brief  Decide whether the receiver should be on.
+  * @param  kf: the filter, predicted to now_ms
+  * @param  next_beacon_ms: time of the next beacon, after now_ms
+  * @param  period_ms: between beacons; 0 for none, when only max_off_ms applies
+  * @retval 1 if duty->on changed, 0 otherwise
+  */
+int gpsduty_step(gpsduty_t *duty, const navkf_t *kf, uint32_t now_ms,
+                 uint32_t next_beacon_ms, uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPSDUTY_H */
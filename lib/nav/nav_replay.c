@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file    nav_replay.c
+  * @brief   Host build: fly the filter and the GPS duty cycle along a
+  *          recorded balloon track and print what they cost and what they
+  *          get wrong.
+  *
+  *          The track comes on stdin, one "<ms>,<lat_e7>,<lon_e7>,<alt_m>"
+  *          line per second, and is taken as the truth; blank lines and
+  *          lines starting with '#' are skipped. While the policy has the
+  *          receiver on, each line after the time to first fix gives a fix
+  *          with Gaussian noise, and every line gives a baro altitude with
+  *          a fixed offset. At each beacon the estimate is compared with the
+  *          track:
+  *            nav_replay [-e err_m] [-b beacon_s] [-l lead_s] [-t ttff_s]
+  *                       [-n noise_m] [-q q_h] [-a] < track.csv
+  *          -e is the error allowed at a beacon (GPSDUTY_CONFIG_DEFAULT's
+  *          herr_max_cm), -n the fix noise per axis, 1 sigma, -q the
+  *          filter's horizontal process noise in cm^2/s^3, and -a keeps the
+  *          receiver on throughout, for comparison. The exit status is 0 if
+  *          95% of the beacons are within -e.
+  ******************************************************************************
+  */
+#include "gpsduty.h"
+#include "navkf.h"
+#include "qgeo.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NAV_REPLAY_LINE         128U
+#define NAV_REPLAY_BARO_BIAS_M  150.0   /* Pressure altitude against GPS altitude */
+#define NAV_REPLAY_BARO_NOISE_M 1.0
+#define NAV_REPLAY_M_PER_E7     0.0111195
+
+static uint32_t nav_replay_seed = 0x2545F491UL;
+
+/* Standard normal, Box-Muller over xorshift32: repeatable runs */
+static double nav_replay_gauss(void)
+{
+  double u[2];
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    nav_replay_seed ^= nav_replay_seed << 13;
+    nav_replay_seed ^= nav_replay_seed >> 17;
+    nav_replay_seed ^= nav_replay_seed << 5;
+    u[i] = ((double)nav_replay_seed + 1.0) / 4294967297.0;
+  }
+  return sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+static int nav_replay_cmp(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void nav_replay_usage(const char *argv0)
+{
+  fprintf(stderr, "usage: %s [-e err_m] [-b beacon_s] [-l lead_s] [-t ttff_s] [-n noise_m] "
+          "[-q q_h] [-a] < track.csv\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+  navkf_config_t kf_config = NAVKF_CONFIG_DEFAULT;
+  gpsduty_config_t duty_config = GPSDUTY_CONFIG_DEFAULT;
+  char line[NAV_REPLAY_LINE];
+  navkf_estimate_t est;
+  navkf_t kf;
+  gpsduty_t duty;
+  uint32_t *err = NULL;
+  unsigned long beacons = 0UL;
+  unsigned long size = 0UL;
+  unsigned long lines = 0UL;
+  unsigned long fixes = 0UL;
+  unsigned long over = 0UL;
+  unsigned long period_s = 60UL;
+  unsigned long ttff_s = 3UL;
+  unsigned long ms;
+  unsigned long first_ms = 0UL;
+  unsigned long on_ms = 0UL;
+  unsigned long next_beacon = 0UL;
+  double noise_m = 3.0;
+  double err_sum = 0.0;
+  double alt_sum = 0.0;
+  double alt_max = 0.0;
+  double alt_m;
+  long lat;
+  long lon;
+  int always_on = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "e:b:l:t:n:q:a")) != -1) {
+    switch (opt) {
+    case 'e':
+      duty_config.herr_max_cm = (uint32_t)(strtoul(optarg, NULL, 10) * 100UL);
+      break;
+    case 'b':
+      period_s = strtoul(optarg, NULL, 10);
+      break;
+    case 'l':
+      duty_config.lead_ms = (uint32_t)(strtoul(optarg, NULL, 10) * 1000UL);
+      break;
+    case 't':
+      ttff_s = strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      noise_m = strtod(optarg, NULL);
+      break;
+    case 'q':
+      kf_config.q_h = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'a':
+      always_on = 1;
+      break;
+    default:
+      nav_replay_usage(argv[0]);
+    }
+  }
+  if (period_s == 0UL) {
+    nav_replay_usage(argv[0]);
+  }
+
+  navkf_init(&kf, &kf_config);
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    if (line[0] == '#' || sscanf(line, "%lu,%ld,%ld,%lf", &ms, &lat, &lon, &alt_m) != 4) {
+      continue;
+    }
+    if (lines++ == 0UL) {
+      first_ms = ms;
+      on_ms = ms;
+      next_beacon = ms + period_s * 1000UL;
+      gpsduty_init(&duty, &duty_config, (uint32_t)ms);
+    }
+
+    navkf_baro(&kf, (uint32_t)ms,
+               (int32_t)lround((alt_m - NAV_REPLAY_BARO_BIAS_M +
+                                NAV_REPLAY_BARO_NOISE_M * nav_replay_gauss()) * 100.0));
+    if (duty.on && ms - on_ms >= ttff_s * 1000UL) {
+      double n = noise_m * nav_replay_gauss() / NAV_REPLAY_M_PER_E7;
+      double e = noise_m * nav_replay_gauss() / NAV_REPLAY_M_PER_E7 /
+                 cos((double)lat * M_PI / 180e7);
+
+      navkf_fix(&kf, (uint32_t)ms, (int32_t)lround((double)lat + n), (int32_t)lround((double)lon + e),
+                (int32_t)lround((alt_m + 2.0 * noise_m * nav_replay_gauss()) * 100.0),
+                (uint32_t)lround(noise_m * 100.0));
+      gpsduty_fix(&duty);
+      fixes++;
+    }
+    navkf_predict(&kf, (uint32_t)ms);
+
+    if (ms >= next_beacon) {
+      next_beacon += period_s * 1000UL;
+      if (navkf_estimate(&kf, &est)) {
+        if (beacons == size) {
+          size = (size == 0UL) ? 1024UL : 2UL * size;
+          err = realloc(err, size * sizeof(*err));
+          if (err == NULL) {
+            return 2;
+          }
+        }
+        err[beacons] = qgeo_distance_m((int32_t)lat, (int32_t)lon, est.lat_e7, est.lon_e7);
+        err_sum += err[beacons];
+        over += (err[beacons] * 100UL > duty_config.herr_max_cm);
+        alt_sum += fabs(est.alt_cm / 100.0 - alt_m);
+        alt_max = fmax(alt_max, fabs(est.alt_cm / 100.0 - alt_m));
+        beacons++;
+      }
+    }
+
+    if (!always_on &&
+        gpsduty_step(&duty, &kf, (uint32_t)ms, (uint32_t)next_beacon, (uint32_t)(period_s * 1000UL)) &&
+        duty.on) {
+      on_ms = ms;
+    }
+  }
+
+  if (lines == 0UL || beacons == 0UL) {
+    fprintf(stderr, "no beacons in the track\n");
+    return 2;
+  }
+  if (always_on) {
+    duty.on_ms = (uint32_t)(ms - first_ms);
+  }
+  qsort(err, beacons, sizeof(*err), nav_replay_cmp);
+  printf("%lu s of track, %lu fixes, GPS on %lu s (%.1f%%), %lu off periods\n",
+         (ms - first_ms) / 1000UL, fixes, (unsigned long)(duty.on_ms / 1000U),
+         100.0 * duty.on_ms / (double)(ms - first_ms), (unsigned long)duty.cycles);
+  printf("%lu beacons: error mean %.1f m, p95 %lu m, max %lu m, %lu over %lu m\n",
+         beacons, err_sum / beacons, (unsigned long)err[beacons * 95UL / 100UL],
+         (unsigned long)err[beacons - 1UL], over, (unsigned long)(duty_config.herr_max_cm / 100U));
+  printf("altitude error mean %.1f m, max %.1f m\n", alt_sum / beacons, alt_max);
+  return (err[beacons * 95UL / 100UL] * 100UL <= duty_config.herr_max_cm) ? 0 : 1;
+}
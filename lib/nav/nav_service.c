@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * @file    nav_service.c
+  * @brief   Position between fixes, applied to the GPS receiver's power.
+  ******************************************************************************
+  */
+#include "nav_service.h"
+#include "main.h"
+#include "config.h"
+#include "console.h"
+#include "dlog.h"
+#include "watchdog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAV_MS_PER_TICK         (1000U / TX_TIMER_TICKS_PER_SECOND)
+
+static const navkf_config_t nav_kf_config = NAVKF_CONFIG_DEFAULT;
+static const gpsduty_config_t nav_duty_config = GPSDUTY_CONFIG_DEFAULT;
+
+static TX_THREAD nav_thread;
+static TX_MUTEX nav_mutex;              /* Guards nav_kf and nav_duty */
+static watchdog_handle_t nav_wdg;
+static navkf_t nav_kf;
+static gpsduty_t nav_duty;
+
+static void nav_thread_entry(ULONG thread_input);
+
+__weak void nav_gps_power(int on)
+{
+  (void)on;
+}
+
+static uint32_t nav_now_ms(void)
+{
+  return (uint32_t)tx_time_get() * NAV_MS_PER_TICK;
+}
+
+UINT nav_service_init(TX_BYTE_POOL *byte_pool)
+{
+  CHAR *pointer;
+  UINT ret;
+
+  navkf_init(&nav_kf, &nav_kf_config);
+  gpsduty_init(&nav_duty, &nav_duty_config, nav_now_ms());
+  ret = tx_mutex_create(&nav_mutex, "Nav", TX_INHERIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_byte_allocate(byte_pool, (VOID **)&pointer, NAV_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_thread_create(&nav_thread, "Nav", nav_thread_entry, 0,
+                         pointer, NAV_THREAD_STACK_SIZE,
+                         NAV_THREAD_PRIORITY, NAV_THREAD_PRIORITY,
+                         TX_NO_TIME_SLICE, TX_AUTO_START);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  nav_wdg = watchdog_register(&nav_thread, 2U * NAV_PERIOD);
+  return (nav_wdg != NULL) ? TX_SUCCESS : TX_NO_INSTANCE;
+}
+
+void nav_service_fix(int32_t lat_e7, int32_t lon_e7, int32_t alt_cm, uint32_t acc_cm)
+{
+  (void)tx_mutex_get(&nav_mutex, TX_WAIT_FOREVER);
+  navkf_fix(&nav_kf, nav_now_ms(), lat_e7, lon_e7, alt_cm, acc_cm);
+  gpsduty_fix(&nav_duty);
+  tx_mutex_put(&nav_mutex);
+}
+
+void nav_service_baro(int32_t baro_cm)
+{
+  (void)tx_mutex_get(&nav_mutex, TX_WAIT_FOREVER);
+  navkf_baro(&nav_kf, nav_now_ms(), baro_cm);
+  tx_mutex_put(&nav_mutex);
+}
+
+int nav_service_estimate(navkf_estimate_t *est)
+{
+  int ret;
+
+  (void)tx_mutex_get(&nav_mutex, TX_WAIT_FOREVER);
+  navkf_predict(&nav_kf, nav_now_ms());
+  ret = navkf_estimate(&nav_kf, est);
+  tx_mutex_put(&nav_mutex);
+  return ret;
+}
+
+int nav_service_gps_on(void)
+{
+  return nav_duty.on;
+}
+
+static void nav_thread_entry(ULONG thread_input)
+{
+  uint32_t period_ms;
+  uint32_t now_ms;
+  uint32_t herr;
+  int changed;
+  int on;
+  (void)thread_input;
+
+  nav_gps_power(1);
+  for (;;) {
+    watchdog_checkin(nav_wdg);
+
+    /* Beacons every beacon_interval from boot, until a scheduler says otherwise */
+    period_ms = (uint32_t)config_get()->beacon_interval * 1000U;
+    (void)tx_mutex_get(&nav_mutex, TX_WAIT_FOREVER);
+    now_ms = nav_now_ms();
+    navkf_predict(&nav_kf, now_ms);
+    changed = gpsduty_step(&nav_duty, &nav_kf, now_ms,
+                           (now_ms / period_ms + 1U) * period_ms, period_ms);
+    on = nav_duty.on;
+    herr = navkf_herr_cm(&nav_kf, 0U);
+    tx_mutex_put(&nav_mutex);
+
+    if (changed) {
+      nav_gps_power(on);
+      DLOG_INFO("nav: GPS %u, error %u cm, off periods %u", (uint32_t)on, herr, nav_duty.cycles);
+    }
+    tx_thread_sleep(NAV_PERIOD);
+  }
+}
+
+static void nav_show(void)
+{
+  navkf_estimate_t est;
+  uint32_t now_ms = nav_now_ms();
+  uint32_t total;
+
+  if (nav_service_estimate(&est)) {
+    printf("  %ld %ld, %ld m, +/- %lu m, +/- %lu m up\n", (long)est.lat_e7, (long)est.lon_e7,
+           (long)(est.alt_cm / 100), (unsigned long)(est.herr_cm / 100U),
+           (unsigned long)(est.verr_cm / 100U));
+    printf("  velocity %ld %ld %ld cm/s north east up, %lu fixes, %lu baro\n",
+           (long)est.vn_cm_s, (long)est.ve_cm_s, (long)est.vu_cm_s,
+           (unsigned long)nav_kf.fixes, (unsigned long)nav_kf.baros);
+  } else {
+    printf("  no fix yet, %lu baro\n", (unsigned long)nav_kf.baros);
+  }
+  if (nav_kf.bias_valid) {
+    printf("  baro offset %ld m\n", (long)(nav_kf.bias_cm / 100));
+  }
+  if (nav_duty.on) {
+    printf("  GPS on, %lu fixes of %lu", (unsigned long)nav_duty.fixes,
+           (unsigned long)nav_duty_config.min_fixes);
+  } else {
+    printf("  GPS off for %lu s", (unsigned long)((nav_duty.off_until_ms - now_ms) / 1000U));
+  }
+  total = nav_duty.on_ms + nav_duty.off_ms;
+  printf(", on %lu%% of %lu s, %lu off periods\n",
+         (unsigned long)((total != 0U) ? (uint32_t)((uint64_t)nav_duty.on_ms * 100U / total) : 100U),
+         (unsigned long)(total / 1000U), (unsigned long)nav_duty.cycles);
+}
+
+/**
+  * @brief  'nav' console command: the estimate and the receiver's duty
+  *         cycle, and a stand-in for the GPS driver's fixes.
+  */
+static int console_cmd_nav(int argc, char *argv[])
+{
+  if (argc == 1) {
+    nav_show();
+    return 0;
+  }
+  if (strcmp(argv[1], "fix") == 0 && argc >= 5) {
+    nav_service_fix((int32_t)strtol(argv[2], NULL, 10), (int32_t)strtol(argv[3], NULL, 10),
+                    (int32_t)strtol(argv[4], NULL, 10) * 100,
+                    (argc > 5) ? (uint32_t)strtoul(argv[5], NULL, 10) * 100U : 500U);
+    nav_show();
+    return 0;
+  }
+  if (strcmp(argv[1], "reset") == 0) {
+    (void)tx_mutex_get(&nav_mutex, TX_WAIT_FOREVER);
+    navkf_init(&nav_kf, &nav_kf_config);
+    gpsduty_init(&nav_duty, &nav_duty_config, nav_now_ms());
+    tx_mutex_put(&nav_mutex);
+    nav_gps_power(1);
+    printf("  reset, GPS on\n");
+    return 0;
+  }
+  printf("  usage: nav [fix <lat_e7> <lon_e7> <alt_m> [acc_m] | reset]\n");
+  return -1;
+}
+
+static const char *console_complete_nav(int argi, uint32_t index)
+{
+  static const char *const subcommands[] = { "fix", "reset" };
+
+  if (argi != 1 || index >= sizeof(subcommands) / sizeof(subcommands[0])) {
+    return NULL;
+  }
+  return subcommands[index];
+}
+
+CONSOLE_COMMAND(nav, "nav [fix|reset]: position estimate and GPS duty cycle",
+                console_cmd_nav, console_complete_nav);
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    nav_service.h
+  * @brief   Position between fixes, applied: a thread that keeps the
+  *          Kalman filter predicted to now and switches the GPS receiver
+  *          with the duty-cycle policy, once a second.
+  *
+  *          The GPS driver hands it fixes and whoever samples the BME280
+  *          hands it pressure altitudes; the beacon code asks it for the
+  *          position. The receiver is switched through a weak hook the GPS
+  *          driver overrides, on top of sunrise_gps_power(): the receiver
+  *          runs only while both want it. Beacons are taken to fall every
+  *          config beacon_interval seconds from boot, which is when the
+  *          policy needs fixes to be fresh.
+  *
+  *          There is no GPS driver yet: 'nav fix' stands in for it, and the
+  *          'baro' command feeds its reading in.
+  ******************************************************************************
+  */
+#ifndef NAV_SERVICE_H
+#define NAV_SERVICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+#include "gpsduty.h"
+#include "navkf.h"
+
+#define NAV_THREAD_STACK_SIZE   512U
+#define NAV_THREAD_PRIORITY     16U     /* Below the ADC and sunrise services */
+#define NAV_PERIOD              TX_TIMER_TICKS_PER_SECOND
+
+/**
+  * @brief  Create the thread, with the receiver on and nothing known.
+  * @param  byte_pool: pool for the thread stack
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT nav_service_init(TX_BYTE_POOL *byte_pool);
+
+/**
+  * @brief  A fix from the GPS driver, from any thread.
+  * @param  acc_cm: horizontal accuracy
+  */
+void nav_service_fix(int32_t lat_e7, int32_t lon_e7, int32_t alt_cm, uint32_t acc_cm);
+
+/**
+  * @brief  A pressure altitude (qmath_baro_altitude_cm), from any thread.
+  */
+void nav_service_baro(int32_t baro_cm);
+
+/**
+  * @brief  The position now, predicted from the last fix if the receiver
+  *         is off, with its error.
+  * @retval 0 before the first fix, 1 otherwise
+  */
+int nav_service_estimate(navkf_estimate_t *est);
+
+/**
+  * @brief  Whether the policy has the receiver on.
+  */
+int nav_service_gps_on(void);
+
+/**
+  * @brief  Receiver hook, called from the nav thread on each change and
+  *         by 'nav reset'. The default does nothing.
+  */
+void nav_gps_power(int on);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAV_SERVICE_H */
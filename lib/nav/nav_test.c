@@ -0,0 +1,327 @@
+/**
+  ******************************************************************************
+  * @file    nav_test.c
+  * @brief   Host build: the filter's restarts and baro pairing, and the GPS
+  *          duty policy's beacon search and limits.
+  *
+  *          navkf: the first fix starts it at rest, a fix more than
+  *          NAVKF_RESET_CM off starts it over and a nearer one does not, a
+  *          steady track gives back its velocity, and the baro offset is
+  *          only taken from a sample NAVKF_BARO_MAX_AGE_MS or less before
+  *          a fix. gpsduty: worked cases with no process noise, where the
+  *          error at a beacon t s after the first fix is
+  *          sqrt(2 (acc^2 + vel0^2 t^2)), for the first beacon over the
+  *          limit, min_off_ms, max_off_ms and the lead, also across the
+  *          wrap of the millisecond clock. Then random filters and beacon
+  *          schedules, where no beacon before the receiver comes back may
+  *          be predicted over the limit, and staying on must have been
+  *          forced by one:
+  *            nav_test [rounds] [seed]
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "gpsduty.h"
+#include "navkf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NAV_TEST_ROUNDS         20000UL
+#define NAV_TEST_LAT_E7         481234567L
+#define NAV_TEST_LON_E7         115678901L
+#define NAV_TEST_ACC_CM         500U
+#define NAV_TEST_WRAP           0xFFFFB1E0UL    /* 20 s before the clock wraps */
+
+/* No process noise: the predicted error follows the formula above exactly */
+static const navkf_config_t nav_test_still = { 0U, 0U, 100U, 150U };
+static const navkf_config_t nav_test_kf_config = NAVKF_CONFIG_DEFAULT;
+
+static uint32_t nav_test_seed;
+static int nav_test_failed;
+
+#define NAV_TEST_CHECK(cond)                                                   \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s:%d: %s\n", __FILE__, __LINE__, #cond);             \
+      nav_test_failed++;                                                       \
+    }                                                                          \
+  } while (0)
+
+static uint32_t nav_test_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  nav_test_seed ^= nav_test_seed << 13;
+  nav_test_seed ^= nav_test_seed >> 17;
+  nav_test_seed ^= nav_test_seed << 5;
+  return nav_test_seed;
+}
+
+static int nav_test_near(long got, long want, long tolerance)
+{
+  return labs(got - want) <= tolerance;
+}
+
+/**
+  * @brief  The first fix, a restart far off, and a jump short of one.
+  */
+static void nav_test_reset(uint32_t t0)
+{
+  navkf_t kf;
+  navkf_estimate_t est;
+  uint32_t i;
+
+  navkf_init(&kf, &nav_test_kf_config);
+  NAV_TEST_CHECK(navkf_estimate(&kf, &est) == 0);
+
+  navkf_fix(&kf, t0, NAV_TEST_LAT_E7, NAV_TEST_LON_E7, 2000000L, NAV_TEST_ACC_CM);
+  NAV_TEST_CHECK(navkf_estimate(&kf, &est) == 1);
+  NAV_TEST_CHECK(nav_test_near(est.lat_e7, NAV_TEST_LAT_E7, 1L));
+  NAV_TEST_CHECK(nav_test_near(est.lon_e7, NAV_TEST_LON_E7, 1L));
+  NAV_TEST_CHECK(est.alt_cm == 2000000L && est.vn_cm_s == 0 && est.ve_cm_s == 0);
+  /* sqrt(2) * 500 */
+  NAV_TEST_CHECK(est.herr_cm == 707U && est.verr_cm == 2U * NAV_TEST_ACC_CM);
+
+  /* A minute north at 10 m/s: the velocity comes out of the fixes */
+  for (i = 1U; i <= 60U; i++) {
+    navkf_fix(&kf, t0 + i * 1000U, NAV_TEST_LAT_E7 + (int32_t)(i * 899U), NAV_TEST_LON_E7,
+              2000000L, NAV_TEST_ACC_CM);
+  }
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(nav_test_near(est.vn_cm_s, 1000L, 50L) && nav_test_near(est.ve_cm_s, 0L, 50L));
+  NAV_TEST_CHECK(nav_test_near(est.lat_e7, NAV_TEST_LAT_E7 + 60L * 899L, 90L));
+  NAV_TEST_CHECK(est.herr_cm < 707U);
+
+  /* 50 km off is a bad fix to weigh, not a restart ... */
+  navkf_fix(&kf, t0 + 61000U, NAV_TEST_LAT_E7 + 61 * 899 + 4500000, NAV_TEST_LON_E7, 2000000L,
+            NAV_TEST_ACC_CM);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(est.vn_cm_s != 0 && est.herr_cm != 707U);
+  NAV_TEST_CHECK(!nav_test_near(est.lat_e7, NAV_TEST_LAT_E7 + 61L * 899L + 4500000L, 1000L));
+
+  /* ... 200 km off starts over there, at rest */
+  navkf_fix(&kf, t0 + 62000U, NAV_TEST_LAT_E7 + 18000000, NAV_TEST_LON_E7 + 1000000, 1500000L,
+            NAV_TEST_ACC_CM);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(nav_test_near(est.lat_e7, NAV_TEST_LAT_E7 + 18000000L, 1L));
+  NAV_TEST_CHECK(nav_test_near(est.lon_e7, NAV_TEST_LON_E7 + 1000000L, 1L));
+  NAV_TEST_CHECK(est.alt_cm == 1500000L && est.vn_cm_s == 0 && est.ve_cm_s == 0);
+  NAV_TEST_CHECK(est.herr_cm == 707U);
+
+  /* And in the other directions: 200 km south, east, then west */
+  navkf_fix(&kf, t0 + 63000U, NAV_TEST_LAT_E7, NAV_TEST_LON_E7 + 1000000, 1500000L,
+            NAV_TEST_ACC_CM);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(nav_test_near(est.lat_e7, NAV_TEST_LAT_E7, 1L) && est.herr_cm == 707U);
+  navkf_fix(&kf, t0 + 64000U, NAV_TEST_LAT_E7, NAV_TEST_LON_E7 + 28000000, 1500000L,
+            NAV_TEST_ACC_CM);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(nav_test_near(est.lon_e7, NAV_TEST_LON_E7 + 28000000L, 1L) && est.herr_cm == 707U);
+  navkf_fix(&kf, t0 + 65000U, NAV_TEST_LAT_E7, NAV_TEST_LON_E7 + 1000000, 1500000L,
+            NAV_TEST_ACC_CM);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(nav_test_near(est.lon_e7, NAV_TEST_LON_E7 + 1000000L, 1L) && est.herr_cm == 707U);
+  NAV_TEST_CHECK(kf.fixes == 66U);
+}
+
+/**
+  * @brief  The baro offset: taken from a recent sample, moved 1/8 of the
+  *         way by each later pair, and only then used on its own.
+  */
+static void nav_test_baro(uint32_t t0)
+{
+  navkf_t kf;
+  navkf_estimate_t est;
+  int32_t alt;
+
+  navkf_init(&kf, &nav_test_kf_config);
+
+  /* Kept before the first fix, but nothing to update */
+  navkf_baro(&kf, t0, 1000000L);
+  NAV_TEST_CHECK(kf.baro_valid && !kf.primed && navkf_estimate(&kf, &est) == 0);
+
+  /* Too old to pair with the fix */
+  navkf_fix(&kf, t0 + NAVKF_BARO_MAX_AGE_MS + 1U, NAV_TEST_LAT_E7, NAV_TEST_LON_E7, 1015000L,
+            NAV_TEST_ACC_CM);
+  NAV_TEST_CHECK(!kf.bias_valid);
+  navkf_baro(&kf, t0 + 3000U, 980000L);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(!kf.bias_valid && est.alt_cm == 1015000L);
+
+  /* Right at the age limit, it pairs: fix - baro */
+  navkf_fix(&kf, t0 + 3000U + NAVKF_BARO_MAX_AGE_MS, NAV_TEST_LAT_E7, NAV_TEST_LON_E7, 1015000L,
+            NAV_TEST_ACC_CM);
+  NAV_TEST_CHECK(kf.bias_valid && kf.bias_cm == 35000L);
+
+  /* The next pair moves it an eighth of the way: 35000 + (43000 - 35000) / 8 */
+  navkf_baro(&kf, t0 + 6000U, 972000L);
+  navkf_fix(&kf, t0 + 6500U, NAV_TEST_LAT_E7, NAV_TEST_LON_E7, 1015000L, NAV_TEST_ACC_CM);
+  NAV_TEST_CHECK(kf.bias_cm == 36000L);
+
+  /* Now the baro alone moves the altitude, to baro + offset */
+  (void)navkf_estimate(&kf, &est);
+  alt = est.alt_cm;
+  navkf_baro(&kf, t0 + 7000U, 1000000L);
+  (void)navkf_estimate(&kf, &est);
+  NAV_TEST_CHECK(est.alt_cm > alt && est.alt_cm <= 1036000L);
+}
+
+/**
+  * @brief  One fix, then the policy at t0 + 1 s, beacons 10 s on and every
+  *         period_s. With no process noise and vel0 1 m/s the error at a
+  *         beacon t s after the fix is sqrt(2 (500^2 + 100^2 t^2)) cm.
+  * @retval Whatever gpsduty_step() returned
+  */
+static int nav_test_duty_case(gpsduty_t *duty, navkf_t *kf, const gpsduty_config_t *config,
+                              uint32_t t0, uint32_t period_s)
+{
+  navkf_init(kf, &nav_test_still);
+  gpsduty_init(duty, config, t0);
+  NAV_TEST_CHECK(gpsduty_step(duty, kf, t0, t0 + 10000U, period_s * 1000U) == 0 && duty->on);
+
+  navkf_fix(kf, t0, NAV_TEST_LAT_E7, NAV_TEST_LON_E7, 0L, NAV_TEST_ACC_CM);
+  gpsduty_fix(duty);
+  navkf_predict(kf, t0 + 1000U);
+  return gpsduty_step(duty, kf, t0 + 1000U, t0 + 11000U, period_s * 1000U);
+}
+
+static void nav_test_duty(uint32_t t0)
+{
+  gpsduty_config_t config = { 10000UL, 30000UL, 1UL, 30000UL, 1800000UL };
+  gpsduty_t duty;
+  navkf_t kf;
+
+  /* Not before min_fixes */
+  config.min_fixes = 2U;
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 20U) == 0 && duty.on);
+  config.min_fixes = 1U;
+
+  /* Beacons 11, 31 and 51 s after the fix are within 100 m (72 m at 51 s),
+   * 71 s is not (101 m): off until 30 s before it */
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 20U) == 1 && !duty.on);
+  NAV_TEST_CHECK(navkf_herr_cm(&kf, 50000U) == 7247U && navkf_herr_cm(&kf, 70000U) == 10065U);
+  NAV_TEST_CHECK(duty.off_until_ms == t0 + 1000U + 70000U - 30000U && duty.cycles == 1U);
+
+  /* Off until then, on again at it, counting fixes from 0 */
+  NAV_TEST_CHECK(gpsduty_step(&duty, &kf, t0 + 40999U, t0 + 51000U, 20000U) == 0 && !duty.on);
+  gpsduty_fix(&duty);
+  NAV_TEST_CHECK(gpsduty_step(&duty, &kf, t0 + 41000U, t0 + 51000U, 20000U) == 1 && duty.on);
+  NAV_TEST_CHECK(duty.fixes == 0U && duty.on_ms == 1000U && duty.off_ms == 40000U);
+  NAV_TEST_CHECK(gpsduty_step(&duty, &kf, t0 + 42000U, t0 + 51000U, 20000U) == 0 && duty.on);
+
+  /* The same 40 s off is under a 2 minute min_off_ms */
+  config.min_off_ms = 120000UL;
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 20U) == 0 && duty.on);
+  config.min_off_ms = 30000UL;
+
+  /* Beacons every 40 s: 11 and 51 s pass, 91 s does not */
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 40U) == 1);
+  NAV_TEST_CHECK(duty.off_until_ms == t0 + 1000U + 90000U - 30000U);
+
+  /* The first beacon already over the limit, and inside the lead */
+  config.herr_max_cm = 1000U;
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 20U) == 0 && duty.on);
+
+  /* Every beacon in reach passes: max_off_ms, and the same with no beacons */
+  config.herr_max_cm = 10000000UL;
+  config.max_off_ms = 100000UL;
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 20U) == 1);
+  NAV_TEST_CHECK(duty.off_until_ms == t0 + 1000U + 100000U);
+  config.herr_max_cm = 1000U;
+  NAV_TEST_CHECK(nav_test_duty_case(&duty, &kf, &config, t0, 0U) == 1);
+  NAV_TEST_CHECK(duty.off_until_ms == t0 + 1000U + 100000U);
+}
+
+/**
+  * @brief  Random filters and schedules, checked against what the policy
+  *         promises rather than against a second copy of it.
+  */
+static void nav_test_random(unsigned long rounds)
+{
+  navkf_config_t kf_config = NAVKF_CONFIG_DEFAULT;
+  gpsduty_config_t config;
+  gpsduty_t duty;
+  navkf_t kf;
+  uint32_t now;
+  uint32_t next;
+  uint32_t period;
+  uint32_t fixes;
+  uint32_t ahead;
+  uint32_t first_bad;
+  int changed;
+  uint32_t i;
+
+  while (rounds-- > 0UL) {
+    kf_config.q_h = nav_test_rand() % 2000U;
+    kf_config.vel0_cm_s = 1U + nav_test_rand() % 3000U;
+    config.herr_max_cm = 1000U + nav_test_rand() % 50000U;
+    config.lead_ms = nav_test_rand() % 60000U;
+    config.min_fixes = 1U + nav_test_rand() % 5U;
+    config.min_off_ms = 1000U + nav_test_rand() % 300000U;
+    config.max_off_ms = config.min_off_ms + nav_test_rand() % 3600000U;
+    period = (nav_test_rand() % 8U == 0U) ? 0U : 1000U * (1U + nav_test_rand() % 600U);
+    now = nav_test_rand();
+
+    navkf_init(&kf, &kf_config);
+    gpsduty_init(&duty, &config, now);
+    fixes = 1U + nav_test_rand() % 10U;
+    for (i = 0U; i < fixes; i++) {
+      now += 1000U;
+      navkf_fix(&kf, now, NAV_TEST_LAT_E7 + (int32_t)(nav_test_rand() % 2000U),
+                NAV_TEST_LON_E7 + (int32_t)(nav_test_rand() % 2000U), 0L,
+                50U + nav_test_rand() % 3000U);
+      gpsduty_fix(&duty);
+    }
+    now += nav_test_rand() % 1000U;
+    next = now + 1U + ((period != 0U) ? nav_test_rand() % period : 0U);
+    navkf_predict(&kf, now);
+    changed = gpsduty_step(&duty, &kf, now, next, period);
+
+    if (fixes < config.min_fixes) {
+      NAV_TEST_CHECK(changed == 0 && duty.on);
+      continue;
+    }
+    /* The first beacon within max_off_ms + lead predicted over the limit */
+    first_bad = UINT32_MAX;
+    for (ahead = next - now; period != 0U && ahead <= config.max_off_ms + config.lead_ms;
+         ahead += period) {
+      if (navkf_herr_cm(&kf, ahead) > config.herr_max_cm) {
+        first_bad = ahead;
+        break;
+      }
+    }
+    if (changed) {
+      NAV_TEST_CHECK(!duty.on);
+      NAV_TEST_CHECK(duty.off_until_ms - now >= config.min_off_ms);
+      NAV_TEST_CHECK(duty.off_until_ms - now <= config.max_off_ms);
+      /* Back on at least lead_ms before the first beacon that needs it */
+      NAV_TEST_CHECK(first_bad == UINT32_MAX ||
+                     duty.off_until_ms - now + config.lead_ms <= first_bad);
+    } else {
+      /* Only a beacon too close to leave min_off_ms keeps it on */
+      NAV_TEST_CHECK(duty.on);
+      NAV_TEST_CHECK(first_bad < config.min_off_ms + config.lead_ms);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long rounds = (argc > 1) ? strtoul(argv[1], NULL, 0) : NAV_TEST_ROUNDS;
+
+  nav_test_seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x3C6EF372UL;
+  if (nav_test_seed == 0U) {
+    fprintf(stderr, "usage: %s [rounds] [seed]\n", argv[0]);
+    return 2;
+  }
+
+  nav_test_reset(1000U);
+  nav_test_reset(NAV_TEST_WRAP);
+  nav_test_baro(1000U);
+  nav_test_baro(UINT32_MAX - 4000U);
+  nav_test_duty(1000U);
+  nav_test_duty(NAV_TEST_WRAP);
+  nav_test_random(rounds);
+
+  printf("  %-22s %s\n", "navkf and gpsduty", (nav_test_failed == 0) ? "ok" : "FAIL");
+  return (nav_test_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+/**
+  ******************************************************************************
+  * @file    navkf.c
+  * @brief   Integer Kalman filter for position and altitude between fixes.
+  ******************************************************************************
+  */
+#include "navkf.h"
+#include "qgeo.h"
+#include "qmath.h"
+
+#define NAVKF_CM_PER_E7_Q16     72873LL         /* 2 pi QGEO_EARTH_RADIUS_M / 360e7 m, Q16 */
+#define NAVKF_E7_PER_CM_Q16     58938LL         /* And back */
+#define NAVKF_COS_MIN_Q30       (QMATH_ONE_Q30 / 64)    /* 89.1 degrees: no balloon goes there */
+#define NAVKF_STEP_MS           600000UL        /* Longest prediction in one step, for the products */
+#define NAVKF_PPP_MAX           100000000000000LL
+#define NAVKF_PPV_MAX           100000000000LL  /* sqrt(NAVKF_PPP_MAX * NAVKF_PVV_MAX) */
+#define NAVKF_PVV_MAX           100000000LL
+#define NAVKF_V_MAX_Q8          (100000L * 256L)    /* 1 km/s */
+#define NAVKF_LAT_MAX_E7        900000000L
+#define NAVKF_LON_TURN_E7       3600000000LL
+
+static int64_t navkf_clamp(int64_t x, int64_t lo, int64_t hi)
+{
+  return (x < lo) ? lo : ((x > hi) ? hi : x);
+}
+
+/**
+  * @brief  (a * b) >> shift, for |a| < 2^62, |b| < 2^31 and shift <= 31,
+  *         without the 128-bit product: a is split at bit 31 so that both
+  *         partial products fit. Rounds down, as the shift would.
+  */
+static int64_t navkf_mulq(int64_t a, int64_t b, uint32_t shift)
+{
+  int64_t hi = a >> 31;
+  int64_t lo = a & 0x7FFFFFFFLL;
+
+  return hi * b * ((int64_t)1 << (31U - shift)) + ((lo * b) >> shift);
+}
+
+static int64_t navkf_r(uint32_t sigma_cm)
+{
+  int64_t s = navkf_clamp(sigma_cm, NAVKF_R_MIN_CM, NAVKF_R_MAX_CM);
+
+  return s * s;
+}
+
+/**
+  * @brief  The covariance of one axis t_ms ahead, t_ms <= NAVKF_STEP_MS:
+  *           Ppp += 2 Ppv t + Pvv t^2 + q t^3 / 3
+  *           Ppv += Pvv t + q t^2 / 2
+  *           Pvv += q t
+  *         with t in seconds, taken a factor of 1000 at a time.
+  */
+static void navkf_cov_predict(int64_t *ppp, int64_t *ppv, int64_t *pvv, uint32_t q, uint32_t t_ms)
+{
+  int64_t t = (int64_t)t_ms;
+  int64_t vt = *pvv * t / 1000;
+  int64_t qt = (int64_t)q * t / 1000;
+  int64_t qt2 = qt * t / 2000;
+  int64_t qt3 = qt2 * t / 1500;
+
+  *ppp = navkf_clamp(*ppp + 2 * *ppv * t / 1000 + vt * t / 1000 + qt3, 1, NAVKF_PPP_MAX);
+  *ppv = navkf_clamp(*ppv + vt + qt2, -NAVKF_PPV_MAX, NAVKF_PPV_MAX);
+  *pvv = navkf_clamp(*pvv + qt, 1, NAVKF_PVV_MAX);
+}
+
+/**
+  * @brief  One scalar measurement z of an axis' position, variance r:
+  *         the gain's two halves are K = (Ppp, Ppv) / S with S = Ppp + r.
+  *         Ppp' = Ppp r / S comes from whichever of K and 1 - K is the
+  *         larger, so it stays precise when one of them is tiny. With
+  *         r >= NAVKF_R_MIN_CM^2 the velocity gain is at most
+  *         sqrt(Pvv) / (2 sqrt(r)) = 100 / s, inside the 2^31 navkf_mulq()
+  *         takes in Q24; the clamp is only for a covariance the clamps in
+  *         navkf_cov_predict() have bent.
+  */
+static void navkf_update(navkf_axis_t *ax, int64_t z_q8, int64_t r)
+{
+  int64_t s = ax->ppp + r;
+  int64_t kr_q30 = (r << 30) / s;       /* r / S, 1 - Kp */
+  int64_t kp_q30 = QMATH_ONE_Q30 - kr_q30;
+  int64_t kv_q24 = navkf_clamp((ax->ppv << 24) / s, -INT32_MAX, INT32_MAX);
+  int64_t y_q8 = z_q8 - ax->p_q8;
+  int64_t v;
+
+  ax->p_q8 += navkf_mulq(y_q8, kp_q30, 30U);
+  v = ax->v_q8 + navkf_mulq(y_q8, kv_q24, 24U);
+  ax->v_q8 = (int32_t)navkf_clamp(v, -NAVKF_V_MAX_Q8, NAVKF_V_MAX_Q8);
+
+  ax->pvv = navkf_clamp(ax->pvv - navkf_mulq(ax->ppv, kv_q24, 24U), 1, NAVKF_PVV_MAX);
+  ax->ppv = navkf_mulq(ax->ppv, kr_q30, 30U);
+  ax->ppp = (ax->ppp > r) ? navkf_mulq(r, kp_q30, 30U) : navkf_mulq(ax->ppp, kr_q30, 30U);
+  ax->ppp = navkf_clamp(ax->ppp, 1, NAVKF_PPP_MAX);
+}
+
+static int32_t navkf_cm(int64_t p_q8)
+{
+  return (int32_t)((p_q8 + 128) >> 8);
+}
+
+/* Longitude difference, wrapped to -180..180 degrees */
+static int64_t navkf_dlon_e7(int32_t lon_e7, int32_t ref_e7)
+{
+  int64_t d = (int64_t)lon_e7 - ref_e7;
+
+  if (d > NAVKF_LON_TURN_E7 / 2) {
+    d -= NAVKF_LON_TURN_E7;
+  } else if (d < -NAVKF_LON_TURN_E7 / 2) {
+    d += NAVKF_LON_TURN_E7;
+  }
+  return d;
+}
+
+static void navkf_to_local(const navkf_t *kf, int32_t lat_e7, int32_t lon_e7, int64_t *n_cm, int64_t *e_cm)
+{
+  *n_cm = ((int64_t)(lat_e7 - kf->ref_lat_e7) * NAVKF_CM_PER_E7_Q16 + 32768) >> 16;
+  *e_cm = ((((navkf_dlon_e7(lon_e7, kf->ref_lon_e7) * NAVKF_CM_PER_E7_Q16 + 32768) >> 16) *
+            kf->ref_cos_q30) + (1LL << 29)) >> 30;
+}
+
+static void navkf_to_global(const navkf_t *kf, int32_t *lat_e7, int32_t *lon_e7)
+{
+  int64_t n = navkf_cm(kf->axis[NAVKF_NORTH].p_q8);
+  int64_t e = navkf_cm(kf->axis[NAVKF_EAST].p_q8);
+  int64_t lat = kf->ref_lat_e7 + ((n * NAVKF_E7_PER_CM_Q16 + 32768) >> 16);
+  int64_t lon = kf->ref_lon_e7 + ((((e * NAVKF_E7_PER_CM_Q16 + 32768) >> 16) << 30) / kf->ref_cos_q30);
+
+  *lat_e7 = (int32_t)navkf_clamp(lat, -NAVKF_LAT_MAX_E7, NAVKF_LAT_MAX_E7);
+  *lon_e7 = (int32_t)navkf_dlon_e7((int32_t)navkf_clamp(lon, INT32_MIN, INT32_MAX), 0);
+}
+
+static void navkf_set_ref(navkf_t *kf, int32_t lat_e7, int32_t lon_e7)
+{
+  int32_t c = qmath_cos(qgeo_e7_to_bam(lat_e7));
+
+  kf->ref_lat_e7 = lat_e7;
+  kf->ref_lon_e7 = lon_e7;
+  kf->ref_cos_q30 = (c < NAVKF_COS_MIN_Q30) ? NAVKF_COS_MIN_Q30 : c;
+}
+
+/* Start over at a fix: at rest, as uncertain as the configuration says */
+static void navkf_start(navkf_t *kf, uint32_t now_ms, int32_t lat_e7, int32_t lon_e7,
+                        int32_t alt_cm, uint32_t acc_cm)
+{
+  int64_t pvv = navkf_clamp((int64_t)kf->config->vel0_cm_s * kf->config->vel0_cm_s, 1, NAVKF_PVV_MAX);
+  uint32_t i;
+
+  navkf_set_ref(kf, lat_e7, lon_e7);
+  for (i = 0U; i < NAVKF_AXES; i++) {
+    kf->axis[i].p_q8 = 0;
+    kf->axis[i].v_q8 = 0;
+    kf->axis[i].ppp = navkf_r((i == NAVKF_UP) ? 2U * acc_cm : acc_cm);
+    kf->axis[i].ppv = 0;
+    kf->axis[i].pvv = pvv;
+  }
+  kf->axis[NAVKF_UP].p_q8 = (int64_t)alt_cm * 256;
+  kf->time_ms = now_ms;
+  kf->primed = 1U;
+}
+
+/* Keep north and east small: re-centre the local frame on the estimate */
+static void navkf_reanchor(navkf_t *kf)
+{
+  int32_t lat_e7;
+  int32_t lon_e7;
+
+  if (navkf_cm(kf->axis[NAVKF_NORTH].p_q8) > NAVKF_REANCHOR_CM ||
+      navkf_cm(kf->axis[NAVKF_NORTH].p_q8) < -NAVKF_REANCHOR_CM ||
+      navkf_cm(kf->axis[NAVKF_EAST].p_q8) > NAVKF_REANCHOR_CM ||
+      navkf_cm(kf->axis[NAVKF_EAST].p_q8) < -NAVKF_REANCHOR_CM) {
+    navkf_to_global(kf, &lat_e7, &lon_e7);
+    navkf_set_ref(kf, lat_e7, lon_e7);
+    kf->axis[NAVKF_NORTH].p_q8 = 0;
+    kf->axis[NAVKF_EAST].p_q8 = 0;
+  }
+}
+
+void navkf_init(navkf_t *kf, const navkf_config_t *config)
+{
+  *kf = (navkf_t){ 0 };
+  kf->config = config;
+  kf->ref_cos_q30 = QMATH_ONE_Q30;
+}
+
+void navkf_predict(navkf_t *kf, uint32_t now_ms)
+{
+  uint32_t dt = now_ms - kf->time_ms;
+  uint32_t t;
+  uint32_t i;
+
+  if ((int32_t)dt <= 0) {
+    return;
+  }
+  kf->time_ms = now_ms;
+  while (kf->primed && dt > 0U) {
+    t = (dt > NAVKF_STEP_MS) ? NAVKF_STEP_MS : dt;
+    dt -= t;
+    for (i = 0U; i < NAVKF_AXES; i++) {
+      navkf_axis_t *ax = &kf->axis[i];
+
+      ax->p_q8 += (int64_t)ax->v_q8 * t / 1000;
+      navkf_cov_predict(&ax->ppp, &ax->ppv, &ax->pvv,
+                        (i == NAVKF_UP) ? kf->config->q_v : kf->config->q_h, t);
+    }
+  }
+  if (kf->primed) {
+    navkf_reanchor(kf);
+  }
+}
+
+void navkf_fix(navkf_t *kf, uint32_t now_ms, int32_t lat_e7, int32_t lon_e7,
+               int32_t alt_cm, uint32_t acc_cm)
+{
+  int64_t n;
+  int64_t e;
+  int32_t d;
+
+  navkf_predict(kf, now_ms);
+  navkf_to_local(kf, lat_e7, lon_e7, &n, &e);
+  if (!kf->primed ||
+      n - navkf_cm(kf->axis[NAVKF_NORTH].p_q8) > NAVKF_RESET_CM ||
+      navkf_cm(kf->axis[NAVKF_NORTH].p_q8) - n > NAVKF_RESET_CM ||
+      e - navkf_cm(kf->axis[NAVKF_EAST].p_q8) > NAVKF_RESET_CM ||
+      navkf_cm(kf->axis[NAVKF_EAST].p_q8) - e > NAVKF_RESET_CM) {
+    navkf_start(kf, now_ms, lat_e7, lon_e7, alt_cm, acc_cm);
+  } else {
+    navkf_update(&kf->axis[NAVKF_NORTH], n * 256, navkf_r(acc_cm));
+    navkf_update(&kf->axis[NAVKF_EAST], e * 256, navkf_r(acc_cm));
+    navkf_update(&kf->axis[NAVKF_UP], (int64_t)alt_cm * 256, navkf_r(2U * acc_cm));
+    navkf_reanchor(kf);
+  }
+
+  /* The baro's offset from the GPS altitude, from a sample taken with the fix */
+  if (kf->baro_valid && now_ms - kf->baro_ms <= NAVKF_BARO_MAX_AGE_MS) {
+    d = alt_cm - kf->baro_cm;
+    kf->bias_cm = kf->bias_valid ? kf->bias_cm + ((d - kf->bias_cm) >> NAVKF_BIAS_SHIFT) : d;
+    kf->bias_valid = 1U;
+  }
+  kf->fixes++;
+}
+
+void navkf_baro(navkf_t *kf, uint32_t now_ms, int32_t baro_cm)
+{
+  kf->baro_cm = baro_cm;
+  kf->baro_ms = now_ms;
+  kf->baro_valid = 1U;
+  kf->baros++;
+  if (kf->primed && kf->bias_valid) {
+    navkf_predict(kf, now_ms);
+    navkf_update(&kf->axis[NAVKF_UP], ((int64_t)baro_cm + kf->bias_cm) * 256,
+                 navkf_r(kf->config->baro_cm));
+  }
+}
+
+int navkf_estimate(const navkf_t *kf, navkf_estimate_t *est)
+{
+  const navkf_axis_t *ax = kf->axis;
+
+  *est = (navkf_estimate_t){ 0 };
+  if (!kf->primed) {
+    return 0;
+  }
+  navkf_to_global(kf, &est->lat_e7, &est->lon_e7);
+  est->alt_cm = navkf_cm(ax[NAVKF_UP].p_q8);
+  est->vn_cm_s = navkf_cm(ax[NAVKF_NORTH].v_q8);
+  est->ve_cm_s = navkf_cm(ax[NAVKF_EAST].v_q8);
+  est->vu_cm_s = navkf_cm(ax[NAVKF_UP].v_q8);
+  est->herr_cm = qmath_sqrt64((uint64_t)(ax[NAVKF_NORTH].ppp + ax[NAVKF_EAST].ppp));
+  est->verr_cm = qmath_sqrt64((uint64_t)ax[NAVKF_UP].ppp);
+  return 1;
+}
+
+uint32_t navkf_herr_cm(const navkf_t *kf, uint32_t ahead_ms)
+{
+  int64_t p[2][3];
+  uint32_t t;
+  uint32_t i;
+
+  for (i = 0U; i < 2U; i++) {
+    p[i][0] = kf->axis[i].ppp;
+    p[i][1] = kf->axis[i].ppv;
+    p[i][2] = kf->axis[i].pvv;
+  }
+  /* The same steps navkf_predict() would take, on a copy */
+  while (ahead_ms > 0U) {
+    t = (ahead_ms > NAVKF_STEP_MS) ? NAVKF_STEP_MS : ahead_ms;
+    ahead_ms -= t;
+    for (i = 0U; i < 2U; i++) {
+      navkf_cov_predict(&p[i][0], &p[i][1], &p[i][2], kf->config->q_h, t);
+    }
+  }
+  return qmath_sqrt64((uint64_t)(p[NAVKF_NORTH][0] + p[NAVKF_EAST][0]));
+}
@@ -0,0 +1,141 @@
+/**
+  ******************************************************************************
+  * @file    navkf.h
+  * @brief   Integer Kalman filter for position and altitude between GPS
+  *          fixes: a constant-velocity model per axis, fed by fixes and by
+  *          barometric altitude.
+  *
+  *          Three axes, each with its own position, velocity and 2x2
+  *          covariance: north and east in centimetres from a reference
+  *          point, which moves to the current position once the balloon is
+  *          NAVKF_REANCHOR_CM from it, and up as altitude in centimetres.
+  *          Velocity is cm/s in Q8, covariances are int64 in cm^2, cm^2/s
+  *          and cm^2/s^2. The process noise is white acceleration of
+  *          spectral density q, cm^2/s^3: between fixes the position
+  *          variance grows as Ppp + 2 Ppv t + Pvv t^2 + q t^3 / 3, which is
+  *          how far ahead the estimate can be trusted.
+  *
+  *          The baro does not know the altitude a fix does, only how it
+  *          changes: each fix refines the offset between the two, and once
+  *          there is one, baro samples update the up axis on their own.
+  *          Horizontal errors are reported as the 1-sigma radius,
+  *          sqrt(Ppp_north + Ppp_east).
+  *
+  *          Pure C, no HAL or kernel, for nav_service.c on target and
+  *          nav_replay on the host. Products are 64-bit; a fix costs six
+  *          64-bit divisions, a prediction none.
+  ******************************************************************************
+  */
+#ifndef NAVKF_H
+#define NAVKF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define NAVKF_NORTH             0U
+#define NAVKF_EAST              1U
+#define NAVKF_UP                2U
+#define NAVKF_AXES              3U
+
+#define NAVKF_REANCHOR_CM       50000000L   /* Move the reference point past 500 km */
+#define NAVKF_RESET_CM          10000000L   /* A fix this far off restarts the filter */
+#define NAVKF_R_MIN_CM          50U         /* Measurement noise, 1 sigma, at least ... */
+#define NAVKF_R_MAX_CM          65535U      /* ... and at most */
+#define NAVKF_BARO_MAX_AGE_MS   2000UL      /* A baro sample this recent pairs with a fix */
+#define NAVKF_BIAS_SHIFT        3U          /* Each fix moves the baro offset 1/8 of the way */
+
+typedef struct {
+  uint32_t q_h;                         /*!< Horizontal acceleration noise, cm^2/s^3, at most 1e6 */
+  uint32_t q_v;                         /*!< Vertical, the same */
+  uint32_t vel0_cm_s;                   /*!< Velocity uncertainty at the first fix, at most 1e4 */
+  uint32_t baro_cm;                     /*!< Baro altitude noise, 1 sigma */
+} navkf_config_t;
+
+/* For a balloon at float: winds that change over minutes, a steady climb */
+#define NAVKF_CONFIG_DEFAULT                                                   \
+  {                                                                            \
+    50U, 400U, 2000U, 150U,                                                    \
+  }
+
+typedef struct {
+  int64_t p_q8;                         /*!< cm * 256 */
+  int32_t v_q8;                         /*!< cm/s * 256 */
+  int64_t ppp;                          /*!< cm^2 */
+  int64_t ppv;                          /*!< cm^2/s */
+  int64_t pvv;                          /*!< cm^2/s^2 */
+} navkf_axis_t;
+
+typedef struct {
+  const navkf_config_t *config;
+  navkf_axis_t axis[NAVKF_AXES];
+  int32_t ref_lat_e7;                   /*!< Where north and east are 0 */
+  int32_t ref_lon_e7;
+  int32_t ref_cos_q30;                  /*!< cos(ref_lat_e7), Q30 */
+  uint32_t time_ms;                     /*!< Of the state, wrapping */
+  uint32_t baro_ms;                     /*!< Of baro_cm */
+  int32_t baro_cm;                      /*!< Last baro altitude */
+  int32_t bias_cm;                      /*!< Fix altitude - baro altitude */
+  uint32_t fixes;
+  uint32_t baros;
+  uint8_t primed;                       /*!< There has been a fix */
+  uint8_t baro_valid;                   /*!< baro_cm has been set */
+  uint8_t bias_valid;                   /*!< bias_cm has been set */
+} navkf_t;
+
+typedef struct {
+  int32_t lat_e7;                       /*!< Degrees * 1e7 */
+  int32_t lon_e7;
+  int32_t alt_cm;
+  int32_t vn_cm_s;                      /*!< Velocity north, east and up */
+  int32_t ve_cm_s;
+  int32_t vu_cm_s;
+  uint32_t herr_cm;                     /*!< 1 sigma, horizontal radius */
+  uint32_t verr_cm;
+} navkf_estimate_t;
+
+/**
+  * @brief  Start empty: nothing is known until the first fix.
+  * @param  config: kept by reference
+  */
+void navkf_init(navkf_t *kf, const navkf_config_t *config);
+
+/**
+  * @brief  Move the state forward to now_ms. Earlier times are ignored.
+  */
+void navkf_predict(navkf_t *kf, uint32_t now_ms);
+
+/**
+  * @brief  Update with a GPS fix, predicting to now_ms first. The first
+  *         fix, and one more than NAVKF_RESET_CM off, starts over at it.
+  * @param  acc_cm: horizontal accuracy; the vertical is taken as twice it
+  */
+void navkf_fix(navkf_t *kf, uint32_t now_ms, int32_t lat_e7, int32_t lon_e7,
+               int32_t alt_cm, uint32_t acc_cm);
+
+/**
+  * @brief  Update the up axis with a barometric altitude, once a fix has
+  *         tied the baro to the GPS altitude; until then it is only kept.
+  * @param  baro_cm: pressure altitude, any fixed reference
+  */
+void navkf_baro(navkf_t *kf, uint32_t now_ms, int32_t baro_cm);
+
+/**
+  * @brief  The state as a position, at the time it was last moved to.
+  * @retval 0 before the first fix, 1 otherwise
+  */
+int navkf_estimate(const navkf_t *kf, navkf_estimate_t *est);
+
+/**
+  * @brief  Horizontal error, 1 sigma, ahead_ms after the state's time if
+  *         no fix comes in between. Saturates at about 140 km.
+  */
+uint32_t navkf_herr_cm(const navkf_t *kf, uint32_t ahead_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NAVKF_H */
@@ -0,0 +1,381 @@
+/**
+  ******************************************************************************
+  * @file    power.c
+  * @brief   Tickless idle: STOP2 between kernel timeouts, RTC wakeup.
+  *
+  *          Time inside the hooks is kept in units of 1 / (ticks per second
+  *          * f), where f is the RTC sub-second rate: a kernel tick is f
+  *          units, an RTC count TX_TIMER_TICKS_PER_SECOND units, and a
+  *          wakeup timer count (RTCCLK / 16 = 2f) half that. Everything
+  *          stays in 32 bits for sleeps up to POWER_MAX_STOP_TICKS.
+  ******************************************************************************
+  */
+#include "power.h"
+#include "power_tick.h"
+#include "clock.h"
+#include "console.h"
+#include "watchdog.h"
+
+#include <stdio.h>
+
+#define POWER_RTC_POLLS         1000U   /* WUTWF takes 2 RTCCLK cycles */
+#define POWER_LSE_TICKS         (LSE_STARTUP_TIMEOUT * TX_TIMER_TICKS_PER_SECOND / 1000U)
+#define POWER_RX_EXTI           (1UL << POWER_RX_EXTI_LINE)
+
+static RTC_HandleTypeDef power_hrtc;
+static UART_HandleTypeDef *power_huart;
+static uint32_t power_rtc_hz;
+static uint32_t power_f;                    /* Sub-second counts per second */
+static volatile uint32_t power_inhibits;
+static volatile ULONG power_activity_tick;
+static uint8_t power_ready;
+static power_stats_t power_stats;
+
+/* Handed from the enter hook to the exit hook */
+static uint8_t power_stopping;
+static ULONG power_idle;                    /* Ticks that may be skipped */
+static uint32_t power_frac;                 /* Units of the tick in progress */
+static uint32_t power_ssr;                  /* Sub-second counter at entry */
+
+void HAL_RTC_MspInit(RTC_HandleTypeDef *hrtc)
+{
+  (void)hrtc;
+  __HAL_RCC_RTC_ENABLE();
+  __HAL_RCC_RTCAPB_CLK_ENABLE();
+  HAL_NVIC_SetPriority(RTC_TAMP_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(RTC_TAMP_IRQn);
+}
+
+/**
+  * @brief  Both wake sources are dealt with in tx_low_power_exit(); the
+  *         handlers only run if their flag was raised outside STOP2.
+  */
+void RTC_TAMP_IRQHandler(void)
+{
+  WRITE_REG(RTC->SCR, RTC_SCR_CWUTF);
+}
+
+void EXTI2_3_IRQHandler(void)
+{
+  EXTI->FPR1 = POWER_RX_EXTI;
+}
+
+/**
+  * @brief  On a thread, start LSE and sleep until it is ready, for as long
+  *         as HAL would spin on it, checking in with the watchdog. Before
+  *         the kernel starts HAL does the waiting.
+  * @retval 0 if LSE runs or HAL is to find out, -1 if it did not start
+  */
+static int power_lse_wait(void)
+{
+  ULONG start = tx_time_get();
+
+  if (tx_thread_identify() == TX_NULL) {
+    return 0;
+  }
+  SET_BIT(RCC->BDCR, RCC_BDCR_LSEON);
+  while (READ_BIT(RCC->BDCR, RCC_BDCR_LSERDY) == 0U) {
+    if (tx_time_get() - start >= POWER_LSE_TICKS) {
+      return -1;
+    }
+    watchdog_checkin_self();
+    tx_thread_sleep(1U);
+  }
+  return 0;
+}
+
+/**
+  * @brief  Select LSE for the RTC, falling back to LSI if it will not start.
+  * @retval RTCCLK in Hz
+  */
+static uint32_t power_rtc_clock(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+  RCC_OscInitTypeDef osc = {0};
+  RCC_PeriphCLKInitTypeDef clk = {0};
+  uint32_t hz = LSE_VALUE;
+
+  /* PWR_CR1 is shared with clock_request()'s low-power run bit */
+  TX_DISABLE
+  HAL_PWR_EnableBkUpAccess();
+  TX_RESTORE
+  osc.OscillatorType = RCC_OSCILLATORTYPE_LSE;
+  osc.LSEState = RCC_LSE_ON;
+  osc.PLL.PLLState = RCC_PLL_NONE;
+  clk.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
+  if (power_lse_wait() != 0 || HAL_RCC_OscConfig(&osc) != HAL_OK) {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_LSE | RCC_OSCILLATORTYPE_LSI;
+    osc.LSEState = RCC_LSE_OFF;
+    osc.LSIState = RCC_LSI_ON;
+    osc.LSIDiv = RCC_LSI_DIV1;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+      Error_Handler();
+    }
+    clk.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
+    hz = LSI_VALUE;
+  }
+
+  clk.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+  if (HAL_RCCEx_PeriphCLKConfig(&clk) != HAL_OK) {
+    Error_Handler();
+  }
+  return hz;
+}
+
+void power_init(UART_HandleTypeDef *huart)
+{
+  power_huart = huart;
+  power_rtc_hz = power_rtc_clock();
+  power_f = power_rtc_hz / (POWER_RTC_ASYNCH_PREDIV + 1U);
+
+  /* Binary counter and BCD calendar side by side, the calendar second
+   * every 1024 counts; exact on LSE */
+  power_hrtc.Instance = RTC;
+  power_hrtc.Init.HourFormat = RTC_HOURFORMAT_24;
+  power_hrtc.Init.AsynchPrediv = POWER_RTC_ASYNCH_PREDIV;
+  power_hrtc.Init.SynchPrediv = power_f - 1U;
+  power_hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
+  power_hrtc.Init.OutPutRemap = RTC_OUTPUT_REMAP_NONE;
+  power_hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+  power_hrtc.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
+  power_hrtc.Init.OutPutPullUp = RTC_OUTPUT_PULLUP_NONE;
+  power_hrtc.Init.BinMode = RTC_BINARY_MIX;
+  power_hrtc.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_2;
+  if (HAL_RTC_Init(&power_hrtc) != HAL_OK ||
+      HAL_RTCEx_EnableBypassShadow(&power_hrtc) != HAL_OK) {
+    Error_Handler();
+  }
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(&power_hrtc);
+  MODIFY_REG(RTC->CR, RTC_CR_WUCKSEL, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+  __HAL_RTC_WRITEPROTECTION_ENABLE(&power_hrtc);
+  __HAL_RTC_WAKEUPTIMER_EXTI_ENABLE_IT();
+
+  /* Console RX edge: armed only while stopped */
+  MODIFY_REG(EXTI->EXTICR[POWER_RX_EXTI_LINE / 4U], 0xFFUL << ((POWER_RX_EXTI_LINE % 4U) * 8U),
+             0U);
+  EXTI->FTSR1 |= POWER_RX_EXTI;
+  HAL_NVIC_SetPriority(EXTI2_3_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(EXTI2_3_IRQn);
+
+#ifdef DEBUG
+  /* Keep the debugger attached through STOP2 */
+  HAL_DBGMCU_EnableDBGStopMode();
+#endif
+  power_ready = 1U;
+}
+
+void power_stop_inhibit(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  power_inhibits++;
+  TX_RESTORE
+}
+
+void power_stop_allow(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  if (power_inhibits > 0U) {
+    power_inhibits--;
+  }
+  TX_RESTORE
+}
+
+void power_activity(void)
+{
+  power_activity_tick = tx_time_get();
+}
+
+void power_stats_get(power_stats_t *stats)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  *stats = power_stats;
+  TX_RESTORE
+}
+
+static uint32_t power_rtc_ssr(void)
+{
+  uint32_t ssr;
+
+  /* Shadow registers are bypassed: read until two reads agree */
+  do {
+    ssr = RTC->SSR;
+  } while (ssr != RTC->SSR);
+  return ssr;
+}
+
+/**
+  * @brief  Arm the wakeup timer for counts + 1 periods of RTCCLK / 16.
+  * @retval 0, or -1 if the timer would not take the new value
+  */
+static int power_rtc_wakeup(uint32_t counts)
+{
+  uint32_t n = 0;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(&power_hrtc);
+  CLEAR_BIT(RTC->CR, RTC_CR_WUTE | RTC_CR_WUTIE);
+  while ((RTC->ICSR & RTC_ICSR_WUTWF) == 0U) {
+    if (++n == POWER_RTC_POLLS) {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(&power_hrtc);
+      return -1;
+    }
+  }
+  WRITE_REG(RTC->WUTR, counts);
+  WRITE_REG(RTC->SCR, RTC_SCR_CWUTF);
+  SET_BIT(RTC->CR, RTC_CR_WUTE | RTC_CR_WUTIE);
+  __HAL_RTC_WRITEPROTECTION_ENABLE(&power_hrtc);
+  return 0;
+}
+
+static void power_rtc_wakeup_stop(void)
+{
+  __HAL_RTC_WRITEPROTECTION_DISABLE(&power_hrtc);
+  CLEAR_BIT(RTC->CR, RTC_CR_WUTE | RTC_CR_WUTIE);
+  WRITE_REG(RTC->SCR, RTC_SCR_CWUTF);
+  __HAL_RTC_WRITEPROTECTION_ENABLE(&power_hrtc);
+}
+
+static int power_stop_allowed(void)
+{
+  return power_ready && power_inhibits == 0U &&
+         power_huart->gState == HAL_UART_STATE_READY &&
+         (tx_time_get() - power_activity_tick) >= POWER_ACTIVITY_HOLD &&
+         (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) == 0U;
+}
+
+/**
+  * @brief  Scheduler idle hook, interrupts disabled: set up STOP2 for the
+  *         WFI that follows, or leave it to be a plain Sleep.
+  */
+void tx_low_power_enter(void)
+{
+  uint32_t load = SysTick->LOAD;
+  uint32_t sleep;
+
+  power_stopping = 0U;
+  power_idle = power_stop_allowed() ? power_tick_idle(POWER_MAX_STOP_TICKS) : 0U;
+  if (power_idle < POWER_MIN_STOP_TICKS) {
+    power_stats.sleeps++;
+    return;
+  }
+
+  /* Wake a margin before the tick on which the next timeout is processed */
+  power_frac = (load - SysTick->VAL) * power_f / (load + 1U);
+  sleep = (power_idle + 1U) * power_f - power_frac -
+          POWER_WAKE_MARGIN * TX_TIMER_TICKS_PER_SECOND;
+  if (power_rtc_wakeup(sleep / (TX_TIMER_TICKS_PER_SECOND / 2U) - 1U) != 0) {
+    power_stats.sleeps++;
+    return;
+  }
+  power_ssr = power_rtc_ssr();
+
+  EXTI->FPR1 = POWER_RX_EXTI;
+  EXTI->IMR1 |= POWER_RX_EXTI;
+
+  /* Wake on the oscillator the current level runs from. STOP2 is entered
+   * from Run; clock_resume() brings back low-power run afterwards. */
+  __HAL_RCC_WAKEUPSTOP_CLK_CONFIG(clock_level_desc(clock_level())->hsi ?
+                                  RCC_STOP_WAKEUPCLOCK_HSI : RCC_STOP_WAKEUPCLOCK_MSI);
+  CLEAR_BIT(PWR->CR1, PWR_CR1_LPR);
+  MODIFY_REG(PWR->CR1, PWR_CR1_LPMS, PWR_CR1_LPMS_1);
+  SET_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+  power_stopping = 1U;
+}
+
+/**
+  * @brief  Scheduler idle hook, interrupts still disabled: after STOP2,
+  *         restore the clock and account for the time spent.
+  */
+void tx_low_power_exit(void)
+{
+  uint32_t woke = SysTick->VAL;
+  uint32_t load = SysTick->LOAD;
+  uint32_t total;
+  uint32_t rem;
+  uint32_t left;
+  uint32_t cycles;
+  uint32_t now;
+  ULONG ticks;
+  int rx;
+
+  if (!power_stopping) {
+    return;
+  }
+  power_stopping = 0U;
+  CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);
+  clock_resume();
+
+  EXTI->IMR1 &= ~POWER_RX_EXTI;
+  rx = (EXTI->FPR1 & POWER_RX_EXTI) != 0U;
+  EXTI->FPR1 = POWER_RX_EXTI;
+  if ((RTC->SR & RTC_SR_WUTF) == 0U) {
+    power_stats.early++;
+  }
+  power_rtc_wakeup_stop();
+
+  /* Time since entry, counted on from the phase the tick was in */
+  total = power_frac + (power_ssr - power_rtc_ssr()) * TX_TIMER_TICKS_PER_SECOND;
+  ticks = total / power_f;
+  rem = total - ticks * power_f;
+  if (ticks > power_idle) {
+    ticks = power_idle;
+    rem = power_f - 1U;
+  }
+  power_tick_advance(ticks);
+  uwTick += ticks * (1000U / TX_TIMER_TICKS_PER_SECOND);
+
+  /* SysTick froze in STOP2, and a wrap since waking is already in the
+   * RTC's count. Run one short period for the rest of the tick in
+   * progress, then the full reload again. */
+  now = SysTick->VAL;
+  cycles = (woke >= now) ? woke - now : woke + load + 1U - now;
+  SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+  left = (power_f - rem) * (load + 1U) / power_f;
+  SysTick->LOAD = ((left > 2U) ? left : 2U) - 1U;
+  SysTick->VAL = 0U;
+  while (SysTick->VAL == 0U) {
+  }
+  SysTick->LOAD = load;
+
+  if (rx) {
+    power_activity_tick = tx_time_get();
+  }
+  power_stats.stops++;
+  power_stats.stop_ticks += ticks;
+  if (ticks > power_stats.longest) {
+    power_stats.longest = ticks;
+  }
+  power_stats.wake_us = cycles * 1000U / (SystemCoreClock / 1000U);
+  if (power_stats.wake_us > power_stats.wake_us_max) {
+    power_stats.wake_us_max = power_stats.wake_us;
+  }
+}
+
+static int console_cmd_power(int argc, char *argv[])
+{
+  power_stats_t s;
+  ULONG now = tx_time_get();
+  (void)argc;
+  (void)argv;
+
+  power_stats_get(&s);
+  printf("  rtc %s, %lu Hz; %lu holds, %s\n", (power_rtc_hz == LSE_VALUE) ? "LSE" : "LSI",
+         (unsigned long)power_rtc_hz, (unsigned long)power_inhibits,
+         ((now - power_activity_tick) < POWER_ACTIVITY_HOLD) ? "console active" : "console idle");
+  printf("  stop2 %lu times, %lu ticks (%lu%%), longest %lu, %lu early\n",
+         (unsigned long)s.stops, (unsigned long)s.stop_ticks,
+         (unsigned long)((now != 0U) ? (uint32_t)((uint64_t)s.stop_ticks * 100U / now) : 0U),
+         (unsigned long)s.longest, (unsigned long)s.early);
+  printf("  sleep %lu times\n", (unsigned long)s.sleeps);
+  printf("  wake %lu us, worst %lu us\n", (unsigned long)s.wake_us,
+         (unsigned long)s.wake_us_max);
+  return 0;
+}
+
+CONSOLE_COMMAND(power, "show sleep residency and wake latency", console_cmd_power, NULL);
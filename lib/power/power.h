@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    power.h
+  * @brief   Tickless idle: STOP2 between kernel timeouts, RTC wakeup.
+  *
+  *          When no thread is ready, ThreadX's scheduler calls the
+  *          tx_low_power_enter()/tx_low_power_exit() hooks around its WFI
+  *          (TX_LOW_POWER and TX_ENABLE_WFI in tx_user.h). If the next
+  *          kernel timeout is at least POWER_MIN_STOP_TICKS away and nothing
+  *          holds the part awake, the enter hook arms the RTC wakeup timer
+  *          just short of it and turns that WFI into STOP2. Otherwise the
+  *          WFI is plain Sleep.
+  *
+  *          STOP2 keeps RAM and every peripheral register, so the exit hook
+  *          only has to put the clock level back (clock_resume()), credit
+  *          the ticks that passed to ThreadX (power_tick_advance()) and the
+  *          HAL tick, and restart SysTick with the right phase. Elapsed time
+  *          comes from the RTC's free-running binary sub-second counter.
+  *
+  *          Held awake by:
+  *            - power_stop_inhibit(), around DMA or bus transfers;
+  *            - a DMA transmission still in progress on the console UART;
+  *            - POWER_ACTIVITY_HOLD ticks after power_activity(), so the
+  *              console stays responsive while someone is typing.
+  *          A falling edge on USART2 RX also ends STOP2, but that first
+  *          byte is lost since the UART had no clock to receive it.
+  *
+  *          The RTC runs from LSE, or from LSI when LSE does not start.
+  ******************************************************************************
+  */
+#ifndef POWER_H
+#define POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "tx_api.h"
+
+#define POWER_MIN_STOP_TICKS    2U      /* Shorter idle periods just Sleep */
+#define POWER_MAX_STOP_TICKS    3000U   /* The wakeup timer tops out at 32 s */
+#define POWER_ACTIVITY_HOLD     1000U   /* Ticks awake after console input */
+#define POWER_WAKE_MARGIN       2U      /* RTC counts to wake before the tick */
+#define POWER_RX_EXTI_LINE      3U      /* USART2_RX is PA3 */
+
+/* RTC prescalers: /32 feeds the binary sub-second counter, about 1 kHz */
+#define POWER_RTC_ASYNCH_PREDIV 31U
+
+typedef struct {
+  uint32_t stops;                   /*!< Idle periods spent in STOP2 */
+  uint32_t sleeps;                  /*!< ... and in Sleep */
+  uint32_t early;                   /*!< STOP2 ended before the RTC wakeup */
+  uint32_t stop_ticks;              /*!< Kernel ticks credited from STOP2 */
+  uint32_t longest;                 /*!< Longest single STOP2, ticks */
+  uint32_t wake_us;                 /*!< Last wakeup to resumed scheduler */
+  uint32_t wake_us_max;
+} power_stats_t;
+
+/**
+  * @brief  Start the RTC and set up STOP2. Before the kernel starts, or
+  *         later from a thread: there the wait for LSE sleeps instead of
+  *         spinning. The idle hook only sleeps until this has run.
+  * @param  huart: console UART, kept awake while it transmits
+  */
+void power_init(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  Keep the part out of STOP2 until power_stop_allow(). Counted.
+  *         Thread or ISR context.
+  */
+void power_stop_inhibit(void);
+
+/**
+  * @brief  Drop a hold taken with power_stop_inhibit().
+  */
+void power_stop_allow(void);
+
+/**
+  * @brief  Note console input. ISR safe.
+  */
+void power_activity(void);
+
+/**
+  * @brief  Snapshot of the residency and wake statistics.
+  */
+void power_stats_get(power_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWER_H */
@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    power_tick.c
+  * @brief   Skipping ThreadX ticks the scheduler would have spent idle.
+  ******************************************************************************
+  */
+#include "power_tick.h"
+#include "tx_timer.h"
+
+/**
+  * @brief  Tick on which a timer filed offset lists ahead is really due.
+  */
+static ULONG power_tick_due(const TX_TIMER_INTERNAL *timer, ULONG offset)
+{
+  ULONG remaining = timer->tx_timer_internal_remaining_ticks;
+
+  return offset + 1U + ((remaining > TX_TIMER_ENTRIES) ? remaining - TX_TIMER_ENTRIES : 0U);
+}
+
+static TX_TIMER_INTERNAL **power_tick_list(ULONG offset)
+{
+  ULONG index = (ULONG)(_tx_timer_current_ptr - _tx_timer_list_start) + offset;
+
+  return &_tx_timer_list_start[index % TX_TIMER_ENTRIES];
+}
+
+ULONG power_tick_idle(ULONG max)
+{
+  TX_TIMER_INTERNAL *head;
+  TX_TIMER_INTERNAL *timer;
+  ULONG next = max + 1U;
+  ULONG due;
+  ULONG offset;
+
+  /* Nothing on a later list can be due before offset + 1 */
+  for (offset = 0; offset < TX_TIMER_ENTRIES && offset + 1U < next; offset++) {
+    head = *power_tick_list(offset);
+    if (head == TX_NULL) {
+      continue;
+    }
+    timer = head;
+    do {
+      due = power_tick_due(timer, offset);
+      if (due < next) {
+        next = due;
+      }
+      timer = timer->tx_timer_internal_active_next;
+    } while (timer != head);
+  }
+  return next - 1U;
+}
+
+void power_tick_advance(ULONG ticks)
+{
+  TX_TIMER_INTERNAL **list;
+  TX_TIMER_INTERNAL *head;
+  TX_TIMER_INTERNAL *timer;
+  TX_TIMER_INTERNAL *next;
+  TX_TIMER_INTERNAL *pending = TX_NULL;
+  TX_TIMER_INTERNAL **tail = &pending;
+  ULONG offset;
+  ULONG due;
+
+  if (ticks == 0U) {
+    return;
+  }
+
+  /* Unfile everything with the time left from the new position; the
+   * previous-link chains the timers until they are filed again. Timers due
+   * on the same tick may come out in a different order than they would
+   * have, which no ThreadX service depends on. */
+  for (offset = 0; offset < TX_TIMER_ENTRIES; offset++) {
+    list = power_tick_list(offset);
+    head = *list;
+    if (head == TX_NULL) {
+      continue;
+    }
+    *list = TX_NULL;
+    timer = head;
+    do {
+      next = timer->tx_timer_internal_active_next;
+      due = power_tick_due(timer, offset);
+      timer->tx_timer_internal_remaining_ticks = (due > ticks) ? due - ticks : 1U;
+      timer->tx_timer_internal_list_head = TX_NULL;
+      timer->tx_timer_internal_active_previous = TX_NULL;
+      *tail = timer;
+      tail = &timer->tx_timer_internal_active_previous;
+      timer = next;
+    } while (timer != head);
+  }
+
+  _tx_timer_system_clock += ticks;
+  _tx_timer_current_ptr = power_tick_list(ticks);
+
+  for (timer = pending; timer != TX_NULL; timer = next) {
+    next = timer->tx_timer_internal_active_previous;
+    _tx_timer_system_activate(timer);
+  }
+}
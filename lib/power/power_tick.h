@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    power_tick.h
+  * @brief   Skipping ThreadX ticks the scheduler would have spent idle.
+  *
+  *          ThreadX keeps its timeouts on a wheel of TX_TIMER_ENTRIES lists
+  *          and moves one list per tick. A timer on the list k places ahead
+  *          of the current one is processed on tick k + 1; one with more
+  *          than TX_TIMER_ENTRIES ticks left is only re-filed then, and
+  *          really expires remaining - TX_TIMER_ENTRIES ticks later.
+  *
+  *          power_tick_idle() turns that into the number of ticks that will
+  *          pass with nothing to do. power_tick_advance() then moves the
+  *          clock forward by up to that many at once: every timer is taken
+  *          off the wheel, its remaining time recomputed, and filed again
+  *          from the new position, exactly as if the ticks had happened.
+  *
+  *          Both work on ThreadX internals and must run with interrupts
+  *          disabled, from the scheduler's idle hooks. No HAL dependency.
+  ******************************************************************************
+  */
+#ifndef POWER_TICK_H
+#define POWER_TICK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+
+/**
+  * @brief  Ticks that will pass before any timer needs processing.
+  * @param  max: cap, returned when no timer is active
+  * @retval ticks that power_tick_advance() may skip, at most max
+  */
+ULONG power_tick_idle(ULONG max);
+
+/**
+  * @brief  Account for ticks that passed while the tick interrupt was
+  *         stopped.
+  * @param  ticks: at most what power_tick_idle() returned
+  */
+void power_tick_advance(ULONG ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWER_TICK_H */
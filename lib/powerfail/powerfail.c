@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file    powerfail.c
+  * @brief   Power-fail path: last flight log record and a quiet part before
+  *          the supply drops through brownout reset.
+  ******************************************************************************
+  */
+#include "powerfail.h"
+#include "main.h"
+#include "cycles.h"
+#include "console.h"
+#include "sections.h"
+#include "tx_api.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define POWERFAIL_DWORD         8U
+#define POWERFAIL_DRILL_DRAIN   10U     /* Ticks for the console to drain */
+
+static const powerfail_budget_t powerfail_settings = {
+  POWERFAIL_HOLDUP_UF, POWERFAIL_LOAD_MA, POWERFAIL_PVD_MV, POWERFAIL_BOR_MV,
+  POWERFAIL_MARGIN_PCT,
+};
+
+static flightlog_t *volatile powerfail_log;
+static volatile uint8_t powerfail_drill;
+
+/* Outside .bss so that the next boot can report it */
+static powerfail_record_t powerfail_record NOINIT;
+
+static powerfail_record_t powerfail_previous;
+static int powerfail_previous_valid;
+
+static const char *const powerfail_source_names[] = { "pvd", "drill" };
+
+static const char *const powerfail_result_names[] = {
+  "wrote", "skipped (flash busy)", "skipped (over budget)", "skipped (no log)", "io error",
+};
+
+__weak void powerfail_tx_abort(void)
+{
+}
+
+static uint32_t powerfail_check_word(const powerfail_record_t *r)
+{
+  return ~r->magic ^ ((uint32_t)r->source | ((uint32_t)r->result << 8) |
+                      ((uint32_t)r->erase << 16)) ^ r->flush_us ^ r->budget_us;
+}
+
+/**
+  * @brief  Stop DMA and gate every clock the rest of the path does not
+  *         need: flash, GPIO (PTT stays driven), PWR, RTC and TIM2.
+  */
+static void powerfail_park(void)
+{
+  DMA_Channel_TypeDef *const channels[] = {
+    DMA1_Channel1, DMA1_Channel2, DMA1_Channel3, DMA1_Channel4,
+    DMA1_Channel5, DMA1_Channel6, DMA1_Channel7,
+  };
+  uint32_t i;
+
+  for (i = 0U; i < sizeof(channels) / sizeof(channels[0]); i++) {
+    CLEAR_BIT(channels[i]->CCR, DMA_CCR_EN);
+  }
+  RCC->AHBENR &= RCC_AHBENR_FLASHEN;
+  RCC->APBENR1 &= RCC_APBENR1_PWREN | RCC_APBENR1_RTCAPBEN | RCC_APBENR1_TIM2EN;
+  RCC->APBENR2 = 0U;
+}
+
+/**
+  * @brief  Whether the handler cut into a flash operation that did not go
+  *         through the flight log, such as config_save(): the HAL holds its
+  *         lock from before the program or erase until after it.
+  */
+static int powerfail_flash_busy(void)
+{
+  return pFlash.Lock == HAL_LOCKED || (FLASH->SR & FLASH_SR_BSY1) != 0U;
+}
+
+/**
+  * @brief  The last record, if the plan lets it through.
+  */
+static powerfail_result_t powerfail_flush(flightlog_t *log, uint8_t source,
+                                          powerfail_plan_t *plan)
+{
+  powerfail_entry_t entry;
+
+  if (log == NULL) {
+    memset(plan, 0, sizeof(*plan));
+    plan->holdup_us = powerfail_holdup_us(&powerfail_settings);
+    return POWERFAIL_SKIPPED_NO_LOG;
+  }
+  powerfail_plan(&powerfail_settings, flightlog_room(log),
+                 flightlog_record_size(sizeof(entry)), plan);
+  if (log->busy || powerfail_flash_busy()) {
+    return POWERFAIL_SKIPPED_BUSY;
+  }
+  if (!plan->fits) {
+    return POWERFAIL_SKIPPED_BUDGET;
+  }
+
+  memset(&entry, 0, sizeof(entry));
+  entry.tick = HAL_GetTick();
+  entry.source = source;
+  log->reserve = 0U;                    /* The room kept for exactly this */
+  return (flightlog_append(log, FLIGHTLOG_TYPE_POWERFAIL, &entry, sizeof(entry)) ==
+          FLIGHTLOG_OK) ? POWERFAIL_WROTE : POWERFAIL_IO_ERROR;
+}
+
+/**
+  * @brief  VDD fell below the PVD threshold, or a drill. Highest priority,
+  *         no kernel calls, never returns.
+  */
+void PVD_PVM_IRQHandler(void)
+{
+  uint8_t source = powerfail_drill ? POWERFAIL_SOURCE_DRILL : POWERFAIL_SOURCE_PVD;
+  powerfail_record_t *r = &powerfail_record;
+  powerfail_plan_t plan;
+  uint32_t start;
+  uint8_t result;
+
+  EXTI->RPR1 = PWR_EXTI_LINE_PVD;
+  powerfail_tx_abort();
+  powerfail_park();
+
+  cycles_start();
+  start = cycles_now();
+  result = (uint8_t)powerfail_flush(powerfail_log, source, &plan);
+
+  r->magic = POWERFAIL_MAGIC;
+  r->source = source;
+  r->result = result;
+  r->erase = plan.erase;
+  r->pad = 0U;
+  r->flush_us = (cycles_now() - start) / cycles_mhz();
+  r->budget_us = plan.holdup_us;
+  r->check = powerfail_check_word(r);
+
+  /* Either BOR (or the watchdog) ends this, or the supply recovers */
+  while ((PWR->SR2 & PWR_SR2_PVDO) != 0U) {
+  }
+  NVIC_SystemReset();
+}
+
+int powerfail_boot_report(void)
+{
+  powerfail_record_t *r = &powerfail_record;
+
+  if (r->magic != POWERFAIL_MAGIC || r->check != powerfail_check_word(r) ||
+      r->source > POWERFAIL_SOURCE_DRILL || r->result > POWERFAIL_IO_ERROR) {
+    memset(r, 0, sizeof(*r));
+    return 0;
+  }
+  powerfail_previous = *r;
+  powerfail_previous_valid = 1;
+  memset(r, 0, sizeof(*r));
+
+  printf("powerfail: %s, %s, flush %lu us of %lu us\n",
+         powerfail_source_names[powerfail_previous.source],
+         powerfail_result_names[powerfail_previous.result],
+         (unsigned long)powerfail_previous.flush_us,
+         (unsigned long)powerfail_previous.budget_us);
+  return 1;
+}
+
+void powerfail_init(void)
+{
+  PWR_PVDTypeDef pvd;
+
+  /* PVDO rises as VDD falls through the threshold */
+  pvd.PVDLevel = POWERFAIL_PVD_LEVEL;
+  pvd.Mode = PWR_PVD_MODE_IT_RISING;
+  __HAL_RCC_PWR_CLK_ENABLE();
+  (void)HAL_PWR_ConfigPVD(&pvd);
+  HAL_PWR_EnablePVD();
+  HAL_NVIC_SetPriority(PVD_PVM_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(PVD_PVM_IRQn);
+}
+
+void powerfail_attach(flightlog_t *log)
+{
+  log->reserve = flightlog_record_size(sizeof(powerfail_entry_t));
+  powerfail_log = log;
+}
+
+static void powerfail_show(void)
+{
+  const powerfail_budget_t *b = &powerfail_settings;
+  flightlog_t *log = powerfail_log;
+  uint32_t record = flightlog_record_size(sizeof(powerfail_entry_t));
+  powerfail_plan_t plan;
+
+  printf("  hold-up    %lu uF, %lu -> %lu mV at %lu mA: %lu us usable (%lu%% kept)\n",
+         (unsigned long)b->holdup_uf, (unsigned long)b->pvd_mv, (unsigned long)b->bor_mv,
+         (unsigned long)b->load_ma, (unsigned long)powerfail_holdup_us(b),
+         (unsigned long)b->margin_pct);
+  printf("  record     %lu bytes: %lu us, %lu us with a page erase\n", (unsigned long)record,
+         (unsigned long)powerfail_flush_us(record / POWERFAIL_DWORD, 0U),
+         (unsigned long)powerfail_flush_us(record / POWERFAIL_DWORD + 1U, 1U));
+  if (log == NULL) {
+    printf("  head page  no log attached\n");
+  } else {
+    powerfail_plan(b, flightlog_room(log), record, &plan);
+    printf("  head page  %lu bytes free: %lu us%s, %s\n", (unsigned long)flightlog_room(log),
+           (unsigned long)plan.flush_us, plan.erase ? " with an erase" : "",
+           plan.fits ? "fits" : "does not fit");
+  }
+  if (powerfail_previous_valid) {
+    printf("  last       %s, %s, flush %lu us of %lu us\n",
+           powerfail_source_names[powerfail_previous.source],
+           powerfail_result_names[powerfail_previous.result],
+           (unsigned long)powerfail_previous.flush_us,
+           (unsigned long)powerfail_previous.budget_us);
+  } else {
+    printf("  last       none since power-on\n");
+  }
+}
+
+static int console_cmd_powerfail(int argc, char *argv[])
+{
+  if (argc == 1) {
+    powerfail_show();
+    return 0;
+  }
+  if (strcmp(argv[1], "drill") == 0) {
+    printf("  tripping the power-fail path; the part resets\n");
+    tx_thread_sleep(POWERFAIL_DRILL_DRAIN);
+    powerfail_drill = 1U;
+    NVIC_SetPendingIRQ(PVD_PVM_IRQn);
+    return 0;
+  }
+  printf("  unknown subcommand '%s'\n", argv[1]);
+  return -1;
+}
+
+static const char *console_complete_powerfail(int argi, uint32_t index)
+{
+  static const char *const subcommands[] = { "drill" };
+
+  if (argi != 1 || index >= sizeof(subcommands) / sizeof(subcommands[0])) {
+    return NULL;
+  }
+  return subcommands[index];
+}
+
+CONSOLE_COMMAND(powerfail, "powerfail [drill]: hold-up budget and last power-fail",
+                console_cmd_powerfail, console_complete_powerfail);
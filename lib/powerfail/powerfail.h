@@ -0,0 +1,127 @@
+/**
+  ******************************************************************************
+  * @file    powerfail.h
+  * @brief   Power-fail path: last flight log record and a quiet part before
+  *          the supply drops through brownout reset.
+  *
+  *          The PVD compares VDD against POWERFAIL_PVD_LEVEL. When VDD
+  *          falls below it, EXTI line 16 raises PVD_PVM_IRQn at the highest
+  *          priority, and everything happens in that handler, which never
+  *          returns:
+  *            1. powerfail_tx_abort(), a weak hook the transmit path
+  *               overrides to drop PTT and stop the DAC;
+  *            2. DMA stopped and every peripheral clock gated but flash,
+  *               GPIO, PWR, RTC and TIM2, to stretch the hold-up time;
+  *            3. one FLIGHTLOG_TYPE_POWERFAIL record, if the plan says it
+  *               fits the time the hold-up capacitance leaves;
+  *            4. a wait for VDD to come back or BOR to end it, then a
+  *               reset either way.
+  *
+  *          Hold-up time is C * (V_pvd - V_bor) / I_load, less a margin.
+  *          A flush costs POWERFAIL_FLASH_PROG_US per double-word, plus
+  *          POWERFAIL_FLASH_ERASE_US if the head page has no room, so the
+  *          flight log keeps room for the record at the end of its head
+  *          page and no erase is normally needed. The record is skipped if
+  *          a thread was inside flightlog_append() or the flash HAL (a
+  *          configuration save): the flash is not ours to program then.
+  *
+  *          TIM2 measures the flush, and the result lands in .noinit for
+  *          powerfail_boot_report() to print on the next boot. The
+  *          `powerfail` command shows the budget and `powerfail drill`
+  *          trips the path by pending the interrupt. The accounting itself
+  *          is checked on the host (powerfail_test.c).
+  *
+  *          Starting below the threshold raises no edge, so nothing trips
+  *          until VDD has risen past it and falls again.
+  ******************************************************************************
+  */
+#ifndef POWERFAIL_H
+#define POWERFAIL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "flightlog.h"
+#include "powerfail_budget.h"
+
+#ifndef POWERFAIL_PVD_LEVEL
+#define POWERFAIL_PVD_LEVEL     PWR_PVDLEVEL_2  /* Falling threshold, about 2.4 V */
+#endif
+#ifndef POWERFAIL_PVD_MV
+#define POWERFAIL_PVD_MV        2400U           /* ... the same, for the budget */
+#endif
+#ifndef POWERFAIL_BOR_MV
+#define POWERFAIL_BOR_MV        1700U           /* BOR level 0, falling */
+#endif
+#ifndef POWERFAIL_HOLDUP_UF
+#define POWERFAIL_HOLDUP_UF     100U            /* Bulk capacitance on VDD */
+#endif
+#ifndef POWERFAIL_LOAD_MA
+#define POWERFAIL_LOAD_MA       5U              /* Parked MCU plus programming */
+#endif
+
+#define POWERFAIL_MAGIC         0x4C494146UL    /* "FAIL" */
+
+typedef enum {
+  POWERFAIL_SOURCE_PVD = 0,
+  POWERFAIL_SOURCE_DRILL,
+} powerfail_source_t;
+
+typedef enum {
+  POWERFAIL_WROTE = 0,
+  POWERFAIL_SKIPPED_BUSY,                   /*!< A thread was using the flash */
+  POWERFAIL_SKIPPED_BUDGET,                 /*!< Would not fit the hold-up time */
+  POWERFAIL_SKIPPED_NO_LOG,                 /*!< Before powerfail_attach() */
+  POWERFAIL_IO_ERROR,
+} powerfail_result_t;
+
+/* FLIGHTLOG_TYPE_POWERFAIL payload */
+typedef struct {
+  uint32_t tick;                            /*!< HAL tick at the trip */
+  uint8_t source;                           /*!< powerfail_source_t */
+  uint8_t pad[3];
+} powerfail_entry_t;
+
+/* Left in .noinit by the handler for the next boot */
+typedef struct {
+  uint32_t magic;
+  uint8_t source;                           /*!< powerfail_source_t */
+  uint8_t result;                           /*!< powerfail_result_t */
+  uint8_t erase;
+  uint8_t pad;
+  uint32_t flush_us;                        /*!< Measured: the record's programming */
+  uint32_t budget_us;                       /*!< Hold-up time it had to fit */
+  uint32_t check;                           /*!< ~magic ^ the words above */
+} powerfail_record_t;
+
+/**
+  * @brief  Print and clear the record a power-fail left. Call once after
+  *         the console UART is up.
+  * @retval 1 if the previous run ended in a power-fail, 0 otherwise
+  */
+int powerfail_boot_report(void);
+
+/**
+  * @brief  Arm the PVD interrupt.
+  */
+void powerfail_init(void);
+
+/**
+  * @brief  Log to record into, once it is initialised; keeps room for the
+  *         record at the end of each page.
+  */
+void powerfail_attach(flightlog_t *log);
+
+/**
+  * @brief  Stop transmitting now. Runs first in the handler, at the highest
+  *         interrupt priority; the default does nothing.
+  */
+void powerfail_tx_abort(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWERFAIL_H */
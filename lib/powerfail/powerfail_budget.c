@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    powerfail_budget.c
+  * @brief   Hold-up budget for the power-fail record.
+  ******************************************************************************
+  */
+#include "powerfail_budget.h"
+
+#define POWERFAIL_DWORD         8U
+
+uint32_t powerfail_holdup_us(const powerfail_budget_t *budget)
+{
+  uint64_t us;
+
+  if (budget->load_ma == 0U || budget->pvd_mv <= budget->bor_mv ||
+      budget->margin_pct >= 100U) {
+    return 0U;
+  }
+  /* uF * mV / mA comes out in us; a supercap needs the 64 bits */
+  us = (uint64_t)budget->holdup_uf * (budget->pvd_mv - budget->bor_mv) / budget->load_ma;
+  us = us * (100U - budget->margin_pct) / 100U;
+  return (us > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : (uint32_t)us;
+}
+
+uint32_t powerfail_flush_us(uint32_t dwords, uint32_t erases)
+{
+  return dwords * POWERFAIL_FLASH_PROG_US + erases * POWERFAIL_FLASH_ERASE_US;
+}
+
+void powerfail_plan(const powerfail_budget_t *budget, uint32_t room, uint32_t record_bytes,
+                    powerfail_plan_t *plan)
+{
+  uint32_t dwords = record_bytes / POWERFAIL_DWORD;
+
+  /* Opening a page also programs its header */
+  plan->erase = (room < record_bytes) ? 1U : 0U;
+  plan->holdup_us = powerfail_holdup_us(budget);
+  plan->flush_us = powerfail_flush_us(dwords + plan->erase, plan->erase);
+  plan->fits = (plan->flush_us <= plan->holdup_us) ? 1U : 0U;
+}
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    powerfail_budget.h
+  * @brief   Hold-up budget for the power-fail record: the time the bulk
+  *          capacitance leaves between the PVD and BOR thresholds, against
+  *          the worst-case time to program the record.
+  *
+  *          Pure C, also builds on the host.
+  ******************************************************************************
+  */
+#ifndef POWERFAIL_BUDGET_H
+#define POWERFAIL_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define POWERFAIL_MARGIN_PCT    25U             /* Of the hold-up, kept unused */
+
+/* Worst case per operation, assumed; check against the part's datasheet */
+#define POWERFAIL_FLASH_PROG_US     125U        /* One double-word */
+#define POWERFAIL_FLASH_ERASE_US    40000U      /* One page */
+
+typedef struct {
+  uint32_t holdup_uf;
+  uint32_t load_ma;
+  uint32_t pvd_mv;
+  uint32_t bor_mv;
+  uint32_t margin_pct;
+} powerfail_budget_t;
+
+typedef struct {
+  uint32_t holdup_us;                       /*!< Usable, margin taken off */
+  uint32_t flush_us;                        /*!< Worst case for the record */
+  uint8_t erase;                            /*!< Needs a page opened first */
+  uint8_t fits;                             /*!< flush_us <= holdup_us */
+} powerfail_plan_t;
+
+/**
+  * @brief  Time the hold-up capacitance covers between the PVD and BOR
+  *         thresholds at the given load, less the margin.
+  * @retval Microseconds, 0 if the thresholds or load make no sense
+  */
+uint32_t powerfail_holdup_us(const powerfail_budget_t *budget);
+
+/**
+  * @brief  Worst-case time to program dwords double-words after erasing
+  *         erases pages.
+  */
+uint32_t powerfail_flush_us(uint32_t dwords, uint32_t erases);
+
+/**
+  * @brief  Whether a record of record_bytes flight log bytes can be written
+  *         with room bytes left in the head page.
+  */
+void powerfail_plan(const powerfail_budget_t *budget, uint32_t room, uint32_t record_bytes,
+                    powerfail_plan_t *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWERFAIL_BUDGET_H */
@@ -0,0 +1,253 @@
+/**
+  ******************************************************************************
+  * @file    powerfail_test.c
+  * @brief   Host build: the hold-up budget, and the flight log room it
+  *          counts on, on flash_sim.
+  *
+  *          The arithmetic is checked against cases worked by hand and
+  *          against a floating-point reference over random boards, along
+  *          with the orderings it must keep: more capacitance never buys
+  *          less time, more load never more. Then a flight log with the
+  *          power-fail reserve takes random appends across its pages, and
+  *          at random points the record is flushed the way the handler
+  *          does it. Each flush must cost exactly the programs the plan
+  *          charged and no erase:
+  *            powerfail_test [seed]
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "powerfail.h"
+#include "flash_sim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define POWERFAIL_TEST_BOARDS   100000UL
+#define POWERFAIL_TEST_APPENDS  20000UL
+#define POWERFAIL_TEST_PAGE     2048U
+#define POWERFAIL_TEST_PAGES    4U
+
+typedef struct {
+  powerfail_budget_t budget;
+  uint32_t room;
+  uint32_t holdup_us;
+  uint32_t flush_us;
+  uint8_t erase;
+  uint8_t fits;
+} powerfail_test_case_t;
+
+/* Worked by hand for the 24-byte record: three double-words */
+static const powerfail_test_case_t powerfail_test_cases[] = {
+  /* The defaults: 100 uF * 700 mV / 5 mA = 14 ms, 10.5 ms kept */
+  { { 100U, 5U, 2400U, 1700U, 25U }, 2048U, 10500U, 375U, 0U, 1U },
+  /* Exactly the record left, then a byte short: a page is opened */
+  { { 100U, 5U, 2400U, 1700U, 25U }, 24U, 10500U, 375U, 0U, 1U },
+  { { 100U, 5U, 2400U, 1700U, 25U }, 23U, 10500U, 40500U, 1U, 0U },
+  /* 10 uF covers the record but not an erase: 1050 us */
+  { { 10U, 5U, 2400U, 1700U, 25U }, 2048U, 1050U, 375U, 0U, 1U },
+  { { 10U, 5U, 2400U, 1700U, 25U }, 0U, 1050U, 40500U, 1U, 0U },
+  /* 3 uF: 315 us, under the 375 us of the record */
+  { { 3U, 5U, 2400U, 1700U, 25U }, 2048U, 315U, 375U, 0U, 0U },
+  /* Exactly the record's 375 us: 5 uF * 75 mV / 1 mA, no margin */
+  { { 5U, 1U, 1775U, 1700U, 0U }, 2048U, 375U, 375U, 0U, 1U },
+  /* 1 F at 1 mA from 3.3 V: 1.6e9 us * 0.75 still fits 32 bits */
+  { { 1000000U, 1U, 3300U, 1700U, 25U }, 0U, 1200000000U, 40500U, 1U, 1U },
+  /* 10 F saturates */
+  { { 10000000U, 1U, 3300U, 1700U, 0U }, 0U, 0xFFFFFFFFUL, 40500U, 1U, 1U },
+  /* Nonsense: thresholds crossed, no load, all margin */
+  { { 100U, 5U, 1700U, 2400U, 25U }, 2048U, 0U, 375U, 0U, 0U },
+  { { 100U, 0U, 2400U, 1700U, 25U }, 2048U, 0U, 375U, 0U, 0U },
+  { { 100U, 5U, 2400U, 1700U, 100U }, 2048U, 0U, 375U, 0U, 0U },
+};
+
+static uint8_t powerfail_test_mem[POWERFAIL_TEST_PAGE * POWERFAIL_TEST_PAGES];
+static uint8_t powerfail_test_torn[sizeof(powerfail_test_mem) / 8U];
+static uint32_t powerfail_test_erases[POWERFAIL_TEST_PAGES];
+static flash_sim_t powerfail_test_sim;
+static flash_dev_t powerfail_test_dev;
+
+static uint32_t powerfail_test_seed;
+static int powerfail_test_failed;
+
+#define POWERFAIL_TEST_CHECK(cond)                                             \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s:%d: %s\n", __FILE__, __LINE__, #cond);             \
+      powerfail_test_failed++;                                                 \
+    }                                                                          \
+  } while (0)
+
+static uint32_t powerfail_test_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  powerfail_test_seed ^= powerfail_test_seed << 13;
+  powerfail_test_seed ^= powerfail_test_seed >> 17;
+  powerfail_test_seed ^= powerfail_test_seed << 5;
+  return powerfail_test_seed;
+}
+
+static uint32_t powerfail_test_record(void)
+{
+  return flightlog_record_size(sizeof(powerfail_entry_t));
+}
+
+static void powerfail_test_worked(void)
+{
+  const powerfail_test_case_t *c;
+  powerfail_plan_t plan;
+  uint32_t n = sizeof(powerfail_test_cases) / sizeof(powerfail_test_cases[0]);
+  uint32_t i;
+
+  POWERFAIL_TEST_CHECK(powerfail_test_record() == 24U);
+  for (i = 0U; i < n; i++) {
+    c = &powerfail_test_cases[i];
+    powerfail_plan(&c->budget, c->room, powerfail_test_record(), &plan);
+    if (plan.holdup_us != c->holdup_us || plan.flush_us != c->flush_us ||
+        plan.erase != c->erase || plan.fits != c->fits) {
+      fprintf(stderr, "  case %lu: %lu us, flush %lu, erase %u, fits %u\n", (unsigned long)i,
+              (unsigned long)plan.holdup_us, (unsigned long)plan.flush_us, plan.erase,
+              plan.fits);
+      powerfail_test_failed++;
+    }
+  }
+  printf("  %-22s %lu cases  %s\n", "worked by hand", (unsigned long)n,
+         (powerfail_test_failed == 0) ? "ok" : "FAIL");
+}
+
+/**
+  * @brief  Random boards up to 10 F, 5 V and 1 A, where a double holds the
+  *         products exactly: the result is the reference, rounded down.
+  */
+static void powerfail_test_boards(unsigned long boards)
+{
+  powerfail_budget_t b;
+  powerfail_budget_t more;
+  powerfail_plan_t plan;
+  uint32_t record = powerfail_test_record();
+  uint32_t holdup;
+  uint32_t room;
+  double ref;
+  unsigned long i;
+
+  for (i = 0UL; i < boards; i++) {
+    b.holdup_uf = 1U + powerfail_test_rand() % 10000000U;
+    b.load_ma = 1U + powerfail_test_rand() % 1000U;
+    b.bor_mv = 1500U + powerfail_test_rand() % 1500U;
+    b.pvd_mv = b.bor_mv + 1U + powerfail_test_rand() % 2000U;
+    b.margin_pct = powerfail_test_rand() % 100U;
+    holdup = powerfail_holdup_us(&b);
+
+    ref = floor((double)b.holdup_uf * (double)(b.pvd_mv - b.bor_mv) / (double)b.load_ma);
+    ref = floor(ref * (double)(100U - b.margin_pct) / 100.0);
+    POWERFAIL_TEST_CHECK(holdup == ((ref > 4294967295.0) ? 0xFFFFFFFFUL : (uint32_t)ref));
+
+    more = b;
+    more.holdup_uf++;
+    POWERFAIL_TEST_CHECK(powerfail_holdup_us(&more) >= holdup);
+    more = b;
+    more.load_ma++;
+    POWERFAIL_TEST_CHECK(powerfail_holdup_us(&more) <= holdup);
+    more = b;
+    more.margin_pct = (b.margin_pct > 0U) ? b.margin_pct - 1U : 0U;
+    POWERFAIL_TEST_CHECK(powerfail_holdup_us(&more) >= holdup);
+
+    room = powerfail_test_rand() % (2U * record);
+    powerfail_plan(&b, room, record, &plan);
+    POWERFAIL_TEST_CHECK(plan.holdup_us == holdup);
+    POWERFAIL_TEST_CHECK(plan.erase == ((room < record) ? 1U : 0U));
+    POWERFAIL_TEST_CHECK(plan.flush_us == (record / 8U + plan.erase) * POWERFAIL_FLASH_PROG_US +
+                                          plan.erase * POWERFAIL_FLASH_ERASE_US);
+    POWERFAIL_TEST_CHECK(plan.fits == ((plan.flush_us <= holdup) ? 1U : 0U));
+  }
+  printf("  %-22s %lu boards  %s\n", "hold-up arithmetic", boards,
+         (powerfail_test_failed == 0) ? "ok" : "FAIL");
+}
+
+static uint32_t powerfail_test_erase_total(void)
+{
+  uint32_t total = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < POWERFAIL_TEST_PAGES; i++) {
+    total += powerfail_test_erases[i];
+  }
+  return total;
+}
+
+/**
+  * @brief  The log keeps the record's room, so the flush never erases and
+  *         programs exactly what the plan charged.
+  */
+static void powerfail_test_log(unsigned long appends)
+{
+  static const powerfail_budget_t defaults = {
+    POWERFAIL_HOLDUP_UF, POWERFAIL_LOAD_MA, POWERFAIL_PVD_MV, POWERFAIL_BOR_MV,
+    POWERFAIL_MARGIN_PCT,
+  };
+  uint8_t payload[FLIGHTLOG_MAX_PAYLOAD];
+  powerfail_entry_t entry;
+  powerfail_plan_t plan;
+  flightlog_t log;
+  uint32_t ops;
+  uint32_t erases;
+  uint32_t trips = 0U;
+  unsigned long i;
+
+  flash_sim_init(&powerfail_test_sim, powerfail_test_mem, powerfail_test_torn,
+                 powerfail_test_erases, POWERFAIL_TEST_PAGE, POWERFAIL_TEST_PAGES);
+  flash_sim_dev(&powerfail_test_sim, &powerfail_test_dev);
+  memset(payload, 0x5A, sizeof(payload));
+  memset(&entry, 0, sizeof(entry));
+
+  for (i = 0UL; i < appends; i++) {
+    if (i == 0UL || (powerfail_test_rand() & 15U) == 0U) {
+      /* Boot: attach as powerfail_attach() does */
+      POWERFAIL_TEST_CHECK(flightlog_init(&log, &powerfail_test_dev) == FLIGHTLOG_OK);
+      log.reserve = powerfail_test_record();
+    }
+    POWERFAIL_TEST_CHECK(flightlog_append(&log, FLIGHTLOG_TYPE_TELEMETRY, payload,
+                                          (uint8_t)(powerfail_test_rand() %
+                                                    (FLIGHTLOG_MAX_PAYLOAD + 1U))) ==
+                         FLIGHTLOG_OK);
+    if ((powerfail_test_rand() & 7U) != 0U) {
+      continue;
+    }
+
+    /* Trip: what powerfail_flush() does, counted */
+    powerfail_plan(&defaults, flightlog_room(&log), powerfail_test_record(), &plan);
+    POWERFAIL_TEST_CHECK(plan.erase == 0U && plan.fits);
+    ops = powerfail_test_sim.ops;
+    erases = powerfail_test_erase_total();
+    log.reserve = 0U;
+    POWERFAIL_TEST_CHECK(flightlog_append(&log, FLIGHTLOG_TYPE_POWERFAIL, &entry,
+                                          sizeof(entry)) == FLIGHTLOG_OK);
+    POWERFAIL_TEST_CHECK(powerfail_test_erase_total() == erases);
+    POWERFAIL_TEST_CHECK((powerfail_test_sim.ops - ops) * POWERFAIL_FLASH_PROG_US ==
+                         plan.flush_us);
+    trips++;
+
+    /* And the next boot picks up after it */
+    POWERFAIL_TEST_CHECK(flightlog_init(&log, &powerfail_test_dev) == FLIGHTLOG_OK);
+    log.reserve = powerfail_test_record();
+  }
+  printf("  %-22s %lu trips  %s\n", "flush within reserve", (unsigned long)trips,
+         (powerfail_test_failed == 0) ? "ok" : "FAIL");
+}
+
+int main(int argc, char *argv[])
+{
+  powerfail_test_seed = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 0x2545F491UL;
+  if (powerfail_test_seed == 0U) {
+    fprintf(stderr, "usage: %s [seed]\n", argv[0]);
+    return 2;
+  }
+
+  powerfail_test_worked();
+  powerfail_test_boards(POWERFAIL_TEST_BOARDS);
+  powerfail_test_log(POWERFAIL_TEST_APPENDS);
+
+  printf("  %-22s %s\n", "powerfail budget", (powerfail_test_failed == 0) ? "ok" : "FAIL");
+  return (powerfail_test_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    qgeo.c
+  * @brief   Integer-only geodesy.
+  ******************************************************************************
+  */
+#include "qgeo.h"
+
+#define QGEO_E7_TO_BAM_Q30      1281023894LL    /* 2^32 / 360e7 ... */
+#define QGEO_E7_TO_BAM_LO_Q62   32675042LL      /* ... and the 32 bits below that */
+#define QGEO_CIRCUMFERENCE_M    40030230ULL     /* 2 pi QGEO_EARTH_RADIUS_M */
+#define QGEO_E7                 10000000UL
+#define QGEO_MIN_E4             600000UL        /* A degree in minutes * 1e4 */
+
+uint32_t qgeo_e7_to_bam(int32_t deg_e7)
+{
+  /* The Q30 constant alone is 0.013 BAM short at 180 degrees */
+  int64_t bam_q30 = (int64_t)deg_e7 * QGEO_E7_TO_BAM_Q30 +
+                    (((int64_t)deg_e7 * QGEO_E7_TO_BAM_LO_Q62) >> 32);
+
+  return (uint32_t)((bam_q30 + (1L << 29)) >> 30);
+}
+
+void qgeo_e7_to_dm(int32_t deg_e7, qgeo_dm_t *dm)
+{
+  uint32_t mag = (deg_e7 < 0) ? 0U - (uint32_t)deg_e7 : (uint32_t)deg_e7;
+  uint32_t deg = mag / QGEO_E7;
+  uint32_t frac = mag - deg * QGEO_E7;
+  /* frac * 60 / 1e7 minutes, in 1e-4: frac * 6 / 100, which fits in 32 bits */
+  uint32_t min_e4 = (frac * 6U + 50U) / 100U;
+
+  if (min_e4 >= QGEO_MIN_E4) {
+    min_e4 -= QGEO_MIN_E4;
+    deg++;
+  }
+  dm->negative = (deg_e7 < 0) ? 1U : 0U;
+  dm->deg = (uint8_t)deg;
+  dm->min_e4 = min_e4;
+}
+
+int32_t qgeo_dm_to_e7(const qgeo_dm_t *dm)
+{
+  uint32_t mag = (uint32_t)dm->deg * QGEO_E7 + (dm->min_e4 * 100U + 3U) / 6U;
+
+  return dm->negative ? -(int32_t)mag : (int32_t)mag;
+}
+
+uint32_t qgeo_distance_m(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7)
+{
+  int32_t lat1 = (int32_t)qgeo_e7_to_bam(lat1_e7);
+  int32_t lat2 = (int32_t)qgeo_e7_to_bam(lat2_e7);
+  uint32_t mid = (uint32_t)(((int64_t)lat1 + lat2) >> 1);
+  uint32_t half_dlat = (uint32_t)((int32_t)((uint32_t)lat2 - (uint32_t)lat1) >> 1);
+  uint32_t half_dlon = (uint32_t)((int32_t)(qgeo_e7_to_bam(lon2_e7) - qgeo_e7_to_bam(lon1_e7)) >> 1);
+  int32_t sd = qmath_sin(half_dlat);
+  int32_t cd = qmath_cos(half_dlat);
+  int32_t sl = qmath_sin(half_dlon);
+  int32_t cl = qmath_cos(half_dlon);
+  int32_t sm = qmath_sin(mid);
+  int32_t cm = qmath_cos(mid);
+  int64_t p[4];
+  uint64_t a;
+  uint64_t b;
+  uint32_t angle;
+
+  /* The haversine a = sin^2(dlat / 2) + cos lat1 cos lat2 sin^2(dlon / 2),
+   * and 1 - a, each as a sum of two squares: with the mean latitude m,
+   *   a     = (sin(dlat / 2) cos(dlon / 2))^2 + (cos m sin(dlon / 2))^2
+   *   1 - a = (cos(dlat / 2) cos(dlon / 2))^2 + (sin m sin(dlon / 2))^2
+   * Neither subtracts, so the angle stays exact from centimetres out to the
+   * antipode, where 1 - a computed as a difference would lose it */
+  p[0] = ((int64_t)sd * cl) >> 30;
+  p[1] = ((int64_t)cm * sl) >> 30;
+  p[2] = ((int64_t)cd * cl) >> 30;
+  p[3] = ((int64_t)sm * sl) >> 30;
+  a = (uint64_t)(p[0] * p[0]) + (uint64_t)(p[1] * p[1]);
+  b = (uint64_t)(p[2] * p[2]) + (uint64_t)(p[3] * p[3]);
+  angle = qmath_atan2((int32_t)qmath_sqrt64(a), (int32_t)qmath_sqrt64(b));
+  if ((int32_t)angle < 0) {
+    angle = 0U;                         /* Rounded below zero, into the fourth quadrant */
+  }
+  return (uint32_t)(((uint64_t)angle * 2U * QGEO_CIRCUMFERENCE_M + QMATH_BAM_HALF) >> 32);
+}
+
+uint32_t qgeo_bearing(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7)
+{
+  uint32_t lat1 = qgeo_e7_to_bam(lat1_e7);
+  uint32_t lat2 = qgeo_e7_to_bam(lat2_e7);
+  uint32_t dlon = qgeo_e7_to_bam(lon2_e7) - qgeo_e7_to_bam(lon1_e7);
+  int32_t c2 = qmath_cos(lat2);
+  int32_t h = qmath_sin((uint32_t)((int32_t)dlon >> 1));
+  int64_t east;
+  int64_t north;
+
+  /* atan2(sin dlon cos lat2, cos lat1 sin lat2 - sin lat1 cos lat2 cos dlon),
+   * with the north component rewritten as
+   * sin(lat2 - lat1) + sin lat1 cos lat2 2 sin^2(dlon / 2): no difference of
+   * two nearly equal products, so short distances keep their precision */
+  east = ((int64_t)qmath_sin(dlon) * c2) >> 30;
+  north = (int64_t)qmath_sin(lat2 - lat1) +
+          (((((int64_t)qmath_sin(lat1) * c2) >> 30) * (((int64_t)h * h) >> 29)) >> 30);
+  return qmath_atan2((int32_t)east, (int32_t)north);
+}
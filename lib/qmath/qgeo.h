@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    qgeo.h
+  * @brief   Integer-only geodesy: positions in degrees * 1e7 (as UBX and
+  *          warmboot keep them), APRS degrees and minutes, and great-circle
+  *          distance and bearing.
+  *
+  *          Distance and bearing are on a sphere of the mean earth radius,
+  *          the model haversine uses: against the WGS84 ellipsoid that is
+  *          good to about 0.5%. QGEO_*_ERR bound the integer arithmetic
+  *          against the same model in double (qmath_accuracy, host build).
+  ******************************************************************************
+  */
+#ifndef QGEO_H
+#define QGEO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "qmath.h"
+
+#define QGEO_EARTH_RADIUS_M     6371009UL   /* Mean radius, IUGG */
+
+/* Error bounds against the spherical model in double */
+#define QGEO_DISTANCE_ERR_M     1U
+#define QGEO_BEARING_ERR_CDEG   2U          /* For points at least QGEO_BEARING_MIN_M apart */
+#define QGEO_BEARING_MIN_M      100U
+
+typedef struct {
+  uint8_t negative;                     /*!< South or west */
+  uint8_t deg;                          /*!< 0..180 */
+  uint32_t min_e4;                      /*!< Minutes * 1e4, 0..599999 */
+} qgeo_dm_t;
+
+/**
+  * @brief  Degrees * 1e7 to BAM, rounded: within half a BAM, 9 mm.
+  */
+uint32_t qgeo_e7_to_bam(int32_t deg_e7);
+
+/**
+  * @brief  Degrees * 1e7 to whole degrees and minutes * 1e4, rounded to
+  *         the nearest 1e-4 minute (0.19 m), carrying into the degrees.
+  *         APRS wants hundredths: (min_e4 + 50) / 100, carrying again.
+  */
+void qgeo_e7_to_dm(int32_t deg_e7, qgeo_dm_t *dm);
+
+/**
+  * @brief  Back to degrees * 1e7, rounded: within 0.5e-7 degree.
+  */
+int32_t qgeo_dm_to_e7(const qgeo_dm_t *dm);
+
+/**
+  * @brief  Great-circle distance by the haversine formula, with the central
+  *         angle from atan2 of sqrt(a) and sqrt(1 - a), both summed from
+  *         squares, so that it stays exact for short and near-antipodal
+  *         distances alike. Within QGEO_DISTANCE_ERR_M anywhere.
+  * @retval Metres, rounded
+  */
+uint32_t qgeo_distance_m(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+/**
+  * @brief  Initial great-circle bearing from the first point to the second.
+  *         Within QGEO_BEARING_ERR_CDEG for points QGEO_BEARING_MIN_M apart;
+  *         0 for the same point. qmath_bam_to_cdeg() makes it degrees.
+  * @retval BAM, clockwise from true north
+  */
+uint32_t qgeo_bearing(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QGEO_H */
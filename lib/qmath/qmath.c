@@ -0,0 +1,321 @@
+/**
+  ******************************************************************************
+  * @file    qmath.c
+  * @brief   Integer-only math for the FPU-less Cortex-M0+.
+  ******************************************************************************
+  */
+#include "qmath.h"
+
+#define QMATH_SIN_POINTS        256U        /* Table segments per quarter turn */
+#define QMATH_SIN_SHIFT         22U         /* BAM bits below a segment */
+#define QMATH_PI_Q30            3373259426ULL
+#define QMATH_CORDIC_ITERS      30U
+#define QMATH_CORDIC_TOP        (1L << 29)  /* Inputs scaled to below this, gain 1.65 */
+#define QMATH_SIXTH_Q18         43691L      /* 1/6 */
+
+/* ISA: 1/5.25588, the troposphere's exponent, and 1/34.1632 above 20 km, Q30 */
+#define QMATH_BARO_K1_Q30       204293595LL
+#define QMATH_BARO_K3_Q30       31429784LL
+#define QMATH_BARO_H1_CM        4433077LL   /* T0 / lapse rate, 288.15 K / 6.5 K/km */
+#define QMATH_BARO_H2_CM        439568LL    /* Scale height at 216.65 K, times ln 2 */
+#define QMATH_BARO_H3_CM        21665000LL  /* T20 / lapse rate, 216.65 K / 1 K/km */
+#define QMATH_BARO_L11_Q24      (-36281570L) /* log2 of p(11 km) / p0 */
+#define QMATH_BARO_L20_Q24      (-34350790L) /* log2 of p(20 km) / p(11 km) */
+
+/* sin(i * pi / 512), Q30 */
+static const int32_t qmath_sine[QMATH_SIN_POINTS + 1U] = {
+  0L, 6588356L, 13176464L, 19764076L, 26350943L, 32936819L,
+  39521455L, 46104602L, 52686014L, 59265442L, 65842639L, 72417357L,
+  78989349L, 85558366L, 92124163L, 98686491L, 105245103L, 111799753L,
+  118350194L, 124896179L, 131437462L, 137973796L, 144504935L, 151030634L,
+  157550647L, 164064728L, 170572633L, 177074115L, 183568930L, 190056834L,
+  196537583L, 203010932L, 209476638L, 215934457L, 222384147L, 228825464L,
+  235258165L, 241682010L, 248096755L, 254502159L, 260897982L, 267283981L,
+  273659918L, 280025552L, 286380643L, 292724951L, 299058239L, 305380268L,
+  311690799L, 317989595L, 324276419L, 330551034L, 336813204L, 343062693L,
+  349299266L, 355522689L, 361732726L, 367929144L, 374111709L, 380280190L,
+  386434353L, 392573967L, 398698801L, 404808624L, 410903207L, 416982319L,
+  423045732L, 429093217L, 435124548L, 441139496L, 447137835L, 453119340L,
+  459083786L, 465030947L, 470960600L, 476872522L, 482766489L, 488642281L,
+  494499676L, 500338453L, 506158392L, 511959275L, 517740883L, 523502998L,
+  529245404L, 534967884L, 540670223L, 546352205L, 552013618L, 557654248L,
+  563273883L, 568872310L, 574449320L, 580004702L, 585538248L, 591049748L,
+  596538995L, 602005783L, 607449906L, 612871159L, 618269338L, 623644239L,
+  628995660L, 634323400L, 639627258L, 644907034L, 650162530L, 655393548L,
+  660599890L, 665781362L, 670937767L, 676068911L, 681174602L, 686254647L,
+  691308855L, 696337036L, 701339000L, 706314559L, 711263525L, 716185713L,
+  721080937L, 725949013L, 730789757L, 735602987L, 740388522L, 745146182L,
+  749875788L, 754577161L, 759250125L, 763894504L, 768510122L, 773096806L,
+  777654384L, 782182683L, 786681534L, 791150767L, 795590213L, 799999706L,
+  804379079L, 808728167L, 813046808L, 817334838L, 821592095L, 825818421L,
+  830013654L, 834177638L, 838310216L, 842411232L, 846480531L, 850517961L,
+  854523370L, 858496606L, 862437520L, 866345964L, 870221790L, 874064853L,
+  877875009L, 881652112L, 885396022L, 889106597L, 892783698L, 896427186L,
+  900036924L, 903612776L, 907154608L, 910662286L, 914135678L, 917574653L,
+  920979082L, 924348837L, 927683790L, 930983817L, 934248793L, 937478595L,
+  940673101L, 943832191L, 946955747L, 950043650L, 953095785L, 956112036L,
+  959092290L, 962036435L, 964944360L, 967815955L, 970651112L, 973449725L,
+  976211688L, 978936898L, 981625251L, 984276646L, 986890984L, 989468165L,
+  992008094L, 994510675L, 996975812L, 999403415L, 1001793390L, 1004145648L,
+  1006460100L, 1008736660L, 1010975242L, 1013175761L, 1015338134L, 1017462281L,
+  1019548121L, 1021595575L, 1023604567L, 1025575020L, 1027506862L, 1029400018L,
+  1031254418L, 1033069992L, 1034846671L, 1036584389L, 1038283080L, 1039942680L,
+  1041563127L, 1043144360L, 1044686319L, 1046188946L, 1047652185L, 1049075980L,
+  1050460278L, 1051805027L, 1053110176L, 1054375676L, 1055601479L, 1056787540L,
+  1057933813L, 1059040255L, 1060106826L, 1061133483L, 1062120190L, 1063066909L,
+  1063973603L, 1064840240L, 1065666786L, 1066453210L, 1067199483L, 1067905576L,
+  1068571464L, 1069197120L, 1069782521L, 1070327646L, 1070832474L, 1071296985L,
+  1071721163L, 1072104991L, 1072448455L, 1072751542L, 1073014240L, 1073236540L,
+  1073418433L, 1073559913L, 1073660973L, 1073721611L, 1073741824L,
+};
+
+/* atan(2^-i) in 1/4 BAM, so the rounding of 30 entries stays under one BAM */
+static const uint32_t qmath_atan_bam[QMATH_CORDIC_ITERS] = {
+  2147483648UL, 1267733622UL, 669835629UL, 340019024UL, 170669324UL, 85417861UL,
+  42719353UL, 21360980UL, 10680653UL, 5340347UL, 2670176UL, 1335088UL,
+  667544UL, 333772UL, 166886UL, 83443UL, 41722UL, 20861UL,
+  10430UL, 5215UL, 2608UL, 1304UL, 652UL, 326UL,
+  163UL, 81UL, 41UL, 20UL, 10UL, 5UL,
+};
+
+/* 2^(2^-k) for k = 1..24, Q30 */
+static const uint32_t qmath_exp2_bits[24] = {
+  1518500250UL, 1276901417UL, 1170923762UL, 1121280436UL, 1097253708UL, 1085434106UL,
+  1079572136UL, 1076653033UL, 1075196443UL, 1074468888UL, 1074105294UL, 1073923544UL,
+  1073832680UL, 1073787251UL, 1073764537UL, 1073753181UL, 1073747502UL, 1073744663UL,
+  1073743244UL, 1073742534UL, 1073742179UL, 1073742001UL, 1073741913UL, 1073741868UL,
+};
+
+uint16_t qmath_sqrt32(uint32_t x)
+{
+  uint32_t root = 0U;
+  uint32_t bit = 1UL << 30;
+
+  while (bit > x) {
+    bit >>= 2;
+  }
+  while (bit != 0U) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)root;
+}
+
+uint32_t qmath_sqrt64(uint64_t x)
+{
+  uint64_t root = 0U;
+  uint64_t bit = 1ULL << 62;
+
+  if ((x >> 32) == 0U) {
+    return qmath_sqrt32((uint32_t)x);
+  }
+  while (bit > x) {
+    bit >>= 2;
+  }
+  while (bit != 0U) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+int32_t qmath_sin(uint32_t angle)
+{
+  uint32_t quadrant = angle >> 30;
+  uint32_t a = angle & (QMATH_BAM_QUARTER - 1U);
+  uint32_t i;
+  int32_t s0;
+  int32_t c0;
+  int32_t d;
+  int32_t d2;
+  int32_t d3;
+  int32_t s;
+
+  /* Second and fourth quadrants run the quarter wave backwards */
+  if ((quadrant & 1U) != 0U) {
+    a = QMATH_BAM_QUARTER - a;
+  }
+  /* Nearest table point, and the step from it in radians */
+  i = (a + (1UL << (QMATH_SIN_SHIFT - 1U))) >> QMATH_SIN_SHIFT;
+  d = (int32_t)(((int64_t)((int32_t)a - (int32_t)(i << QMATH_SIN_SHIFT)) *
+                 (int64_t)QMATH_PI_Q30) >> 31);
+  s0 = qmath_sine[i];
+  c0 = qmath_sine[QMATH_SIN_POINTS - i];
+
+  /* sin(x + d) = s0 + d c0 - d^2 s0 / 2 - d^3 c0 / 6 */
+  d2 = (int32_t)(((int64_t)d * d) >> 30);
+  d3 = (int32_t)(((int64_t)d2 * d) >> 30);
+  s = s0 + (int32_t)(((int64_t)d * c0 + (1L << 29)) >> 30) -
+      (int32_t)(((int64_t)d2 * s0 + (1L << 30)) >> 31) -
+      (int32_t)(((int64_t)d3 * c0 >> 30) * QMATH_SIXTH_Q18 >> 18);
+  s = (s > QMATH_ONE_Q30) ? QMATH_ONE_Q30 : s;
+  return (quadrant >= 2U) ? -s : s;
+}
+
+int32_t qmath_cos(uint32_t angle)
+{
+  return qmath_sin(angle + QMATH_BAM_QUARTER);
+}
+
+uint32_t qmath_atan2(int32_t y, int32_t x)
+{
+  uint32_t ax = (x < 0) ? 0U - (uint32_t)x : (uint32_t)x;
+  uint32_t ay = (y < 0) ? 0U - (uint32_t)y : (uint32_t)y;
+  uint32_t top = ax | ay;
+  uint32_t angle = 0U;
+  int64_t fine = 0;
+  uint32_t i;
+  int32_t vx;
+  int32_t vy;
+  int32_t t;
+
+  if (y == 0) {
+    return (x < 0) ? QMATH_BAM_HALF : 0U;
+  }
+  /* Scale the larger component to just under 2^29: full precision, and
+   * room for the CORDIC gain */
+  while (top >= (uint32_t)QMATH_CORDIC_TOP) {
+    top >>= 1;
+    ax >>= 1;
+    ay >>= 1;
+  }
+  while (top < (uint32_t)(QMATH_CORDIC_TOP >> 1)) {
+    top <<= 1;
+    ax <<= 1;
+    ay <<= 1;
+  }
+  /* Into the right half-plane, where the rotations converge */
+  vx = (int32_t)ax;
+  vy = (y < 0) ? -(int32_t)ay : (int32_t)ay;
+  if (x < 0) {
+    vy = -vy;
+    angle = QMATH_BAM_HALF;
+  }
+
+  /* Rotate towards the x axis; the shifts round, as 30 truncations in a
+   * row would bias the angle by more than ten BAM */
+  for (i = 0U; i < QMATH_CORDIC_ITERS; i++) {
+    int32_t half = (i == 0U) ? 0 : (int32_t)(1UL << (i - 1U));
+    t = vx;
+    if (vy > 0) {
+      vx += (vy + half) >> i;
+      vy -= (t + half) >> i;
+      fine += qmath_atan_bam[i];
+    } else {
+      vx -= (vy + half) >> i;
+      vy += (t + half) >> i;
+      fine -= qmath_atan_bam[i];
+    }
+  }
+  return angle + (uint32_t)((fine + 2) >> 2);
+}
+
+int32_t qmath_log2(uint32_t x)
+{
+  uint32_t m = x;
+  int32_t n = 31;
+  int32_t result;
+  uint32_t bit;
+
+  if (x == 0U) {
+    return INT32_MIN;
+  }
+  while ((m & 0x80000000UL) == 0U) {
+    m <<= 1;
+    n--;
+  }
+  /* Mantissa in [1, 2) as Q30; each squaring doubles log2 of it, and
+   * whether it then reaches 2 is the next bit */
+  m >>= 1;
+  result = n << 24;
+  for (bit = 1UL << 23; bit != 0U; bit >>= 1) {
+    m = (uint32_t)(((uint64_t)m * m) >> 30);
+    if (m >= 0x80000000UL) {
+      result |= (int32_t)bit;
+      m >>= 1;
+    }
+  }
+  return result;
+}
+
+/**
+  * @brief  2^f for a fraction f in [0, 1), Q24, as Q30 in [2^30, 2^31).
+  */
+static uint32_t qmath_exp2_frac(uint32_t f)
+{
+  uint32_t r = (uint32_t)QMATH_ONE_Q30;
+  uint32_t k;
+
+  for (k = 0U; k < 24U; k++) {
+    if ((f & (1UL << (23U - k))) != 0U) {
+      r = (uint32_t)(((uint64_t)r * qmath_exp2_bits[k] + (1UL << 29)) >> 30);
+    }
+  }
+  return r;
+}
+
+/**
+  * @brief  2^e for e in Q24, as Q30, for results up to 2^32.
+  */
+static int64_t qmath_pow2_q30(int32_t e)
+{
+  int32_t n = e >> 24;
+  uint32_t r = qmath_exp2_frac((uint32_t)e & 0xFFFFFFUL);
+
+  if (n >= 0) {
+    return (n > 32) ? INT64_MAX : (int64_t)r << n;
+  }
+  return (n < -31) ? 0 : (int64_t)(r >> (uint32_t)-n);
+}
+
+uint32_t qmath_exp2(int32_t x)
+{
+  int32_t n = x >> 24;
+  uint32_t r = qmath_exp2_frac((uint32_t)x & 0xFFFFFFUL);
+  uint32_t shift;
+
+  if (n >= 16) {
+    return UINT32_MAX;
+  }
+  if (n >= 14) {
+    return r << (uint32_t)(n - 14);
+  }
+  shift = (uint32_t)(14 - n);
+  return (shift >= 32U) ? 0U : (r + (1UL << (shift - 1U))) >> shift;
+}
+
+int32_t qmath_baro_altitude_cm(uint32_t pressure_pa, uint32_t p0_pa)
+{
+  int32_t d;
+  int32_t e;
+
+  if (pressure_pa == 0U || p0_pa == 0U) {
+    return INT32_MAX;
+  }
+  d = qmath_log2(pressure_pa) - qmath_log2(p0_pa);        /* log2(p / p0) */
+  if (d >= QMATH_BARO_L11_Q24) {
+    /* Troposphere: h = H1 (1 - (p / p0)^K1) */
+    e = (int32_t)(((int64_t)d * QMATH_BARO_K1_Q30) >> 30);
+    return (int32_t)((QMATH_BARO_H1_CM * (QMATH_ONE_Q30 - qmath_pow2_q30(e)) + (1L << 29)) >> 30);
+  }
+  d -= QMATH_BARO_L11_Q24;                                  /* log2(p / p11) */
+  if (d >= QMATH_BARO_L20_Q24) {
+    /* Isothermal: h = 11 km + H2 ln(p11 / p) */
+    return (int32_t)(1100000L + ((-(int64_t)d * QMATH_BARO_H2_CM + (1L << 23)) >> 24));
+  }
+  d -= QMATH_BARO_L20_Q24;                                  /* log2(p / p20) */
+  /* Warming: h = 20 km + H3 ((p / p20)^-K3 - 1) */
+  e = (int32_t)((-(int64_t)d * QMATH_BARO_K3_Q30) >> 30);
+  return (int32_t)(2000000L + ((QMATH_BARO_H3_CM * (qmath_pow2_q30(e) - QMATH_ONE_Q30) +
+                                (1L << 29)) >> 30));
+}
@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file    qmath.h
+  * @brief   Integer-only math for the FPU-less Cortex-M0+: square roots,
+  *          sine, cosine, atan2, log2 and exp2, and the barometric formula.
+  *
+  *          Any float or double pulls in libgcc's soft-float routines,
+  *          hundreds of cycles per operation. Everything here is integer
+  *          arithmetic with fixed binary points: Qn is a value times 2^n.
+  *          Angles are binary angles (BAM): a uint32_t where 2^32 is a full
+  *          turn, so they wrap the way angles do and differences of
+  *          longitudes need no reduction.
+  *
+  *          Every function states its error against the exact result. The
+  *          QMATH_*_ERR bounds are what qmath_accuracy (host build) checks
+  *          against double over dense sweeps of the input range; the 'bench'
+  *          cases qmath_* and, built with PICOAPRS_BENCH_SOFTFLOAT,
+  *          softfloat_* compare the cost on target.
+  *
+  *          Pure C, also builds on the host. There is no division by a
+  *          variable anywhere; the 64-bit products are __aeabi_lmul on the
+  *          M0+, a few dozen cycles each.
+  ******************************************************************************
+  */
+#ifndef QMATH_H
+#define QMATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define QMATH_ONE_Q30           (1L << 30)
+#define QMATH_BAM_QUARTER       0x40000000UL
+#define QMATH_BAM_HALF          0x80000000UL
+
+/* Error bounds, in units of the result's last place */
+#define QMATH_SIN_ERR           4U      /* Q30, about 4e-9 */
+#define QMATH_ATAN2_ERR         16U     /* BAM, about 2.3e-8 rad */
+#define QMATH_LOG2_ERR          2U      /* Q24, about 1.2e-7 */
+#define QMATH_EXP2_ERR          1U      /* Q16, after rounding ... */
+#define QMATH_EXP2_ERR_PPB      4U      /* ... plus this much of the result */
+#define QMATH_BARO_ERR_CM       2U      /* Against the same ISA layers in double */
+
+/* ISA sea-level pressure, Pa */
+#define QMATH_BARO_P0_PA        101325UL
+
+/**
+  * @brief  Square root, rounded down. Exact.
+  */
+uint16_t qmath_sqrt32(uint32_t x);
+uint32_t qmath_sqrt64(uint64_t x);
+
+/**
+  * @brief  Sine from a quarter-wave table of 257 points, with a third-order
+  *         Taylor step from the nearest point. Within QMATH_SIN_ERR.
+  * @param  angle: BAM
+  * @retval Q30, -2^30..2^30
+  */
+int32_t qmath_sin(uint32_t angle);
+
+/**
+  * @brief  Cosine, as qmath_sin(angle + a quarter turn).
+  */
+int32_t qmath_cos(uint32_t angle);
+
+/**
+  * @brief  Angle of the vector (x, y) by CORDIC: 30 shift-and-add
+  *         rotations, no multiplies. Within QMATH_ATAN2_ERR; 0 for (0, 0).
+  * @retval BAM, counter-clockwise from the positive x axis
+  */
+uint32_t qmath_atan2(int32_t y, int32_t x);
+
+/**
+  * @brief  Base-2 logarithm, one result bit per squaring of the mantissa.
+  *         Within QMATH_LOG2_ERR.
+  * @param  x: at least 1; a Qn input gives log2 + n
+  * @retval Q24, 0..32 << 24; INT32_MIN for 0
+  */
+int32_t qmath_log2(uint32_t x);
+
+/**
+  * @brief  2^x, one multiply by 2^(2^-k) per fraction bit. Within
+  *         QMATH_EXP2_ERR plus QMATH_EXP2_ERR_PPB.
+  * @param  x: Q24
+  * @retval Q16, saturated to UINT32_MAX at x >= 16
+  */
+uint32_t qmath_exp2(int32_t x);
+
+/**
+  * @brief  Pressure altitude in the ISA: the troposphere's lapse rate up to
+  *         11 km, isothermal to 20 km, then +1 K/km, carried on above
+  *         32 km. Within QMATH_BARO_ERR_CM of the same model in double;
+  *         the model itself is what limits it.
+  * @param  p0_pa: sea-level pressure (QNH), QMATH_BARO_P0_PA for standard
+  * @retval Centimetres above the p0_pa level
+  */
+int32_t qmath_baro_altitude_cm(uint32_t pressure_pa, uint32_t p0_pa);
+
+/**
+  * @brief  BAM to hundredths of a degree, 0..35999, rounded.
+  */
+static inline uint32_t qmath_bam_to_cdeg(uint32_t angle)
+{
+  uint32_t cdeg = (uint32_t)(((uint64_t)angle * 36000U + QMATH_BAM_HALF) >> 32);
+
+  return (cdeg == 36000U) ? 0U : cdeg;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QMATH_H */
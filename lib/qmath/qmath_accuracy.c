@@ -0,0 +1,274 @@
+/**
+  ******************************************************************************
+  * @file    qmath_accuracy.c
+  * @brief   Host build: check qmath and qgeo against double.
+  *
+  *          Sweeps each function over its input range, densely and with a
+  *          fixed pseudo-random sequence, and prints the worst error next to
+  *          the bound the header documents, in its QMATH_*_ERR or QGEO_*_ERR
+  *          or in its comment for the rounded conversions:
+  *            qmath_accuracy [samples]
+  *          The exit status is 0 if every function is within its bound.
+  ******************************************************************************
+  */
+#include "qgeo.h"
+#include "qmath.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define QMATH_ACCURACY_SAMPLES  1000000UL
+
+static uint32_t qmath_accuracy_seed = 0x12345678UL;
+static int qmath_accuracy_failed;
+
+static uint32_t qmath_accuracy_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  qmath_accuracy_seed ^= qmath_accuracy_seed << 13;
+  qmath_accuracy_seed ^= qmath_accuracy_seed >> 17;
+  qmath_accuracy_seed ^= qmath_accuracy_seed << 5;
+  return qmath_accuracy_seed;
+}
+
+static int32_t qmath_accuracy_range(int32_t lo, int32_t hi)
+{
+  return lo + (int32_t)(qmath_accuracy_rand() % (uint32_t)(hi - lo + 1));
+}
+
+static void qmath_accuracy_report(const char *name, unsigned long n, double worst,
+                                  double bound, const char *unit)
+{
+  int ok = (worst <= bound);
+
+  printf("  %-14s %9lu  worst %12.3f  bound %8.1f %-6s %s\n", name, n, worst, bound, unit,
+         ok ? "ok" : "FAIL");
+  qmath_accuracy_failed |= !ok;
+}
+
+static double qmath_accuracy_bam_rad(uint32_t angle)
+{
+  return (double)angle * (2.0 * M_PI / 4294967296.0);
+}
+
+/* Signed difference of two angles in BAM, as a double */
+static double qmath_accuracy_bam_err(uint32_t angle, double ref_rad)
+{
+  double ref = fmod(ref_rad / (2.0 * M_PI) * 4294967296.0, 4294967296.0);
+  double d = (double)angle - ref;
+
+  d = fmod(d + 6442450944.0, 4294967296.0) - 2147483648.0;
+  return fabs(d);
+}
+
+static void qmath_accuracy_sqrt(unsigned long n)
+{
+  unsigned long bad = 0UL;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    uint32_t x = (i < 65536UL) ? (uint32_t)i : qmath_accuracy_rand();
+    uint64_t x64 = ((uint64_t)qmath_accuracy_rand() << 32 | qmath_accuracy_rand()) >>
+                   (qmath_accuracy_rand() & 31U);
+    uint64_t r = qmath_sqrt32(x);
+    uint64_t r64 = qmath_sqrt64(x64);
+
+    bad += !(r * r <= x && (r + 1U) * (r + 1U) > x);
+    bad += !(r64 * r64 <= x64 && (r64 + 1U) * (r64 + 1U) > x64);
+  }
+  bad += (qmath_sqrt32(UINT32_MAX) != 65535U) + (qmath_sqrt64(UINT64_MAX) != UINT32_MAX);
+  qmath_accuracy_report("sqrt32/64", 2UL * n, (double)bad, 0.0, "wrong");
+}
+
+static void qmath_accuracy_sin(unsigned long n)
+{
+  double worst = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    uint32_t a = (i & 1UL) ? qmath_accuracy_rand() : (uint32_t)(i * (4294967296.0 / (double)n));
+    double ref = sin(qmath_accuracy_bam_rad(a)) * (double)QMATH_ONE_Q30;
+    double refc = cos(qmath_accuracy_bam_rad(a)) * (double)QMATH_ONE_Q30;
+    double e = fabs((double)qmath_sin(a) - ref);
+    double ec = fabs((double)qmath_cos(a) - refc);
+
+    worst = (e > worst) ? e : worst;
+    worst = (ec > worst) ? ec : worst;
+  }
+  qmath_accuracy_report("sin/cos", 2UL * n, worst, QMATH_SIN_ERR, "Q30");
+}
+
+static void qmath_accuracy_atan2(unsigned long n)
+{
+  double worst = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    /* Magnitudes from 1 to 2^31, so both the scaling paths are covered */
+    int32_t y = (int32_t)(qmath_accuracy_rand() >> (qmath_accuracy_rand() % 31U));
+    int32_t x = (int32_t)(qmath_accuracy_rand() >> (qmath_accuracy_rand() % 31U));
+    double e;
+
+    y = (i & 1UL) ? -y : y;
+    x = (i & 2UL) ? -x : x;
+    e = qmath_accuracy_bam_err(qmath_atan2(y, x), atan2((double)y, (double)x));
+    worst = (e > worst) ? e : worst;
+  }
+  qmath_accuracy_report("atan2", n, worst, QMATH_ATAN2_ERR, "BAM");
+}
+
+static void qmath_accuracy_log_exp(unsigned long n)
+{
+  double worst_log = 0.0;
+  double worst_exp = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    uint32_t x = (i < 65536UL) ? (uint32_t)i + 1U : qmath_accuracy_rand() | 1U;
+    int32_t e = qmath_accuracy_range(-(20 << 24), 16 << 24);
+    double el = fabs((double)qmath_log2(x) - log2((double)x) * 16777216.0);
+    double ref = exp2((double)e / 16777216.0) * 65536.0;
+    double ee = (ref >= 4294967295.0) ? 0.0 :
+                fabs((double)qmath_exp2(e) - ref) - ref * QMATH_EXP2_ERR_PPB * 1e-9;
+
+    worst_log = (el > worst_log) ? el : worst_log;
+    worst_exp = (ee > worst_exp) ? ee : worst_exp;
+  }
+  qmath_accuracy_report("log2", n, worst_log, QMATH_LOG2_ERR, "Q24");
+  qmath_accuracy_report("exp2", n, worst_exp, QMATH_EXP2_ERR, "Q16+ppb");
+}
+
+/* The ISA layers of qmath_baro_altitude_cm(), in double */
+static double qmath_accuracy_baro_ref(double p, double p0)
+{
+  const double k = 9.80665 * 0.0289644 / 8.31432;       /* g M / R, K/m */
+  double p11 = p0 * pow(216.65 / 288.15, k / 0.0065);
+  double p20 = p11 * exp(-9000.0 * k / 216.65);
+
+  if (p >= p11) {
+    return 288.15 / 0.0065 * (1.0 - pow(p / p0, 0.0065 / k));
+  }
+  if (p >= p20) {
+    return 11000.0 + 216.65 / k * log(p11 / p);
+  }
+  return 20000.0 + 216.65 / 0.001 * (pow(p / p20, -0.001 / k) - 1.0);
+}
+
+static void qmath_accuracy_baro(unsigned long n)
+{
+  double worst = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    uint32_t p = (uint32_t)qmath_accuracy_range(100, 110000);
+    uint32_t p0 = (i & 1UL) ? QMATH_BARO_P0_PA : (uint32_t)qmath_accuracy_range(95000, 105000);
+    double e = fabs((double)qmath_baro_altitude_cm(p, p0) -
+                    qmath_accuracy_baro_ref((double)p, (double)p0) * 100.0);
+
+    worst = (e > worst) ? e : worst;
+  }
+  qmath_accuracy_report("baro", n, worst, QMATH_BARO_ERR_CM, "cm");
+}
+
+static void qmath_accuracy_geo(unsigned long n)
+{
+  const double r = (double)QGEO_EARTH_RADIUS_M;
+  const double rad = M_PI / 180e7;
+  double worst_d = 0.0;
+  double worst_b = 0.0;
+  double worst_bam = 0.0;
+  double worst_dm = 0.0;
+  double worst_e7 = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    int32_t lat1 = qmath_accuracy_range(-900000000, 900000000);
+    int32_t lon1 = qmath_accuracy_range(-1800000000, 1800000000);
+    /* A quarter of the pairs close together, down to centimetres */
+    int32_t span = (int32_t)(qmath_accuracy_rand() >> (qmath_accuracy_rand() % 32U)) >> 1;
+    int32_t lat2 = (i & 3UL) ? qmath_accuracy_range(-900000000, 900000000)
+                             : lat1 + qmath_accuracy_range(-(span >> 2), span >> 2);
+    int32_t lon2 = (i & 3UL) ? qmath_accuracy_range(-1800000000, 1800000000)
+                             : lon1 + qmath_accuracy_range(-(span >> 2), span >> 2);
+    double p1;
+    double p2;
+    double dl;
+    double a;
+    double d;
+    double e;
+    qgeo_dm_t dm;
+
+    lat2 = (lat2 > 900000000) ? 900000000 : ((lat2 < -900000000) ? -900000000 : lat2);
+    p1 = lat1 * rad;
+    p2 = lat2 * rad;
+    dl = ((double)lon2 - (double)lon1) * rad;
+    a = sin((p2 - p1) / 2) * sin((p2 - p1) / 2) + cos(p1) * cos(p2) * sin(dl / 2) * sin(dl / 2);
+    d = 2.0 * r * atan2(sqrt(a), sqrt(1.0 - a));
+    e = fabs((double)qgeo_distance_m(lat1, lon1, lat2, lon2) - d);
+    worst_d = (e > worst_d) ? e : worst_d;
+
+    if (d >= QGEO_BEARING_MIN_M && labs(lat1) < 899000000L && labs(lat2) < 899000000L) {
+      double b = atan2(sin(dl) * cos(p2), cos(p1) * sin(p2) - sin(p1) * cos(p2) * cos(dl));
+      e = qmath_accuracy_bam_err(qgeo_bearing(lat1, lon1, lat2, lon2), b) * 36000.0 / 4294967296.0;
+      worst_b = (e > worst_b) ? e : worst_b;
+    }
+
+    e = qmath_accuracy_bam_err(qgeo_e7_to_bam(lon1), lon1 * rad);
+    worst_bam = (e > worst_bam) ? e : worst_bam;
+
+    /* Minutes * 1e4 in all, against the exact value; out of range is a miss */
+    qgeo_e7_to_dm(lon1, &dm);
+    e = fabs(((double)dm.deg * 600000.0 + dm.min_e4) - fabs((double)lon1) * 6e-2);
+    e = (dm.min_e4 >= 600000U || dm.negative != (lon1 < 0)) ? 1e9 : e;
+    worst_dm = (e > worst_dm) ? e : worst_dm;
+
+    dm.deg = (uint8_t)(qmath_accuracy_rand() % 180U);
+    dm.min_e4 = qmath_accuracy_rand() % 600000U;
+    dm.negative = (uint8_t)(i & 1UL);
+    e = fabs(fabs((double)qgeo_dm_to_e7(&dm)) - ((double)dm.deg + dm.min_e4 / 600000.0) * 1e7);
+    worst_e7 = (e > worst_e7) ? e : worst_e7;
+  }
+  qmath_accuracy_report("distance", n, worst_d, QGEO_DISTANCE_ERR_M, "m");
+  qmath_accuracy_report("bearing", n, worst_b, QGEO_BEARING_ERR_CDEG, "cdeg");
+  qmath_accuracy_report("e7 to BAM", n, worst_bam, 0.5, "BAM");
+  qmath_accuracy_report("e7 to deg/min", n, worst_dm, 0.5, "1e-4'");
+  qmath_accuracy_report("deg/min to e7", n, worst_e7, 0.5, "e7");
+}
+
+static void qmath_accuracy_cdeg(unsigned long n)
+{
+  double worst = 0.0;
+  unsigned long i;
+
+  for (i = 0UL; i < n; i++) {
+    uint32_t a = (i < 65536UL) ? (uint32_t)i << 16 : qmath_accuracy_rand();
+    uint32_t cdeg = qmath_bam_to_cdeg(a);
+    double e = fabs((double)cdeg - (double)a * (36000.0 / 4294967296.0));
+
+    /* Just below a full turn rounds to 0 */
+    e = (e > 35999.0) ? fabs(e - 36000.0) : e;
+    e = (cdeg >= 36000U) ? 1e9 : e;
+    worst = (e > worst) ? e : worst;
+  }
+  qmath_accuracy_report("BAM to cdeg", n, worst, 0.5, "cdeg");
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long n = (argc > 1) ? strtoul(argv[1], NULL, 10) : QMATH_ACCURACY_SAMPLES;
+
+  if (n == 0UL) {
+    fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+    return 2;
+  }
+  printf("  function         samples  worst error\n");
+  qmath_accuracy_sqrt(n);
+  qmath_accuracy_sin(n);
+  qmath_accuracy_atan2(n);
+  qmath_accuracy_log_exp(n);
+  qmath_accuracy_baro(n);
+  qmath_accuracy_geo(n);
+  qmath_accuracy_cdeg(n);
+  return qmath_accuracy_failed ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    ramfunc.h
+  * @brief   Run hot code from SRAM, clear of flash wait states.
+  *
+  *          At 16 MHz the flash needs one wait state, so every fetch that
+  *          misses the prefetch buffer stalls the M0+; SRAM never does.
+  *          RAMFUNC puts a function in the .ramfunc section, which the
+  *          linker script keeps inside .data: the startup code copies it
+  *          to SRAM along with the initialised variables, and it costs that
+  *          SRAM for good (ramfunc_bytes(), tools/ramfunc_report.sh).
+  *
+  *          Calls between flash and SRAM are out of BL range, so the linker
+  *          routes them through veneers; a RAMFUNC is never inlined into a
+  *          flash caller. Helpers it calls should be static inline so they
+  *          land in the same copy.
+  *
+  *          RAMFUNC_FLASH_COPY() gives the same function's load image in
+  *          flash, so benchmarks can run identical machine code from both
+  *          memories. Only valid for RAMFUNCs: their calls are either into
+  *          .data, which keeps its layout in the load image, or through
+  *          veneers holding absolute addresses.
+  *
+  *          Off the target there is one kind of memory: RAMFUNC is empty.
+  ******************************************************************************
+  */
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#if defined(PICOAPRS_HOST) || !defined(__arm__)
+#define RAMFUNC
+#define RAMFUNC_FLASH_COPY(fn)  (fn)
+
+static inline uint32_t ramfunc_bytes(void)
+{
+  return 0U;
+}
+#else
+#define RAMFUNC                 __attribute__((section(".ramfunc"), noinline))
+
+extern const uint8_t _sdata[];          /* .data in SRAM */
+extern const uint8_t _sidata[];         /* ... and its load image in flash */
+extern const uint8_t __ramfunc_start[];
+extern const uint8_t __ramfunc_end[];
+
+#define RAMFUNC_FLASH_COPY(fn)                                                 \
+  ((__typeof__(&(fn)))((uintptr_t)(fn) - (uintptr_t)_sdata + (uintptr_t)_sidata))
+
+/**
+  * @brief  SRAM taken by RAMFUNC code.
+  */
+static inline uint32_t ramfunc_bytes(void)
+{
+  return (uint32_t)(__ramfunc_end - __ramfunc_start);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAMFUNC_H */
@@ -0,0 +1,294 @@
+/**
+  ******************************************************************************
+  * @file    ring_buffer.h
+  * @brief   Lock-free single-producer/single-consumer byte ring buffer.
+  *
+  *          Intended for handing data from an ISR to a thread (or the other
+  *          way around) without a mutex. Exactly one context may call the
+  *          producer side (put/write/reserve/commit) and exactly one context
+  *          may call the consumer side (get/read/peek/consume).
+  *
+  *          The head index is only ever written by the producer and the tail
+  *          index only by the consumer, so a plain 32-bit load/store with
+  *          acquire/release ordering is sufficient. No read-modify-write
+  *          atomics are used, which matters on the Cortex-M0+ (ARMv6-M has
+  *          no LDREX/STREX).
+  *
+  *          Indices run freely and wrap at 2^32; the capacity must be a power
+  *          of two so that (index & mask) selects the slot and
+  *          (head - tail) is the fill level even across wrap-around.
+  ******************************************************************************
+  */
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t *buf;                 /*!< Backing storage, capacity bytes long */
+  uint32_t mask;                /*!< capacity - 1 */
+  _Atomic uint32_t head;        /*!< Next write index, owned by the producer */
+  _Atomic uint32_t tail;        /*!< Next read index, owned by the consumer */
+} ring_buffer_t;
+
+#define RING_BUFFER_IS_POW2(n)  (((n) != 0U) && ((((n) - 1U) & (n)) == 0U))
+
+/**
+  * @brief  Static initializer for a ring buffer over existing storage.
+  * @note   size must be a power of two.
+  */
+#define RING_BUFFER_INIT(storage, size) \
+  { .buf = (storage), .mask = (uint32_t)(size) - 1U, .head = 0U, .tail = 0U }
+
+/**
+  * @brief  Define a ring buffer together with its backing storage.
+  *         Capacity is checked at compile time.
+  */
+#define RING_BUFFER_DEFINE(name, size)                                         \
+  _Static_assert(RING_BUFFER_IS_POW2(size),                                    \
+                 #name " capacity must be a power of two");                    \
+  static uint8_t name##_storage[(size)];                                       \
+  ring_buffer_t name = RING_BUFFER_INIT(name##_storage, size)
+
+/**
+  * @brief  Initialize a ring buffer at runtime.
+  * @param  rb: ring buffer
+  * @param  storage: backing storage of size bytes
+  * @param  size: capacity in bytes, must be a power of two
+  * @retval 0 on success, -1 if size is not a power of two
+  */
+static inline int ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint32_t size)
+{
+  if (!RING_BUFFER_IS_POW2(size)) {
+    return -1;
+  }
+  rb->buf = storage;
+  rb->mask = size - 1U;
+  atomic_store_explicit(&rb->head, 0U, memory_order_relaxed);
+  atomic_store_explicit(&rb->tail, 0U, memory_order_relaxed);
+  return 0;
+}
+
+static inline uint32_t ring_buffer_capacity(const ring_buffer_t *rb)
+{
+  return rb->mask + 1U;
+}
+
+/**
+  * @brief  Number of bytes available to read.
+  * @note   Exact when called from the consumer, a lower bound otherwise.
+  */
+static inline uint32_t ring_buffer_used(ring_buffer_t *rb)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  return head - tail;
+}
+
+/**
+  * @brief  Number of bytes that can be written.
+  * @note   Exact when called from the producer, a lower bound otherwise.
+  */
+static inline uint32_t ring_buffer_free(ring_buffer_t *rb)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  return ring_buffer_capacity(rb) - (head - tail);
+}
+
+static inline int ring_buffer_empty(ring_buffer_t *rb)
+{
+  return ring_buffer_used(rb) == 0U;
+}
+
+/* Producer side -------------------------------------------------------------*/
+
+/**
+  * @brief  Reserve contiguous space for zero-copy writing.
+  * @param  rb: ring buffer
+  * @param  ptr: set to the first writable byte
+  * @retval Number of contiguous bytes writable at *ptr (0 if full). The caller
+  *         fills up to that many bytes and then calls ring_buffer_commit().
+  */
+static inline uint32_t ring_buffer_reserve(ring_buffer_t *rb, uint8_t **ptr)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  uint32_t free_bytes = ring_buffer_capacity(rb) - (head - tail);
+  uint32_t to_end = ring_buffer_capacity(rb) - (head & rb->mask);
+
+  *ptr = &rb->buf[head & rb->mask];
+  return (free_bytes < to_end) ? free_bytes : to_end;
+}
+
+/**
+  * @brief  Address of the slot offset bytes past the current head, for
+  *         producers that assemble a record in place before committing it.
+  * @note   The caller must have checked ring_buffer_free() first. Unlike
+  *         ring_buffer_reserve() the record may wrap, so fetch the slot for
+  *         every field rather than indexing from the first one.
+  */
+static inline uint8_t *ring_buffer_slot(ring_buffer_t *rb, uint32_t offset)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  return &rb->buf[(head + offset) & rb->mask];
+}
+
+/**
+  * @brief  Publish n bytes previously filled through ring_buffer_reserve()
+  *         or ring_buffer_slot().
+  */
+static inline void ring_buffer_commit(ring_buffer_t *rb, uint32_t n)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  atomic_store_explicit(&rb->head, head + n, memory_order_release);
+}
+
+/**
+  * @brief  Write a single byte.
+  * @retval 1 if written, 0 if the buffer was full
+  */
+static inline int ring_buffer_put(ring_buffer_t *rb, uint8_t byte)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+
+  if ((head - tail) > rb->mask) {
+    return 0;
+  }
+  rb->buf[head & rb->mask] = byte;
+  atomic_store_explicit(&rb->head, head + 1U, memory_order_release);
+  return 1;
+}
+
+/**
+  * @brief  Write up to len bytes from src.
+  * @retval Number of bytes written; less than len if the buffer filled up
+  */
+static inline uint32_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *src, uint32_t len)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  uint32_t free_bytes = ring_buffer_capacity(rb) - (head - tail);
+  uint32_t idx = head & rb->mask;
+  uint32_t first;
+
+  if (len > free_bytes) {
+    len = free_bytes;
+  }
+  first = ring_buffer_capacity(rb) - idx;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(&rb->buf[idx], src, first);
+  memcpy(rb->buf, src + first, len - first);
+  atomic_store_explicit(&rb->head, head + len, memory_order_release);
+  return len;
+}
+
+/**
+  * @brief  Write exactly len bytes or nothing.
+  * @retval 1 if written, 0 if there was not enough room
+  */
+static inline int ring_buffer_write_all(ring_buffer_t *rb, const uint8_t *src, uint32_t len)
+{
+  if (ring_buffer_free(rb) < len) {
+    return 0;
+  }
+  (void)ring_buffer_write(rb, src, len);
+  return 1;
+}
+
+/* Consumer side -------------------------------------------------------------*/
+
+/**
+  * @brief  Peek at contiguous readable data without copying.
+  * @param  rb: ring buffer
+  * @param  ptr: set to the first readable byte
+  * @retval Number of contiguous bytes readable at *ptr (0 if empty). The caller
+  *         releases them with ring_buffer_consume(). Data that wraps past the
+  *         end of storage is returned by a second peek.
+  */
+static inline uint32_t ring_buffer_peek(ring_buffer_t *rb, const uint8_t **ptr)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  uint32_t used = head - tail;
+  uint32_t to_end = ring_buffer_capacity(rb) - (tail & rb->mask);
+
+  *ptr = &rb->buf[tail & rb->mask];
+  return (used < to_end) ? used : to_end;
+}
+
+/**
+  * @brief  Release n bytes previously returned by ring_buffer_peek().
+  */
+static inline void ring_buffer_consume(ring_buffer_t *rb, uint32_t n)
+{
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  atomic_store_explicit(&rb->tail, tail + n, memory_order_release);
+}
+
+/**
+  * @brief  Read a single byte.
+  * @retval 1 if a byte was read, 0 if the buffer was empty
+  */
+static inline int ring_buffer_get(ring_buffer_t *rb, uint8_t *byte)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+
+  if (head == tail) {
+    return 0;
+  }
+  *byte = rb->buf[tail & rb->mask];
+  atomic_store_explicit(&rb->tail, tail + 1U, memory_order_release);
+  return 1;
+}
+
+/**
+  * @brief  Read up to len bytes into dst.
+  * @retval Number of bytes read
+  */
+static inline uint32_t ring_buffer_read(ring_buffer_t *rb, uint8_t *dst, uint32_t len)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  uint32_t used = head - tail;
+  uint32_t idx = tail & rb->mask;
+  uint32_t first;
+
+  if (len > used) {
+    len = used;
+  }
+  first = ring_buffer_capacity(rb) - idx;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(dst, &rb->buf[idx], first);
+  memcpy(dst + first, rb->buf, len - first);
+  atomic_store_explicit(&rb->tail, tail + len, memory_order_release);
+  return len;
+}
+
+/**
+  * @brief  Discard everything currently readable. Consumer side only.
+  */
+static inline void ring_buffer_flush(ring_buffer_t *rb)
+{
+  uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  atomic_store_explicit(&rb->tail, head, memory_order_release);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_BUFFER_H */
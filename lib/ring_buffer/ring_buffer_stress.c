@@ -0,0 +1,206 @@
+/**
+  ******************************************************************************
+  * @file    ring_buffer_stress.c
+  * @brief   Host build: a producer and a consumer thread hammer one ring
+  *          with every API pair, checking that the byte stream arrives
+  *          complete and in order, then time the bulk path.
+  *
+  *          The indices start just below 2^32 so that they wrap during the
+  *          run, and the ring has the UART RX ring's 64 bytes, so that it
+  *          is full or empty most of the time:
+  *            ring_buffer_stress [bytes]
+  *          The exit status is 0 if every pass delivered the stream intact.
+  ******************************************************************************
+  */
+#include "ring_buffer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RING_STRESS_BYTES       (16UL << 20)
+#define RING_STRESS_SIZE        64U
+#define RING_STRESS_START       0xFFFFF000UL    /* Wraps after 4 KiB */
+#define RING_STRESS_CHUNK       23U             /* Odd, so chunks straddle the end */
+#define RING_BENCH_SIZE         4096U
+
+typedef enum {
+  RING_STRESS_BYTE = 0,                 /*!< put / get */
+  RING_STRESS_BULK,                     /*!< write / read */
+  RING_STRESS_ZERO_COPY,                /*!< reserve + commit / peek + consume */
+  RING_STRESS_SLOT,                     /*!< write_all, slot + commit / read */
+  RING_STRESS_MODES
+} ring_stress_mode_t;
+
+static const char *const ring_stress_names[RING_STRESS_MODES] = {
+  "put/get", "write/read", "reserve/peek", "slot/write_all",
+};
+
+typedef struct {
+  ring_buffer_t *rb;
+  ring_stress_mode_t mode;
+  unsigned long bytes;
+  unsigned long errors;
+} ring_stress_t;
+
+/* The stream: a byte sequence that does not repeat on any ring-sized period */
+static uint8_t ring_stress_byte(unsigned long i)
+{
+  return (uint8_t)(i ^ (i >> 8) ^ (i >> 16));
+}
+
+static void *ring_stress_producer(void *arg)
+{
+  ring_stress_t *t = arg;
+  uint8_t chunk[RING_STRESS_CHUNK];
+  unsigned long sent = 0UL;
+  uint32_t n;
+  uint32_t m;
+  uint32_t i;
+  uint8_t *p;
+
+  while (sent < t->bytes) {
+    n = (t->bytes - sent < RING_STRESS_CHUNK) ? (uint32_t)(t->bytes - sent) : RING_STRESS_CHUNK;
+    n = 1U + (uint32_t)(sent % n);      /* Vary the length */
+    for (i = 0U; i < n; i++) {
+      chunk[i] = ring_stress_byte(sent + i);
+    }
+    switch (t->mode) {
+    case RING_STRESS_BYTE:
+      n = (uint32_t)ring_buffer_put(t->rb, chunk[0]);
+      break;
+    case RING_STRESS_BULK:
+      n = ring_buffer_write(t->rb, chunk, n);
+      break;
+    case RING_STRESS_ZERO_COPY:
+      m = ring_buffer_reserve(t->rb, &p);
+      n = (m < n) ? m : n;
+      memcpy(p, chunk, n);
+      ring_buffer_commit(t->rb, n);
+      break;
+    default:
+      if ((sent & 1UL) != 0UL) {
+        n = ring_buffer_write_all(t->rb, chunk, n) ? n : 0U;
+      } else if (ring_buffer_free(t->rb) >= n) {
+        for (i = 0U; i < n; i++) {
+          *ring_buffer_slot(t->rb, i) = chunk[i];
+        }
+        ring_buffer_commit(t->rb, n);
+      } else {
+        n = 0U;
+      }
+      break;
+    }
+    if (n == 0U) {
+      sched_yield();
+    }
+    sent += n;
+  }
+  return NULL;
+}
+
+static void *ring_stress_consumer(void *arg)
+{
+  ring_stress_t *t = arg;
+  uint8_t chunk[RING_STRESS_CHUNK];
+  const uint8_t *p;
+  unsigned long got = 0UL;
+  uint32_t n;
+  uint32_t i;
+
+  while (got < t->bytes) {
+    switch (t->mode) {
+    case RING_STRESS_BYTE:
+      n = (uint32_t)ring_buffer_get(t->rb, chunk);
+      break;
+    case RING_STRESS_ZERO_COPY:
+      n = ring_buffer_peek(t->rb, &p);
+      n = (n < RING_STRESS_CHUNK) ? n : RING_STRESS_CHUNK;
+      memcpy(chunk, p, n);
+      ring_buffer_consume(t->rb, n);
+      break;
+    default:
+      n = ring_buffer_read(t->rb, chunk, 1U + (uint32_t)(got % RING_STRESS_CHUNK));
+      break;
+    }
+    if (n == 0U) {
+      sched_yield();
+    }
+    for (i = 0U; i < n; i++) {
+      t->errors += (chunk[i] != ring_stress_byte(got + i));
+    }
+    got += n;
+  }
+  t->errors += !ring_buffer_empty(t->rb);
+  return NULL;
+}
+
+static void ring_stress_start(ring_buffer_t *rb, uint8_t *storage, uint32_t size)
+{
+  (void)ring_buffer_init(rb, storage, size);
+  atomic_store(&rb->head, RING_STRESS_START);
+  atomic_store(&rb->tail, RING_STRESS_START);
+}
+
+static double ring_stress_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static unsigned long ring_stress_run(ring_buffer_t *rb, ring_stress_mode_t mode, unsigned long bytes)
+{
+  ring_stress_t t = { rb, mode, bytes, 0UL };
+  pthread_t producer;
+  pthread_t consumer;
+
+  pthread_create(&consumer, NULL, ring_stress_consumer, &t);
+  pthread_create(&producer, NULL, ring_stress_producer, &t);
+  pthread_join(producer, NULL);
+  pthread_join(consumer, NULL);
+  return t.errors;
+}
+
+int main(int argc, char *argv[])
+{
+  static uint8_t storage[RING_BENCH_SIZE];
+  ring_buffer_t rb;
+  unsigned long bytes = (argc > 1) ? strtoul(argv[1], NULL, 0) : RING_STRESS_BYTES;
+  unsigned long errors;
+  unsigned long failed = 0UL;
+  double t0;
+  int mode;
+
+  if (bytes == 0UL) {
+    fprintf(stderr, "usage: %s [bytes]\n", argv[0]);
+    return 2;
+  }
+  if (ring_buffer_init(&rb, storage, 48U) == 0) {
+    fprintf(stderr, "ring_buffer_init accepted a size that is not a power of two\n");
+    failed++;
+  }
+
+  for (mode = 0; mode < RING_STRESS_MODES; mode++) {
+    ring_stress_start(&rb, storage, RING_STRESS_SIZE);
+    /* Byte at a time is slow under contention: a sixteenth of the stream */
+    errors = ring_stress_run(&rb, (ring_stress_mode_t)mode,
+                             (mode == RING_STRESS_BYTE) ? bytes / 16UL : bytes);
+    printf("  %-15s %9lu bytes  %s\n", ring_stress_names[mode],
+           (mode == RING_STRESS_BYTE) ? bytes / 16UL : bytes, (errors == 0UL) ? "ok" : "FAIL");
+    failed += errors;
+  }
+
+  /* Throughput of the bulk path, on a larger ring */
+  ring_stress_start(&rb, storage, RING_BENCH_SIZE);
+  t0 = ring_stress_now();
+  errors = ring_stress_run(&rb, RING_STRESS_BULK, bytes);
+  printf("  %-15s %9lu bytes  %.1f MB/s\n", "bulk, 4 KiB", bytes,
+         (double)bytes / (ring_stress_now() - t0) / 1e6);
+  failed += errors;
+
+  return (failed == 0UL) ? 0 : 1;
+}
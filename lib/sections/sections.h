@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    sections.h
+  * @brief   Where a buffer lives in SRAM, and what startup does to it.
+  *
+  *          The STM32U083 has 40 KB of SRAM in two banks, mapped back to
+  *          back. The linker scripts name them:
+  *            RAM   SRAM1, 32 KB  .data, .bss, .noinit, heap and stack;
+  *            RAM2  SRAM2,  8 KB  parity-checked: .dma and .trace.
+  *
+  *          With parity checking on, reading a word of SRAM2 that has not
+  *          been written since power-on raises a parity error. So only
+  *          buffers that are always written before they are read go there,
+  *          and startup neither copies nor zeroes them. Parity is kept per
+  *          byte, so byte and halfword stores are fine, but |= on a fresh
+  *          buffer is a read. What goes there:
+  *            DMA_BUFFER    DMA source or target, filled by its producer;
+  *            TRACE_BUFFER  log and trace ring storage, read only behind
+  *                          the ring's indices.
+  *          NOINIT stays in SRAM1, because its users read it first to see
+  *          whether a warm reset left something behind (lib/crash). It also
+  *          suits large buffers that need no zeroing.
+  *
+  *          The post-link report (tools/mem_report.py) prints each region's
+  *          use and the sections in it.
+  *
+  *          Off the target everything is ordinary .bss: the macros are empty.
+  ******************************************************************************
+  */
+#ifndef SECTIONS_H
+#define SECTIONS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(PICOAPRS_HOST) || !defined(__arm__)
+#define NOINIT
+#define DMA_BUFFER
+#define TRACE_BUFFER
+#else
+#define NOINIT                  __attribute__((section(".noinit")))
+#define DMA_BUFFER              __attribute__((section(".dma_buffer"), aligned(4)))
+#define TRACE_BUFFER            __attribute__((section(".trace_buffer"), aligned(4)))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECTIONS_H */
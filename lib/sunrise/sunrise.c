@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    sunrise.c
+  * @brief   Staged start-up on a marginal supply: which loads may run for
+  *          the supply voltage seen so far.
+  ******************************************************************************
+  */
+#include "sunrise.h"
+
+#define SUNRISE_MS_PER_MIN      60000L
+#define SUNRISE_MAX_STEP_MV     30000L  /* Keeps the slope product in 32 bits */
+
+static const char *const sunrise_stage_names[SUNRISE_STAGES] = { "adc", "gps", "radio" };
+static const char *const sunrise_reason_names[] = { "up", "sag", "falling" };
+
+void sunrise_init(sunrise_t *sm, const sunrise_config_t *config)
+{
+  sm->config = config;
+  sm->stage = SUNRISE_ADC_ONLY;
+  sm->primed = 0U;
+  sm->good = 0U;
+  sm->holding = 0U;
+  sm->mv = 0U;
+  sm->slope = 0;
+  sm->last_ms = 0U;
+  sm->good_ms = 0U;
+  sm->holdoff_end_ms = 0U;
+}
+
+/**
+  * @brief  Fold one sample into the filtered slope.
+  */
+static void sunrise_slope(sunrise_t *sm, uint32_t now_ms, uint16_t mv)
+{
+  uint32_t dt = now_ms - sm->last_ms;
+  int32_t step = (int32_t)mv - (int32_t)sm->mv;
+  int32_t raw;
+
+  if (dt == 0U) {
+    return;
+  }
+  if (step > SUNRISE_MAX_STEP_MV) {
+    step = SUNRISE_MAX_STEP_MV;
+  } else if (step < -SUNRISE_MAX_STEP_MV) {
+    step = -SUNRISE_MAX_STEP_MV;
+  }
+  raw = (step * SUNRISE_MS_PER_MIN) / (int32_t)((dt > INT32_MAX) ? INT32_MAX : dt);
+  sm->slope += (raw - sm->slope) / (1 << SUNRISE_SLOPE_SHIFT);
+}
+
+static int sunrise_move(sunrise_t *sm, uint32_t now_ms, uint8_t to, uint8_t reason,
+                        sunrise_transition_t *tr)
+{
+  tr->time_ms = now_ms;
+  tr->mv = sm->mv;
+  tr->slope = (int16_t)((sm->slope > INT16_MAX) ? INT16_MAX :
+                        (sm->slope < INT16_MIN) ? INT16_MIN : sm->slope);
+  tr->from = sm->stage;
+  tr->to = to;
+  tr->reason = reason;
+  sm->stage = to;
+  sm->good = 0U;
+  if (reason != SUNRISE_REASON_UP) {
+    sm->holding = 1U;
+    sm->holdoff_end_ms = now_ms + sm->config->holdoff_ms;
+  }
+  return 1;
+}
+
+int sunrise_step(sunrise_t *sm, uint32_t now_ms, uint16_t mv, sunrise_transition_t *tr)
+{
+  const sunrise_config_t *cfg = sm->config;
+  uint8_t stage = sm->stage;
+
+  if (sm->primed) {
+    sunrise_slope(sm, now_ms, mv);
+  }
+  sm->primed = 1U;
+  sm->mv = mv;
+  sm->last_ms = now_ms;
+
+  if (sm->holding && (int32_t)(now_ms - sm->holdoff_end_ms) >= 0) {
+    sm->holding = 0U;
+  }
+
+  /* Down first: every stage whose floor the sample is under, at once */
+  if (stage > SUNRISE_ADC_ONLY && mv < cfg->down_mv[stage]) {
+    while (stage > SUNRISE_ADC_ONLY && mv < cfg->down_mv[stage]) {
+      stage--;
+    }
+    return sunrise_move(sm, now_ms, stage, SUNRISE_REASON_SAG, tr);
+  }
+  if (stage > SUNRISE_ADC_ONLY && sm->slope < cfg->down_slope) {
+    return sunrise_move(sm, now_ms, (uint8_t)(stage - 1U), SUNRISE_REASON_FALLING, tr);
+  }
+
+  if (stage + 1U >= SUNRISE_STAGES || sm->holding ||
+      mv < cfg->up_mv[stage + 1U] || sm->slope < cfg->up_slope) {
+    sm->good = 0U;
+    return 0;
+  }
+  if (!sm->good) {
+    sm->good = 1U;
+    sm->good_ms = now_ms;
+  }
+  if (now_ms - sm->good_ms < cfg->dwell_ms) {
+    return 0;
+  }
+  return sunrise_move(sm, now_ms, (uint8_t)(stage + 1U), SUNRISE_REASON_UP, tr);
+}
+
+const char *sunrise_stage_name(uint8_t stage)
+{
+  return (stage < SUNRISE_STAGES) ? sunrise_stage_names[stage] : "?";
+}
+
+const char *sunrise_reason_name(uint8_t reason)
+{
+  return (reason < sizeof(sunrise_reason_names) / sizeof(sunrise_reason_names[0])) ?
+         sunrise_reason_names[reason] : "?";
+}
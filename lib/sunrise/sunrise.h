@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * @file    sunrise.h
+  * @brief   Staged start-up on a marginal supply: which loads may run for
+  *          the supply voltage seen so far.
+  *
+  *          Three stages, each adding a load to the one before:
+  *            SUNRISE_ADC_ONLY  minimum clock, supply sampling only;
+  *            SUNRISE_GPS       the GPS receiver is powered;
+  *            SUNRISE_RADIO     the radio may key up, SYSCLK at full speed.
+  *          Stepping up takes the next stage's voltage and a slope of at
+  *          least up_slope, both held for dwell_ms. Stepping down happens on
+  *          the first sample that sags below a stage's floor, as many
+  *          stages as it takes, or one stage if the voltage falls faster
+  *          than down_slope. After a step down nothing steps up again for
+  *          holdoff_ms, so a cloud does not make the loads cycle.
+  *
+  *          The slope is the change between samples in mV per minute,
+  *          low-pass filtered. Samples may come at any interval; time is
+  *          milliseconds, wrapping.
+  *
+  *          Pure C, no HAL or kernel: sunrise_service.c feeds it from the
+  *          ADC service on target, and sunrise_replay (host build) feeds it
+  *          a recorded trace.
+  ******************************************************************************
+  */
+#ifndef SUNRISE_H
+#define SUNRISE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SUNRISE_SLOPE_SHIFT     2U      /* Each sample moves 1/4 of the way */
+
+typedef enum {
+  SUNRISE_ADC_ONLY = 0,
+  SUNRISE_GPS,
+  SUNRISE_RADIO,
+  SUNRISE_STAGES
+} sunrise_stage_t;
+
+typedef enum {
+  SUNRISE_REASON_UP = 0,                /*!< Voltage and slope held long enough */
+  SUNRISE_REASON_SAG,                   /*!< Below the stage's floor */
+  SUNRISE_REASON_FALLING,               /*!< Slope below down_slope */
+} sunrise_reason_t;
+
+typedef struct {
+  uint16_t up_mv[SUNRISE_STAGES];       /*!< To enter a stage; [0] unused */
+  uint16_t down_mv[SUNRISE_STAGES];     /*!< Leave a stage below; [0] unused */
+  int16_t up_slope;                     /*!< mV/min, at least, to step up */
+  int16_t down_slope;                   /*!< mV/min, below which to step down */
+  uint32_t dwell_ms;                    /*!< How long step-up conditions must hold */
+  uint32_t holdoff_ms;                  /*!< No step up for this long after a step down */
+} sunrise_config_t;
+
+/* For a part running straight off the panel and its buffer capacitor */
+#define SUNRISE_CONFIG_DEFAULT                                                 \
+  {                                                                            \
+    { 0U, 3000U, 3200U },                                                      \
+    { 0U, 2700U, 2900U },                                                      \
+    -20, -300, 20000UL, 120000UL,                                              \
+  }
+
+typedef struct {
+  uint32_t time_ms;
+  uint16_t mv;
+  int16_t slope;                        /*!< mV/min at the time */
+  uint8_t from;                         /*!< sunrise_stage_t */
+  uint8_t to;
+  uint8_t reason;                       /*!< sunrise_reason_t */
+} sunrise_transition_t;
+
+typedef struct {
+  const sunrise_config_t *config;
+  uint8_t stage;                        /*!< sunrise_stage_t */
+  uint8_t primed;                       /*!< A sample has been seen */
+  uint8_t good;                         /*!< Step-up conditions hold since good_ms */
+  uint8_t holding;                      /*!< Held off until holdoff_end_ms */
+  uint16_t mv;
+  int32_t slope;
+  uint32_t last_ms;
+  uint32_t good_ms;
+  uint32_t holdoff_end_ms;
+} sunrise_t;
+
+/**
+  * @brief  Start in SUNRISE_ADC_ONLY.
+  * @param  config: kept by reference
+  */
+void sunrise_init(sunrise_t *sm, const sunrise_config_t *config);
+
+/**
+  * @brief  Feed one supply sample.
+  * @param  tr: filled in on a change of stage
+  * @retval 1 if the stage changed, 0 otherwise
+  */
+int sunrise_step(sunrise_t *sm, uint32_t now_ms, uint16_t mv, sunrise_transition_t *tr);
+
+const char *sunrise_stage_name(uint8_t stage);
+const char *sunrise_reason_name(uint8_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUNRISE_H */
@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    sunrise_replay.c
+  * @brief   Host build: run the sunrise state machine over a recorded supply
+  *          trace and print its transitions.
+  *
+  *          The trace comes from the file named, or stdin, one "<ms>,<mV>"
+  *          sample per line; blank lines and lines starting with '#' are
+  *          skipped. Options override SUNRISE_CONFIG_DEFAULT, to try
+  *          thresholds out before building them in:
+  *            sunrise_replay [-g up:down] [-r up:down] [-s up:down]
+  *                           [-d dwell_ms] [-h holdoff_ms] [-n transitions]
+  *                           [trace.csv]
+  *          -g and -r are the GPS and radio stage voltages in mV, -s the
+  *          slopes in mV/min. The exit status is 0 if the trace ends with
+  *          the radio stage reached, after exactly -n transitions if given;
+  *          ctest runs it so over sunrise_dawn.csv.
+  ******************************************************************************
+  */
+#include "sunrise.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SUNRISE_REPLAY_LINE     128U
+
+static int sunrise_replay_pair(const char *arg, long *a, long *b)
+{
+  return (sscanf(arg, "%ld:%ld", a, b) == 2) ? 0 : -1;
+}
+
+static void sunrise_replay_usage(const char *argv0)
+{
+  fprintf(stderr, "usage: %s [-g up:down] [-r up:down] [-s up:down] [-d dwell_ms] "
+          "[-h holdoff_ms] [-n transitions] [trace.csv]\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+  sunrise_config_t config = SUNRISE_CONFIG_DEFAULT;
+  uint32_t in_stage[SUNRISE_STAGES] = { 0U };
+  char line[SUNRISE_REPLAY_LINE];
+  sunrise_transition_t tr;
+  sunrise_t sm;
+  unsigned long ms;
+  unsigned long prev_ms = 0UL;
+  unsigned long mv;
+  unsigned long samples = 0UL;
+  unsigned long transitions = 0UL;
+  long expected = -1L;
+  FILE *in = stdin;
+  long a;
+  long b;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "g:r:s:d:h:n:")) != -1) {
+    switch (opt) {
+    case 'g':
+    case 'r':
+      if (sunrise_replay_pair(optarg, &a, &b) != 0) {
+        sunrise_replay_usage(argv[0]);
+      }
+      i = (opt == 'g') ? SUNRISE_GPS : SUNRISE_RADIO;
+      config.up_mv[i] = (uint16_t)a;
+      config.down_mv[i] = (uint16_t)b;
+      break;
+    case 's':
+      if (sunrise_replay_pair(optarg, &a, &b) != 0) {
+        sunrise_replay_usage(argv[0]);
+      }
+      config.up_slope = (int16_t)a;
+      config.down_slope = (int16_t)b;
+      break;
+    case 'd':
+      config.dwell_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'h':
+      config.holdoff_ms = (uint32_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      expected = strtol(optarg, NULL, 10);
+      break;
+    default:
+      sunrise_replay_usage(argv[0]);
+    }
+  }
+  if (optind < argc) {
+    in = fopen(argv[optind], "r");
+    if (in == NULL) {
+      perror(argv[optind]);
+      return 2;
+    }
+  }
+
+  sunrise_init(&sm, &config);
+  while (fgets(line, sizeof(line), in) != NULL) {
+    if (line[0] == '#' || sscanf(line, "%lu,%lu", &ms, &mv) != 2) {
+      continue;
+    }
+    if (samples > 0UL) {
+      in_stage[sm.stage] += (uint32_t)(ms - prev_ms);
+    }
+    prev_ms = ms;
+    samples++;
+    if (sunrise_step(&sm, (uint32_t)ms, (uint16_t)mv, &tr)) {
+      printf("%8lu.%03lu s  %-5s -> %-5s %-7s %5u mV %6d mV/min\n",
+             (unsigned long)(tr.time_ms / 1000U), (unsigned long)(tr.time_ms % 1000U),
+             sunrise_stage_name(tr.from), sunrise_stage_name(tr.to),
+             sunrise_reason_name(tr.reason), tr.mv, tr.slope);
+      transitions++;
+    }
+  }
+
+  printf("%lu samples, %lu transitions, ends in %s\n", samples, transitions,
+         sunrise_stage_name(sm.stage));
+  for (i = 0; i < SUNRISE_STAGES; i++) {
+    printf("  %-5s %8lu s\n", sunrise_stage_name((uint8_t)i),
+           (unsigned long)(in_stage[i] / 1000U));
+  }
+  return (sm.stage == SUNRISE_RADIO &&
+          (expected < 0L || transitions == (unsigned long)expected)) ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/**
+  ******************************************************************************
+  * @file    sunrise_service.c
+  * @brief   Staged start-up, applied to the clock and the loads.
+  ******************************************************************************
+  */
+#include "sunrise_service.h"
+#include "adc_service.h"
+#include "clock.h"
+#include "console.h"
+#include "dlog.h"
+#include "watchdog.h"
+
+#include <stdio.h>
+
+static const sunrise_config_t sunrise_config = SUNRISE_CONFIG_DEFAULT;
+
+static const clock_level_t sunrise_levels[SUNRISE_STAGES] = {
+  CLOCK_LEVEL_MIN, CLOCK_LEVEL_LOW, CLOCK_LEVEL_HIGH,
+};
+
+static TX_THREAD sunrise_thread;
+static watchdog_handle_t sunrise_wdg;
+static sunrise_t sunrise_sm;
+static volatile uint8_t sunrise_stage_now;
+static sunrise_transition_t sunrise_history[SUNRISE_HISTORY];
+static uint32_t sunrise_transitions;        /* Total, the newest at (n - 1) % SUNRISE_HISTORY */
+
+static void sunrise_thread_entry(ULONG thread_input);
+
+__weak void sunrise_gps_power(int on)
+{
+  (void)on;
+}
+
+__weak void sunrise_radio_power(int on)
+{
+  (void)on;
+}
+
+UINT sunrise_service_init(TX_BYTE_POOL *byte_pool)
+{
+  CHAR *pointer;
+  UINT ret;
+
+  sunrise_init(&sunrise_sm, &sunrise_config);
+  ret = tx_byte_allocate(byte_pool, (VOID **)&pointer, SUNRISE_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  ret = tx_thread_create(&sunrise_thread, "Sunrise", sunrise_thread_entry, 0,
+                         pointer, SUNRISE_THREAD_STACK_SIZE,
+                         SUNRISE_THREAD_PRIORITY, SUNRISE_THREAD_PRIORITY,
+                         TX_NO_TIME_SLICE, TX_AUTO_START);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  sunrise_wdg = watchdog_register(&sunrise_thread, 2U * ADC_SERVICE_PERIOD);
+  return (sunrise_wdg != NULL) ? TX_SUCCESS : TX_NO_INSTANCE;
+}
+
+sunrise_stage_t sunrise_service_stage(void)
+{
+  return (sunrise_stage_t)sunrise_stage_now;
+}
+
+uint32_t sunrise_service_history(sunrise_transition_t *out, uint32_t max)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t total;
+  uint32_t n;
+  uint32_t i;
+
+  TX_DISABLE
+  total = sunrise_transitions;
+  n = (total < SUNRISE_HISTORY) ? total : SUNRISE_HISTORY;
+  n = (n < max) ? n : max;
+  for (i = 0U; i < n; i++) {
+    out[i] = sunrise_history[(total - n + i) % SUNRISE_HISTORY];
+  }
+  TX_RESTORE
+  return n;
+}
+
+/**
+  * @brief  Switch loads and clock from one stage to another: loads on after
+  *         the clock goes up, off before it comes down.
+  */
+static void sunrise_apply(const sunrise_transition_t *tr)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint8_t stage;
+
+  clock_request(sunrise_levels[tr->to]);
+  for (stage = tr->from; stage > tr->to; stage--) {
+    if (stage == SUNRISE_RADIO) {
+      sunrise_radio_power(0);
+    } else if (stage == SUNRISE_GPS) {
+      sunrise_gps_power(0);
+    }
+  }
+  for (stage = (uint8_t)(tr->from + 1U); stage <= tr->to; stage++) {
+    if (stage == SUNRISE_GPS) {
+      sunrise_gps_power(1);
+    } else if (stage == SUNRISE_RADIO) {
+      sunrise_radio_power(1);
+    }
+  }
+  clock_release(sunrise_levels[tr->from]);
+
+  TX_DISABLE
+  sunrise_history[sunrise_transitions % SUNRISE_HISTORY] = *tr;
+  sunrise_transitions++;
+  sunrise_stage_now = tr->to;
+  TX_RESTORE
+  DLOG_INFO("sunrise: stage %u -> %u (reason %u) at %u mV, %d mV/min",
+            tr->from, tr->to, tr->reason, tr->mv, (int32_t)tr->slope);
+}
+
+static void sunrise_thread_entry(ULONG thread_input)
+{
+  sunrise_transition_t tr;
+  adc_readings_t readings;
+  ULONG last = 0U;
+  (void)thread_input;
+
+  clock_request(sunrise_levels[SUNRISE_ADC_ONLY]);
+  for (;;) {
+    watchdog_checkin(sunrise_wdg);
+    /* One step per ADC scan, whenever it lands */
+    if (adc_service_get(&readings) && readings.time != last) {
+      last = readings.time;
+      if (sunrise_step(&sunrise_sm, (uint32_t)readings.time * (1000U / TX_TIMER_TICKS_PER_SECOND),
+                       readings.vdda_mv, &tr)) {
+        sunrise_apply(&tr);
+      }
+    }
+    tx_thread_sleep(ADC_SERVICE_PERIOD / 4U);
+  }
+}
+
+/**
+  * @brief  'sunrise' console command: stage, supply, and the transitions
+  *         kept for telemetry.
+  */
+static int console_cmd_sunrise(int argc, char *argv[])
+{
+  sunrise_transition_t history[SUNRISE_HISTORY];
+  sunrise_transition_t *tr;
+  uint32_t n;
+  uint32_t i;
+  (void)argc;
+  (void)argv;
+
+  printf("  stage %s, %u mV, %ld mV/min%s\n", sunrise_stage_name(sunrise_stage_now),
+         sunrise_sm.mv, (long)sunrise_sm.slope, sunrise_sm.holding ? ", held off" : "");
+  n = sunrise_service_history(history, SUNRISE_HISTORY);
+  for (i = 0U; i < n; i++) {
+    tr = &history[i];
+    printf("  %8lu.%03lu s  %-5s -> %-5s %-7s %5u mV %6ld mV/min\n",
+           (unsigned long)(tr->time_ms / 1000U), (unsigned long)(tr->time_ms % 1000U),
+           sunrise_stage_name(tr->from), sunrise_stage_name(tr->to),
+           sunrise_reason_name(tr->reason), tr->mv, (long)tr->slope);
+  }
+  printf("  %lu transitions\n", (unsigned long)sunrise_transitions);
+  return 0;
+}
+
+CONSOLE_COMMAND(sunrise, "staged start-up: supply stage and transitions", console_cmd_sunrise, NULL);
@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    sunrise_service.h
+  * @brief   Staged start-up, applied: a thread that feeds each ADC scan of
+  *          VDDA to the sunrise state machine and switches loads and clock
+  *          level with its stage.
+  *
+  *          Each stage holds one clock request, CLOCK_LEVEL_MIN to
+  *          CLOCK_LEVEL_HIGH, and powers its loads through weak hooks the
+  *          GPS and radio drivers override. Loads go on after the clock
+  *          goes up and off before it comes down. The last
+  *          SUNRISE_HISTORY transitions are kept for telemetry, and each
+  *          one is logged; the `sunrise` command shows both.
+  ******************************************************************************
+  */
+#ifndef SUNRISE_SERVICE_H
+#define SUNRISE_SERVICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+#include "sunrise.h"
+
+#define SUNRISE_THREAD_STACK_SIZE   512U
+#define SUNRISE_THREAD_PRIORITY     14U     /* Just above the ADC service */
+#define SUNRISE_HISTORY             8U
+
+/**
+  * @brief  Create the thread, in SUNRISE_ADC_ONLY with every load off.
+  * @param  byte_pool: pool for the thread stack
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT sunrise_service_init(TX_BYTE_POOL *byte_pool);
+
+/**
+  * @brief  Stage in effect: loads may only run if it includes them.
+  */
+sunrise_stage_t sunrise_service_stage(void);
+
+/**
+  * @brief  Transitions so far, oldest first, at most SUNRISE_HISTORY.
+  * @retval Number copied to out
+  */
+uint32_t sunrise_service_history(sunrise_transition_t *out, uint32_t max);
+
+/**
+  * @brief  Load hooks, called from the sunrise thread. The defaults do
+  *         nothing.
+  */
+void sunrise_gps_power(int on);
+void sunrise_radio_power(int on);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUNRISE_SERVICE_H */
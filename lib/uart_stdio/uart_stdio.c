@@ -0,0 +1,170 @@
+/**
+  ******************************************************************************
+  * @file    uart_stdio.c
+  * @brief   Per-thread line-buffered streams behind _write().
+  ******************************************************************************
+  */
+#include "uart_stdio.h"
+#include "uart_stdio_internal.h"
+#include "uart_tx.h"
+
+static uart_stdio_stream_t uart_stdio_streams[UART_STDIO_STREAMS];
+static UART_HandleTypeDef *uart_stdio_huart;
+
+void uart_stdio_init(UART_HandleTypeDef *huart)
+{
+  uart_stdio_huart = huart;
+}
+
+static void uart_stdio_stream_flush(uart_stdio_stream_t *stream)
+{
+  if (stream->len == 0U) {
+    return;
+  }
+  if (stream->owner != NULL) {
+    (void)uart_tx_write((const uint8_t *)stream->buf, stream->len, TX_WAIT_FOREVER);
+  } else if (uart_stdio_huart != NULL) {
+    /* Kernel not running yet: nothing to serialize against */
+    (void)HAL_UART_Transmit(uart_stdio_huart, (const uint8_t *)stream->buf, stream->len,
+                            HAL_MAX_DELAY);
+  }
+  stream->len = 0U;
+}
+
+/* A thread that is gone leaves its slot, and any partial line in it, behind */
+static int uart_stdio_owner_gone(TX_THREAD *owner)
+{
+  UINT state;
+
+  if (tx_thread_info_get(owner, TX_NULL, &state, TX_NULL, TX_NULL, TX_NULL, TX_NULL,
+                         TX_NULL, TX_NULL) != TX_SUCCESS) {
+    return 1;
+  }
+  return (state == TX_COMPLETED || state == TX_TERMINATED);
+}
+
+/* The thread's own slot, or a free one, or one a finished thread left */
+static uart_stdio_stream_t *uart_stdio_stream_find(TX_THREAD *self)
+{
+  uart_stdio_stream_t *stream;
+  uart_stdio_stream_t *free_slot = NULL;
+  uint32_t i;
+
+  for (i = 0; i < UART_STDIO_STREAMS; i++) {
+    stream = &uart_stdio_streams[i];
+    if (stream->owner == self) {
+      return stream;
+    }
+    if (free_slot == NULL && (stream->owner == NULL || uart_stdio_owner_gone(stream->owner))) {
+      free_slot = stream;
+    }
+  }
+  if (free_slot != NULL) {
+    uart_stdio_stream_flush(free_slot);
+    free_slot->owner = self;
+    free_slot->scoped = 0U;
+  }
+  return free_slot;
+}
+
+uart_stdio_stream_t *uart_stdio_stream_get(uart_stdio_stream_t *scratch)
+{
+  TX_THREAD *self;
+  uart_stdio_stream_t *stream;
+
+  if (__get_IPSR() != 0U) {
+    return NULL;
+  }
+
+  self = tx_thread_identify();
+  if (self != NULL) {
+    /* Held until uart_stdio_stream_put(). Every stream is only touched
+     * under it, so uart_stdio_poll() can flush any thread's partial line. */
+    (void)uart_tx_lock(TX_WAIT_FOREVER);
+    stream = uart_stdio_stream_find(self);
+    if (stream != NULL) {
+      return stream;
+    }
+  }
+
+  /* Pre-kernel or out of slots: buffer for the duration of this call only */
+  scratch->owner = self;
+  scratch->len = 0U;
+  scratch->scoped = 1U;
+  return scratch;
+}
+
+void uart_stdio_putc(void *ctx, char c)
+{
+  uart_stdio_stream_t *stream = (uart_stdio_stream_t *)ctx;
+
+  if (stream->len == 0U) {
+    stream->since = tx_time_get();
+  }
+  stream->buf[stream->len++] = c;
+  if (c == '\n' || stream->len == UART_STDIO_LINE_SIZE) {
+    uart_stdio_stream_flush(stream);
+  }
+}
+
+void uart_stdio_stream_put(uart_stdio_stream_t *stream)
+{
+  if (stream->scoped) {
+    uart_stdio_stream_flush(stream);
+  }
+  if (stream->owner != NULL) {
+    uart_tx_unlock();
+  }
+}
+
+void uart_stdio_flush(void)
+{
+  uart_stdio_stream_t scratch;
+  uart_stdio_stream_t *stream = uart_stdio_stream_get(&scratch);
+
+  if (stream != NULL) {
+    uart_stdio_stream_flush(stream);
+    uart_stdio_stream_put(stream);
+  }
+}
+
+void uart_stdio_poll(void)
+{
+  uart_stdio_stream_t *stream;
+  ULONG now;
+  uint32_t i;
+
+  if (uart_tx_lock(TX_WAIT_FOREVER) != TX_SUCCESS) {
+    return;
+  }
+  now = tx_time_get();
+  for (i = 0; i < UART_STDIO_STREAMS; i++) {
+    stream = &uart_stdio_streams[i];
+    if (stream->len != 0U && (now - stream->since >= UART_STDIO_FLUSH_TICKS ||
+                              uart_stdio_owner_gone(stream->owner))) {
+      uart_stdio_stream_flush(stream);
+    }
+  }
+  uart_tx_unlock();
+}
+
+/**
+  * @brief  newlib low level write, overriding the weak stub in syscalls.c.
+  */
+int _write(int file, char *ptr, int len)
+{
+  uart_stdio_stream_t scratch;
+  uart_stdio_stream_t *stream;
+  int i;
+  (void)file;
+
+  stream = uart_stdio_stream_get(&scratch);
+  if (stream == NULL) {
+    return len;
+  }
+  for (i = 0; i < len; i++) {
+    uart_stdio_putc(stream, ptr[i]);
+  }
+  uart_stdio_stream_put(stream);
+  return len;
+}
@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    uart_stdio.h
+  * @brief   Retargeted, reentrant stdio over the DMA UART path.
+  *
+  *          Linking this module replaces newlib's printf family with the
+  *          integer-only formatter in lib/fmt and routes _write() through
+  *          line-buffered per-thread streams. Each flush is a single
+  *          uart_tx_write(), so lines from concurrent threads never
+  *          interleave.
+  *
+  *          Stream buffers come from a fixed table and are claimed by a
+  *          thread on its first output; once the table is exhausted further
+  *          threads write unbuffered, one call at a time. A partial line
+  *          goes out once it is UART_STDIO_FLUSH_TICKS old, or once its
+  *          thread has finished, at the next uart_stdio_poll(); the slot of
+  *          a finished thread goes to the next thread that needs one. The
+  *          buffers are only touched under uart_tx_lock(), which a stdio
+  *          call holds while it formats. Output from ISRs is
+  *          dropped (use lib/dlog there); output before the kernel starts is
+  *          sent with polled HAL_UART_Transmit().
+  ******************************************************************************
+  */
+#ifndef UART_STDIO_H
+#define UART_STDIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+
+#define UART_STDIO_STREAMS       4U    /* threads with a private line buffer */
+#define UART_STDIO_LINE_SIZE     80U   /* bytes buffered per thread */
+#define UART_STDIO_FLUSH_TICKS   25U   /* ticks a partial line is held at most */
+
+/**
+  * @brief  Select the UART used before the kernel is running. The threaded
+  *         path always goes through uart_tx.
+  */
+void uart_stdio_init(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  Push out the calling thread's partial line, if any.
+  */
+void uart_stdio_flush(void);
+
+/**
+  * @brief  Push out every thread's partial line that has waited
+  *         UART_STDIO_FLUSH_TICKS, or whose thread has finished. Call it
+  *         periodically from a thread, e.g. the console's idle wakeup.
+  */
+void uart_stdio_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_STDIO_H */
@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file    uart_stdio_internal.h
+  * @brief   Stream plumbing shared by uart_stdio.c and uart_stdio_printf.c.
+  ******************************************************************************
+  */
+#ifndef UART_STDIO_INTERNAL_H
+#define UART_STDIO_INTERNAL_H
+
+#include "uart_stdio.h"
+#include "tx_api.h"
+
+typedef struct {
+  TX_THREAD *owner;       /*!< NULL before the kernel runs */
+  uint8_t scoped;         /*!< Stack scratch stream, flushed at end of call */
+  uint16_t len;
+  ULONG since;            /*!< Tick the partial line in buf was started */
+  char buf[UART_STDIO_LINE_SIZE];
+} uart_stdio_stream_t;
+
+/**
+  * @brief  Stream for the calling context: the thread's own slot, or scratch
+  *         initialized as a call-scoped stream. NULL in ISR context. From a
+  *         thread, holds the UART TX lock until uart_stdio_stream_put().
+  */
+uart_stdio_stream_t *uart_stdio_stream_get(uart_stdio_stream_t *scratch);
+
+/**
+  * @brief  End of a stdio call: flushes call-scoped streams and releases
+  *         the lock uart_stdio_stream_get() took.
+  */
+void uart_stdio_stream_put(uart_stdio_stream_t *stream);
+
+/**
+  * @brief  fmt_putc_t sink appending to a stream, flushing on '\n' or full.
+  */
+void uart_stdio_putc(void *ctx, char c);
+
+#endif /* UART_STDIO_INTERNAL_H */
@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    uart_stdio_printf.c
+  * @brief   printf family on top of lib/fmt, replacing newlib's formatter.
+  *
+  *          Strong definitions here win over libc.a at link time, so
+  *          newlib's vfprintf and its heap-backed FILE machinery are never
+  *          pulled in. GCC also rewrites some printf calls into puts() and
+  *          putchar(), which is why those are provided as well.
+  *          Left out of the build with -DPICOAPRS_NEWLIB_STDIO=ON to measure
+  *          the difference (tools/stdio_size_report.sh).
+  ******************************************************************************
+  */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fmt.h"
+#include "uart_stdio_internal.h"
+
+#undef putchar
+
+int vprintf(const char *fmt, va_list ap)
+{
+  uart_stdio_stream_t scratch;
+  uart_stdio_stream_t *stream = uart_stdio_stream_get(&scratch);
+  int n;
+
+  if (stream == NULL) {
+    return 0;
+  }
+  n = fmt_vformat(uart_stdio_putc, stream, fmt, ap);
+  uart_stdio_stream_put(stream);
+  return n;
+}
+
+int printf(const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int puts(const char *s)
+{
+  uart_stdio_stream_t scratch;
+  uart_stdio_stream_t *stream = uart_stdio_stream_get(&scratch);
+
+  if (stream == NULL) {
+    return 0;
+  }
+  while (*s != '\0') {
+    uart_stdio_putc(stream, *s++);
+  }
+  uart_stdio_putc(stream, '\n');
+  uart_stdio_stream_put(stream);
+  return 1;
+}
+
+int putchar(int c)
+{
+  uart_stdio_stream_t scratch;
+  uart_stdio_stream_t *stream = uart_stdio_stream_get(&scratch);
+
+  if (stream != NULL) {
+    uart_stdio_putc(stream, (char)c);
+    uart_stdio_stream_put(stream);
+  }
+  return (unsigned char)c;
+}
+
+int vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+  return fmt_vsnprintf(buf, size, fmt, ap);
+}
+
+int snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = fmt_vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int vsprintf(char *buf, const char *fmt, va_list ap)
+{
+  return fmt_vsnprintf(buf, SIZE_MAX, fmt, ap);
+}
+
+int sprintf(char *buf, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = fmt_vsnprintf(buf, SIZE_MAX, fmt, ap);
+  va_end(ap);
+  return n;
+}
@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    uart_tx.c
+  * @brief   Thread-safe DMA transmit path for the console UART.
+  ******************************************************************************
+  */
+#include "uart_tx.h"
+
+static UART_HandleTypeDef *uart_tx_huart;
+static TX_MUTEX uart_tx_mutex;
+static TX_SEMAPHORE uart_tx_done;
+
+UINT uart_tx_init(UART_HandleTypeDef *huart)
+{
+  UINT status;
+
+  uart_tx_huart = huart;
+
+  status = tx_mutex_create(&uart_tx_mutex, "UART TX Mutex", TX_INHERIT);
+  if (status != TX_SUCCESS) {
+    return status;
+  }
+  return tx_semaphore_create(&uart_tx_done, "UART TX Done", 0);
+}
+
+/* Twice the time on the wire at the current baud rate, and the margin */
+static ULONG uart_tx_timeout(uint16_t len)
+{
+  uint32_t baud = uart_tx_huart->Init.BaudRate;
+
+  return (ULONG)(((uint32_t)len * 20U * TX_TIMER_TICKS_PER_SECOND + baud - 1U) / baud) +
+         UART_TX_TIMEOUT_MARGIN_TICKS;
+}
+
+/* Take back a completion left over from an aborted transfer, which would
+ * otherwise end the next writer's wait before its bytes are out */
+static void uart_tx_drain(void)
+{
+  while (tx_semaphore_get(&uart_tx_done, TX_NO_WAIT) == TX_SUCCESS) {
+  }
+}
+
+UINT uart_tx_write(const uint8_t *data, uint16_t len, ULONG wait_option)
+{
+  UINT status;
+
+  if (len == 0U) {
+    return TX_SUCCESS;
+  }
+
+  status = tx_mutex_get(&uart_tx_mutex, wait_option);
+  if (status != TX_SUCCESS) {
+    return status;
+  }
+
+  uart_tx_drain();
+  if (HAL_UART_Transmit_DMA(uart_tx_huart, data, len) != HAL_OK) {
+    status = TX_NOT_DONE;
+  } else if (tx_semaphore_get(&uart_tx_done, uart_tx_timeout(len)) != TX_SUCCESS) {
+    /* Lost completion (e.g. DMA error); stop the channel so that it cannot
+     * read data after we return, and free the UART for the next writer. A
+     * completion that raced the abort is drained before the next transfer. */
+    HAL_UART_AbortTransmit(uart_tx_huart);
+    uart_tx_drain();
+    status = TX_NOT_DONE;
+  }
+
+  tx_mutex_put(&uart_tx_mutex);
+  return status;
+}
+
+UINT uart_tx_lock(ULONG wait_option)
+{
+  /* Writers hold the mutex until their last stop bit is out */
+  return tx_mutex_get(&uart_tx_mutex, wait_option);
+}
+
+void uart_tx_unlock(void)
+{
+  tx_mutex_put(&uart_tx_mutex);
+}
+
+/**
+  * @brief  UART Tx Transfer completed callback
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart == uart_tx_huart) {
+    tx_semaphore_put(&uart_tx_done);
+  }
+}
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    uart_tx.h
+  * @brief   Thread-safe DMA transmit path for the console UART.
+  *
+  *          Every writer (echo, logging, stdio) funnels through
+  *          uart_tx_write(), which serializes callers with a mutex and sleeps
+  *          on a semaphore while DMA moves the bytes, instead of spinning in
+  *          HAL_UART_Transmit().
+  ******************************************************************************
+  */
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "tx_api.h"
+
+/* A writer gives up on a DMA transfer and aborts it after twice its time on
+ * the wire at the UART's baud rate, 10 bits a byte, plus this margin for the
+ * DMA start-up and the completion interrupt. At 115200 baud a full 256 byte
+ * chunk takes ~23 ms. */
+#define UART_TX_TIMEOUT_MARGIN_TICKS  10U
+
+/**
+  * @brief  Create the kernel objects for the TX path. Call once from the
+  *         application's ThreadX init hook.
+  * @param  huart: UART whose hdmatx has been linked by HAL_UART_MspInit()
+  * @retval TX_SUCCESS or the failing ThreadX status
+  */
+UINT uart_tx_init(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  Transmit len bytes over DMA and wait for completion.
+  * @note   Thread context only. data must stay valid until the call returns.
+  * @param  data: bytes to send
+  * @param  len: number of bytes
+  * @param  wait_option: how long to wait for the UART to become free
+  * @retval TX_SUCCESS, the tx_mutex_get() status, or TX_NOT_DONE if the
+  *         transfer failed or timed out, in which case it has been aborted
+  */
+UINT uart_tx_write(const uint8_t *data, uint16_t len, ULONG wait_option);
+
+/**
+  * @brief  Keep the UART idle: waits out the transfer in flight, if any, and
+  *         holds off new ones until uart_tx_unlock(). For reconfiguring the
+  *         UART under the writers, e.g. on a clock change.
+  * @note   Thread context only.
+  * @retval TX_SUCCESS or the tx_mutex_get() status
+  */
+UINT uart_tx_lock(ULONG wait_option);
+
+/**
+  * @brief  Release uart_tx_lock().
+  */
+void uart_tx_unlock(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_TX_H */
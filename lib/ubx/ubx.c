@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    ubx.c
+  * @brief   u-blox UBX frames for GNSS receiver aiding.
+  ******************************************************************************
+  */
+#include "ubx.h"
+
+#include <string.h>
+
+#define UBX_MGA_INI_TYPE_POS_LLH    0x01U
+#define UBX_MGA_INI_TYPE_TIME_UTC   0x10U
+#define UBX_LEAP_UNKNOWN            0x80U   /* I1 -128: receiver's own value */
+
+static void ubx_put16(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void ubx_put32(uint8_t *p, uint32_t v)
+{
+  ubx_put16(p, v);
+  ubx_put16(&p[2], v >> 16);
+}
+
+void ubx_utc_from_unix(uint32_t unix_s, ubx_utc_t *utc)
+{
+  /* Days to civil date, with March as the first month of the year so that
+   * the leap day comes last (H. Hinnant's days_from_civil inverse) */
+  uint32_t days = unix_s / 86400UL + 719468UL;
+  uint32_t secs = unix_s % 86400UL;
+  uint32_t era = days / 146097UL;
+  uint32_t doe = days - era * 146097UL;
+  uint32_t yoe = (doe - doe / 1460U + doe / 36524UL - doe / 146096UL) / 365U;
+  uint32_t doy = doe - (365U * yoe + yoe / 4U - yoe / 100U);
+  uint32_t mp = (5U * doy + 2U) / 153U;
+  uint32_t month = (mp < 10U) ? mp + 3U : mp - 9U;
+
+  utc->year = (uint16_t)(yoe + era * 400U + ((month <= 2U) ? 1U : 0U));
+  utc->month = (uint8_t)month;
+  utc->day = (uint8_t)(doy - (153U * mp + 2U) / 5U + 1U);
+  utc->hour = (uint8_t)(secs / 3600U);
+  utc->minute = (uint8_t)((secs / 60U) % 60U);
+  utc->second = (uint8_t)(secs % 60U);
+}
+
+uint32_t ubx_frame(uint8_t *out, uint32_t size, uint8_t cls, uint8_t id, const uint8_t *payload,
+                   uint16_t len)
+{
+  uint8_t ck_a = 0U;
+  uint8_t ck_b = 0U;
+  uint32_t i;
+
+  if (size < (uint32_t)len + UBX_OVERHEAD) {
+    return 0U;
+  }
+  out[0] = UBX_SYNC1;
+  out[1] = UBX_SYNC2;
+  out[2] = cls;
+  out[3] = id;
+  ubx_put16(&out[4], len);
+  memcpy(&out[6], payload, len);
+  for (i = 2U; i < 6U + (uint32_t)len; i++) {
+    ck_a = (uint8_t)(ck_a + out[i]);
+    ck_b = (uint8_t)(ck_b + ck_a);
+  }
+  out[6U + len] = ck_a;
+  out[7U + len] = ck_b;
+  return (uint32_t)len + UBX_OVERHEAD;
+}
+
+uint32_t ubx_mga_ini_time_utc(uint8_t *out, uint32_t size, const ubx_utc_t *utc,
+                              uint16_t acc_s)
+{
+  uint8_t p[UBX_MGA_INI_TIME_UTC_LEN];
+
+  memset(p, 0, sizeof(p));
+  p[0] = UBX_MGA_INI_TYPE_TIME_UTC;
+  p[3] = UBX_LEAP_UNKNOWN;
+  ubx_put16(&p[4], utc->year);
+  p[6] = utc->month;
+  p[7] = utc->day;
+  p[8] = utc->hour;
+  p[9] = utc->minute;
+  p[10] = utc->second;
+  ubx_put16(&p[16], acc_s);
+  return ubx_frame(out, size, UBX_CLASS_MGA, UBX_ID_MGA_INI, p, sizeof(p));
+}
+
+uint32_t ubx_mga_ini_pos_llh(uint8_t *out, uint32_t size, int32_t lat_e7, int32_t lon_e7,
+                             int32_t alt_cm, uint32_t acc_cm)
+{
+  uint8_t p[UBX_MGA_INI_POS_LLH_LEN];
+
+  memset(p, 0, sizeof(p));
+  p[0] = UBX_MGA_INI_TYPE_POS_LLH;
+  ubx_put32(&p[4], (uint32_t)lat_e7);
+  ubx_put32(&p[8], (uint32_t)lon_e7);
+  ubx_put32(&p[12], (uint32_t)alt_cm);
+  ubx_put32(&p[16], acc_cm);
+  return ubx_frame(out, size, UBX_CLASS_MGA, UBX_ID_MGA_INI, p, sizeof(p));
+}
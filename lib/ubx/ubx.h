@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    ubx.h
+  * @brief   u-blox UBX frames for GNSS receiver aiding.
+  *
+  *          A frame is 0xB5 0x62, class, id, a little-endian 16-bit payload
+  *          length, the payload, and an 8-bit Fletcher checksum over class
+  *          to payload end. Only what warm starts need is here: the
+  *          UBX-MGA-INI messages that hand the receiver an approximate
+  *          UTC time and position, so it searches the satellites that are
+  *          actually up instead of the whole sky.
+  *
+  *          Pure C, also builds on the host.
+  ******************************************************************************
+  */
+#ifndef UBX_H
+#define UBX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define UBX_SYNC1               0xB5U
+#define UBX_SYNC2               0x62U
+#define UBX_OVERHEAD            8U      /* Sync, class, id, length, checksum */
+
+#define UBX_CLASS_MGA           0x13U
+#define UBX_ID_MGA_INI          0x40U
+
+#define UBX_MGA_INI_TIME_UTC_LEN    24U
+#define UBX_MGA_INI_POS_LLH_LEN     20U
+
+typedef struct {
+  uint16_t year;
+  uint8_t month;                        /*!< 1..12 */
+  uint8_t day;                          /*!< 1..31 */
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+} ubx_utc_t;
+
+/**
+  * @brief  Calendar time from seconds since 1970-01-01 UTC.
+  */
+void ubx_utc_from_unix(uint32_t unix_s, ubx_utc_t *utc);
+
+/**
+  * @brief  Frame a payload.
+  * @retval Bytes written, or 0 if out is too small
+  */
+uint32_t ubx_frame(uint8_t *out, uint32_t size, uint8_t cls, uint8_t id, const uint8_t *payload,
+                   uint16_t len);
+
+/**
+  * @brief  UBX-MGA-INI-TIME_UTC: time valid on receipt.
+  * @param  acc_s: accuracy in whole seconds
+  * @retval Bytes written, or 0 if out is too small
+  */
+uint32_t ubx_mga_ini_time_utc(uint8_t *out, uint32_t size, const ubx_utc_t *utc,
+                              uint16_t acc_s);
+
+/**
+  * @brief  UBX-MGA-INI-POS_LLH.
+  * @param  lat_e7, lon_e7: degrees * 1e7
+  * @param  alt_cm: height above the ellipsoid
+  * @param  acc_cm: position accuracy
+  * @retval Bytes written, or 0 if out is too small
+  */
+uint32_t ubx_mga_ini_pos_llh(uint8_t *out, uint32_t size, int32_t lat_e7, int32_t lon_e7,
+                             int32_t alt_cm, uint32_t acc_cm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UBX_H */
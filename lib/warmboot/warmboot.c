@@ -0,0 +1,404 @@
+/**
+  ******************************************************************************
+  * @file    warmboot.c
+  * @brief   Warm-boot state in the RTC backup registers, for GPS aiding.
+  ******************************************************************************
+  */
+#include "warmboot.h"
+#include "console.h"
+#include "crc32.h"
+#include "dlog.h"
+#include "tx_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A fix this old has drifted past WARMBOOT_TIME_MAX_S: no aiding needs more */
+#define WARMBOOT_AGE_MAX_S      ((WARMBOOT_TIME_MAX_S + 1UL) * WARMBOOT_TIME_DRIFT_S)
+#define WARMBOOT_RTC_READS      4U          /* TR/DR pairs until two agree */
+
+/* BKP7 flags */
+#define WARMBOOT_HAVE_TIME      0x01U       /* BKP1 holds a UTC offset */
+#define WARMBOOT_HAVE_FIX       0x02U       /* BKP2..5 hold a fix */
+
+enum {
+  WARMBOOT_BOOTS = 0,
+  WARMBOOT_UTC_OFFSET,
+  WARMBOOT_FIX_RTC,
+  WARMBOOT_LAT,
+  WARMBOOT_LON,
+  WARMBOOT_ALT_ACC,
+  WARMBOOT_TTFF,
+  WARMBOOT_RESET,
+};
+
+static uint32_t warmboot_bkp[WARMBOOT_WORDS];   /* Mirror of BKP0..BKP7 */
+static uint32_t warmboot_on_tick;
+static volatile uint8_t warmboot_timing;        /* GPS on, no fix yet */
+
+static const uint16_t warmboot_month_days[12] = {
+  0U, 31U, 59U, 90U, 120U, 151U, 181U, 212U, 243U, 273U, 304U, 334U,
+};
+
+static uint32_t warmboot_bcd(uint32_t reg, uint32_t tens_mask, uint32_t tens_pos,
+                             uint32_t units_mask, uint32_t units_pos)
+{
+  return ((reg & tens_mask) >> tens_pos) * 10U + ((reg & units_mask) >> units_pos);
+}
+
+/**
+  * @brief  RTC calendar as seconds since 2000-01-01. The shadow registers are
+  *         bypassed, so TR and DR are read until two reads agree.
+  */
+static uint32_t warmboot_rtc_seconds(void)
+{
+  uint32_t tr = RTC->TR;
+  uint32_t dr = RTC->DR;
+  uint32_t year;
+  uint32_t month;
+  uint32_t day;
+  uint32_t days;
+  uint32_t i;
+
+  for (i = 0U; i < WARMBOOT_RTC_READS; i++) {
+    uint32_t tr2 = RTC->TR;
+    uint32_t dr2 = RTC->DR;
+    if (tr2 == tr && dr2 == dr) {
+      break;
+    }
+    tr = tr2;
+    dr = dr2;
+  }
+
+  year = warmboot_bcd(dr, RTC_DR_YT, RTC_DR_YT_Pos, RTC_DR_YU, RTC_DR_YU_Pos);
+  month = warmboot_bcd(dr, RTC_DR_MT, RTC_DR_MT_Pos, RTC_DR_MU, RTC_DR_MU_Pos);
+  day = warmboot_bcd(dr, RTC_DR_DT, RTC_DR_DT_Pos, RTC_DR_DU, RTC_DR_DU_Pos);
+  month = (month < 1U) ? 1U : ((month > 12U) ? 12U : month);
+  day = (day < 1U) ? 1U : day;
+
+  /* 2000 to 2099: every fourth year is a leap year */
+  days = year * 365U + (year + 3U) / 4U + warmboot_month_days[month - 1U] + day - 1U;
+  if (month > 2U && (year % 4U) == 0U) {
+    days++;
+  }
+  return days * 86400UL +
+         warmboot_bcd(tr, RTC_TR_HT, RTC_TR_HT_Pos, RTC_TR_HU, RTC_TR_HU_Pos) * 3600U +
+         warmboot_bcd(tr, RTC_TR_MNT, RTC_TR_MNT_Pos, RTC_TR_MNU, RTC_TR_MNU_Pos) * 60U +
+         warmboot_bcd(tr, RTC_TR_ST, RTC_TR_ST_Pos, RTC_TR_SU, RTC_TR_SU_Pos);
+}
+
+static int warmboot_rtc_on_lse(void)
+{
+  return (RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_RTCCLKSOURCE_LSE;
+}
+
+/**
+  * @brief  Write the mirror and its CRC to the backup registers.
+  */
+static void warmboot_save(void)
+{
+  volatile uint32_t *bkp = &TAMP->BKP0R;
+  uint32_t i;
+
+  for (i = 0U; i < WARMBOOT_WORDS; i++) {
+    bkp[i] = warmboot_bkp[i];
+  }
+  bkp[WARMBOOT_WORDS] = crc32(warmboot_bkp, sizeof(warmboot_bkp));
+}
+
+static uint8_t warmboot_flags(void)
+{
+  return (uint8_t)(warmboot_bkp[WARMBOOT_RESET] >> 8);
+}
+
+static uint8_t warmboot_resets_since_fix(void)
+{
+  return (uint8_t)(warmboot_bkp[WARMBOOT_TTFF] >> 24);
+}
+
+/**
+  * @brief  Age of the last fix, seconds, saturated at WARMBOOT_AGE_MAX_S.
+  */
+static uint32_t warmboot_fix_age(void)
+{
+  uint32_t age = warmboot_rtc_seconds() - warmboot_bkp[WARMBOOT_FIX_RTC];
+
+  return (age > WARMBOOT_AGE_MAX_S) ? WARMBOOT_AGE_MAX_S : age;
+}
+
+static uint32_t warmboot_time_acc(void)
+{
+  return WARMBOOT_TIME_ACC_S + warmboot_resets_since_fix() +
+         warmboot_fix_age() / WARMBOOT_TIME_DRIFT_S;
+}
+
+static uint32_t warmboot_pos_acc(void)
+{
+  uint32_t age = warmboot_fix_age();
+
+  /* Saturated in metres, just past the limit, so that the product cannot
+   * overflow */
+  return (warmboot_bkp[WARMBOOT_ALT_ACC] >> 16) +
+         ((age > WARMBOOT_POS_MAX_M / WARMBOOT_DRIFT_MPS) ? WARMBOOT_POS_MAX_M + 1UL
+                                                           : age * WARMBOOT_DRIFT_MPS);
+}
+
+/**
+  * @brief  Which aiding the state is good for now.
+  */
+static uint8_t warmboot_aid(void)
+{
+  uint8_t flags = warmboot_flags();
+  uint8_t aid = 0U;
+
+  if ((flags & WARMBOOT_HAVE_TIME) != 0U && warmboot_rtc_on_lse() &&
+      warmboot_time_acc() <= WARMBOOT_TIME_MAX_S) {
+    aid |= WARMBOOT_AID_TIME;
+  }
+  if ((flags & WARMBOOT_HAVE_FIX) != 0U && warmboot_pos_acc() <= WARMBOOT_POS_MAX_M) {
+    aid |= WARMBOOT_AID_POS;
+  }
+  return aid;
+}
+
+static const char *warmboot_aid_name(uint8_t aid)
+{
+  static const char *const names[] = { "cold", "time", "pos", "time+pos" };
+
+  return names[aid & (WARMBOOT_AID_TIME | WARMBOOT_AID_POS)];
+}
+
+const char *warmboot_reset_name(uint32_t reset_flags)
+{
+  if ((reset_flags & RCC_CSR_PWRRSTF) != 0U) {
+    return "brownout";
+  }
+  if ((reset_flags & (RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF)) != 0U) {
+    return "watchdog";
+  }
+  if ((reset_flags & RCC_CSR_SFTRSTF) != 0U) {
+    return "software";
+  }
+  if ((reset_flags & RCC_CSR_LPWRRSTF) != 0U) {
+    return "low-power";
+  }
+  if ((reset_flags & RCC_CSR_OBLRSTF) != 0U) {
+    return "option bytes";
+  }
+  return "pin";
+}
+
+void warmboot_boot(uint32_t reset_flags)
+{
+  volatile uint32_t *bkp = &TAMP->BKP0R;
+  uint32_t boots;
+  uint32_t resets;
+  uint32_t i;
+
+  for (i = 0U; i < WARMBOOT_WORDS; i++) {
+    warmboot_bkp[i] = bkp[i];
+  }
+  if ((warmboot_bkp[WARMBOOT_BOOTS] >> 16) != WARMBOOT_MAGIC ||
+      crc32(warmboot_bkp, sizeof(warmboot_bkp)) != bkp[WARMBOOT_WORDS]) {
+    memset(warmboot_bkp, 0, sizeof(warmboot_bkp));
+  }
+
+  boots = (warmboot_bkp[WARMBOOT_BOOTS] & 0xFFFFU) + 1U;
+  warmboot_bkp[WARMBOOT_BOOTS] = ((uint32_t)WARMBOOT_MAGIC << 16) | (boots & 0xFFFFU);
+  resets = warmboot_resets_since_fix();
+  if (resets < 0xFFU) {
+    resets++;
+  }
+  warmboot_bkp[WARMBOOT_TTFF] = (warmboot_bkp[WARMBOOT_TTFF] & 0x00FFFFFFUL) | (resets << 24);
+  warmboot_bkp[WARMBOOT_RESET] = (warmboot_bkp[WARMBOOT_RESET] & 0xFF00U) | (reset_flags >> 24);
+  warmboot_save();
+
+  printf("warmboot: boot %lu, %s reset, %s start", (unsigned long)boots,
+         warmboot_reset_name(reset_flags), warmboot_aid_name(warmboot_aid()));
+  if ((warmboot_bkp[WARMBOOT_TTFF] & 0xFFFFU) != 0U) {
+    printf(", last TTFF %lu.%lu s (%s)",
+           (unsigned long)((warmboot_bkp[WARMBOOT_TTFF] & 0xFFFFU) / 10U),
+           (unsigned long)((warmboot_bkp[WARMBOOT_TTFF] & 0xFFFFU) % 10U),
+           warmboot_aid_name((uint8_t)(warmboot_bkp[WARMBOOT_TTFF] >> 16)));
+  }
+  printf("\n");
+}
+
+uint32_t warmboot_gps_on(uint8_t *buf, uint32_t size)
+{
+  TX_INTERRUPT_SAVE_AREA
+  ubx_utc_t utc;
+  uint32_t len = 0U;
+  uint32_t n;
+  uint8_t aid;
+
+  TX_DISABLE
+  aid = warmboot_aid();
+  if ((aid & WARMBOOT_AID_TIME) != 0U) {
+    ubx_utc_from_unix(warmboot_rtc_seconds() + warmboot_bkp[WARMBOOT_UTC_OFFSET], &utc);
+    n = ubx_mga_ini_time_utc(buf, size, &utc, (uint16_t)warmboot_time_acc());
+    aid = (n != 0U) ? aid : (uint8_t)(aid & ~WARMBOOT_AID_TIME);
+    len += n;
+  }
+  if ((aid & WARMBOOT_AID_POS) != 0U) {
+    n = ubx_mga_ini_pos_llh(&buf[len], size - len, (int32_t)warmboot_bkp[WARMBOOT_LAT],
+                            (int32_t)warmboot_bkp[WARMBOOT_LON],
+                            (int32_t)(int16_t)warmboot_bkp[WARMBOOT_ALT_ACC] * 100,
+                            warmboot_pos_acc() * 100U);
+    aid = (n != 0U) ? aid : (uint8_t)(aid & ~WARMBOOT_AID_POS);
+    len += n;
+  }
+  warmboot_bkp[WARMBOOT_TTFF] = (warmboot_bkp[WARMBOOT_TTFF] & 0xFF00FFFFUL) | ((uint32_t)aid << 16);
+  warmboot_save();
+  warmboot_on_tick = tx_time_get();
+  warmboot_timing = 1U;
+  TX_RESTORE
+  return len;
+}
+
+void warmboot_fix(const warmboot_fix_t *fix)
+{
+  TX_INTERRUPT_SAVE_AREA
+  uint32_t ttff = 0U;
+  uint32_t rtc = warmboot_rtc_seconds();
+  int32_t alt = fix->alt_m;
+  uint32_t acc = (fix->acc_m > 0xFFFFU) ? 0xFFFFU : fix->acc_m;
+  uint8_t timed;
+
+  alt = (alt > INT16_MAX) ? INT16_MAX : ((alt < INT16_MIN) ? INT16_MIN : alt);
+
+  TX_DISABLE
+  timed = warmboot_timing;
+  if (timed != 0U) {
+    ttff = (tx_time_get() - warmboot_on_tick) * 10U / TX_TIMER_TICKS_PER_SECOND;
+    ttff = (ttff > 0xFFFFU) ? 0xFFFFU : ((ttff == 0U) ? 1U : ttff);
+    warmboot_timing = 0U;
+  }
+  warmboot_bkp[WARMBOOT_UTC_OFFSET] = fix->utc - rtc;
+  warmboot_bkp[WARMBOOT_FIX_RTC] = rtc;
+  warmboot_bkp[WARMBOOT_LAT] = (uint32_t)fix->lat_e7;
+  warmboot_bkp[WARMBOOT_LON] = (uint32_t)fix->lon_e7;
+  warmboot_bkp[WARMBOOT_ALT_ACC] = (acc << 16) | ((uint32_t)alt & 0xFFFFU);
+  /* A fix clears the resets since the last one; the TTFF stays until the next */
+  warmboot_bkp[WARMBOOT_TTFF] = (warmboot_bkp[WARMBOOT_TTFF] & 0x00FF0000UL) |
+                                ((timed != 0U) ? ttff : (warmboot_bkp[WARMBOOT_TTFF] & 0xFFFFU));
+  warmboot_bkp[WARMBOOT_RESET] |= (uint32_t)(WARMBOOT_HAVE_TIME | WARMBOOT_HAVE_FIX) << 8;
+  warmboot_save();
+  TX_RESTORE
+
+  if (timed != 0U) {
+    DLOG_INFO("warmboot: TTFF %u.%u s, aid %u", ttff / 10U, ttff % 10U,
+              (warmboot_bkp[WARMBOOT_TTFF] >> 16) & 0xFFU);
+  }
+}
+
+uint32_t warmboot_utc(void)
+{
+  if ((warmboot_flags() & WARMBOOT_HAVE_TIME) == 0U) {
+    return 0U;
+  }
+  return warmboot_rtc_seconds() + warmboot_bkp[WARMBOOT_UTC_OFFSET];
+}
+
+void warmboot_clear(void)
+{
+  TX_INTERRUPT_SAVE_AREA
+
+  TX_DISABLE
+  warmboot_bkp[WARMBOOT_UTC_OFFSET] = 0U;
+  warmboot_bkp[WARMBOOT_FIX_RTC] = 0U;
+  warmboot_bkp[WARMBOOT_LAT] = 0U;
+  warmboot_bkp[WARMBOOT_LON] = 0U;
+  warmboot_bkp[WARMBOOT_ALT_ACC] = 0U;
+  warmboot_bkp[WARMBOOT_RESET] &= 0xFFU;
+  warmboot_save();
+  TX_RESTORE
+}
+
+static void warmboot_show(void)
+{
+  uint32_t ttff = warmboot_bkp[WARMBOOT_TTFF];
+  uint8_t flags = warmboot_flags();
+
+  printf("  boot %lu, last reset %s, RTC on %s\n",
+         (unsigned long)(warmboot_bkp[WARMBOOT_BOOTS] & 0xFFFFU),
+         warmboot_reset_name(warmboot_bkp[WARMBOOT_RESET] << 24),
+         warmboot_rtc_on_lse() ? "LSE" : "LSI");
+  if ((flags & WARMBOOT_HAVE_TIME) != 0U) {
+    printf("  UTC %lu, +/- %lu s\n", (unsigned long)warmboot_utc(),
+           (unsigned long)warmboot_time_acc());
+  }
+  if ((flags & WARMBOOT_HAVE_FIX) != 0U) {
+    printf("  fix %ld %ld, %ld m, %lu s old, %lu resets since, +/- %lu m\n",
+           (long)(int32_t)warmboot_bkp[WARMBOOT_LAT], (long)(int32_t)warmboot_bkp[WARMBOOT_LON],
+           (long)(int16_t)warmboot_bkp[WARMBOOT_ALT_ACC], (unsigned long)warmboot_fix_age(),
+           (unsigned long)warmboot_resets_since_fix(), (unsigned long)warmboot_pos_acc());
+  }
+  printf("  next start %s", warmboot_aid_name(warmboot_aid()));
+  if ((ttff & 0xFFFFU) != 0U) {
+    printf(", last TTFF %lu.%lu s (%s)", (unsigned long)((ttff & 0xFFFFU) / 10U),
+           (unsigned long)((ttff & 0xFFFFU) % 10U), warmboot_aid_name((uint8_t)(ttff >> 16)));
+  }
+  printf("%s\n", (warmboot_timing != 0U) ? ", timing a fix" : "");
+}
+
+/**
+  * @brief  'warm' console command: the warm-boot state, the aiding it makes,
+  *         and a stand-in for the GPS driver's calls.
+  */
+static int console_cmd_warm(int argc, char *argv[])
+{
+  uint8_t buf[WARMBOOT_AID_SIZE];
+  warmboot_fix_t fix;
+  uint32_t len;
+  uint32_t i;
+
+  if (argc == 1) {
+    warmboot_show();
+    return 0;
+  }
+  if (strcmp(argv[1], "aid") == 0) {
+    /* As the GPS driver would at switch-on, so this also starts the TTFF clock */
+    len = warmboot_gps_on(buf, sizeof(buf));
+    for (i = 0U; i < len; i++) {
+      printf("%s%02x", ((i % 16U) == 0U) ? "  " : " ", buf[i]);
+      if ((i % 16U) == 15U || i + 1U == len) {
+        printf("\n");
+      }
+    }
+    printf("  %lu bytes, %s start\n", (unsigned long)len,
+           warmboot_aid_name((uint8_t)(warmboot_bkp[WARMBOOT_TTFF] >> 16)));
+    return 0;
+  }
+  if (strcmp(argv[1], "fix") == 0 && argc >= 6) {
+    fix.utc = (uint32_t)strtoul(argv[2], NULL, 10);
+    fix.lat_e7 = (int32_t)strtol(argv[3], NULL, 10);
+    fix.lon_e7 = (int32_t)strtol(argv[4], NULL, 10);
+    fix.alt_m = (int32_t)strtol(argv[5], NULL, 10);
+    fix.acc_m = (argc > 6) ? (uint32_t)strtoul(argv[6], NULL, 10) : 10U;
+    warmboot_fix(&fix);
+    warmboot_show();
+    return 0;
+  }
+  if (strcmp(argv[1], "clear") == 0) {
+    warmboot_clear();
+    printf("  cleared, next start cold\n");
+    return 0;
+  }
+  printf("  usage: warm [aid | fix <utc> <lat_e7> <lon_e7> <alt_m> [acc_m] | clear]\n");
+  return -1;
+}
+
+static const char *console_complete_warm(int argi, uint32_t index)
+{
+  static const char *const subcommands[] = { "aid", "fix", "clear" };
+
+  if (argi != 1 || index >= sizeof(subcommands) / sizeof(subcommands[0])) {
+    return NULL;
+  }
+  return subcommands[index];
+}
+
+CONSOLE_COMMAND(warm, "warm [aid|fix|clear]: warm-boot state and GPS aiding",
+                console_cmd_warm, console_complete_warm);
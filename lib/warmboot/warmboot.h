@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file    warmboot.h
+  * @brief   Warm-boot state in the RTC backup registers, for GPS aiding.
+  *
+  *          The backup domain keeps running on VBAT and survives what RAM
+  *          does not: a brownout, a watchdog, a power-fail reset. It holds
+  *          the last fix, the offset from RTC time to UTC, a boot counter,
+  *          the reset cause and the last time to first fix, checked by a
+  *          CRC-32:
+  *            BKP0  magic << 16 | boots
+  *            BKP1  UTC - RTC seconds since 2000-01-01
+  *            BKP2  RTC seconds at the last fix
+  *            BKP3  latitude, degrees * 1e7
+  *            BKP4  longitude, degrees * 1e7
+  *            BKP5  accuracy m << 16 | altitude m
+  *            BKP6  resets since fix << 24 | aid << 16 | TTFF in 0.1 s
+  *            BKP7  flags << 8 | reset cause (RCC->CSR >> 24)
+  *            BKP8  CRC-32 of BKP0..BKP7
+  *
+  *          When the GPS is switched on, warmboot_gps_on() turns that state
+  *          into UBX-MGA-INI aiding: the time, if the RTC runs from LSE and
+  *          so has kept it, and the position, if the receiver cannot have
+  *          moved too far since. Their accuracies grow with the age of the
+  *          fix and with every reset in between, since HAL_RTC_Init stops
+  *          the calendar for up to a second. The first warmboot_fix() after
+  *          that measures the time to first fix.
+  *
+  *          There is no GPS driver yet: it calls warmboot_gps_on() and
+  *          warmboot_fix(), and 'warm fix' stands in for it.
+  ******************************************************************************
+  */
+#ifndef WARMBOOT_H
+#define WARMBOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include "ubx.h"
+
+#define WARMBOOT_MAGIC          0x5742U     /* "WB" */
+#define WARMBOOT_WORDS          8U          /* Backup registers before the CRC */
+#define WARMBOOT_TIME_ACC_S     2U          /* Time accuracy just after a fix */
+#define WARMBOOT_TIME_DRIFT_S   43200UL     /* One more second per this age (LSE, 23 ppm) */
+#define WARMBOOT_TIME_MAX_S     60U         /* Worse than this, no time aiding */
+#define WARMBOOT_DRIFT_MPS      50U         /* How fast the balloon may have gone */
+#define WARMBOOT_POS_MAX_M      300000UL    /* Worse than this, no position aiding */
+#define WARMBOOT_AID_SIZE       (UBX_MGA_INI_TIME_UTC_LEN + UBX_MGA_INI_POS_LLH_LEN + 2U * UBX_OVERHEAD)
+
+/* Aiding given at GPS switch-on, a bit mask */
+#define WARMBOOT_AID_TIME       0x01U
+#define WARMBOOT_AID_POS        0x02U
+
+typedef struct {
+  uint32_t utc;                         /*!< Seconds since 1970-01-01 */
+  int32_t lat_e7;                       /*!< Degrees * 1e7 */
+  int32_t lon_e7;
+  int32_t alt_m;                        /*!< Above the ellipsoid */
+  uint32_t acc_m;                       /*!< Horizontal accuracy */
+} warmboot_fix_t;
+
+/**
+  * @brief  Check the backup registers, count the boot and keep its cause.
+  *         Invalid state starts over cold. After power_init(): the backup
+  *         domain must be writable and the RTC running.
+  * @param  reset_flags: RCC->CSR at reset
+  */
+void warmboot_boot(uint32_t reset_flags);
+
+/**
+  * @brief  The GPS has been switched on: build the aiding to send it and
+  *         start timing the first fix.
+  * @param  buf: at least WARMBOOT_AID_SIZE bytes
+  * @retval Bytes of UBX frames in buf, 0 for a cold start
+  */
+uint32_t warmboot_gps_on(uint8_t *buf, uint32_t size);
+
+/**
+  * @brief  Keep a fix. The first one after warmboot_gps_on() sets the TTFF.
+  */
+void warmboot_fix(const warmboot_fix_t *fix);
+
+/**
+  * @brief  UTC from the RTC, or 0 if it has not been set by a fix.
+  */
+uint32_t warmboot_utc(void);
+
+/**
+  * @brief  Forget everything: the next GPS start is cold.
+  */
+void warmboot_clear(void);
+
+const char *warmboot_reset_name(uint32_t reset_flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARMBOOT_H */
@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * @file    watchdog.c
+  * @brief   IWDG supervisor with per-thread liveness check-ins.
+  ******************************************************************************
+  */
+#include "watchdog.h"
+#include "main.h"
+#include "crash.h"
+#include "dlog.h"
+
+static watchdog_slot_t watchdog_slots[WATCHDOG_SLOTS];
+static uint32_t watchdog_count;
+static IWDG_HandleTypeDef watchdog_hiwdg;
+static TX_THREAD watchdog_thread;
+
+static void watchdog_thread_entry(ULONG thread_input);
+
+UINT watchdog_init(TX_BYTE_POOL *byte_pool, uint32_t reset_flags)
+{
+  CHAR *pointer;
+  UINT ret;
+
+  ret = tx_byte_allocate(byte_pool, (VOID **)&pointer, WATCHDOG_THREAD_STACK_SIZE, TX_NO_WAIT);
+  if (ret != TX_SUCCESS) {
+    return ret;
+  }
+  return tx_thread_create(&watchdog_thread, "Watchdog", watchdog_thread_entry, reset_flags,
+                          pointer, WATCHDOG_THREAD_STACK_SIZE,
+                          WATCHDOG_THREAD_PRIORITY, WATCHDOG_THREAD_PRIORITY,
+                          TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+watchdog_handle_t watchdog_register(TX_THREAD *thread, ULONG deadline)
+{
+  TX_INTERRUPT_SAVE_AREA
+  watchdog_slot_t *slot = NULL;
+
+  TX_DISABLE
+  if (watchdog_count < WATCHDOG_SLOTS) {
+    slot = &watchdog_slots[watchdog_count];
+    watchdog_slot_init(slot, thread->tx_thread_name, thread, deadline, tx_time_get());
+    /* Published last, the supervisor only polls slots below the count */
+    watchdog_count++;
+  }
+  TX_RESTORE
+  return slot;
+}
+
+void watchdog_checkin_self(void)
+{
+  TX_THREAD *self = tx_thread_identify();
+  uint32_t i;
+
+  for (i = 0; i < watchdog_count; i++) {
+    if (watchdog_slots[i].owner == self) {
+      watchdog_slot_checkin(&watchdog_slots[i]);
+    }
+  }
+}
+
+static void watchdog_start(uint32_t reset_flags)
+{
+  if ((reset_flags & RCC_CSR_IWDGRSTF) != 0U) {
+    DLOG_WARN("watchdog: previous run was reset by the IWDG");
+  }
+
+#ifdef DEBUG
+  /* Keep the debugger from tripping it while halted */
+  __HAL_DBGMCU_FREEZE_IWDG();
+#endif
+
+  watchdog_hiwdg.Instance = IWDG;
+  watchdog_hiwdg.Init.Prescaler = WATCHDOG_IWDG_PRESCALER;
+  watchdog_hiwdg.Init.Reload = (LSI_VALUE / 32U) * WATCHDOG_IWDG_TIMEOUT_MS / 1000U;
+  watchdog_hiwdg.Init.Window = IWDG_WINDOW_DISABLE;
+  watchdog_hiwdg.Init.EWI = 0;
+  if (HAL_IWDG_Init(&watchdog_hiwdg) != HAL_OK) {
+    Error_Handler();
+  }
+}
+
+static void watchdog_thread_entry(ULONG thread_input)
+{
+  watchdog_slot_t *slot;
+  ULONG now;
+  ULONG next;
+  int missed;
+
+  watchdog_start((uint32_t)thread_input);
+
+  for (;;) {
+    now = tx_time_get();
+    missed = watchdog_poll(watchdog_slots, watchdog_count, now);
+    if (missed < 0) {
+      (void)HAL_IWDG_Refresh(&watchdog_hiwdg);
+      next = watchdog_next_poll(watchdog_slots, watchdog_count, now, WATCHDOG_MAX_PERIOD);
+      tx_thread_sleep((next > WATCHDOG_PERIOD) ? next : WATCHDOG_PERIOD);
+      continue;
+    }
+
+    slot = &watchdog_slots[missed];
+    DLOG_ERROR("watchdog: %s (slot %u, thread %p) missed its %u tick deadline by %u",
+               (uint32_t)(uintptr_t)slot->name, (uint32_t)missed,
+               (uint32_t)(uintptr_t)slot->owner, slot->deadline,
+               watchdog_slot_overdue(slot, now));
+    tx_thread_sleep(WATCHDOG_LOG_GRACE);
+    crash_watchdog((TX_THREAD *)slot->owner);
+  }
+}
@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * @file    watchdog.h
+  * @brief   IWDG supervisor with per-thread liveness check-ins.
+  *
+  *          Threads register with a deadline and call watchdog_checkin()
+  *          from their main loop. A high-priority supervisor thread refreshes
+  *          the IWDG only while every registered thread is within its
+  *          deadline. When one misses, the supervisor logs it, gives the
+  *          log drain a moment, and records the stalled thread's context
+  *          through crash_watchdog() before resetting. If the supervisor
+  *          itself stops running, the IWDG resets the part on its own.
+  *
+  *          The supervisor polls when the nearest deadline could first be
+  *          missed rather than on a fixed beat, so it does not keep an idle
+  *          part out of STOP2: polls are WATCHDOG_PERIOD to
+  *          WATCHDOG_MAX_PERIOD apart.
+  *
+  *          The deadline logic lives in watchdog_core.c and has no target
+  *          dependencies.
+  ******************************************************************************
+  */
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tx_api.h"
+#include "watchdog_core.h"
+
+#define WATCHDOG_SLOTS                  8U
+#define WATCHDOG_THREAD_STACK_SIZE      512U
+#define WATCHDOG_THREAD_PRIORITY        1U
+#define WATCHDOG_PERIOD                 10U   /* ticks between polls, at least */
+#define WATCHDOG_LOG_GRACE              5U    /* ticks for the log to drain */
+
+/* IWDG runs from the 32 kHz LSI: /32 gives 1 ms per count */
+#define WATCHDOG_IWDG_PRESCALER         IWDG_PRESCALER_32
+#define WATCHDOG_IWDG_TIMEOUT_MS        2000U
+
+/* Longest gap between polls, half the IWDG timeout */
+#define WATCHDOG_MAX_PERIOD             (WATCHDOG_IWDG_TIMEOUT_MS / 2U * TX_TIMER_TICKS_PER_SECOND / 1000U)
+
+typedef watchdog_slot_t *watchdog_handle_t;
+
+/**
+  * @brief  Create the supervisor thread. The IWDG starts when it first runs,
+  *         so pre-kernel initialization is not bounded by it.
+  * @param  byte_pool: pool for the supervisor stack
+  * @param  reset_flags: RCC->CSR at reset, to report an IWDG reset
+  * @retval TX_SUCCESS or a ThreadX error code
+  */
+UINT watchdog_init(TX_BYTE_POOL *byte_pool, uint32_t reset_flags);
+
+/**
+  * @brief  Put a thread under supervision.
+  * @param  thread: thread to watch, recorded on a miss
+  * @param  deadline: longest allowed gap between check-ins, in ticks
+  * @retval handle for watchdog_checkin(), NULL if all slots are taken
+  */
+watchdog_handle_t watchdog_register(TX_THREAD *thread, ULONG deadline);
+
+/**
+  * @brief  Report the calling thread alive, for code that runs on a
+  *         supervised thread without its handle, such as a long console
+  *         command. Does nothing on a thread that is not registered.
+  */
+void watchdog_checkin_self(void);
+
+/**
+  * @brief  Report the calling thread alive. A single byte store.
+  */
+static inline void watchdog_checkin(watchdog_handle_t handle)
+{
+  watchdog_slot_checkin(handle);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATCHDOG_H */
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file    watchdog_core.c
+  * @brief   Liveness deadline bookkeeping behind the watchdog supervisor.
+  ******************************************************************************
+  */
+#include "watchdog_core.h"
+
+#include <stddef.h>
+
+void watchdog_slot_init(watchdog_slot_t *slot, const char *name, void *owner,
+                        uint32_t deadline, uint32_t now)
+{
+  slot->alive = 0U;
+  slot->deadline = deadline;
+  slot->last_seen = now;
+  slot->name = name;
+  slot->owner = owner;
+}
+
+uint32_t watchdog_slot_overdue(const watchdog_slot_t *slot, uint32_t now)
+{
+  uint32_t age = now - slot->last_seen;
+
+  return (age > slot->deadline) ? (age - slot->deadline) : 0U;
+}
+
+int watchdog_poll(watchdog_slot_t *slots, uint32_t count, uint32_t now)
+{
+  uint32_t worst_late = 0U;
+  int worst = -1;
+  uint32_t i;
+
+  for (i = 0; i < count; i++) {
+    watchdog_slot_t *slot = &slots[i];
+    uint32_t late;
+
+    if (slot->alive) {
+      slot->alive = 0U;
+      slot->last_seen = now;
+      continue;
+    }
+    late = watchdog_slot_overdue(slot, now);
+    if (late > worst_late) {
+      worst_late = late;
+      worst = (int)i;
+    }
+  }
+  return worst;
+}
+
+uint32_t watchdog_next_poll(const watchdog_slot_t *slots, uint32_t count, uint32_t now,
+                            uint32_t max)
+{
+  uint32_t next = max;
+  uint32_t age;
+  uint32_t i;
+
+  for (i = 0; i < count; i++) {
+    age = now - slots[i].last_seen;
+    if (age >= slots[i].deadline) {
+      return 1U;
+    }
+    if (slots[i].deadline - age + 1U < next) {
+      next = slots[i].deadline - age + 1U;
+    }
+  }
+  return next;
+}
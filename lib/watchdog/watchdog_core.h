@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    watchdog_core.h
+  * @brief   Liveness deadline bookkeeping behind the watchdog supervisor.
+  *
+  *          Pure logic with no HAL or ThreadX dependency, so it builds and
+  *          runs on the host. Time is an abstract free-running uint32_t
+  *          tick count supplied by the caller; wrap-around is handled with
+  *          unsigned differences.
+  *
+  *          A supervised thread checks in by setting its slot's alive flag,
+  *          one byte store. The supervisor polls periodically: a set flag
+  *          is consumed and moves last_seen to the poll time, and a slot
+  *          whose last_seen is older than its deadline has missed.
+  *
+  *          A check-in that lands between the supervisor reading and
+  *          clearing the flag is lost. Pick a deadline of at least twice the
+  *          thread's check-in interval plus one supervisor period.
+  ******************************************************************************
+  */
+#ifndef WATCHDOG_CORE_H
+#define WATCHDOG_CORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct {
+  volatile uint8_t alive;   /*!< Set by the owner, cleared by the supervisor */
+  uint32_t deadline;        /*!< Longest allowed gap between check-ins */
+  uint32_t last_seen;       /*!< Poll time of the last consumed check-in */
+  const char *name;
+  void *owner;              /*!< Opaque, e.g. the TX_THREAD being watched */
+} watchdog_slot_t;
+
+/**
+  * @brief  Arm a slot. The first deadline runs from now.
+  */
+void watchdog_slot_init(watchdog_slot_t *slot, const char *name, void *owner,
+                        uint32_t deadline, uint32_t now);
+
+/**
+  * @brief  Record a check-in. The only thing a supervised thread calls.
+  */
+static inline void watchdog_slot_checkin(watchdog_slot_t *slot)
+{
+  slot->alive = 1U;
+}
+
+/**
+  * @brief  Ticks a slot is past its deadline at time now, 0 if it is not.
+  *         Does not consume the alive flag.
+  */
+uint32_t watchdog_slot_overdue(const watchdog_slot_t *slot, uint32_t now);
+
+/**
+  * @brief  Consume pending check-ins and find the slot furthest past its
+  *         deadline.
+  * @param  slots: slot table
+  * @param  count: number of slots in use
+  * @param  now: current time
+  * @retval index of the worst missed slot, or -1 if every slot is in time
+  */
+int watchdog_poll(watchdog_slot_t *slots, uint32_t count, uint32_t now);
+
+/**
+  * @brief  Ticks from now until the first slot could be found overdue, for
+  *         a supervisor that polls no more often than it has to.
+  * @param  max: returned if that is further away, or there are no slots
+  */
+uint32_t watchdog_next_poll(const watchdog_slot_t *slots, uint32_t count, uint32_t now,
+                            uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATCHDOG_CORE_H */
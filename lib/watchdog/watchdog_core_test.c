@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * @file    watchdog_core_test.c
+  * @brief   Host build: the watchdog's deadline bookkeeping.
+  *
+  *          A slot that checks in is never reported, one that stops is
+  *          reported on the first poll past its deadline and not before,
+  *          and the worst of several late slots is the one named. The same
+  *          holds with last_seen just below the tick counter's wrap. Then
+  *          random slot tables that stop checking in are polled the way the
+  *          supervisor does it, sleeping what watchdog_next_poll() allows,
+  *          and the first miss must land on the exact tick it is due:
+  *            watchdog_core_test [tables] [seed]
+  *          The exit status is 0 if every check held.
+  ******************************************************************************
+  */
+#include "watchdog_core.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WATCHDOG_TEST_TABLES    20000UL
+#define WATCHDOG_TEST_SLOTS     8U
+#define WATCHDOG_TEST_MAX       500U        /* Longest supervisor sleep */
+#define WATCHDOG_TEST_WRAP      0xFFFFFFF0UL
+
+static watchdog_slot_t watchdog_test_slots[WATCHDOG_TEST_SLOTS];
+
+static uint32_t watchdog_test_seed;
+static int watchdog_test_failed;
+
+#define WATCHDOG_TEST_CHECK(cond)                                              \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  %s:%d: %s\n", __FILE__, __LINE__, #cond);             \
+      watchdog_test_failed++;                                                  \
+    }                                                                          \
+  } while (0)
+
+static uint32_t watchdog_test_rand(void)
+{
+  /* xorshift32: repeatable runs, no libc state */
+  watchdog_test_seed ^= watchdog_test_seed << 13;
+  watchdog_test_seed ^= watchdog_test_seed >> 17;
+  watchdog_test_seed ^= watchdog_test_seed << 5;
+  return watchdog_test_seed;
+}
+
+/**
+  * @brief  One slot with a 100-tick deadline armed at start: kept alive,
+  *         then left to run out.
+  */
+static void watchdog_test_one(uint32_t start)
+{
+  watchdog_slot_t *slot = &watchdog_test_slots[0];
+
+  watchdog_slot_init(slot, "one", NULL, 100U, start);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slot, 1U, start, 1000U) == 101U);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slot, 1U, start + 100U) < 0);
+
+  /* On time: the check-in is consumed and the deadline runs from the poll */
+  watchdog_slot_checkin(slot);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slot, 1U, start + 100U) < 0);
+  WATCHDOG_TEST_CHECK(slot->alive == 0U && slot->last_seen == start + 100U);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slot, 1U, start + 150U, 1000U) == 51U);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slot, 1U, start + 150U, 20U) == 20U);
+
+  /* Silent from here: due at the deadline, missed one tick after it */
+  WATCHDOG_TEST_CHECK(watchdog_poll(slot, 1U, start + 200U) < 0);
+  WATCHDOG_TEST_CHECK(watchdog_slot_overdue(slot, start + 200U) == 0U);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slot, 1U, start + 200U, 1000U) == 1U);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slot, 1U, start + 201U) == 0);
+  WATCHDOG_TEST_CHECK(watchdog_slot_overdue(slot, start + 201U) == 1U);
+  WATCHDOG_TEST_CHECK(watchdog_slot_overdue(slot, start + 350U) == 150U);
+
+  /* A late check-in still clears the miss */
+  watchdog_slot_checkin(slot);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slot, 1U, start + 400U) < 0);
+  WATCHDOG_TEST_CHECK(watchdog_slot_overdue(slot, start + 400U) == 0U);
+}
+
+/**
+  * @brief  Three late slots: the one furthest past its deadline is named,
+  *         and a slot that checked in is not.
+  */
+static void watchdog_test_worst(uint32_t start)
+{
+  watchdog_slot_t *slots = watchdog_test_slots;
+
+  watchdog_slot_init(&slots[0], "a", NULL, 100U, start);
+  watchdog_slot_init(&slots[1], "b", NULL, 50U, start);
+  watchdog_slot_init(&slots[2], "c", NULL, 120U, start);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slots, 3U, start, 1000U) == 51U);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slots, 3U, start + 200U) == 1);
+
+  watchdog_slot_checkin(&slots[1]);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slots, 3U, start + 200U) == 0);
+  WATCHDOG_TEST_CHECK(slots[1].last_seen == start + 200U);
+
+  watchdog_slot_checkin(&slots[0]);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slots, 3U, start + 210U) == 2);
+  watchdog_slot_checkin(&slots[2]);
+  WATCHDOG_TEST_CHECK(watchdog_poll(slots, 3U, start + 210U) < 0);
+
+  /* Nothing to watch */
+  WATCHDOG_TEST_CHECK(watchdog_poll(slots, 0U, start) < 0);
+  WATCHDOG_TEST_CHECK(watchdog_next_poll(slots, 0U, start, 1000U) == 1000U);
+}
+
+/**
+  * @brief  Random tables that stop checking in, polled as the supervisor
+  *         does: the first miss is the earliest deadline, on its first tick.
+  */
+static void watchdog_test_random(unsigned long tables)
+{
+  watchdog_slot_t *slots = watchdog_test_slots;
+  uint32_t count;
+  uint32_t start;
+  uint32_t now;
+  uint32_t due;
+  uint32_t late;
+  uint32_t worst;
+  uint32_t polls;
+  int missed;
+  uint32_t i;
+
+  while (tables-- > 0UL) {
+    count = 1U + watchdog_test_rand() % WATCHDOG_TEST_SLOTS;
+    start = WATCHDOG_TEST_WRAP - watchdog_test_rand() % 4000U;
+    due = 0U;
+    for (i = 0U; i < count; i++) {
+      watchdog_slot_init(&slots[i], "r", NULL, 1U + watchdog_test_rand() % 1500U,
+                         start + watchdog_test_rand() % 100U);
+      /* Ticks from start until this slot is overdue */
+      late = slots[i].last_seen - start + slots[i].deadline + 1U;
+      due = (i == 0U || late < due) ? late : due;
+    }
+
+    now = start + 100U;
+    polls = 0U;
+    while ((missed = watchdog_poll(slots, count, now)) < 0 && polls++ < 100U) {
+      now += watchdog_next_poll(slots, count, now, WATCHDOG_TEST_MAX);
+    }
+    WATCHDOG_TEST_CHECK(missed >= 0);
+    if (missed < 0) {
+      continue;
+    }
+    WATCHDOG_TEST_CHECK(now - start == ((due > 100U) ? due : 100U));
+
+    /* And it is the worst of those missed at that tick */
+    worst = watchdog_slot_overdue(&slots[missed], now);
+    for (i = 0U; i < count; i++) {
+      WATCHDOG_TEST_CHECK(watchdog_slot_overdue(&slots[i], now) <= worst);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long tables = (argc > 1) ? strtoul(argv[1], NULL, 0) : WATCHDOG_TEST_TABLES;
+
+  watchdog_test_seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x6A09E667UL;
+  if (watchdog_test_seed == 0U) {
+    fprintf(stderr, "usage: %s [tables] [seed]\n", argv[0]);
+    return 2;
+  }
+
+  watchdog_test_one(1000U);
+  watchdog_test_one(WATCHDOG_TEST_WRAP);
+  watchdog_test_worst(1000U);
+  watchdog_test_worst(WATCHDOG_TEST_WRAP);
+  watchdog_test_random(tables);
+
+  printf("  %-22s %s\n", "watchdog deadlines", (watchdog_test_failed == 0) ? "ok" : "FAIL");
+  return (watchdog_test_failed == 0) ? 0 : 1;
+}
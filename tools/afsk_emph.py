@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Design AFSK pre-emphasis coefficients for lib/afsk/afsk_emph.h.
+
+Prints an afsk_emph_coeffs_t initializer for a single CMSIS-DSP q15
+DF1 biquad at the modulator's 19.2 kHz sample rate. The filter is scaled
+so that the louder of the two tones comes out at full level; the other
+one ends up `twist` dB below it.
+
+    afsk_emph.py --preemph          # 750 us, 6 dB/oct (about 5.3 dB)
+    afsk_emph.py --twist 8          # high shelf, 2200 Hz 8 dB over 1200 Hz
+    afsk_emph.py --twist -3         # the other way round
+
+A built-in curve's response is printed too, to check what the radio's
+de-emphasis will leave.
+"""
+import argparse
+import cmath
+import math
+import sys
+
+FS = 19200.0
+MARK = 1200.0
+SPACE = 2200.0
+
+
+def response(b, a, f):
+    z = cmath.exp(-2j * math.pi * f / FS)
+    num = b[0] + b[1] * z + b[2] * z * z
+    den = a[0] + a[1] * z + a[2] * z * z
+    return abs(num / den)
+
+
+def preemph(tau=750e-6, pole_hz=6000.0):
+    """First order zero at 1/(2 pi tau), pole above the band, bilinear."""
+    k = 2 * FS
+    wz = k * math.tan(math.pi / (2 * math.pi * tau) / FS)
+    wp = k * math.tan(math.pi * pole_hz / FS)
+    return [k + wz, wz - k, 0.0], [k + wp, wp - k, 0.0]
+
+
+def high_shelf(gain_db, f0=1700.0):
+    """RBJ audio EQ cookbook high shelf, slope 1."""
+    amp = 10 ** (gain_db / 40)
+    w0 = 2 * math.pi * f0 / FS
+    alpha = math.sin(w0) / 2 * math.sqrt(2)
+    c = math.cos(w0)
+    sq = 2 * math.sqrt(amp) * alpha
+    b = [amp * ((amp + 1) + (amp - 1) * c + sq),
+         -2 * amp * ((amp - 1) + (amp + 1) * c),
+         amp * ((amp + 1) + (amp - 1) * c - sq)]
+    a = [(amp + 1) - (amp - 1) * c + sq,
+         2 * ((amp - 1) - (amp + 1) * c),
+         (amp + 1) - (amp - 1) * c - sq]
+    return b, a
+
+
+def twist_db(b, a):
+    return 20 * math.log10(response(b, a, SPACE) / response(b, a, MARK))
+
+
+def shelf_for_twist(twist):
+    """Bisect the shelf gain that gives the wanted tone ratio."""
+    lo, hi = -40.0, 40.0
+    for _ in range(100):
+        mid = (lo + hi) / 2
+        if twist_db(*high_shelf(mid)) < twist:
+            lo = mid
+        else:
+            hi = mid
+    return high_shelf((lo + hi) / 2)
+
+
+def quantize(b, a):
+    """Normalise, scale the louder tone to 1 and convert to CMSIS q15."""
+    b = [x / a[0] for x in b]
+    a = [x / a[0] for x in a]
+    scale = max(response(b, a, MARK), response(b, a, SPACE))
+    b = [x / scale for x in b]
+    # CMSIS adds the feedback terms: a1, a2 go in negated
+    coeffs = [b[0], b[1], b[2], -a[1], -a[2]]
+    shift = 0
+    while max(abs(x) for x in coeffs) / (1 << shift) >= 1.0:
+        shift += 1
+    q = [round(x / (1 << shift) * 32768) for x in coeffs]
+    q = [min(32767, max(-32768, x)) for x in q]
+    return q, shift, b, a
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--preemph", action="store_true", help="750 us pre-emphasis")
+    group.add_argument("--twist", type=float, help="2200 Hz over 1200 Hz, dB")
+    args = parser.parse_args()
+
+    b, a = preemph() if args.preemph else shelf_for_twist(args.twist)
+    q, shift, b, a = quantize(b, a)
+    print(f"/* twist {twist_db(b, a):+.2f} dB */")
+    print(f"{{ {{ {q[0]}, 0, {q[1]}, {q[2]}, {q[3]}, {q[4]} }}, {shift}U }}")
+    for f in (MARK, SPACE, 4800.0, FS / 2 - 1):
+        gain = 20 * math.log10(max(response(b, a, f), 1e-9))
+        print(f"/* {f:7.0f} Hz {gain:+6.2f} dB */", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Compare two captures of the console's `bench all` output.
+
+Lines are read as `bench key=value ...`; anything else in the capture (the
+prompt, log frames) is skipped. Cases are matched by name and compared on
+their median, and the exit status is 1 if any got slower by more than the
+threshold.
+
+    bench_diff.py before.txt after.txt
+    bench_diff.py before.txt after.txt --threshold 2
+"""
+import argparse
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, "rb") as f:
+        for raw in f:
+            line = raw.decode("ascii", errors="ignore")
+            start = line.find("bench name=")
+            if start < 0:
+                continue
+            fields = dict(kv.split("=", 1) for kv in line[start:].split()[1:] if "=" in kv)
+            results[fields["name"]] = fields
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("before", help="capture from the baseline build")
+    parser.add_argument("after", help="capture from the build under test")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent slower that counts as a regression")
+    args = parser.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+    regressed = False
+
+    print(f"{'case':<20} {'before':>10} {'after':>10} {'change':>8}")
+    for name in sorted(before.keys() | after.keys()):
+        if name not in before or name not in after:
+            side = "after" if name in after else "before"
+            print(f"{name:<20} only in {side}")
+            continue
+        old, new = before[name], after[name]
+        if old.get("unit") != new.get("unit") or old.get("hz") != new.get("hz"):
+            print(f"{name:<20} not comparable: {old.get('unit')}@{old.get('hz')} "
+                  f"vs {new.get('unit')}@{new.get('hz')}")
+            continue
+        a, b = int(old["med"]), int(new["med"])
+        change = (b - a) * 100.0 / a if a else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  slower"
+            regressed = True
+        print(f"{name:<20} {a:>10} {b:>10} {change:>+7.1f}%{flag}")
+
+    sys.exit(1 if regressed else 0)
+
+
+if __name__ == "__main__":
+    main()
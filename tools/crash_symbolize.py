@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Symbolize the CRASH report printed by lib/crash on the boot after a fault.
+
+Feed it the console capture (file or stdin) and the ELF of the build that
+crashed; every code address in the report is resolved with addr2line.
+
+    crash_symbolize.py build/Debug/apps/uart_echo_app/uart_echo_app.elf console.log
+    picocom ... | crash_symbolize.py app.elf
+
+Requires arm-none-eabi-addr2line on PATH (or --addr2line).
+"""
+import argparse
+import re
+import subprocess
+import sys
+
+FIELD_RE = re.compile(r"(\w+)=(0x[0-9a-fA-F]+(?:,0x[0-9a-fA-F]+)*)")
+
+
+def symbolize(addr2line, elf, addrs):
+    # Return addresses point after the BL; step back into the call instruction
+    query = [f"0x{(a & ~1) - (2 if a & 1 else 0):08x}" for a in addrs]
+    out = subprocess.run([addr2line, "-e", elf, "-f", "-p", "-C", "-i"] + query,
+                         check=True, capture_output=True, text=True).stdout
+    # -i may print extra "(inlined by)" lines; keep them with their address
+    results = []
+    for line in out.splitlines():
+        if line.lstrip().startswith("(inlined by)") and results:
+            results[-1] += "\n" + " " * 24 + line.strip()
+        else:
+            results.append(line.strip())
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("log", nargs="?", help="console capture, default stdin")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line")
+    args = parser.parse_args()
+
+    src = open(args.log, errors="replace") if args.log else sys.stdin
+    entries = []
+    for line in src:
+        if "CRASH" not in line:
+            continue
+        print(line.rstrip())
+        for name, value in FIELD_RE.findall(line):
+            if name in ("pc", "lr"):
+                entries.append((name, int(value, 16)))
+            elif name == "trace":
+                entries.extend(("trace", int(v, 16)) for v in value.split(","))
+
+    if not entries:
+        sys.exit("no CRASH report found")
+
+    # The pc is the faulting instruction itself, not a return address
+    lines = []
+    for name, addr in entries:
+        lookup = addr | 1 if name != "pc" else addr & ~1
+        lines.append((name, addr, symbolize(args.addr2line, args.elf, [lookup])[0]))
+
+    print()
+    for name, addr, where in lines:
+        print(f"{name:>5} 0x{addr:08x}  {where}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Decode the deferred binary log stream produced by lib/dlog.
+
+Format strings are read from the .dlog_fmt section of the firmware ELF; the
+stream comes from a serial port or a capture file.
+
+    dlog_decode.py build/Debug/uart_echo_app.elf --port /dev/ttyACM0
+    dlog_decode.py build/Debug/uart_echo_app.elf --file capture.bin
+
+Requires pyelftools, and pyserial for --port.
+"""
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile
+
+SYNC = 0xA5
+MAX_ARGS = 8
+LEVELS = ["ERROR", "WARN", "INFO", "DEBUG"]
+
+# printf conversion: flags, width, precision, length modifier, conversion
+CONV_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcps%])")
+
+
+def load_formats(elf_path):
+    with open(elf_path, "rb") as f:
+        elf = ELFFile(f)
+        section = elf.get_section_by_name(".dlog_fmt")
+        if section is None:
+            sys.exit(f"{elf_path}: no .dlog_fmt section")
+        data = section.data()
+        # Where %s arguments can point: constant strings the image loads
+        images = [(s["sh_addr"], s.data()) for s in elf.iter_sections()
+                  if s["sh_type"] == "SHT_PROGBITS" and s["sh_flags"] & SH_FLAGS.SHF_ALLOC
+                  and not s["sh_flags"] & SH_FLAGS.SHF_WRITE]
+
+    formats = {}
+    start = 0
+    while start < len(data):
+        end = data.index(b"\0", start)
+        if end > start:
+            text = data[start:end].decode("utf-8", errors="replace")
+            site, _, fmt = text.partition("\x1f")
+            formats[start] = (site, fmt)
+        start = end + 1
+    return formats, images
+
+
+def string_at(images, addr):
+    """The NUL-terminated string at addr in the ELF, or None."""
+    for base, data in images:
+        if base <= addr < base + len(data):
+            end = data.find(b"\0", addr - base)
+            if end >= 0:
+                return data[addr - base:end].decode("utf-8", errors="replace")
+    return None
+
+
+def render(fmt, args, images=()):
+    """Apply a C printf format to raw 32-bit arguments."""
+    it = iter(args)
+
+    def sub(m):
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = next(it, 0)
+        if conv in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            spec = "d"
+        elif conv == "u":
+            spec = "d"
+        elif conv == "c":
+            return chr(value & 0xFF)
+        elif conv == "p":
+            return f"0x{value:08x}"
+        elif conv == "s":
+            text = string_at(images, value)
+            if text is None:
+                return f"<str@0x{value:08x}>"
+            return ("%" + flags + width + (("." + prec) if prec else "") + "s") % text
+        else:
+            spec = conv
+        py = "%" + flags + width + (("." + prec) if prec else "") + spec
+        return py % value
+
+    return CONV_RE.sub(sub, fmt)
+
+
+def records(read, formats, images=()):
+    """Yield (timestamp, level, site, text), resynchronising on garbage."""
+    buf = bytearray()
+    while True:
+        chunk = read()
+        if not chunk:
+            return
+        buf.extend(chunk)
+        while len(buf) >= 8:
+            if buf[0] != SYNC:
+                del buf[0]
+                continue
+            info, fmt_id = buf[1], struct.unpack_from("<H", buf, 2)[0]
+            level, nargs = info >> 4, info & 0x0F
+            if nargs > MAX_ARGS or level >= len(LEVELS) or fmt_id not in formats:
+                del buf[0]
+                continue
+            size = 8 + 4 * nargs
+            if len(buf) < size:
+                break
+            timestamp = struct.unpack_from("<I", buf, 4)[0]
+            args = struct.unpack_from(f"<{nargs}I", buf, 8)
+            del buf[:size]
+            site, fmt = formats[fmt_id]
+            yield timestamp, LEVELS[level], site, render(fmt, args, images)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF with the .dlog_fmt section")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial device")
+    source.add_argument("--file", help="raw capture file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--sites", action="store_true", help="print file:line of each call")
+    args = parser.parse_args()
+
+    formats, images = load_formats(args.elf)
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud, timeout=None)
+        read = lambda: stream.read(max(1, stream.in_waiting))
+    else:
+        stream = open(args.file, "rb")
+        read = lambda: stream.read(4096)
+
+    with stream:
+        for timestamp, level, site, text in records(read, formats, images):
+            where = f" {site}" if args.sites else ""
+            print(f"{timestamp / 1000:10.3f} {level:<5}{where} {text}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
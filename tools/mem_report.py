@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Print how full each linker script memory region is, and with what.
+
+Reads the MEMORY block of the linker script and the section headers of the
+linked ELF (arm-none-eabi-objdump -h), and prints every region's use with
+the sections placed in it. Initialised data counts twice: in SRAM where it
+runs and in flash where its load image sits.
+
+    mem_report.py app.elf CubeMX/STM32U083xx_FLASH.ld
+    mem_report.py app.elf CubeMX/STM32U083xx_FLASH.ld --objdump llvm-objdump
+
+The app build runs it after every link.
+"""
+import argparse
+import re
+import subprocess
+
+MEMORY_LINE = re.compile(
+    r"^\s*(\w+)\s*\([rwx]+\)\s*:\s*ORIGIN\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*,"
+    r"\s*LENGTH\s*=\s*(\d+)\s*([KM]?)", re.MULTILINE)
+
+
+def regions(path):
+    with open(path) as f:
+        text = f.read()
+    block = text[text.index("MEMORY"):]
+    block = block[:block.index("}")]
+    scale = {"": 1, "K": 1024, "M": 1024 * 1024}
+    return [(name, int(origin, 0), int(length) * scale[unit])
+            for name, origin, length, unit in MEMORY_LINE.findall(block)]
+
+
+def sections(elf, objdump):
+    out = subprocess.run([objdump, "-h", elf], check=True, capture_output=True,
+                         text=True).stdout.splitlines()
+    for head, flags in zip(out, out[1:]):
+        fields = head.split()
+        if len(fields) < 7 or not fields[0].isdigit() or "ALLOC" not in flags:
+            continue
+        name, size, vma, lma = fields[1], int(fields[2], 16), int(fields[3], 16), int(fields[4], 16)
+        if size == 0:
+            continue
+        yield name, size, vma
+        if "LOAD" in flags and lma != vma:
+            yield name + " (load)", size, lma
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="linked image")
+    parser.add_argument("ld", help="linker script it was linked with")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    args = parser.parse_args()
+
+    mems = regions(args.ld)
+    placed = {name: [] for name, _, _ in mems}
+    for sec, size, addr in sections(args.elf, args.objdump):
+        for name, origin, length in mems:
+            if origin <= addr < origin + length:
+                placed[name].append((sec, size))
+                break
+
+    for name, origin, length in mems:
+        used = sum(size for _, size in placed[name])
+        print(f"{name:<10} {used:>7} / {length:>7} B  {used * 100.0 / length:5.1f}%"
+              f"  @ 0x{origin:08x}")
+        for sec, size in placed[name]:
+            print(f"  {sec:<24} {size:>7}")
+
+
+if __name__ == "__main__":
+    main()
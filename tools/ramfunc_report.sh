@@ -0,0 +1,33 @@
+#!/bin/sh
+# List the functions lib/ramfunc placed in SRAM and what they cost.
+#
+# Every RAMFUNC function takes its size in SRAM (in .data) and again in flash
+# (the load image startup copies from). Prints each symbol between
+# __ramfunc_start and __ramfunc_end with its size, then the total.
+#
+#   tools/ramfunc_report.sh [elf]
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+ELF=${1:-$ROOT/build/Release/apps/uart_echo_app/uart_echo_app.elf}
+
+arm-none-eabi-nm -S -n "$ELF" | awk '
+    function hex(s,    i, n) {
+        n = 0
+        for (i = 1; i <= length(s); i++) {
+            n = n * 16 + index("0123456789abcdef", tolower(substr(s, i, 1))) - 1
+        }
+        return n
+    }
+    $NF == "__ramfunc_start" { start = hex($1); next }
+    $NF == "__ramfunc_end" { end = hex($1); next }
+    NF == 4 && ($3 == "t" || $3 == "T") { addr[$4] = hex($1); size[$4] = hex($2) }
+    END {
+        printf "%-28s %6s\n", "function", "bytes"
+        for (f in addr) {
+            if (addr[f] >= start && addr[f] < end) {
+                printf "%-28s %6d\n", f, size[f]
+            }
+        }
+        printf "%-28s %6d  (SRAM, same again in flash)\n", "total", end - start
+    }'
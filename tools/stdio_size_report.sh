@@ -0,0 +1,34 @@
+#!/bin/sh
+# Compare the image size of lib/fmt's printf against newlib-nano's.
+#
+# Builds uart_echo_app twice in Release, once with the lib/uart_stdio printf
+# family and once with -DPICOAPRS_NEWLIB_STDIO=ON (newlib-nano formatter, same
+# _write() streams underneath), and prints arm-none-eabi-size for both plus
+# the delta.
+#
+#   tools/stdio_size_report.sh [build-root]
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${1:-$ROOT/build/stdio-size}
+APP=apps/uart_echo_app/uart_echo_app.elf
+
+for variant in fmt newlib; do
+    if [ "$variant" = newlib ]; then opt=ON; else opt=OFF; fi
+    cmake -S "$ROOT" -B "$OUT/$variant" -G Ninja \
+        -DCMAKE_BUILD_TYPE=Release -DPICOAPRS_NEWLIB_STDIO=$opt > /dev/null
+    cmake --build "$OUT/$variant" > /dev/null
+done
+
+printf '%-8s %8s %8s %8s\n' variant text data bss
+for variant in fmt newlib; do
+    arm-none-eabi-size "$OUT/$variant/$APP" | awk -v v="$variant" 'NR == 2 { printf "%-8s %8d %8d %8d\n", v, $1, $2, $3 }'
+done
+
+arm-none-eabi-size "$OUT/fmt/$APP" "$OUT/newlib/$APP" | awk '
+    NR == 2 { t = $1; d = $2; b = $3 }
+    NR == 3 { printf "%-8s %+8d %+8d %+8d  (newlib-nano minus lib/fmt)\n", "delta", $1 - t, $2 - d, $3 - b }'
+
+echo
+echo "Formatter symbols pulled in by newlib-nano:"
+arm-none-eabi-nm --size-sort -S "$OUT/newlib/$APP" | grep -E ' [tT] _?(_svfprintf_r|_vfprintf_r|_printf_i|_printf_common|__sfp|__smakebuf_r|_malloc_r|_free_r)$' || true